@@ -0,0 +1,243 @@
+#ifndef DECOMPOSITION_HPP
+#define DECOMPOSITION_HPP
+
+#include "Matrix.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+/// @brief Base of the factorizations with the blocked operations they are built of. The
+///        operations recurse on halves of the triangles and panels until they are narrow, so
+///        that almost all of their work is done by products on the tiled Gemm kernels, in
+///        parallel if the ThreadPool is started.
+/// @tparam T must be float or double.
+template<class T>
+class Decomposition
+{
+protected:
+    /// @brief Computes C = alpha * A * B + beta * C, see Matrix::multiplyInto. C must not share
+    ///        elements with A or B.
+    static void multiply(MatrixView<const T> a, MatrixView<const T> b, T alpha, T beta, MatrixView<T> c);
+
+    /// @brief Solves L * X = B in place of the RowMajor rows X of B, with L the unit lower
+    ///        triangle of the square view.
+    static void solveUnitLower(MatrixView<const T> triangle, MatrixView<T> x);
+
+    /// @brief Solves U * X = B in place of the RowMajor rows X of B, with U the upper triangle
+    ///        of the square view.
+    static void solveUpper(MatrixView<const T> triangle, MatrixView<T> x);
+
+};
+
+
+/// @brief LU factorization with partial pivoting, P * A = L * U, of a square matrix A: L is unit
+///        lower triangular, U upper triangular and P the permutation of the row exchanges.
+///
+///        The factorization is blocked and right-looking: a panel of BLOCK_SIZE columns is
+///        factored recursively, the rows of U to its right are solved with L of the panel and
+///        the trailing matrix is updated by one product, A22 -= L21 * U12. The products run on
+///        the tiled Gemm kernels, in parallel if the ThreadPool is started, and make up all but
+///        O(n^2 * BLOCK_SIZE) of the 2/3 * n^3 operations.
+///
+///        A factorization solves any amount of right hand sides with O(n^2) operations each,
+///        factor once and call Solve for every system of the same matrix.
+/// @tparam T must be float or double.
+template<class T>
+class LuDecomposition : private Decomposition<T>
+{
+public:
+    using ValueType = T;
+
+    /// @brief The amount of columns of the panels of the factorization.
+    inline constexpr static size_t BLOCK_SIZE = 128;
+
+    LuDecomposition() = delete;
+
+    /// @brief Factors the matrix. Singular matrices are factored as well, with a zero on the
+    ///        diagonal of U, see IsSingular.
+    /// @throws std::invalid_argument if the matrix is not square.
+    explicit LuDecomposition(const Matrix<T>& matrix);
+
+    size_t GetSize() const;
+
+    /// @brief Returns the row exchanges: row i was exchanged with row GetPivots()[i] >= i in
+    ///        step i of the factorization, the steps applied in increasing order.
+    const std::vector<size_t>& GetPivots() const;
+
+    /// @brief Returns L, the unit lower triangular factor.
+    Matrix<T> GetLower() const;
+
+    /// @brief Returns U, the upper triangular factor.
+    Matrix<T> GetUpper() const;
+
+    /// @brief Returns true if a pivot is exactly zero, i.e. the matrix is singular in the
+    ///        precision of T. Nearly singular matrices are not detected.
+    bool IsSingular() const;
+
+    /// @brief Returns the determinant, the product of the diagonal of U times the sign of P.
+    T Determinant() const;
+
+    /// @brief Returns X with A * X = rhs in RowMajor ordering, by applying P and substituting
+    ///        forward with L and backward with U, with all columns of rhs at once.
+    /// @throws std::invalid_argument if the height of rhs differs from the size of A.
+    /// @throws std::runtime_error if A is singular.
+    Matrix<T> Solve(const Matrix<T>& rhs) const;
+
+    /// @brief Returns the inverse of A in RowMajor ordering, the solution of A * X = I.
+    /// @throws std::runtime_error if A is singular.
+    Matrix<T> Inverse() const;
+
+private:
+    using Decomposition<T>::multiply;
+    using Decomposition<T>::solveUnitLower;
+    using Decomposition<T>::solveUpper;
+
+    /// @brief Factors the columns [col, col + width) of the rows [col, n) of the factors, which
+    ///        are updated with all previous columns. Halves the columns until they are narrow,
+    ///        so that the updates of the right half by the left half are products.
+    void factorPanel(size_t col, size_t width);
+
+private:
+    Matrix<T>           _factors; // L below and U on and above the diagonal, RowMajor
+    std::vector<size_t> _pivots;
+    bool                _singular;
+
+};
+
+
+/// @brief Householder QR factorization, A = Q * R, of a m x n matrix A: Q is orthogonal and R
+///        upper triangular with a non-negative diagonal, which makes R unique if A has full rank.
+///        Q is kept as the product of p = min(m, n) reflections H_i = I - tau_i * v_i * v_i^T,
+///        R has p rows.
+///
+///        The factorization is blocked like LuDecomposition: the reflections of a panel of
+///        BLOCK_SIZE columns are accumulated into the compact WY representation I - V * T * V^T,
+///        with T upper triangular, and applied to the trailing matrix with three products.
+///        Q and Q^T are applied to other matrices the same way, panel by panel.
+///
+///        Tall-skinny matrices, e.g. the design matrices of least squares problems with many
+///        more observations than parameters, are better factored by TallSkinnyR.
+/// @tparam T must be float or double.
+template<class T>
+class QrDecomposition : private Decomposition<T>
+{
+public:
+    using ValueType = T;
+
+    /// @brief The amount of columns of the panels of the factorization.
+    inline constexpr static size_t BLOCK_SIZE = 64;
+
+    /// @brief The blocks of rows of TallSkinnyR have TALL_SKINNY_ROWS times as many rows as the
+    ///        matrix has columns, and at least MIN_TALL_SKINNY_ROWS. The narrow panels of a block
+    ///        stay in the L2 cache, and stacking the blocks below triangles adds about
+    ///        1 / TALL_SKINNY_ROWS to the operations.
+    inline constexpr static size_t TALL_SKINNY_ROWS = 8;
+    inline constexpr static size_t MIN_TALL_SKINNY_ROWS = 1024;
+
+    QrDecomposition() = delete;
+
+    /// @brief Factors the matrix. Rank deficient matrices are factored as well, with a zero on
+    ///        the diagonal of R, see IsRankDeficient.
+    explicit QrDecomposition(const Matrix<T>& matrix);
+
+    /// @brief Factors the matrix in place of its elements if it is RowMajor.
+    explicit QrDecomposition(Matrix<T>&& matrix);
+
+    size_t GetHeight() const;
+    size_t GetWidth()  const;
+
+    /// @brief Returns the scales tau_i of the reflections.
+    const std::vector<T>& GetScales() const;
+
+    /// @brief Returns R, the upper triangular min(m, n) x n factor.
+    Matrix<T> GetR() const;
+
+    /// @brief Returns the first min(m, n) columns of Q, the thin factor with A = Q * R.
+    Matrix<T> GetQ() const;
+
+    /// @brief Returns true if a diagonal element of R is exactly zero. Nearly rank deficient
+    ///        matrices are not detected.
+    bool IsRankDeficient() const;
+
+    /// @brief Returns Q * rhs in RowMajor ordering.
+    /// @throws std::invalid_argument if the height of rhs differs from the height of A.
+    Matrix<T> MultiplyQ(const Matrix<T>& rhs) const;
+
+    /// @brief Returns Q^T * rhs in RowMajor ordering.
+    /// @throws std::invalid_argument if the height of rhs differs from the height of A.
+    Matrix<T> MultiplyQTranspose(const Matrix<T>& rhs) const;
+
+    /// @brief Returns the least squares solution X, which minimizes the Frobenius norm of
+    ///        A * X - rhs, in RowMajor ordering: the first n rows of Q^T * rhs solved with R.
+    /// @throws std::invalid_argument if the height of rhs differs from the height of A, or if A
+    ///         has fewer rows than columns.
+    /// @throws std::runtime_error if A is rank deficient.
+    Matrix<T> Solve(const Matrix<T>& rhs) const;
+
+    /// @brief Returns R of the matrix by the tall-skinny QR (TSQR), without forming Q. The rows
+    ///        are split into blocks and every thread factors a range of blocks, each stacked below
+    ///        R of the previous ones. The R of the threads are merged by a binary tree of
+    ///        factorizations of two stacked triangles, the pairs of a level in parallel.
+    ///        Equals GetR of the whole matrix up to rounding if the matrix has full rank.
+    static Matrix<T> TallSkinnyR(const Matrix<T>& matrix);
+
+    /// @brief Returns the least squares solution like Solve, from TallSkinnyR of the matrix
+    ///        [A, rhs]: its first n rows are R and the first n rows of Q^T * rhs. The blocks of
+    ///        [A, rhs] are copied one at a time, the whole matrix is never formed.
+    /// @throws std::invalid_argument see Solve.
+    /// @throws std::runtime_error if A is rank deficient.
+    static Matrix<T> TallSkinnySolve(const Matrix<T>& a, const Matrix<T>& rhs);
+
+private:
+    using Decomposition<T>::multiply;
+    using Decomposition<T>::solveUpper;
+
+    /// @brief Factors all columns, see the constructor.
+    void factor();
+
+    /// @brief Factors the columns [col, col + width) of the rows [col, m) of the factors, which
+    ///        are updated with all previous reflections, like LuDecomposition::factorPanel.
+    void factorPanel(size_t col, size_t width);
+
+    /// @brief Returns V of the width reflections starting at column col: the (m - col) x width
+    ///        lower trapezoid of the factors with a unit diagonal, RowMajor.
+    Matrix<T> reflectionVectors(size_t col, size_t width) const;
+
+    /// @brief Returns T of the compact WY representation of the width reflections starting at
+    ///        column col, H_col * ... * H_(col + width - 1) = I - V * T * V^T.
+    Matrix<T> triangularFactor(size_t col, size_t width) const;
+
+    /// @brief Overwrites C with (I - V * T * V^T) * C, or with the transpose applied if transpose
+    ///        is true, for the reflections starting at column col. C has the rows [col, m).
+    void applyReflections(size_t col, const Matrix<T>& triangle, MatrixView<T> c, bool transpose) const;
+
+    /// @brief Returns R of the matrix [a, b], see TallSkinnyR. b may have no columns.
+    static Matrix<T> tallSkinny(MatrixView<const T> a, MatrixView<const T> b);
+
+private:
+    Matrix<T>              _factors;   // V below and R on and above the diagonal, RowMajor
+    std::vector<T>         _scales;
+    std::vector<Matrix<T>> _triangles; // T of the compact WY representation of every panel
+
+};
+
+
+/// @brief Returns X with A * X = B in RowMajor ordering, see LuDecomposition::Solve. Factor A
+///        with LuDecomposition once to solve several systems of the same matrix.
+template<class T> Matrix<T>
+Solve(const Matrix<T>& a, const Matrix<T>& b)
+{
+    return LuDecomposition<T>(a).Solve(b);
+}
+
+/// @brief Returns the X which minimizes the Frobenius norm of A * X - B in RowMajor ordering,
+///        see QrDecomposition::TallSkinnySolve.
+template<class T> Matrix<T>
+LeastSquares(const Matrix<T>& a, const Matrix<T>& b)
+{
+    return QrDecomposition<T>::TallSkinnySolve(a, b);
+}
+
+
+#endif // DECOMPOSITION_HPP
@@ -0,0 +1,218 @@
+#ifndef FIXED_MATRIX_HPP
+#define FIXED_MATRIX_HPP
+
+#include "Math.hpp"
+#include "Matrix.hpp"
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/// @brief Dense Rows X Columns matrix with dimensions known at compile time, for small matrices
+///        such as 2x2 to 4x4 transforms. The elements are stored in RowMajor ordering inside the
+///        object, so it never allocates, and all operations are constexpr with loops that are
+///        unrolled at compile time. Element access is not bounds checked.
+///
+///        Convert to and from Matrix to mix fixed and dynamically sized matrices, the arithmetic
+///        operators only accept fixed matrices of matching dimensions.
+template<class T, size_t Rows, size_t Columns>
+class FixedMatrix
+{
+    static_assert(Rows > 0 && Columns > 0, "Fixed matrices must have at least one row and one column.");
+
+public:
+    using ValueType = T;
+
+    /// @brief Returns the identity matrix.
+    static constexpr FixedMatrix ID()
+    {
+        static_assert(Rows == Columns, "The identity matrix is square.");
+
+        FixedMatrix result;
+        unroll<Rows>([&result](auto i) { result._data[i * Columns + i] = static_cast<T>(1); });
+        return result;
+    }
+
+    // Constructors
+
+    /// @brief Sets all elements to zero.
+    constexpr FixedMatrix() : _data{} {}
+
+    /// @brief Initializes the matrix with the rows of the 2-dimensional initializer list.
+    /// @throws std::invalid_argument if the list is not Rows X Columns.
+    constexpr FixedMatrix(std::initializer_list<std::initializer_list<T>> twoDimList) : _data{}
+    {
+        if (twoDimList.size() != Rows) {
+            throw std::invalid_argument("Fixed matrix initialized with the wrong amount of rows.");
+        }
+
+        size_t i = 0;
+        for (const auto& rowData : twoDimList)
+        {
+            if (rowData.size() != Columns) {
+                throw std::invalid_argument("All rows of a fixed matrix must have Columns elements.");
+            }
+            for (T v : rowData) {
+                _data[i++] = v;
+            }
+        }
+    }
+
+    /// @brief Copies the elements of the matrix or view.
+    /// @throws std::invalid_argument if it is not Rows X Columns.
+    explicit FixedMatrix(MatrixView<const T> matrix) : _data{}
+    {
+        if (matrix.GetHeight() != Rows || matrix.GetWidth() != Columns) {
+            throw std::invalid_argument("Mismatching matrix dimensions for the conversion to a fixed matrix.");
+        }
+
+        const Gemm::Strides strides = matrix.GetStrides();
+        for (size_t r = 0; r < Rows; ++r) {
+            for (size_t c = 0; c < Columns; ++c) {
+                _data[r * Columns + c] = matrix.Data()[r * strides.Row + c * strides.Col];
+            }
+        }
+    }
+
+    /// @brief Returns a Matrix with the same elements, saved with the given ordering.
+    Matrix<T> ToMatrix(typename Matrix<T>::Ordering ordering = Matrix<T>::Ordering::RowMajor) const
+    {
+        const Matrix<T> rowMajor(Rows, Columns, std::vector<T>(_data.begin(), _data.end()));
+        return rowMajor.ToOrdering(ordering);
+    }
+
+    explicit operator Matrix<T>() const { return ToMatrix(); }
+
+    // Getters
+
+    static constexpr size_t GetWidth()  { return Columns; }
+    static constexpr size_t GetHeight() { return Rows; }
+
+    constexpr T&       operator()(size_t row, size_t col)       { return _data[row * Columns + col]; }
+    constexpr const T& operator()(size_t row, size_t col) const { return _data[row * Columns + col]; }
+
+    /// @brief The Rows * Columns elements in RowMajor ordering.
+    constexpr T*       Data()       { return _data.data(); }
+    constexpr const T* Data() const { return _data.data(); }
+
+    // Arithmetic
+
+    constexpr FixedMatrix operator+(const FixedMatrix& rhs) const
+    {
+        FixedMatrix result;
+        unroll<Rows * Columns>([&](auto i) { result._data[i] = static_cast<T>(_data[i] + rhs._data[i]); });
+        return result;
+    }
+
+    constexpr FixedMatrix operator-(const FixedMatrix& rhs) const
+    {
+        FixedMatrix result;
+        unroll<Rows * Columns>([&](auto i) { result._data[i] = static_cast<T>(_data[i] - rhs._data[i]); });
+        return result;
+    }
+
+    constexpr FixedMatrix operator*(T factor) const
+    {
+        FixedMatrix result;
+        unroll<Rows * Columns>([&](auto i) { result._data[i] = static_cast<T>(_data[i] * factor); });
+        return result;
+    }
+
+    /// @brief Returns the product of this (lhs) and the rhs matrix. Every element is one
+    ///        unrolled sum of products, added in the order of the inner dimension.
+    template<size_t Width>
+    constexpr FixedMatrix<T, Rows, Width> operator*(const FixedMatrix<T, Columns, Width>& rhs) const
+    {
+        FixedMatrix<T, Rows, Width> result;
+        unroll<Rows * Width>([&](auto i) {
+            constexpr size_t row = decltype(i)::value / Width;
+            constexpr size_t col = decltype(i)::value % Width;
+            result._data[i] = dot<row, col>(rhs, std::make_index_sequence<Columns>());
+        });
+        return result;
+    }
+
+    constexpr FixedMatrix& operator+=(const FixedMatrix& rhs) { return *this = *this + rhs; }
+    constexpr FixedMatrix& operator-=(const FixedMatrix& rhs) { return *this = *this - rhs; }
+    constexpr FixedMatrix& operator*=(T factor) { return *this = *this * factor; }
+
+    /// @brief Replaces this matrix with the product of it and the square rhs matrix.
+    constexpr FixedMatrix& operator*=(const FixedMatrix<T, Columns, Columns>& rhs) { return *this = *this * rhs; }
+
+    constexpr FixedMatrix<T, Columns, Rows> Transpose() const
+    {
+        FixedMatrix<T, Columns, Rows> result;
+        unroll<Rows * Columns>([&](auto i) {
+            result._data[(i % Columns) * Rows + i / Columns] = _data[i];
+        });
+        return result;
+    }
+
+    /// @brief Compares the elements like Matrix::Equals, with a tolerance for floating point types.
+    /// @return true, if all elements are equal, false otherwise.
+    bool Equals(const FixedMatrix& rhs) const
+    {
+        constexpr T realTEpsilonFactor = static_cast<T>(3);
+
+        bool equal = true;
+        unroll<Rows * Columns>([&](auto i) { equal = equal && Math::AreEqual(_data[i], rhs._data[i], realTEpsilonFactor); });
+        return equal;
+    }
+
+    template<class U, size_t R, size_t C>
+    friend class FixedMatrix;
+
+private:
+    /// @brief Calls func(std::integral_constant<size_t, I>) for I = 0, ..., Count - 1, expanded
+    ///        at compile time instead of looping.
+    template<size_t Count, class F>
+    static constexpr void unroll(const F& func)
+    {
+        unroll(func, std::make_index_sequence<Count>());
+    }
+
+    template<class F, size_t... I>
+    static constexpr void unroll(const F& func, std::index_sequence<I...>)
+    {
+        (func(std::integral_constant<size_t, I>()), ...);
+    }
+
+    /// @brief Returns the sum of the products of the row of this matrix and the column of rhs.
+    template<size_t Row, size_t Col, size_t Width, size_t... P>
+    constexpr T dot(const FixedMatrix<T, Columns, Width>& rhs, std::index_sequence<P...>) const
+    {
+        return static_cast<T>((... + (_data[Row * Columns + P] * rhs._data[P * Width + Col])));
+    }
+
+private:
+    std::array<T, Rows * Columns> _data;
+
+};
+
+
+template<class T, size_t Rows, size_t Columns> constexpr FixedMatrix<T, Rows, Columns>
+operator*(T factor, const FixedMatrix<T, Rows, Columns>& mat)
+{
+    return mat * factor;
+}
+
+template<class T, size_t Rows, size_t Columns> bool
+operator==(const FixedMatrix<T, Rows, Columns>& lhs, const FixedMatrix<T, Rows, Columns>& rhs)
+{
+    return lhs.Equals(rhs);
+}
+
+template<class T, size_t Rows, size_t Columns> std::ostream&
+operator<<(std::ostream& out, const FixedMatrix<T, Rows, Columns>& mat)
+{
+    return out << mat.ToMatrix();
+}
+
+
+#endif // FIXED_MATRIX_HPP
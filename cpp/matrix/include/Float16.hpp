@@ -0,0 +1,211 @@
+#ifndef FLOAT16_HPP
+#define FLOAT16_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+
+/// @brief 16 bit floating point element types for matrices that are limited by memory bandwidth.
+///        Both store 16 bits per element and convert to float for every operation: the arithmetic
+///        operators of float apply through the implicit conversion, and the results are rounded
+///        to nearest even when they are assigned back. Matrix kernels load the elements as float
+///        and accumulate in float, see AccumulatorType.
+///
+///        BFloat16 is the upper half of a float: the range of float with 8 significant bits.
+///        Float16 is the IEEE 754 half precision type: 11 significant bits, largest value 65504.
+
+/// @brief Brain floating point, a float with the low 16 bits of the significand truncated.
+class BFloat16
+{
+public:
+    /// @brief Uninitialized, value initialization sets the value to zero.
+    BFloat16() = default;
+
+    template<typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>
+    BFloat16(U value) : _bits(fromFloat(static_cast<float>(value))) {}
+
+    operator float() const
+    {
+        const uint32_t bits = static_cast<uint32_t>(_bits) << 16;
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static constexpr BFloat16 FromBits(uint16_t bits) { return BFloat16(bits, 0); }
+    constexpr uint16_t Bits() const { return _bits; }
+
+    BFloat16& operator+=(float rhs) { return *this = *this + rhs; }
+    BFloat16& operator-=(float rhs) { return *this = *this - rhs; }
+    BFloat16& operator*=(float rhs) { return *this = *this * rhs; }
+    BFloat16& operator/=(float rhs) { return *this = *this / rhs; }
+
+private:
+    constexpr BFloat16(uint16_t bits, int) : _bits(bits) {}
+
+    static uint16_t fromFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        if ((bits & 0x7FFFFFFF) > 0x7F800000) { // NaN, keep it quiet when the payload is truncated
+            return static_cast<uint16_t>((bits >> 16) | 0x40);
+        }
+
+        // Round to nearest even: add half of the dropped bits, and the lowest kept bit for ties.
+        bits += 0x7FFF + ((bits >> 16) & 1);
+        return static_cast<uint16_t>(bits >> 16);
+    }
+
+private:
+    uint16_t _bits;
+};
+
+
+/// @brief IEEE 754 binary16, half precision.
+class Float16
+{
+public:
+    /// @brief Uninitialized, value initialization sets the value to zero.
+    Float16() = default;
+
+    template<typename U, typename = std::enable_if_t<std::is_arithmetic_v<U>>>
+    Float16(U value) : _bits(fromFloat(static_cast<float>(value))) {}
+
+    operator float() const
+    {
+        const uint32_t sign     = static_cast<uint32_t>(_bits & 0x8000) << 16;
+        const uint32_t exponent = (_bits >> 10) & 0x1F;
+        uint32_t mantissa       = _bits & 0x3FF;
+
+        uint32_t bits;
+        if (exponent == 0x1F) { // Infinity or NaN
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        } else if (exponent != 0) {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        } else if (mantissa == 0) {
+            bits = sign;
+        } else
+        { // Subnormal, normalized for float
+            uint32_t floatExponent = 127 - 14;
+            while ((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                --floatExponent;
+            }
+            bits = sign | (floatExponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static constexpr Float16 FromBits(uint16_t bits) { return Float16(bits, 0); }
+    constexpr uint16_t Bits() const { return _bits; }
+
+    Float16& operator+=(float rhs) { return *this = *this + rhs; }
+    Float16& operator-=(float rhs) { return *this = *this - rhs; }
+    Float16& operator*=(float rhs) { return *this = *this * rhs; }
+    Float16& operator/=(float rhs) { return *this = *this / rhs; }
+
+private:
+    constexpr Float16(uint16_t bits, int) : _bits(bits) {}
+
+    static uint16_t fromFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const uint32_t sign = (bits >> 16) & 0x8000;
+        bits &= 0x7FFFFFFF;
+
+        uint32_t half;
+        if (bits >= 0x7F800000) { // Infinity or NaN, NaNs stay quiet NaNs
+            half = 0x7C00 | (bits > 0x7F800000 ? 0x200 | ((bits >> 13) & 0x3FF) : 0);
+        } else if (bits >= 0x477FF000) { // Rounds to more than 65504
+            half = 0x7C00;
+        } else if (bits >= 0x38800000) { // Normal, rebias the exponent and round the 13 dropped bits to nearest even
+            half = (bits + 0xFFF + ((bits >> 13) & 1) - ((127 - 15) << 23)) >> 13;
+        } else if (bits > 0x33000000)
+        { // Subnormal, the significand with its implicit bit shifted to units of 2^-24
+            const uint32_t shift     = 126 - (bits >> 23);
+            const uint32_t mantissa  = (bits & 0x7FFFFF) | 0x800000;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway   = 1u << (shift - 1);
+            half = (mantissa >> shift) + (remainder > halfway || (remainder == halfway && ((mantissa >> shift) & 1)));
+        } else { // Rounds to zero
+            half = 0;
+        }
+
+        return static_cast<uint16_t>(sign | half);
+    }
+
+private:
+    uint16_t _bits;
+};
+
+
+/// @brief The type the elements of type T are accumulated in by the matrix kernels: float for
+///        the 16 bit types, T itself otherwise.
+template<typename T> struct Accumulator { using Type = T; };
+template<> struct Accumulator<BFloat16> { using Type = float; };
+template<> struct Accumulator<Float16>  { using Type = float; };
+
+template<typename T>
+using AccumulatorType = typename Accumulator<T>::Type;
+
+/// @brief True for BFloat16 and Float16.
+template<typename T>
+inline constexpr bool IsFloat16 = std::is_same_v<T, BFloat16> || std::is_same_v<T, Float16>;
+
+
+namespace std
+{
+    template<> class numeric_limits<BFloat16>
+    {
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed      = true;
+        static constexpr bool is_integer     = false;
+        static constexpr bool is_exact       = false;
+        static constexpr bool has_infinity   = true;
+        static constexpr bool has_quiet_NaN  = true;
+        static constexpr bool is_iec559      = false;
+        static constexpr int  digits         = 8;
+        static constexpr int  radix          = 2;
+
+        static constexpr BFloat16 min()           { return BFloat16::FromBits(0x0080); } // 2^-126
+        static constexpr BFloat16 max()           { return BFloat16::FromBits(0x7F7F); }
+        static constexpr BFloat16 lowest()        { return BFloat16::FromBits(0xFF7F); }
+        static constexpr BFloat16 epsilon()       { return BFloat16::FromBits(0x3C00); } // 2^-7
+        static constexpr BFloat16 infinity()      { return BFloat16::FromBits(0x7F80); }
+        static constexpr BFloat16 quiet_NaN()     { return BFloat16::FromBits(0x7FC0); }
+    };
+
+    template<> class numeric_limits<Float16>
+    {
+    public:
+        static constexpr bool is_specialized = true;
+        static constexpr bool is_signed      = true;
+        static constexpr bool is_integer     = false;
+        static constexpr bool is_exact       = false;
+        static constexpr bool has_infinity   = true;
+        static constexpr bool has_quiet_NaN  = true;
+        static constexpr bool is_iec559      = true;
+        static constexpr int  digits         = 11;
+        static constexpr int  radix          = 2;
+
+        static constexpr Float16 min()            { return Float16::FromBits(0x0400); } // 2^-14
+        static constexpr Float16 max()            { return Float16::FromBits(0x7BFF); } // 65504
+        static constexpr Float16 lowest()         { return Float16::FromBits(0xFBFF); }
+        static constexpr Float16 epsilon()        { return Float16::FromBits(0x1400); } // 2^-10
+        static constexpr Float16 infinity()       { return Float16::FromBits(0x7C00); }
+        static constexpr Float16 quiet_NaN()      { return Float16::FromBits(0x7E00); }
+    };
+
+} // end namespace std
+
+
+#endif // FLOAT16_HPP
@@ -0,0 +1,215 @@
+#ifndef GEMM_HPP
+#define GEMM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// @brief Low level general matrix multiplication (GEMM) routines operating on raw
+///        buffers. The Matrix class resolves its ordering into element strides once
+///        per operation and delegates the actual computation to these routines.
+namespace Gemm
+{
+    /// @brief Describes how a matrix is laid out in memory. Element (row, col) is
+    ///        located at offset row * Row + col * Col from the start of the buffer.
+    struct Strides
+    {
+        size_t Row;
+        size_t Col;
+    };
+
+    /// @brief Describes how a batch of matrices of the same shape is laid out in memory. Element
+    ///        (row, col) of matrix i is located at offset i * Batch + row * Row + col * Col.
+    struct BatchStrides
+    {
+        size_t Batch;
+        size_t Row;
+        size_t Col;
+
+        /// @brief Matrices stored one after the other, batchStride elements apart, each with the
+        ///        given element strides.
+        static constexpr BatchStrides Strided(size_t batchStride, Strides strides)
+        {
+            return { batchStride, strides.Row, strides.Col };
+        }
+
+        /// @brief The same element of all count matrices stored next to each other: element
+        ///        (row, col) of matrix i is at offset (row * strides.Row + col * strides.Col) * count + i.
+        static constexpr BatchStrides Interleaved(size_t count, Strides strides)
+        {
+            return { 1, strides.Row * count, strides.Col * count };
+        }
+    };
+
+    /// @brief Cache block sizes used by the blocked multiplication. The blocks are
+    ///        chosen so that a KC x NC panel of the rhs stays resident in L3, a
+    ///        MC x KC block of the lhs stays resident in L2 and a KC x NR sliver of
+    ///        the rhs stays resident in L1 while the register tiles are computed.
+    ///        The register tile dimensions (MR x NR) depend on the instruction set
+    ///        selected at runtime, see Simd::Kernels.
+    template<typename T>
+    struct BlockSizes
+    {
+        inline constexpr static size_t KC = 256;
+        inline constexpr static size_t MC = (128 * 1024) / (KC * sizeof(T));
+        inline constexpr static size_t NC = 4096;
+    };
+
+    /// @brief The blocks of the 8 bit products of MultiplyQuantized. A multiply-add reads a
+    ///        quarter of the bytes of float, so the blocks are twice as deep in the same caches,
+    ///        which halves the passes over the int32 elements of C.
+    template<>
+    struct BlockSizes<int8_t>
+    {
+        inline constexpr static size_t KC = 512;
+        inline constexpr static size_t MC = (128 * 1024) / KC;
+        inline constexpr static size_t NC = 4096;
+    };
+
+    /// @brief Splits an m x n x k product into a grid of Rows x Columns tiles of C, each computed
+    ///        as the sum of Depth partial products over disjoint ranges of the inner dimension.
+    struct Partition
+    {
+        size_t Rows;
+        size_t Columns;
+        size_t Depth;
+
+        size_t Tiles() const { return Rows * Columns * Depth; }
+
+        /// @brief Returns the first index of part i of extent elements split into parts.
+        ///        Inner boundaries are rounded down to a multiple of grain, so that the tiles
+        ///        are made of whole register tiles or cache blocks.
+        static size_t Bound(size_t extent, size_t parts, size_t i, size_t grain);
+    };
+
+    /// @brief Plans the partition of an m x n x k product into at most tasks tiles of at least
+    ///        minOperationsPerTask multiply-adds each. The number of tasks is factored into primes
+    ///        which are assigned one at a time to the dimension with the largest extent per tile,
+    ///        so that tall-skinny and short-wide products are split along their long side.
+    ///        The inner dimension is only split when the tiles of C would become thinner than
+    ///        a cache block, since its partial products must be reduced afterwards.
+    Partition
+    PlanPartition(size_t m, size_t n, size_t k, size_t tasks, size_t minOperationsPerTask);
+
+    /// @brief Computes C = alpha * A * B + beta * C using a cache blocked algorithm with
+    ///        register tiling. A is of dimensions m x k, B is of dimensions k x n and C of m x n.
+    ///        Blocks of A and B are packed into contiguous panels before they are
+    ///        multiplied, so the speed does not depend on the strides of the operands.
+    ///        The computation is serial, parallelism is handled by the caller by
+    ///        computing the tiles of a Partition.
+    /// @param a Pointer to the first element of A.
+    /// @param as Element strides of A.
+    /// @param b Pointer to the first element of B.
+    /// @param bs Element strides of B.
+    /// @param beta Scale of the existing values of C. If zero, C is not read and may be uninitialized.
+    /// @param c Pointer to the first element of C.
+    /// @param cs Element strides of C.
+    template<typename T> void
+    Multiply(
+        size_t m, size_t n, size_t k,
+        T alpha,
+        const T* a, Strides as,
+        const T* b, Strides bs,
+        T beta,
+        T* c, Strides cs
+    );
+
+    /// @brief Computes C = A * B, all elements of C are overwritten.
+    template<typename T> inline void
+    Multiply(
+        size_t m, size_t n, size_t k,
+        const T* a, Strides as,
+        const T* b, Strides bs,
+        T* c, Strides cs)
+    {
+        Multiply<T>(m, n, k, static_cast<T>(1), a, as, b, bs, static_cast<T>(0), c, cs);
+    }
+
+    /// @brief The largest inner dimension for which the products of MultiplyQuantized are exact:
+    ///        every product of an unsigned and a signed byte is at most 255 * 128 in magnitude.
+    inline constexpr size_t MAX_QUANTIZED_DEPTH = 65793;
+
+    /// @brief Computes C = A * B for 8 bit integer matrices, with the products summed exactly in
+    ///        int32, see Simd::QuantizedKernels. A is of dimensions m x k, B of k x n and C of m x n.
+    ///        Blocks of A and B are packed into groups of Simd::QUANTIZED_GROUP elements of the
+    ///        inner dimension. Signed elements of A are packed with an offset of 128, so that all
+    ///        products are of an unsigned and a signed byte, and the offset times the column sums
+    ///        of B is subtracted from C. The computation is serial.
+    /// @tparam L must be uint8_t or int8_t.
+    /// @param k must be at most MAX_QUANTIZED_DEPTH.
+    /// @param c All elements of C are overwritten.
+    template<typename L> void
+    MultiplyQuantized(
+        size_t m, size_t n, size_t k,
+        const L* a, Strides as,
+        const int8_t* b, Strides bs,
+        int32_t* c, Strides cs
+    );
+
+    /// @brief Returns the default recursion cutoff of Strassen for the instruction set selected
+    ///        at runtime. The faster the classic kernel, the larger the blocks must be before
+    ///        trading one multiplication of half the size for the extra additions pays off.
+    template<typename T> size_t
+    StrassenCutoff();
+
+    /// @brief Returns the coefficient g of the normwise error bound of Strassen for an n x n x n
+    ///        product with recursion cutoff n0: max|C - fl(C)| <= g * max|A| * max|B|. See Strassen.
+    template<typename T> double
+    StrassenErrorBound(size_t n, size_t cutoff);
+
+    /// @brief Computes C = A * B with the Strassen-Winograd variant of Strassen's algorithm:
+    ///        seven products of half the size per level, recursing until a dimension is at
+    ///        or below the cutoff and then using the classic kernel. Odd dimensions are
+    ///        handled by peeling the last row, column or inner index off and fixing the
+    ///        result up with the classic kernel.
+    ///
+    ///        Strassen type algorithms are not stable elementwise, only normwise. For a
+    ///        square product of size n = 2^r * n0 the error is bounded (Higham, Accuracy and
+    ///        Stability of Numerical Algorithms, 2nd ed., Thm. 23.3) by
+    ///            max|C - fl(C)| <= [(n / n0)^log2(18) * (n0^2 + 6 * n0) - 6 * n] * u * max|A| * max|B|
+    ///        to first order in the unit roundoff u, which is 2^-24 for float and 2^-53 for
+    ///        double. The bound grows as n^4.17 instead of n^2 for the classic algorithm (per
+    ///        element n * u * sum|a_ik||b_kj|), e.g. for n = 4096 and n0 = 256 it is about
+    ///        7e9 * u: ~8e-7 for double but ~4e2 for float. Observed errors are usually orders
+    ///        of magnitude smaller, but float should only be used when that is acceptable.
+    /// @param cutoff Recursion stops when any dimension is <= cutoff. Must be at least 1.
+    /// @param parallel If true, the seven products of the top level are computed in parallel
+    ///                 on the ThreadPool. Must be false if called from a worker thread.
+    template<typename T> void
+    Strassen(
+        size_t m, size_t n, size_t k,
+        const T* a, Strides as,
+        const T* b, Strides bs,
+        T* c, Strides cs,
+        size_t cutoff,
+        bool parallel
+    );
+
+    /// @brief The smallest dimension from which batched products use the blocked Multiply.
+    inline constexpr size_t BATCH_BLOCKED_MIN = 16;
+
+    /// @brief Computes C_i = alpha * A_i * B_i + beta * C_i for the count matrices of a batch of
+    ///        independent m x k by k x n products. Small products are computed for a group of
+    ///        matrices at once, vectorized across the batch: one vector holds the same element of
+    ///        several matrices. Interleaved batches are read in place, other batches are packed
+    ///        into interleaved groups first. Products with all dimensions of at least
+    ///        BATCH_BLOCKED_MIN use the blocked Multiply for every matrix instead.
+    ///        The batch is split into slices of at least minOperationsPerTask multiply-adds that
+    ///        run in parallel if the ThreadPool is started.
+    /// @param beta Scale of the existing values of C. If zero, C is not read and may be uninitialized.
+    template<typename T> void
+    MultiplyBatched(
+        size_t count,
+        size_t m, size_t n, size_t k,
+        T alpha,
+        const T* a, BatchStrides as,
+        const T* b, BatchStrides bs,
+        T beta,
+        T* c, BatchStrides cs,
+        size_t minOperationsPerTask
+    );
+
+} // end namespace Gemm
+
+
+#endif // GEMM_HPP
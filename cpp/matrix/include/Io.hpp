@@ -1,6 +1,10 @@
 #ifndef IO_HPP
 #define IO_HPP
 
+#include "Float16.hpp"
+#include "Matrix.hpp"
+
+#include <cstdint>
 #include <string_view>
 #include <string>
 #include <vector>
@@ -23,6 +27,147 @@ namespace IO
     std::optional<std::vector<FilePath>> FilesInDirectory(std::string_view path);
 
     std::optional<std::vector<std::string>> ReadLinesTextFile(const std::string& fpath);
+
+
+    /**** Binary matrix files ****/
+
+    /// @brief Element types of binary matrix files, Int32 for int and UInt64 for size_t.
+    enum class DataType : uint32_t { Int32 = 1, UInt64 = 2, Float32 = 3, Float64 = 4, Float16 = 5, BFloat16 = 6 };
+
+    /// @brief Version of the binary matrix files written by WriteMatrixFile.
+    inline constexpr uint32_t MATRIX_FILE_VERSION = 1;
+
+    /// @brief Alignment of the elements in binary matrix files, a page, so that the elements of
+    ///        a mapped file are aligned like the buffers of Memory::Allocate.
+    inline constexpr uint64_t MATRIX_FILE_ALIGNMENT = 4096;
+
+    /// @brief The 64 byte header at the start of a binary matrix file. The elements follow at
+    ///        DataOffset, as Rows X Columns matrix without gaps in the saved ordering. All fields
+    ///        and the elements are saved in the byte order of the writer, which readers detect
+    ///        from ByteOrder.
+    struct MatrixFileHeader
+    {
+        char     Magic[8];      // "MATRIXER"
+        uint32_t Version;       // MATRIX_FILE_VERSION
+        uint32_t ByteOrder;     // 0x01020304
+        uint32_t Type;          // DataType
+        uint32_t ElementSize;   // Bytes of an element
+        uint64_t Rows;
+        uint64_t Columns;
+        uint32_t Ordering;      // 0 RowMajor, 1 ColumnMajor
+        uint32_t Reserved;
+        uint64_t Alignment;     // DataOffset is a multiple of the alignment
+        uint64_t DataOffset;    // Bytes from the start of the file to the first element
+    };
+
+    static_assert(sizeof(MatrixFileHeader) == 64, "The header of binary matrix files is 64 bytes.");
+
+    /// @brief Writes the elements of the matrix or view into a binary matrix file, see
+    ///        MatrixFileHeader. The ordering of the matrix is kept.
+    /// @throws std::system_error if the file can not be written.
+    template<typename T>
+    void WriteMatrixFile(const std::string& fpath, MatrixView<const T> matrix);
+
+    /// @brief Overload for matrices and views of non-const elements.
+    template<class M>
+    void WriteMatrixFile(const std::string& fpath, const M& matrix)
+    {
+        WriteMatrixFile<typename M::ValueType>(fpath, MatrixView<const typename M::ValueType>(matrix));
+    }
+
+    /// @brief Writes the elements of the matrix or view into a numpy .npy file (format version
+    ///        1.0), as 2-dimensional array with fortran_order for ColumnMajor matrices. Numpy has
+    ///        no bfloat16 type, BFloat16 matrices can only be saved as binary matrix files.
+    /// @throws std::system_error if the file can not be written.
+    template<typename T>
+    void WriteNpyFile(const std::string& fpath, MatrixView<const T> matrix);
+
+    /// @brief Overload for matrices and views of non-const elements.
+    template<class M>
+    void WriteNpyFile(const std::string& fpath, const M& matrix)
+    {
+        WriteNpyFile<typename M::ValueType>(fpath, MatrixView<const typename M::ValueType>(matrix));
+    }
+
+    /// @brief Read only view of the elements of a binary matrix file or of a .npy file, mapped
+    ///        into memory instead of read: no elements are copied, and only the pages that are
+    ///        accessed are loaded from the file. The file must not be modified while it is mapped.
+    ///        One dimensional .npy arrays of n elements are viewed as n X 1 matrices.
+    template<typename T>
+    class MappedMatrix
+    {
+    public:
+        /// @throws std::system_error if the file can not be opened or mapped.
+        /// @throws std::runtime_error if the file is not a binary matrix file or a .npy file of
+        ///         elements of type T in the byte order of this machine.
+        explicit MappedMatrix(const std::string& fpath);
+        ~MappedMatrix();
+
+        MappedMatrix(MappedMatrix&& other) noexcept;
+        MappedMatrix& operator=(MappedMatrix&& other) noexcept;
+
+        MappedMatrix(const MappedMatrix& other) = delete;
+        MappedMatrix& operator=(const MappedMatrix& other) = delete;
+
+        /// @brief Returns the view of the elements, it is valid as long as this mapping.
+        MatrixView<const T> View() const { return _view; }
+
+        size_t GetWidth()  const { return _view.GetWidth(); }
+        size_t GetHeight() const { return _view.GetHeight(); }
+
+    private:
+        void*               _address;
+        size_t              _bytes;
+        MatrixView<const T> _view;
+    };
+
+    /// @brief Returns a Matrix with a copy of the elements of a binary matrix file or of a .npy
+    ///        file, with the ordering of the file.
+    /// @throws see MappedMatrix.
+    template<typename T>
+    Matrix<T> ReadMatrixFile(const std::string& fpath);
+
+
+    /**** Text matrix files ****/
+
+    /// @brief Returns the RowMajor matrix saved as text like numpy.savetxt does: one row per line,
+    ///        the elements separated by spaces or tabs. Empty lines and everything after a '#' are
+    ///        skipped. The text is split into chunks at line boundaries that are parsed in parallel
+    ///        with std::from_chars, directly into the elements of the matrix.
+    /// @throws std::runtime_error if the rows have different amounts of elements, or if an element
+    ///         is not a number of type T.
+    template<typename T>
+    Matrix<T> ParseTextMatrix(std::string_view text);
+
+    /// @brief Maps the file into memory and parses it with ParseTextMatrix.
+    /// @throws std::system_error if the file can not be opened or mapped.
+    /// @throws std::runtime_error if the file is empty or see ParseTextMatrix.
+    template<typename T>
+    Matrix<T> ReadTextMatrix(const std::string& fpath);
+
+
+    /**** Out-of-core products ****/
+
+    /// @brief Default memory budget of MultiplyMatrixFiles, in bytes.
+    inline constexpr size_t STREAMING_MEMORY_BUDGET = static_cast<size_t>(1) << 30;
+
+    /// @brief Computes C = A * B for matrices saved in binary matrix files or .npy files that can
+    ///        be larger than the memory, and writes C into the binary matrix file cPath in RowMajor
+    ///        ordering. C is computed tile by tile: a tile is accumulated in memory from blocks of
+    ///        A and B read from their files, and written to cPath when it is complete. The blocks
+    ///        of the next step are read on a worker of the ThreadPool while the current blocks are
+    ///        multiplied, so reading overlaps the computation if the pool is started.
+    ///        The tile and two sets of blocks are sized to fit into memoryBudget bytes, the memory
+    ///        in use does not depend on the dimensions of the matrices. cPath must not be the path
+    ///        of A or B.
+    /// @throws std::invalid_argument if the dimensions of A and B do not match, or if the budget
+    ///         is too small for blocks of a single row and column.
+    /// @throws std::system_error if a file can not be opened, read or written.
+    /// @throws std::runtime_error if A or B is not a binary matrix file or a .npy file of elements of type T.
+    template<typename T>
+    void MultiplyMatrixFiles(const std::string& aPath, const std::string& bPath, const std::string& cPath,
+                             size_t memoryBudget = STREAMING_MEMORY_BUDGET);
+
 } // end namespace IO
 
 #endif // IO_HPP
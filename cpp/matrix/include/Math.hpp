@@ -1,11 +1,15 @@
 #ifndef MATH_HPP
 #define MATH_HPP
 
+#include <cstddef>
+#include <cstdint>
+
 
 namespace Math
 {
     /// @brief Compares two values of type T for equality.
-    /// @tparam T must be one of float, double, int or size_t.
+    /// @tparam T must be one of float, double, BFloat16, Float16, int or size_t. The 16 bit
+    ///         types are compared in float, with their own epsilon.
     /// @param val1 value to compare.
     /// @param val2 value to compare.
     /// @param realTypeToleranceFactor Factor to set tolerance, default value is 1. This factor is used to multiplicate std::numeric_limits<T>::epsilon() for RealTypes.
@@ -32,6 +36,43 @@ namespace Random
     template<typename T> T
     Fast(T minInclusive = static_cast<T>(0), T maxInclusive = static_cast<T>(1));
 
+    /// @brief Counter-based pseudo-random generator Philox4x32-10 (Salmon et al., "Parallel Random
+    ///        Numbers: As Easy as 1, 2, 3", SC 2011). Every 128 bit counter is encrypted into four
+    ///        random words by ten rounds of multiplications keyed with the seed, so the value of
+    ///        element i of a sequence depends only on the seed, the stream and i. Any range of a
+    ///        sequence is generated directly, without generating the values before it, which
+    ///        makes parallel generation reproducible for any amount of threads. The blocks are
+    ///        computed by the vector kernels of Simd::RandomKernels.
+    class Philox
+    {
+    public:
+        /// @param seed The key of the generator.
+        /// @param stream Selects one of 2^64 independent sequences of the same seed, the upper
+        ///               half of the counters.
+        explicit Philox(uint64_t seed, uint64_t stream = 0);
+
+        uint64_t GetSeed()   const;
+        uint64_t GetStream() const;
+
+        /// @brief Writes the random words of the groups [firstGroup, firstGroup + groups) of
+        ///        Simd::PHILOX_LANES counters, 4 * Simd::PHILOX_LANES words per group, see
+        ///        Simd::RandomKernels for their order. Word j of the sequence is word j % 64 of group j / 64.
+        void Generate(uint64_t firstGroup, size_t groups, uint32_t* out) const;
+
+        /// @brief Writes the elements [first, first + n) of the sequence of uniformly distributed
+        ///        values in [minInclusive, maxInclusive] to out. Element i is made of word i of the
+        ///        sequence, or of the words 2i and 2i + 1 for double and size_t: 24 (float and the
+        ///        16 bit types) or 53 (double) random bits scaled to the range, or the words
+        ///        reduced to the range for integers, with a bias of at most range / 2^32.
+        /// @tparam T must be one of float, double, BFloat16, Float16, int or size_t.
+        template<typename T> void
+        Fill(T* out, size_t n, uint64_t first, T minInclusive, T maxInclusive) const;
+
+    private:
+        uint64_t _seed;
+        uint64_t _stream;
+    };
+
 } // end namespace Random
 
 
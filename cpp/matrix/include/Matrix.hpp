@@ -1,18 +1,34 @@
 #ifndef MATRIX_HPP
 #define MATRIX_HPP
 
+#include "Gemm.hpp"
+#include "MatrixExpression.hpp"
+#include "Memory.hpp"
+
 #include <array>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 
 template<class T>
-class Matrix
+class MatrixView;
+
+template<class T>
+class SparseMatrix;
+
+
+/// @brief Dense matrix. The arithmetic operators +, - and * (and scaling by a scalar) are
+///        declared in MatrixExpression.hpp and evaluate lazily, see MatrixExpression.
+template<class T>
+class Matrix : public MatrixExpression::Expression<Matrix<T>>
 {
 public:
+    using ValueType = T;
 
     // The minimum number of assignments that should be distributed to
     // any given thread.
@@ -74,14 +90,35 @@ public:
         Matrix::Ordering ordering = Matrix::Ordering::RowMajor
     );
 
+    /// @brief Returns a matrix of uniformly distributed values in [minInclusive, maxInclusive]
+    ///        generated by Random::Philox with the seed, see Random::Philox::Fill. Element i of
+    ///        the data array is element i of the sequence of the seed, so the matrix only depends
+    ///        on the seed, the dimensions and the ordering. The data array is filled in parallel
+    ///        if the ThreadPool is started, with the same result for any amount of threads.
+    static Matrix Random(
+        size_t rows,
+        size_t columns,
+        T minInclusive,
+        T maxInclusive,
+        uint64_t seed,
+        Matrix::Ordering ordering = Matrix::Ordering::RowMajor
+    );
+
     // Constructors
 
     Matrix() = delete;
-    Matrix(Matrix&& other) = delete; // move ctor
-    Matrix& operator=(const Matrix& other) = delete; // assignment ctor
 
     Matrix(const Matrix& other); // copy ctor
 
+    /// @brief Takes over the data of the other matrix, which is left empty with dimensions 0 X 0.
+    Matrix(Matrix&& other) noexcept; // move ctor
+
+    /// @brief Copies the other matrix, reusing the data buffer if the amount of elements is equal.
+    Matrix& operator=(const Matrix& other);
+
+    /// @brief Takes over the data of the other matrix, which is left empty with dimensions 0 X 0.
+    Matrix& operator=(Matrix&& other) noexcept;
+
     /// @brief Sets all elements to default value of zero.
     Matrix(
         size_t rows,
@@ -110,6 +147,15 @@ public:
         Matrix::Ordering ordering = Matrix::Ordering::RowMajor
     );
 
+    /// @brief Initializes a new matrix by taking ownership of the buffer, e.g. one returned by Memory::Allocate.
+    /// @param data A buffer holding the data the matrix should be initialized with.
+    Matrix(
+        size_t rows,
+        size_t columns,
+        Memory::Buffer<T>&& data,
+        Matrix::Ordering ordering = Matrix::Ordering::RowMajor
+    );
+
     /// @brief Initializes a new matrix object with the data in the 2-dimensional initializer list.
     /// @param twoDimList 2d array holding the values of the matrix.
     /// @param ordering How the matrix should be saved in memory. Defaults to RowMajor ordering.
@@ -118,6 +164,72 @@ public:
         Matrix::Ordering ordering = Matrix::Ordering::RowMajor
     );
 
+    /// @brief Initializes a new matrix with the value of the expression. Elementwise expressions
+    ///        are saved with the ordering of their leftmost operand, products in RowMajor ordering.
+    template<class E>
+    Matrix(const MatrixExpression::Expression<E>& expr)
+        : Matrix(expr.Self().GetHeight(), expr.Self().GetWidth(), uninitialized(expr.Self().GetHeight() * expr.Self().GetWidth()), expr.Self().GetOrdering())
+    {
+        MatrixExpression::Terms<T> terms;
+        MatrixExpression::Collect(expr.Self(), static_cast<T>(1), terms);
+        assign(terms);
+    }
+
+    /// @brief Evaluates the expression into this matrix. The expression may reference this matrix,
+    ///        e.g. C = A * B + C is computed by accumulating into C. If the dimensions are equal the
+    ///        data buffer and the ordering are kept, otherwise the matrix is replaced by a new one.
+    template<class E>
+    Matrix& operator=(const MatrixExpression::Expression<E>& expr)
+    {
+        if (expr.Self().GetHeight() != GetHeight() || expr.Self().GetWidth() != GetWidth()) {
+            return *this = Matrix(expr);
+        }
+
+        MatrixExpression::Terms<T> terms;
+        MatrixExpression::Collect(expr.Self(), static_cast<T>(1), terms);
+        assign(terms);
+        return *this;
+    }
+
+    /// @brief Adds the value of the expression to this matrix in place.
+    /// @throws std::invalid_argument if the dimensions of the expression differ from this matrix.
+    template<class E>
+    Matrix& operator+=(const MatrixExpression::Expression<E>& expr)
+    {
+        return *this = *this + expr.Self();
+    }
+
+    /// @brief Subtracts the value of the expression from this matrix in place.
+    /// @throws std::invalid_argument if the dimensions of the expression differ from this matrix.
+    template<class E>
+    Matrix& operator-=(const MatrixExpression::Expression<E>& expr)
+    {
+        return *this = *this - expr.Self();
+    }
+
+    /// @brief Multiplies all elements of this matrix with the factor in place.
+    Matrix& operator*=(T factor);
+
+    /// @brief Replaces this (lhs) matrix with the product of it and the rhs matrix. If rhs is square
+    ///        the product is computed in place, block of rows by block of rows, through a scratch
+    ///        buffer of at most 128 rows from the current allocator. Otherwise, or if rhs is this
+    ///        matrix, the product is computed into a new matrix.
+    /// @throws std::invalid_argument if the width of this matrix differs from the height of rhs.
+    Matrix& operator*=(const Matrix<T>& rhs);
+
+    /// @brief Returns the transpose of this matrix, saved with the same ordering.
+    Matrix Transpose() const;
+
+    /// @brief Replaces this matrix with its transpose, keeping the ordering. Square matrices are
+    ///        transposed in place, other shapes are transposed into a new data buffer.
+    void TransposeInPlace();
+
+    /// @brief Returns a copy of this matrix saved with the given ordering.
+    Matrix ToOrdering(Matrix::Ordering ordering) const;
+
+    /// @brief Exchanges the dimensions, orderings and data buffers of this and the other matrix.
+    void Swap(Matrix& other) noexcept;
+
     size_t GetWidth()  const;
     size_t GetHeight() const;
     Matrix::Ordering GetOrdering() const;
@@ -125,25 +237,68 @@ public:
     Matrix::Reference operator[](size_t row);
     const Matrix::ConstReference operator[](size_t row) const;
 
-    /// @brief Multiplicates this (lhs) matrix with the rhs matrix and returns a new matrix holding the results.
-    /// @return The computed matrix.
-    Matrix operator*(const Matrix<T>& rhs) const;
+    /// @brief Returns a view of all elements, see MatrixView. Views are invalidated when the
+    ///        matrix is assigned a value of other dimensions.
+    MatrixView<T> View();
+    MatrixView<const T> View() const;
 
-    /// @brief Adds the rhs matrix to this (lhs) matrix and returns a new matrix holding the results.
-    /// @return The computed matrix.
-    Matrix operator+(const Matrix<T>& rhs) const;
+    /// @brief Returns views of a row, a column and a rows X columns block starting at (row, col).
+    /// @throws std::out_of_range if the slice is outside of the matrix.
+    MatrixView<T> Row(size_t row);
+    MatrixView<const T> Row(size_t row) const;
+    MatrixView<T> Column(size_t col);
+    MatrixView<const T> Column(size_t col) const;
+    MatrixView<T> Block(size_t row, size_t col, size_t rows, size_t columns);
+    MatrixView<const T> Block(size_t row, size_t col, size_t rows, size_t columns) const;
 
-    /// @brief Subtracts the rhs matrix from this (lhs) matrix and returns a new matrix holding the results.
+    /// @brief Multiplicates this (lhs) matrix with the rhs matrix and returns a new matrix holding the results.
+    ///        The operands may have any combination of orderings.
+    /// @param resultOrdering How the computed matrix should be saved in memory.
     /// @return The computed matrix.
-    Matrix operator-(const Matrix<T>& rhs) const;
-
-    /// @brief Compares this matrix with the rhs matrix.
+    Matrix Multiply(const Matrix<T>& rhs, Matrix::Ordering resultOrdering) const;
+
+    /// @brief Multiplicates this (lhs) matrix with the rhs matrix using the Strassen-Winograd
+    ///        algorithm and returns a new RowMajor matrix holding the results. The seven
+    ///        products of the top level are computed in parallel if the ThreadPool is started.
+    ///        The result is only normwise accurate, see Gemm::Strassen for the error bounds.
+    /// @param cutoff Recursion stops at blocks with a dimension <= cutoff, which are multiplied
+    ///               with the classic kernel. Zero selects the default for the running CPU.
+    /// @return The computed matrix.
+    Matrix MultiplyStrassen(const Matrix<T>& rhs, size_t cutoff = 0) const;
+
+    /// @brief Returns the inverse of this square matrix in RowMajor ordering, computed from its
+    ///        LuDecomposition. Only available for float and double, see Decomposition.hpp.
+    ///        Factor the matrix with LuDecomposition to solve linear systems instead of
+    ///        multiplying with the inverse, which is faster and more accurate.
+    /// @throws std::invalid_argument if the matrix is not square.
+    /// @throws std::runtime_error if the matrix is singular.
+    Matrix Inverse() const;
+
+    /// @brief Returns the determinant of this square matrix, computed from its LuDecomposition.
+    ///        Only available for float and double, see Decomposition.hpp.
+    /// @throws std::invalid_argument if the matrix is not square.
+    T Determinant() const;
+
+    /// @brief Compares this matrix with the rhs matrix. The operator== for matrices and
+    ///        expressions is declared in MatrixExpression.hpp and uses this method.
     /// @return true, if all elements are equal, false otherwise.
-    bool operator==(const Matrix<T>& rhs)  const;
+    bool Equals(const Matrix<T>& rhs) const;
 
     template<typename U>
     friend std::ostream& operator<<(std::ostream& out, const Matrix<U>& mat);
 
+    // Sparse matrices read and write the data of their dense operands and results directly.
+    template<typename U>
+    friend class SparseMatrix;
+
+    // Views evaluate expressions assigned to them like matrices.
+    template<typename U>
+    friend class MatrixView;
+
+    // Factorizations update their blocks with the parallel products.
+    template<typename U>
+    friend class Decomposition;
+
 private:
     /// @brief Returns the index in the data array for the requested marix element.
     ///        This index differs for matrices stored in column vs. row major order.
@@ -153,14 +308,44 @@ private:
     size_t getDataIdx(size_t row, size_t col) const;
 
     size_t getDataIdx(size_t row, size_t col, Matrix::Ordering ordering) const;
+
+    /// @brief Returns the element strides of the data array, resolved from the ordering.
+    Gemm::Strides getStrides() const;
     size_t getLength() const;
 
+    /// @brief Dimensions of the data array seen as a row major array: rows X columns for
+    ///        RowMajor matrices and columns X rows for ColumnMajor matrices.
+    size_t physicalRows() const;
+    size_t physicalColumns() const;
+
+    static Memory::Buffer<T> uninitialized(size_t length);
+
+    /// @brief Copies or fills length elements, in parallel if the ThreadPool is started.
+    static void parallelCopy(const T* src, T* dst, size_t length);
+    static void parallelFill(T* dst, size_t length, T value);
+
+    /// @brief Overwrites this matrix with the value of the flattened expression.
+    void assign(const MatrixExpression::Terms<T>& terms);
+
+    /// @brief Overwrites the viewed elements with the value of the flattened expression. Operands
+    ///        that overlap the result without being the result itself are evaluated into a
+    ///        temporary first.
+    static void evaluate(MatrixView<T> result, const MatrixExpression::Terms<T>& terms);
+
+    /// @brief Computes result = sum(Scale_i * Operand_i) in one pass over the result.
+    static void evaluateLinear(MatrixView<T> result, const std::vector<typename MatrixExpression::Terms<T>::Linear>& linears);
+
+    /// @brief Computes C = alpha * A * B + beta * C, in parallel over the tiles of a Gemm::Partition
+    ///        if the ThreadPool is started. Products where one of the dimensions is one use the
+    ///        matrix-vector kernels instead. beta is either zero, in which case C is not read, or one.
+    static void multiplyInto(MatrixView<const T> a, MatrixView<const T> b, T alpha, T beta, MatrixView<T> c);
+
 
 private:
-  const size_t         _rows;
-  const size_t         _columns;
+  size_t               _rows;
+  size_t               _columns;
   Ordering             _ordering;
-  std::unique_ptr<T[]> _data;
+  Memory::Buffer<T>    _data;
 
 };
 
@@ -168,5 +353,15 @@ private:
 template<typename T>
 std::ostream& operator<<(std::ostream& out, const Matrix<T>& mat);
 
+template<typename T> void
+swap(Matrix<T>& lhs, Matrix<T>& rhs) noexcept
+{
+    lhs.Swap(rhs);
+}
+
+
+// Views are complete wherever matrices are, since expressions hold their operands as views.
+#include "MatrixView.hpp"
+
 
 #endif // MATRIX_HPP
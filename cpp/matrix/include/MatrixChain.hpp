@@ -0,0 +1,100 @@
+#ifndef MATRIXCHAIN_HPP
+#define MATRIXCHAIN_HPP
+
+#include "Matrix.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/// @brief Products of chains of matrices, A_0 * A_1 * ... * A_(N-1), in the order of the
+///        products which is fastest for the shapes of the matrices. The order matters: for
+///        A (10^6 x 1000), B (1000 x 10^6) and C (10^6 x 1), A * (B * C) takes 2 * 10^9
+///        multiply-adds and (A * B) * C 10^15, with a 10^12 element intermediate on top.
+///
+///        The order is planned by dynamic programming over the subchains, see MakePlan, and
+///        executed with the parallel products of Matrix. Independent products of the plan, e.g.
+///        A * B and C * D of (A * B) * (C * D), are computed at the same time when they are too
+///        small to keep all threads busy on their own.
+namespace MatrixChain
+{
+    /// @brief One product of a plan. Node i < N is the operand A_i, node N + p the result of
+    ///        product p of the plan.
+    struct Product
+    {
+        size_t Left;
+        size_t Right;
+
+        // The result is Height x Width, Depth is the inner dimension.
+        size_t Height;
+        size_t Width;
+        size_t Depth;
+
+        // The subchains of Left and Right are computed at the same time, each by one thread.
+        bool Concurrent;
+    };
+
+    /// @brief The order of the products of a chain of N matrices.
+    struct Plan
+    {
+        // The N + 1 dimensions of the chain, A_i is Dimensions[i] x Dimensions[i + 1].
+        std::vector<size_t> Dimensions;
+
+        // The N - 1 products in an order of evaluation, the last one is the whole chain.
+        std::vector<Product> Products;
+
+        // The amount of multiply-adds of all products.
+        double Operations;
+
+        // The estimated time in multiply-adds of one thread, with the parallel products.
+        double Time;
+
+        // The most elements of intermediate products that are alive at the same time, the
+        // result included, the operands not.
+        size_t PeakElements;
+
+        /// @brief Returns the parenthesization, e.g. "((A0 A1) (A2 A3))". Concurrent products
+        ///        are joined by '|' instead of ' ', e.g. "((A0 A1)|(A2 A3))".
+        std::string ToString() const;
+    };
+
+    /// @brief Plans the products of a chain of matrices with the given dimensions.
+    ///
+    ///        A product of m x k and k x n matrices takes m * n * k multiply-adds and runs on
+    ///        min(threads, m * n * k / MIN_OPERATIONS_PER_THREAD) threads, like Matrix::Multiply.
+    ///        The plan minimizes the time of the products in this model, in O(N^3): every
+    ///        subchain is either split in two subchains which are computed one after the other,
+    ///        each with all threads, or in two which are computed at the same time, each on one
+    ///        thread. With a single thread the plan has the least multiply-adds.
+    ///
+    ///        Among the splits of a subchain the fastest one whose intermediates fit into
+    ///        maxElements is taken, or the one with the fewest elements if none fits. Since every
+    ///        subchain keeps only its best split, the plan is not guaranteed to fit even if some
+    ///        other order would.
+    /// @param dimensions The N + 1 dimensions of a chain of N matrices.
+    /// @param threads The amount of threads of the products, at least 1.
+    /// @param maxElements The limit of PeakElements, zero for no limit.
+    /// @throws std::invalid_argument if there are fewer than two dimensions or no threads.
+    Plan MakePlan(const std::vector<size_t>& dimensions, size_t threads, size_t maxElements = 0);
+
+    /// @brief Returns the product of the matrices in RowMajor ordering, computed by the plan of
+    ///        their dimensions for the threads of the ThreadPool, see MakePlan. A chain of one
+    ///        matrix returns a copy.
+    /// @param memoryBudget The limit of the intermediates of the plan in bytes, zero for no limit.
+    /// @throws std::invalid_argument if there are no matrices, if a pointer is null or if the
+    ///         dimensions of two neighbours do not match.
+    template<class T> Matrix<T>
+    Multiply(const std::vector<const Matrix<T>*>& matrices, size_t memoryBudget = 0);
+
+    /// @brief Returns first * rest..., see Multiply.
+    template<class T, class... U> Matrix<T>
+    Multiply(const Matrix<T>& first, const U&... rest)
+    {
+        return Multiply<T>(std::vector<const Matrix<T>*>{ &first, &rest... });
+    }
+
+} // end namespace MatrixChain
+
+
+#endif // MATRIXCHAIN_HPP
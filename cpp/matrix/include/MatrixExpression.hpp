@@ -0,0 +1,296 @@
+#ifndef MATRIX_EXPRESSION_HPP
+#define MATRIX_EXPRESSION_HPP
+
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+template<class T>
+class Matrix;
+
+template<class T>
+class MatrixView;
+
+
+/// @brief Expression templates for lazy evaluation of Matrix arithmetic. The operators
+///        +, -, * and scaling by a scalar return lightweight expression nodes instead of
+///        computing a new matrix. When an expression is assigned to a Matrix, its tree is
+///        flattened into a linear combination of matrices and of matrix products,
+///            sum(a_i * M_i) + sum(b_j * L_j * R_j),
+///        which is evaluated in one fused elementwise pass over the result, followed by one
+///        accumulating GEMM per product. No matrix sized temporaries are created, except
+///        for operands of products that are expressions themselves (e.g. (A + B) * C).
+///        Operands are kept as MatrixViews, so views of submatrices are evaluated the same way.
+///
+///        Nodes hold references to the named matrices they are built from, so an expression must
+///        not outlive them and it reads their values at the time it is evaluated. Temporary
+///        matrices, e.g. the result of Matrix::Random, are moved into the node that uses them.
+namespace MatrixExpression
+{
+    /// @brief The flattened form of an expression.
+    template<typename T>
+    struct Terms
+    {
+        struct Linear
+        {
+            T Scale;
+            MatrixView<const T> Operand;
+        };
+
+        struct Product
+        {
+            T Scale;
+            MatrixView<const T> Lhs;
+            MatrixView<const T> Rhs;
+        };
+
+        std::vector<Linear>  Linears;
+        std::vector<Product> Products;
+
+        // Evaluated operands of products that were not plain matrices.
+        std::vector<std::unique_ptr<Matrix<T>>> Temporaries;
+    };
+
+    /// @brief Base class of all expressions (CRTP), including Matrix itself.
+    template<class Derived>
+    struct Expression
+    {
+        const Derived& Self() const { return static_cast<const Derived&>(*this); }
+    };
+
+    template<class E>
+    struct IsMatrix : std::false_type {};
+
+    template<class T>
+    struct IsMatrix<Matrix<T>> : std::true_type {};
+
+    template<class E>
+    struct IsMatrixView : std::false_type {};
+
+    template<class T>
+    struct IsMatrixView<MatrixView<T>> : std::true_type {};
+
+    template<class E>
+    using IsExpression = std::is_base_of<Expression<E>, E>;
+
+    template<class E>
+    using ValueOf = typename std::decay_t<E>::ValueType;
+
+    /// @brief The type an operand, passed as E&&, is stored as in a node. Named (lvalue) matrices
+    ///        are stored by reference, temporary matrices, views and other nodes by value.
+    template<class E>
+    using Operand = std::conditional_t<IsMatrix<std::decay_t<E>>::value && std::is_lvalue_reference_v<E>,
+                                       const std::decay_t<E>&, std::decay_t<E>>;
+
+    /// @brief Enables the operators only if both operands are expressions.
+    template<class L, class R>
+    using EnableIfExpressions = std::enable_if_t<IsExpression<std::decay_t<L>>::value && IsExpression<std::decay_t<R>>::value>;
+
+    /// @brief Appends the terms of the expression, multiplied by scale, to terms.
+    template<class E, typename T> void
+    Collect(const E& expr, T scale, Terms<T>& terms)
+    {
+        if constexpr (IsMatrix<E>::value) {
+            terms.Linears.push_back({ scale, expr.View() });
+        } else {
+            expr.Collect(scale, terms);
+        }
+    }
+
+    /// @brief Returns a view holding the value of the operand of a product, and sets scale to
+    ///        the factor the view must be multiplied with. Plain (and scaled) matrices and views are
+    ///        used directly, other expressions are evaluated into a temporary owned by terms.
+    template<class E, typename T> MatrixView<const T>
+    ProductOperand(const E& expr, T& scale, Terms<T>& terms)
+    {
+        Terms<T> operand;
+        Collect(expr, static_cast<T>(1), operand);
+
+        if (operand.Linears.size() == 1 && operand.Products.empty()) {
+            scale = operand.Linears.front().Scale;
+            return operand.Linears.front().Operand;
+        }
+
+        scale = static_cast<T>(1);
+        terms.Temporaries.push_back(std::make_unique<Matrix<T>>(expr));
+        return terms.Temporaries.back()->View();
+    }
+
+    template<class L, class R>
+    class Sum : public Expression<Sum<L, R>>
+    {
+    public:
+        using ValueType = ValueOf<L>;
+
+        template<class A, class B>
+        Sum(A&& lhs, B&& rhs) : _lhs(std::forward<A>(lhs)), _rhs(std::forward<B>(rhs))
+        {
+            if (_lhs.GetHeight() != _rhs.GetHeight() || _lhs.GetWidth() != _rhs.GetWidth()) {
+                throw std::invalid_argument("Mismatching matrix dimensions for addition");
+            }
+        }
+
+        size_t GetHeight() const { return _lhs.GetHeight(); }
+        size_t GetWidth()  const { return _lhs.GetWidth(); }
+        auto   GetOrdering() const { return _lhs.GetOrdering(); }
+
+        void Collect(ValueType scale, Terms<ValueType>& terms) const
+        {
+            MatrixExpression::Collect(_lhs, scale, terms);
+            MatrixExpression::Collect(_rhs, scale, terms);
+        }
+
+    private:
+        L _lhs;
+        R _rhs;
+    };
+
+    template<class L, class R>
+    class Difference : public Expression<Difference<L, R>>
+    {
+    public:
+        using ValueType = ValueOf<L>;
+
+        template<class A, class B>
+        Difference(A&& lhs, B&& rhs) : _lhs(std::forward<A>(lhs)), _rhs(std::forward<B>(rhs))
+        {
+            if (_lhs.GetHeight() != _rhs.GetHeight() || _lhs.GetWidth() != _rhs.GetWidth()) {
+                throw std::invalid_argument("Mismatching matrix dimensions for subtraction");
+            }
+        }
+
+        size_t GetHeight() const { return _lhs.GetHeight(); }
+        size_t GetWidth()  const { return _lhs.GetWidth(); }
+        auto   GetOrdering() const { return _lhs.GetOrdering(); }
+
+        void Collect(ValueType scale, Terms<ValueType>& terms) const
+        {
+            MatrixExpression::Collect(_lhs, scale, terms);
+            MatrixExpression::Collect(_rhs, static_cast<ValueType>(static_cast<ValueType>(0) - scale), terms);
+        }
+
+    private:
+        L _lhs;
+        R _rhs;
+    };
+
+    template<class E>
+    class Scaled : public Expression<Scaled<E>>
+    {
+    public:
+        using ValueType = ValueOf<E>;
+
+        template<class A>
+        Scaled(A&& expr, ValueType factor) : _expr(std::forward<A>(expr)), _factor(factor) {}
+
+        size_t GetHeight() const { return _expr.GetHeight(); }
+        size_t GetWidth()  const { return _expr.GetWidth(); }
+        auto   GetOrdering() const { return _expr.GetOrdering(); }
+
+        void Collect(ValueType scale, Terms<ValueType>& terms) const
+        {
+            MatrixExpression::Collect(_expr, static_cast<ValueType>(scale * _factor), terms);
+        }
+
+    private:
+        E _expr;
+        ValueType _factor;
+    };
+
+    template<class L, class R>
+    class Product : public Expression<Product<L, R>>
+    {
+    public:
+        using ValueType = ValueOf<L>;
+
+        template<class A, class B>
+        Product(A&& lhs, B&& rhs) : _lhs(std::forward<A>(lhs)), _rhs(std::forward<B>(rhs))
+        {
+            if (_lhs.GetWidth() != _rhs.GetHeight()) {
+                throw std::invalid_argument("Mismatching matrix dimensions for multiplication.");
+            }
+        }
+
+        size_t GetHeight() const { return _lhs.GetHeight(); }
+        size_t GetWidth()  const { return _rhs.GetWidth(); }
+        auto   GetOrdering() const { return Matrix<ValueType>::Ordering::RowMajor; }
+
+        void Collect(ValueType scale, Terms<ValueType>& terms) const
+        {
+            ValueType lhsScale;
+            ValueType rhsScale;
+            const MatrixView<const ValueType> lhs = ProductOperand(_lhs, lhsScale, terms);
+            const MatrixView<const ValueType> rhs = ProductOperand(_rhs, rhsScale, terms);
+            terms.Products.push_back({ static_cast<ValueType>(scale * lhsScale * rhsScale), lhs, rhs });
+        }
+
+    private:
+        L _lhs;
+        R _rhs;
+    };
+
+
+    /// @brief Returns a lazy expression for the elementwise sum of the operands.
+    template<class L, class R, typename = EnableIfExpressions<L, R>> Sum<Operand<L>, Operand<R>>
+    operator+(L&& lhs, R&& rhs)
+    {
+        return Sum<Operand<L>, Operand<R>>(std::forward<L>(lhs), std::forward<R>(rhs));
+    }
+
+    /// @brief Returns a lazy expression for the elementwise difference of the operands.
+    template<class L, class R, typename = EnableIfExpressions<L, R>> Difference<Operand<L>, Operand<R>>
+    operator-(L&& lhs, R&& rhs)
+    {
+        return Difference<Operand<L>, Operand<R>>(std::forward<L>(lhs), std::forward<R>(rhs));
+    }
+
+    /// @brief Returns a lazy expression for the matrix product of the operands.
+    template<class L, class R, typename = EnableIfExpressions<L, R>> Product<Operand<L>, Operand<R>>
+    operator*(L&& lhs, R&& rhs)
+    {
+        return Product<Operand<L>, Operand<R>>(std::forward<L>(lhs), std::forward<R>(rhs));
+    }
+
+    /// @brief Returns a lazy expression for the operand scaled by a scalar.
+    template<class E, typename = EnableIfExpressions<E, E>> Scaled<Operand<E>>
+    operator*(E&& expr, ValueOf<E> factor)
+    {
+        return Scaled<Operand<E>>(std::forward<E>(expr), factor);
+    }
+
+    template<class E, typename = EnableIfExpressions<E, E>> Scaled<Operand<E>>
+    operator*(ValueOf<E> factor, E&& expr)
+    {
+        return Scaled<Operand<E>>(std::forward<E>(expr), factor);
+    }
+
+    /// @brief Returns the matrix itself, or a new matrix holding the value of other expressions.
+    template<class E> std::conditional_t<IsMatrix<E>::value, const E&, Matrix<typename E::ValueType>>
+    Evaluate(const Expression<E>& expr)
+    {
+        return expr.Self();
+    }
+
+    /// @brief Evaluates the operands that are not matrices and compares the results.
+    /// @return true, if all elements are equal, false otherwise.
+    template<class L, class R> bool
+    operator==(const Expression<L>& lhs, const Expression<R>& rhs)
+    {
+        return Evaluate(lhs).Equals(Evaluate(rhs));
+    }
+
+    /// @brief Evaluates the expression and prints the result.
+    template<class E> std::ostream&
+    operator<<(std::ostream& out, const Expression<E>& expr)
+    {
+        return out << Evaluate(expr);
+    }
+
+} // end namespace MatrixExpression
+
+
+#endif // MATRIX_EXPRESSION_HPP
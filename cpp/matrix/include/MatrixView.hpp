@@ -0,0 +1,187 @@
+#ifndef MATRIX_VIEW_HPP
+#define MATRIX_VIEW_HPP
+
+#include "Gemm.hpp"
+#include "Matrix.hpp"
+#include "MatrixExpression.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+
+/// @brief Non-owning view of a rows X columns matrix stored in an array with a leading dimension:
+///        element (r, c) is Data()[r * ld + c] for RowMajor and Data()[r + c * ld] for ColumnMajor
+///        views. Views of a Matrix are returned by Matrix::View, Row, Column and Block. Slicing a
+///        view returns a view of the same array, so it never allocates or copies.
+///
+///        Views are expressions like matrices, products read them through their strides. The
+///        elements of a MatrixView<T> can be assigned any expression of the same dimensions, also
+///        one that references the viewed matrix. MatrixView<const T> is a read only view.
+///
+///        Like std::span, copying or assigning a view makes it a view of the same elements as the
+///        other view. The elements of another view are copied with CopyFrom.
+///
+///        A view does not own its array, it must not outlive the matrix it was taken from, and
+///        it is invalidated when that matrix is assigned a value of other dimensions.
+template<class T>
+class MatrixView : public MatrixExpression::Expression<MatrixView<T>>
+{
+public:
+    using ValueType = std::remove_const_t<T>;
+    using Ordering  = typename Matrix<ValueType>::Ordering;
+
+    /// @brief Views the array data as a rows X columns matrix.
+    /// @param leadingDimension Distance between the first elements of consecutive rows (RowMajor)
+    ///                         or columns (ColumnMajor).
+    /// @throws std::invalid_argument if the leading dimension is smaller than a row (RowMajor)
+    ///         or a column (ColumnMajor).
+    MatrixView(T* data, size_t rows, size_t columns, size_t leadingDimension, Ordering ordering = Ordering::RowMajor)
+        : _data(data)
+        , _rows(rows)
+        , _columns(columns)
+        , _leadingDimension(leadingDimension)
+        , _ordering(ordering)
+    {
+        if (lines() > 1 && leadingDimension < lineLength()) {
+            throw std::invalid_argument("Leading dimension " + std::to_string(leadingDimension) + " is smaller than the lines of the view.");
+        }
+    }
+
+    /// @brief Views all elements of the matrix.
+    MatrixView(std::conditional_t<std::is_const_v<T>, const Matrix<ValueType>, Matrix<ValueType>>& matrix)
+        : MatrixView(matrix.View())
+    {}
+
+    /// @brief Read only view of the elements of a view of non-const elements.
+    template<class U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+    MatrixView(const MatrixView<U>& other)
+        : MatrixView(other.Data(), other.GetHeight(), other.GetWidth(), other.GetLeadingDimension(), other.GetOrdering())
+    {}
+
+    MatrixView(const MatrixView& other) = default;
+
+    /// @brief Makes this view a view of the elements of the other view. Temporary views, e.g. the
+    ///        ones returned by Block, can not be rebound.
+    MatrixView& operator=(const MatrixView& other) & = default;
+
+    /// @brief Copies the elements of the other view into the elements of this view. The views may
+    ///        overlap, e.g. be blocks of the same matrix.
+    /// @throws std::invalid_argument if the dimensions differ.
+    MatrixView& CopyFrom(const MatrixView<const ValueType>& other)
+    {
+        return assign(other);
+    }
+
+    /// @brief Evaluates the expression into the viewed elements, see Matrix::operator=. Views
+    ///        are not assigned through this operator, see operator=(const MatrixView&) and CopyFrom.
+    /// @throws std::invalid_argument if the dimensions of the expression differ from this view.
+    template<class E, typename = std::enable_if_t<!MatrixExpression::IsMatrixView<E>::value>>
+    MatrixView& operator=(const MatrixExpression::Expression<E>& expr)
+    {
+        return assign(expr.Self());
+    }
+
+    /// @throws std::invalid_argument if the dimensions of the expression differ from this view.
+    template<class E>
+    MatrixView& operator+=(const MatrixExpression::Expression<E>& expr)
+    {
+        return assign(*this + expr.Self());
+    }
+
+    /// @throws std::invalid_argument if the dimensions of the expression differ from this view.
+    template<class E>
+    MatrixView& operator-=(const MatrixExpression::Expression<E>& expr)
+    {
+        return assign(*this - expr.Self());
+    }
+
+    MatrixView& operator*=(ValueType factor)
+    {
+        return assign(*this * factor);
+    }
+
+    size_t GetWidth()  const { return _columns; }
+    size_t GetHeight() const { return _rows; }
+    Ordering GetOrdering() const { return _ordering; }
+    size_t GetLeadingDimension() const { return _leadingDimension; }
+    T* Data() const { return _data; }
+
+    /// @brief Returns the element strides of the viewed array, resolved from the ordering.
+    Gemm::Strides GetStrides() const
+    {
+        return _ordering == Ordering::RowMajor ? Gemm::Strides{ _leadingDimension, 1 } : Gemm::Strides{ 1, _leadingDimension };
+    }
+
+    /// @brief Returns true if the viewed elements have no gaps between them, e.g. for views
+    ///        of whole matrices or of full rows of RowMajor matrices.
+    bool IsContiguous() const { return lines() <= 1 || _leadingDimension == lineLength(); }
+
+    /// @throws std::out_of_range if the element is outside of the view.
+    T& operator()(size_t row, size_t col) const
+    {
+        if (row >= _rows || col >= _columns) {
+            throw std::out_of_range("Element (" + std::to_string(row) + ", " + std::to_string(col) + ") out of bounds.");
+        }
+        return _data[row * GetStrides().Row + col * GetStrides().Col];
+    }
+
+    /// @brief Returns the 1 X width view of the row.
+    /// @throws std::out_of_range if the row is outside of the view.
+    MatrixView Row(size_t row) const { return Block(row, 0, 1, _columns); }
+
+    /// @brief Returns the height X 1 view of the column.
+    /// @throws std::out_of_range if the column is outside of the view.
+    MatrixView Column(size_t col) const { return Block(0, col, _rows, 1); }
+
+    /// @brief Returns the rows X columns view whose first element is (row, col) of this view.
+    /// @throws std::out_of_range if the block is not inside of this view.
+    MatrixView Block(size_t row, size_t col, size_t rows, size_t columns) const
+    {
+        if (row + rows > _rows || col + columns > _columns || row + rows < row || col + columns < col) {
+            throw std::out_of_range("Block of " + std::to_string(rows) + 'X' + std::to_string(columns) + " at (" +
+                                    std::to_string(row) + ", " + std::to_string(col) + ") out of bounds.");
+        }
+
+        // Empty blocks keep the data pointer of the view, they are never read.
+        T* data = rows > 0 && columns > 0 ? _data + row * GetStrides().Row + col * GetStrides().Col : _data;
+        return MatrixView(data, rows, columns, _leadingDimension, _ordering);
+    }
+
+    void Collect(ValueType scale, MatrixExpression::Terms<ValueType>& terms) const
+    {
+        terms.Linears.push_back({ scale, MatrixView<const ValueType>(*this) });
+    }
+
+private:
+    template<class E>
+    MatrixView& assign(const E& expr)
+    {
+        static_assert(!std::is_const_v<T>, "The elements of a read only view can not be assigned.");
+
+        if (expr.GetHeight() != _rows || expr.GetWidth() != _columns) {
+            throw std::invalid_argument("Mismatching matrix dimensions for the assignment to a view.");
+        }
+
+        MatrixExpression::Terms<ValueType> terms;
+        MatrixExpression::Collect(expr, static_cast<ValueType>(1), terms);
+        Matrix<ValueType>::evaluate(*this, terms);
+        return *this;
+    }
+
+    /// @brief Amount and length of the contiguous lines: rows for RowMajor, columns for ColumnMajor views.
+    size_t lines()      const { return _ordering == Ordering::RowMajor ? _rows : _columns; }
+    size_t lineLength() const { return _ordering == Ordering::RowMajor ? _columns : _rows; }
+
+private:
+    T*       _data;
+    size_t   _rows;
+    size_t   _columns;
+    size_t   _leadingDimension;
+    Ordering _ordering;
+
+};
+
+
+#endif // MATRIX_VIEW_HPP
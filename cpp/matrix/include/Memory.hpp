@@ -0,0 +1,232 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+/// @brief Storage allocation for the data of matrices and for the scratch buffers of the kernels.
+///        The allocator is pluggable at runtime: all buffers are drawn from the allocator set
+///        with SetAllocator, and every buffer remembers the allocator it was drawn from, so
+///        that the allocator can be changed while buffers of the previous one are alive.
+namespace Memory
+{
+    /// @brief Alignment of all buffers, the size of a cache line and of an AVX-512 vector.
+    inline constexpr size_t ALIGNMENT = 64;
+
+    /// @brief Size of a transparent huge page on x86-64 Linux.
+    inline constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    /// @brief Interface of the allocators.
+    class Allocator
+    {
+    public:
+        virtual ~Allocator() = default;
+
+        /// @brief Returns uninitialized storage of at least bytes size, aligned to at least ALIGNMENT.
+        ///        Returns nullptr if bytes is zero.
+        /// @throws std::bad_alloc if the storage can not be allocated.
+        virtual void* Allocate(size_t bytes) = 0;
+
+        /// @brief Releases storage returned by Allocate with the same amount of bytes.
+        virtual void Deallocate(void* ptr, size_t bytes) noexcept = 0;
+    };
+
+    /// @brief The default allocator. Buffers of at least hugePageThreshold bytes are aligned to
+    ///        HUGE_PAGE_SIZE and advised to be backed by transparent huge pages (on Linux), which
+    ///        avoids most of the TLB misses when streaming through matrices of several GB.
+    class AlignedAllocator final : public Allocator
+    {
+    public:
+        explicit AlignedAllocator(size_t hugePageThreshold = 4 * HUGE_PAGE_SIZE);
+
+        void* Allocate(size_t bytes) override;
+        void  Deallocate(void* ptr, size_t bytes) noexcept override;
+
+    private:
+        size_t _hugePageThreshold;
+    };
+
+    /// @brief Allocator that retains released blocks in size classes and hands them out again,
+    ///        so that repeatedly creating matrices of the same shapes does not reach the upstream
+    ///        allocator in the steady state. Sizes are rounded up to one of four classes between
+    ///        consecutive powers of two, which wastes at most 25% of a block.
+    ///        Every thread keeps the blocks it released last in a cache of its own, which is used
+    ///        without locks. Full caches spill half of their blocks of a size class into eight
+    ///        shards guarded by mutexes, that the threads are mapped onto round robin. Allocations
+    ///        take blocks from the cache of the calling thread first, then from its shard and then
+    ///        from the other shards, which are only searched if they hold blocks of the size class.
+    ///        The cache of a thread is moved to the shards when the thread exits.
+    ///        All buffers must be released, and no thread may use the pool, when it is destroyed.
+    class PoolAllocator final : public Allocator
+    {
+    public:
+        struct Stats
+        {
+            size_t Hits;          // Allocations served from retained blocks
+            size_t Misses;        // Allocations forwarded to the upstream allocator
+            size_t RetainedBytes; // Bytes held in the caches and free lists
+            size_t RetainedBlocks;
+
+            double HitRate() const;
+        };
+
+        /// @param maxRetainedBytes Released blocks that would grow the retained bytes beyond
+        ///                         this limit are returned to the upstream allocator instead.
+        /// @param upstream The allocator blocks are drawn from, nullptr selects the DefaultAllocator.
+        explicit PoolAllocator(size_t maxRetainedBytes = static_cast<size_t>(1) << 30, Allocator* upstream = nullptr);
+        ~PoolAllocator() override;
+
+        PoolAllocator(const PoolAllocator& other) = delete;
+        PoolAllocator& operator=(const PoolAllocator& other) = delete;
+
+        void* Allocate(size_t bytes) override;
+        void  Deallocate(void* ptr, size_t bytes) noexcept override;
+
+        /// @brief Returns the retained blocks of the shards and of the cache of the calling thread
+        ///        to the upstream allocator. The caches of other threads are kept.
+        void Trim();
+
+        Stats GetStats() const;
+
+    private:
+        inline constexpr static size_t MIN_BLOCK_SIZE = 64;
+        inline constexpr static size_t CLASSES_PER_POWER = 4;
+        inline constexpr static size_t CLASS_COUNT = 1 + (64 - 6) * CLASSES_PER_POWER;
+        inline constexpr static size_t SHARD_COUNT = 8;
+        inline constexpr static size_t CACHE_BLOCKS = 8; // Blocks per size class in the cache of a thread
+
+        struct alignas(64) Shard
+        {
+            std::mutex Mutex;
+            std::array<std::vector<void*>, CLASS_COUNT> FreeLists;
+        };
+
+        /// @brief Returns the index of the size class for the amount of bytes, and its block size.
+        /// @throws std::bad_alloc if the block size of the class is not representable.
+        static size_t sizeClass(size_t bytes, size_t& blockSize);
+        static size_t classBlockSize(size_t sizeClass);
+        static size_t shardIndex();
+
+        /// @brief The blocks cached by one thread, and the caches of a thread for all pools it used.
+        struct ThreadCache;
+        class  ThreadCaches;
+
+        /// @brief Returns the caches of the calling thread, or nullptr while the thread exits.
+        static ThreadCaches* threadCaches();
+
+        /// @brief Returns the cache of the calling thread for this pool, or nullptr if there is none.
+        ThreadCache* threadCache() noexcept;
+
+        void* takeBlock(size_t sizeClass);
+
+        /// @brief Moves the first count cached blocks of the size class to the shard of the thread.
+        /// @return false, if the shard could not take the blocks.
+        bool spill(ThreadCache& cache, size_t sizeClass, size_t count) noexcept;
+
+        /// @brief Moves all cached blocks to the shard of the thread, or to the upstream allocator.
+        void flush(ThreadCache& cache, bool toUpstream) noexcept;
+
+        /// @brief Returns a retained block to the upstream allocator.
+        void release(void* block, size_t blockSize) noexcept;
+
+    private:
+        Allocator&               _upstream;
+        const size_t             _maxRetainedBytes;
+        std::unique_ptr<Shard[]> _shards;
+
+        // Blocks in the shards per size class, so misses skip the shards without blocks.
+        std::unique_ptr<std::atomic<size_t>[]> _shardBlocks;
+
+        // The caches of the threads that used this pool, guarded by a global mutex.
+        std::vector<ThreadCache*> _threadCaches;
+
+        std::atomic<size_t> _hits           { 0 };
+        std::atomic<size_t> _misses         { 0 };
+        std::atomic<size_t> _retainedBytes  { 0 };
+        std::atomic<size_t> _retainedBlocks { 0 };
+    };
+
+    /// @brief Sets the allocator new buffers are drawn from for the lifetime of the scope, and
+    ///        restores the previous allocator at the end of it.
+    class AllocatorScope
+    {
+    public:
+        explicit AllocatorScope(Allocator& allocator);
+        ~AllocatorScope();
+
+        AllocatorScope(const AllocatorScope& other) = delete;
+        AllocatorScope& operator=(const AllocatorScope& other) = delete;
+
+    private:
+        Allocator* _previous;
+    };
+
+    /// @brief Returns the process wide instance of the AlignedAllocator.
+    Allocator& DefaultAllocator();
+
+    /// @brief Returns the allocator new buffers are drawn from.
+    Allocator& GetAllocator();
+
+    /// @brief Sets the allocator new buffers are drawn from. The allocator must outlive all buffers
+    ///        allocated from it.
+    /// @param allocator The new allocator, or nullptr to restore the DefaultAllocator.
+    /// @return The previously set allocator.
+    Allocator* SetAllocator(Allocator* allocator);
+
+    /// @brief Returns the storage of a buffer to the allocator it was drawn from. Buffers without
+    ///        an allocator were allocated with new[].
+    template<typename T>
+    struct Deleter
+    {
+        Allocator* Source = nullptr;
+        size_t     Bytes  = 0;
+
+        void operator()(T* ptr) const noexcept
+        {
+            if (Source != nullptr) {
+                Source->Deallocate(ptr, Bytes);
+            } else {
+                delete[] ptr;
+            }
+        }
+    };
+
+    template<typename T>
+    using Buffer = std::unique_ptr<T[], Deleter<T>>;
+
+    /// @brief Returns an uninitialized buffer for count elements from the current allocator.
+    /// @throws std::bad_alloc if the storage can not be allocated.
+    template<typename T> Buffer<T>
+    Allocate(size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>() && std::is_trivially_destructible<T>(),
+                      "Buffers hold uninitialized storage and never run constructors or destructors");
+
+        if (count > static_cast<size_t>(-1) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+
+        Allocator& allocator = GetAllocator();
+        const size_t bytes = count * sizeof(T);
+
+        return Buffer<T>(static_cast<T*>(allocator.Allocate(bytes)), Deleter<T>{ &allocator, bytes });
+    }
+
+    /// @brief Takes ownership of an array allocated with new[].
+    template<typename T> Buffer<T>
+    Adopt(std::unique_ptr<T[]>&& data)
+    {
+        return Buffer<T>(data.release(), Deleter<T>{});
+    }
+
+} // end namespace Memory
+
+
+#endif // MEMORY_HPP
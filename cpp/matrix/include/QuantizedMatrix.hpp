@@ -0,0 +1,148 @@
+#ifndef QUANTIZEDMATRIX_HPP
+#define QUANTIZEDMATRIX_HPP
+
+#include "Matrix.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+
+/// @brief Matrix of 8 bit integers with an affine quantization per row or per column: the
+///        element q in row i and column j stands for the real value Scale * (q - ZeroPoint),
+///        with the Parameters of row i or of column j. The elements are stored in RowMajor order.
+///
+///        The lhs of a product is quantized per row and the rhs per column, so the scales of
+///        every product of two elements factor out of its inner sum: the products are computed
+///        exactly in int32 by Gemm::MultiplyQuantized, corrected for the zero points with the
+///        row sums of the lhs and the column sums of the rhs, and scaled once per element of
+///        the result. The rhs is always signed, the lhs is either uint8_t, e.g. the activations
+///        after a ReLU, or int8_t.
+///        Products run in parallel on the ThreadPool if it is started.
+/// @tparam T must be int8_t or uint8_t.
+template<class T>
+class QuantizedMatrix
+{
+public:
+    using ValueType = T;
+
+    /// @brief The largest inner dimension of the products. An element of the product sums up
+    ///        to 255 * 255 in magnitude per inner index, which must fit into int32.
+    inline constexpr static size_t MAX_DEPTH = 33025;
+
+    enum class Axis {
+        Rows,   // Parameters per row, for the lhs of products
+        Columns // Parameters per column, for the rhs of products
+    };
+
+    /// @brief The quantization of a row or a column.
+    struct Parameters
+    {
+        float   Scale;
+        int32_t ZeroPoint;
+    };
+
+    // Constructors
+
+    QuantizedMatrix() = delete;
+
+    /// @brief Initializes a matrix from its quantized elements in RowMajor order and the
+    ///        parameters of every row (Axis::Rows) or column (Axis::Columns).
+    /// @throws std::invalid_argument if values does not hold rows * columns elements, the amount
+    ///         of parameters does not match, a scale is not positive and finite or a zero point
+    ///         is not a value of T.
+    QuantizedMatrix(size_t rows, size_t columns, std::vector<T> values, std::vector<Parameters> parameters, Axis axis);
+
+    /// @brief Quantizes every row (Axis::Rows) or column (Axis::Columns) of the matrix over the
+    ///        range of its values, extended to include zero so that zero is represented exactly.
+    ///        uint8_t maps the range to [0, 255] with a zero point, int8_t symmetrically to
+    ///        [-127, 127] with a zero point of zero. Values are rounded to nearest.
+    static QuantizedMatrix Quantize(const Matrix<float>& values, Axis axis);
+
+    // Getters
+
+    size_t GetWidth()  const;
+    size_t GetHeight() const;
+    QuantizedMatrix::Axis GetAxis() const;
+
+    const std::vector<T>&          GetValues()     const;
+    const std::vector<Parameters>& GetParameters() const;
+
+    /// @brief Returns the quantized element in the row and column.
+    /// @throws std::out_of_range if the element is outside of the matrix.
+    T At(size_t row, size_t col) const;
+
+    // Conversions
+
+    /// @brief Returns the real values of the elements in RowMajor ordering.
+    Matrix<float> Dequantize() const;
+
+    // Arithmetic
+
+    /// @brief Returns the exact inner sums of the quantized product,
+    ///        sum((a(i, p) - ZeroPoint_i) * (b(p, j) - ZeroPoint_j) for p in [0, k)),
+    ///        which are the elements of the real product divided by Scale_i * Scale_j.
+    /// @throws std::invalid_argument if the dimensions do not match, the inner dimension exceeds
+    ///         MAX_DEPTH, this matrix is not quantized per row or rhs is not quantized per column.
+    Matrix<int> MultiplyAccumulate(const QuantizedMatrix<int8_t>& rhs) const;
+
+    /// @brief Returns the real product this * rhs in RowMajor ordering, see MultiplyAccumulate.
+    Matrix<float> Multiply(const QuantizedMatrix<int8_t>& rhs) const;
+
+    /// @brief Returns the product this * rhs requantized to U with the same parameters for all
+    ///        elements, e.g. the input of the next layer. The elements are rounded to nearest and
+    ///        saturated to the range of U.
+    /// @tparam U must be int8_t or uint8_t.
+    /// @throws std::invalid_argument see MultiplyAccumulate, and if the output parameters are invalid.
+    template<typename U>
+    QuantizedMatrix<U> MultiplyRequantized(const QuantizedMatrix<int8_t>& rhs, Parameters output) const;
+
+    /// @brief Compares the dimensions, axes, elements and parameters of the matrices.
+    bool Equals(const QuantizedMatrix& rhs) const;
+
+    template<typename U>
+    friend std::ostream& operator<<(std::ostream& out, const QuantizedMatrix<U>& mat);
+
+    // The lhs of a product reads the elements of the rhs directly, and the product of the
+    // lhs creates the requantized matrix.
+    template<typename U>
+    friend class QuantizedMatrix;
+
+private:
+    /// @brief Calls func(accumulators, row, endRow) for ranges of the rows of the product with
+    ///        rhs, in parallel if the ThreadPool is started. The accumulators of the rows of the
+    ///        range are the int32 inner sums corrected for the zero points, see MultiplyAccumulate,
+    ///        stored row by row with a stride of the width of rhs.
+    template<typename F>
+    void forProductRows(const QuantizedMatrix<int8_t>& rhs, const F& func) const;
+
+    /// @brief Checks the dimensions and parameters.
+    /// @throws std::invalid_argument if they do not describe a valid matrix.
+    void validate() const;
+
+private:
+    size_t                  _rows;
+    size_t                  _columns;
+    Axis                    _axis;
+    std::vector<T>          _values;
+    std::vector<Parameters> _parameters;
+
+};
+
+
+/// @brief Real product of two quantized matrices, see QuantizedMatrix::Multiply.
+template<class T> Matrix<float>
+operator*(const QuantizedMatrix<T>& lhs, const QuantizedMatrix<int8_t>& rhs)
+{
+    return lhs.Multiply(rhs);
+}
+
+template<class T> bool
+operator==(const QuantizedMatrix<T>& lhs, const QuantizedMatrix<T>& rhs)
+{
+    return lhs.Equals(rhs);
+}
+
+
+#endif // QUANTIZEDMATRIX_HPP
@@ -0,0 +1,173 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include "Float16.hpp"
+#include "Gemm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+/// @brief Hand-written vector kernels for the hot loops of the Matrix operations.
+///        The binary is built without any -march flags, so every kernel is compiled
+///        for each supported instruction set separately and the best one for the
+///        running CPU is selected once at startup by querying CPUID.
+namespace Simd
+{
+    /// @brief Instruction sets in increasing order of capability.
+    enum class Isa {
+        Scalar, // Portable C++, used for the integer types and on non x86 platforms
+        SSE2,   // 128 bit vectors, the baseline of every x86-64 CPU
+        AVX2,   // 256 bit vectors with fused multiply-add
+        AVX512  // 512 bit vectors (AVX-512F)
+    };
+
+    /// @brief The maximum amount of elements in a register tile of any micro-kernel.
+    inline constexpr size_t MAX_TILE_ELEMENTS = 256;
+
+    /// @brief Table of the kernels compiled for one instruction set. All function
+    ///        pointers are always set, instruction sets without a dedicated kernel
+    ///        for an operation use the kernel of the next lower instruction set.
+    ///        The kernels of the 16 bit types load their elements as float, compute and
+    ///        accumulate in float and round only the stored results, see AccumulatorType.
+    template<typename T>
+    struct Kernels
+    {
+        // Type of the scalars and of the accumulation, T itself except for the 16 bit types.
+        using S = AccumulatorType<T>;
+
+        Isa InstructionSet;
+
+        // Register tile dimensions of the MicroKernel.
+        size_t MR;
+        size_t NR;
+
+        /// @brief out[i] = a[i] + b[i] for i in [0, n).
+        void (*Add)(const T* a, const T* b, T* out, size_t n);
+
+        /// @brief out[i] = a[i] - b[i] for i in [0, n).
+        void (*Subtract)(const T* a, const T* b, T* out, size_t n);
+
+        /// @brief out[i] = alpha * a[i] for i in [0, n). a and out may be the same array.
+        void (*Scale)(S alpha, const T* a, T* out, size_t n);
+
+        /// @brief out[i] += alpha * a[i] for i in [0, n).
+        void (*Axpy)(S alpha, const T* a, T* out, size_t n);
+
+        /// @brief out[r] = sum(a[r * rowStride + j] * x[j] for j in [0, n)) for r in [0, rows).
+        ///        The rows of a matrix times a vector, reading x once for every four rows.
+        void (*DotRows)(size_t rows, size_t n, const T* a, size_t rowStride, const T* x, T* out);
+
+        /// @brief out[i] += alpha * sum(a[c * columnStride + i] * x[c] for c in [0, columns)) for i in [0, n).
+        ///        The columns of a matrix times a vector, reading and writing out once for every four columns.
+        void (*AxpyColumns)(size_t columns, size_t n, S alpha, const T* a, size_t columnStride, const T* x, T* out);
+
+        /// @brief out[l] = sum(a[p * aStride + l] * b[p * bStride + l] for p in [0, k)) for l in [0, n).
+        ///        n independent dot products of length k whose vectors are interleaved, the lanes of a
+        ///        batch of small matrix products. Every lane is summed in the same order.
+        void (*DotBatch)(size_t k, size_t n, const T* a, size_t aStride, const T* b, size_t bStride, T* out);
+
+        /// @brief Compares the n first elements of a and b with the same semantics as Math::AreEqual.
+        /// @return true, if all elements are equal, false otherwise.
+        bool (*AreEqual)(const T* a, const T* b, size_t n, S realTypeToleranceFactor);
+
+        /// @brief out[i] = a[i] converted to the accumulator type for i in [0, n), a copy for the
+        ///        types that are their own accumulator type. Used to pack the 16 bit types.
+        void (*Widen)(const T* a, S* out, size_t n);
+
+        /// @brief Computes a full MR x NR tile of the product of a MR x kc block of A and a
+        ///        kc x NR block of B. The elements of each row of B must be contiguous.
+        ///        The blocks are packed in the accumulator type, so the 16 bit types share
+        ///        the micro-kernel of float.
+        /// @param tile Output buffer of MR * NR elements, the tile is stored in row major order.
+        void (*MicroKernel)(size_t kc, const S* a, Gemm::Strides as, const S* b, size_t bRowStride, S* tile);
+    };
+
+    /// @brief The amount of consecutive elements of the inner dimension that the quantized
+    ///        micro-kernels multiply and sum at once, see QuantizedKernels.
+    inline constexpr size_t QUANTIZED_GROUP = 4;
+
+    /// @brief Kernels of the products of 8 bit integers, see Gemm::MultiplyQuantized. The
+    ///        products of unsigned bytes of A and signed bytes of B are summed in int32 without
+    ///        saturation: AVX-512 uses vpdpbusd (VNNI), AVX2 sign extends the bytes to 16 bit and
+    ///        uses vpmaddwd. The instruction sets without a dedicated kernel use the portable one.
+    struct QuantizedKernels
+    {
+        Isa InstructionSet;
+
+        // Register tile dimensions of the MicroKernel.
+        size_t MR;
+        size_t NR;
+
+        /// @brief Computes a full MR x NR tile of the product of a MR x (groups * QUANTIZED_GROUP)
+        ///        block of A and a (groups * QUANTIZED_GROUP) x NR block of B, packed in groups of
+        ///        QUANTIZED_GROUP consecutive elements of a row of A or of a column of B: group g of
+        ///        row i of A starts at a[(g * MR + i) * QUANTIZED_GROUP], group g of column j of B at
+        ///        b[(g * NR + j) * QUANTIZED_GROUP].
+        /// @param tile Output buffer of MR * NR elements, the tile is stored in row major order.
+        void (*MicroKernel)(size_t groups, const uint8_t* a, const int8_t* b, int32_t* tile);
+    };
+
+    /// @brief The amount of counters of Random::Philox that the random kernels compute at once.
+    inline constexpr size_t PHILOX_LANES = 16;
+
+    /// @brief Kernels of the counter-based random generator Random::Philox, vectorized across
+    ///        counters: every lane of a vector computes the rounds of another counter.
+    struct RandomKernels
+    {
+        Isa InstructionSet;
+
+        /// @brief Computes the Philox4x32-10 blocks of the groups of PHILOX_LANES consecutive
+        ///        counters [firstGroup * PHILOX_LANES, (firstGroup + groups) * PHILOX_LANES). Word w of
+        ///        the block of counter c is stored at out[(c / PHILOX_LANES - firstGroup) * 4 * PHILOX_LANES
+        ///        + w * PHILOX_LANES + c % PHILOX_LANES], so that the vectors are stored without shuffles.
+        /// @param key The 64 bit key, the two words of the Philox key.
+        /// @param stream The upper 64 bits of the 128 bit counters.
+        void (*Philox)(uint64_t key, uint64_t stream, uint64_t firstGroup, size_t groups, uint32_t* out);
+    };
+
+    /// @brief Detects the best instruction set supported by the running CPU. The CPU is only
+    ///        queried on the first call.
+    Isa DetectIsa();
+
+    /// @brief Returns true if the running CPU can execute kernels compiled for the instruction set.
+    bool IsSupported(Isa isa);
+
+    const char* IsaName(Isa isa);
+
+    /// @brief Returns the kernels for the best instruction set supported by the running CPU.
+    /// @tparam T must be one of float, double, BFloat16, Float16, int or size_t. The integer
+    ///         types always use the scalar kernels, Float16 needs F16C (AVX2 or AVX-512) for
+    ///         the vector kernels.
+    template<typename T> const Kernels<T>&
+    GetKernels();
+
+    /// @brief Returns the kernels compiled for the given instruction set.
+    /// @throws std::invalid_argument if the running CPU does not support the instruction set.
+    template<typename T> const Kernels<T>&
+    GetKernels(Isa isa);
+
+    /// @brief Returns the quantized kernels for the running CPU. The AVX-512 kernel needs the
+    ///        AVX512BW and AVX512_VNNI extensions, CPUs with AVX-512F only use the AVX2 kernel.
+    const QuantizedKernels&
+    GetQuantizedKernels();
+
+    /// @brief Returns the quantized kernels compiled for the given instruction set.
+    /// @throws std::invalid_argument if the running CPU does not support the instruction set.
+    const QuantizedKernels&
+    GetQuantizedKernels(Isa isa);
+
+    /// @brief Returns the random kernels for the best instruction set supported by the running CPU.
+    const RandomKernels&
+    GetRandomKernels();
+
+    /// @brief Returns the random kernels compiled for the given instruction set. All kernels
+    ///        compute the same words.
+    /// @throws std::invalid_argument if the running CPU does not support the instruction set.
+    const RandomKernels&
+    GetRandomKernels(Isa isa);
+
+} // end namespace Simd
+
+
+#endif // SIMD_HPP
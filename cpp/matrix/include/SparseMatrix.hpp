@@ -0,0 +1,175 @@
+#ifndef SPARSEMATRIX_HPP
+#define SPARSEMATRIX_HPP
+
+#include "Matrix.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+
+/// @brief Sparse matrix in the compressed sparse row (CSR) or compressed sparse column (CSC)
+///        format, which only stores the nonzero elements. The lines of the matrix are its rows
+///        in the CSR and its columns in the CSC format:
+///            Offsets[l] is the position of the first nonzero of line l, Offsets[lines] the
+///            amount of nonzeros, and Indices[p] and Values[p] are the column (CSR) or row (CSC)
+///            index and the value of the nonzero at position p. The indices of every line are
+///            strictly increasing.
+///        Products run in parallel on the ThreadPool if it is started. The work is split by the
+///        amount of nonzeros instead of the amount of lines, so that a few dense lines do not
+///        serialize the product.
+template<class T>
+class SparseMatrix
+{
+public:
+    using ValueType = T;
+
+    enum class Format {
+        CSR, // Compressed rows, for products of this matrix with dense matrices and vectors
+        CSC  // Compressed columns, for products of dense matrices with this matrix
+    };
+
+    /// @brief An element of the matrix, used to build sparse matrices.
+    struct Triplet
+    {
+        size_t Row;
+        size_t Column;
+        T      Value;
+    };
+
+    // Constructors
+
+    SparseMatrix() = delete;
+
+    /// @brief Initializes a matrix without nonzero elements.
+    SparseMatrix(size_t rows, size_t columns, Format format = Format::CSR);
+
+    /// @brief Initializes a matrix from the arrays of the compressed format, see the class description.
+    /// @throws std::invalid_argument if the arrays do not describe a valid rows X columns matrix.
+    SparseMatrix(
+        size_t rows,
+        size_t columns,
+        std::vector<size_t> offsets,
+        std::vector<size_t> indices,
+        std::vector<T> values,
+        Format format = Format::CSR
+    );
+
+    /// @brief Initializes a matrix with the elements of the dense matrix whose absolute value
+    ///        is larger than the tolerance.
+    explicit SparseMatrix(const Matrix<T>& dense, Format format = Format::CSR, T tolerance = static_cast<T>(0));
+
+    /// @brief Builds a matrix from elements given in any order. The values of elements given
+    ///        more than once are summed.
+    /// @throws std::out_of_range if an element is outside of the rows X columns matrix.
+    static SparseMatrix FromTriplets(size_t rows, size_t columns, std::vector<Triplet> triplets, Format format = Format::CSR);
+
+    // Getters
+
+    size_t GetWidth()    const;
+    size_t GetHeight()   const;
+    size_t GetNonZeros() const;
+    SparseMatrix::Format GetFormat() const;
+
+    const std::vector<size_t>& GetOffsets() const;
+    const std::vector<size_t>& GetIndices() const;
+    const std::vector<T>&      GetValues()  const;
+
+    /// @brief Returns the element in the row and column, zero if it is not stored.
+    /// @throws std::out_of_range if the element is outside of the matrix.
+    T At(size_t row, size_t col) const;
+
+    // Conversions
+
+    /// @brief Returns the dense matrix with the same elements.
+    Matrix<T> ToDense(typename Matrix<T>::Ordering ordering = Matrix<T>::Ordering::RowMajor) const;
+
+    /// @brief Returns the same matrix stored in the requested format.
+    SparseMatrix ToFormat(Format format) const;
+
+    /// @brief Returns the transposed matrix. The compressed arrays of a CSR matrix are those of
+    ///        its transpose in the CSC format and vice versa, so the arrays are only copied.
+    SparseMatrix Transpose() const;
+
+    // Arithmetic
+
+    /// @brief Returns this * rhs in the ordering of rhs. A rhs with a single column is a sparse
+    ///        matrix-vector product. CSC matrices are converted to the CSR format first, keep
+    ///        matrices in the CSR format that are multiplied with dense matrices repeatedly.
+    /// @throws std::invalid_argument if the dimensions do not match.
+    Matrix<T> Multiply(const Matrix<T>& rhs) const;
+
+    /// @brief Returns this * rhs in the format of this matrix, computed row by row with a dense
+    ///        accumulator (Gustavson's algorithm): a symbolic pass counts the nonzeros of every
+    ///        row of the result, a numeric pass computes them.
+    /// @throws std::invalid_argument if the dimensions do not match.
+    SparseMatrix Multiply(const SparseMatrix& rhs) const;
+
+    /// @brief Returns lhs * this in RowMajor ordering.
+    /// @throws std::invalid_argument if the dimensions do not match.
+    Matrix<T> MultiplyLeft(const Matrix<T>& lhs) const;
+
+    /// @brief Compares the elements of the matrices, independent of their formats. Explicitly
+    ///        stored zeros are equal to elements that are not stored.
+    /// @return true, if the dimensions and all elements are equal, false otherwise.
+    bool Equals(const SparseMatrix& rhs) const;
+
+    template<typename U>
+    friend std::ostream& operator<<(std::ostream& out, const SparseMatrix<U>& mat);
+
+private:
+    /// @brief Amount of lines and the length of every line: rows and columns for CSR matrices,
+    ///        columns and rows for CSC matrices.
+    size_t lines() const;
+    size_t lineLength() const;
+
+    /// @brief Calls func(line, endLine) for contiguous ranges of the lines, in parallel if the
+    ///        ThreadPool is started. The ranges hold about the same amount of nonzeros plus lines,
+    ///        weighted by the cost of one operation on a nonzero.
+    template<typename F>
+    void forLines(size_t operationsPerNonZero, const F& func) const;
+
+    /// @brief Checks the compressed arrays.
+    /// @throws std::invalid_argument if they do not describe a valid matrix.
+    void validate() const;
+
+private:
+    size_t              _rows;
+    size_t              _columns;
+    Format              _format;
+    std::vector<size_t> _offsets;
+    std::vector<size_t> _indices;
+    std::vector<T>      _values;
+
+};
+
+
+/// @brief Product of a sparse and a dense matrix, see SparseMatrix::Multiply.
+template<class T> Matrix<T>
+operator*(const SparseMatrix<T>& lhs, const Matrix<T>& rhs)
+{
+    return lhs.Multiply(rhs);
+}
+
+/// @brief Product of a dense and a sparse matrix, see SparseMatrix::MultiplyLeft.
+template<class T> Matrix<T>
+operator*(const Matrix<T>& lhs, const SparseMatrix<T>& rhs)
+{
+    return rhs.MultiplyLeft(lhs);
+}
+
+/// @brief Product of two sparse matrices, see SparseMatrix::Multiply.
+template<class T> SparseMatrix<T>
+operator*(const SparseMatrix<T>& lhs, const SparseMatrix<T>& rhs)
+{
+    return lhs.Multiply(rhs);
+}
+
+template<class T> bool
+operator==(const SparseMatrix<T>& lhs, const SparseMatrix<T>& rhs)
+{
+    return lhs.Equals(rhs);
+}
+
+
+#endif // SPARSEMATRIX_HPP
@@ -1,7 +1,9 @@
 #ifndef THREADPOOL_HPP
 #define THREADPOOL_HPP
 
+#include <algorithm>
 #include <condition_variable>
+#include <exception>
 #include <functional>
 #include <future>
 #include <memory>
@@ -52,11 +54,69 @@ public:
         return wrapper->get_future();
     }
 
+    /// @brief Splits the range [0, length) into contiguous slices of at least minSliceLength
+    ///        elements, one per worker thread and one for the calling thread, calls
+    ///        func(begin, end) for every slice and waits for all of them to complete.
+    ///        The whole range is processed on the calling thread if the pool is not started,
+    ///        if the range is too short to be split, or if called from a worker thread.
+    template<typename F> inline static void
+    ParallelFor(size_t length, size_t minSliceLength, const F& func)
+    {
+        size_t slices = IsStarted() && !IsWorkerThread() ? GetThreadsCount() + 1 : 1;
+        if (minSliceLength > 0 && length / minSliceLength < slices) {
+            slices = std::max<size_t>(length / minSliceLength, 1);
+        }
+
+        if (slices <= 1) {
+            func(size_t(0), length);
+            return;
+        }
+
+        const size_t sliceLength = length / slices;
+
+        std::vector<std::future<void>> results;
+        results.reserve(slices - 1);
+
+        size_t begin = 0;
+        for (size_t s = 0; s + 1 < slices; ++s, begin += sliceLength) {
+            results.push_back(QueueTask([&func, begin, sliceLength] { func(begin, begin + sliceLength); }));
+        }
+
+        // The last slice and the remainder. All slices must complete before returning, even
+        // if one of them throws, since the tasks reference func.
+        std::exception_ptr error;
+        try {
+            func(begin, length);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        for (auto& r : results)
+        {
+            try {
+                r.get();
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
     static bool   HasTasksQueued();
     static bool   IsIdle();
     static bool   IsStarted();
     static size_t GetThreadsCount() ;
 
+    /// @brief Returns true if called from one of the worker threads. Tasks running on the
+    ///        workers must not queue new tasks and wait for them, since all workers could
+    ///        end up waiting on tasks that are never started.
+    static bool   IsWorkerThread();
+
 private:
     static void threadLoop();
 
@@ -68,6 +128,7 @@ private:
     inline static std::mutex               s_queueMutex;
     inline static std::condition_variable  s_queueMutexCondition;
     inline static std::queue<Task>         s_jobs;
+    inline static thread_local bool        s_isWorkerThread = false;
 
 };
 
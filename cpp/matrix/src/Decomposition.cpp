@@ -0,0 +1,766 @@
+#include "Decomposition.hpp"
+#include "Memory.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+
+namespace
+{
+    // Panels of at most LEAF columns and triangles of at most LEAF rows are computed row by row,
+    // larger ones are halved and the second half is updated with the first by a product.
+    constexpr size_t LEAF = 16;
+
+    /// @brief Returns a RowMajor copy of the matrix.
+    /// @throws std::invalid_argument if the matrix is not square.
+    template<typename T> Matrix<T>
+    squareRowMajor(const Matrix<T>& matrix)
+    {
+        if (matrix.GetHeight() != matrix.GetWidth()) {
+            throw std::invalid_argument("Only square matrices can be factored, the matrix is " +
+                                        std::to_string(matrix.GetHeight()) + "X" + std::to_string(matrix.GetWidth()) + ".");
+        }
+        return matrix.ToOrdering(Matrix<T>::Ordering::RowMajor);
+    }
+
+    /// @brief Exchanges the rows i and pivots[i] of the RowMajor array for i in increasing order.
+    template<typename T> void
+    exchangeRows(T* data, size_t rowLength, const std::vector<size_t>& pivots)
+    {
+        for (size_t i = 0; i < pivots.size(); ++i) {
+            if (pivots[i] != i) {
+                std::swap_ranges(data + i * rowLength, data + (i + 1) * rowLength, data + pivots[i] * rowLength);
+            }
+        }
+    }
+
+    /// @brief Checks the dimensions of a least squares problem.
+    /// @throws std::invalid_argument if the heights differ or there are fewer rows than columns.
+    void
+    checkLeastSquares(size_t rows, size_t columns, size_t rhsRows)
+    {
+        if (rhsRows != rows) {
+            throw std::invalid_argument("Mismatching matrix dimensions for solving, the right hand side has " +
+                                        std::to_string(rhsRows) + " rows instead of " + std::to_string(rows) + ".");
+        }
+        if (rows < columns) {
+            throw std::invalid_argument("Least squares problems need at least as many rows as columns, the matrix is " +
+                                        std::to_string(rows) + "X" + std::to_string(columns) + ".");
+        }
+    }
+
+} // end anonymous namespace
+
+
+/****************************************
+ * Blocked operations
+ ****************************************/
+template<class T> void
+Decomposition<T>::multiply(MatrixView<const T> a, MatrixView<const T> b, T alpha, T beta, MatrixView<T> c)
+{ // static function
+    if (c.GetHeight() > 0 && c.GetWidth() > 0) {
+        Matrix<T>::multiplyInto(a, b, alpha, beta, c);
+    }
+}
+
+template<class T> void
+Decomposition<T>::solveUnitLower(MatrixView<const T> triangle, MatrixView<T> x)
+{ // static function
+    const size_t rows  = triangle.GetHeight();
+    const size_t width = x.GetWidth();
+
+    if (rows > LEAF)
+    {
+        const size_t top    = rows / 2;
+        const size_t bottom = rows - top;
+
+        solveUnitLower(triangle.Block(0, 0, top, top), x.Block(0, 0, top, width));
+        multiply(
+            triangle.Block(top, 0, bottom, top), x.Block(0, 0, top, width),
+            static_cast<T>(-1), static_cast<T>(1), x.Block(top, 0, bottom, width)
+        );
+        solveUnitLower(triangle.Block(top, top, bottom, bottom), x.Block(top, 0, bottom, width));
+        return;
+    }
+
+    const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+    const size_t minColumns = std::max<size_t>(Matrix<T>::MIN_OPERATIONS_PER_THREAD / std::max<size_t>(rows * rows / 2, 1), 1);
+
+    ThreadPool::ParallelFor(width, minColumns, [&](size_t begin, size_t end) {
+        for (size_t i = 1; i < rows; ++i)
+        {
+            T* row = x.Data() + i * x.GetLeadingDimension() + begin;
+            for (size_t r = 0; r < i; ++r) {
+                kernels.Axpy(-triangle(i, r), x.Data() + r * x.GetLeadingDimension() + begin, row, end - begin);
+            }
+        }
+    });
+}
+
+template<class T> void
+Decomposition<T>::solveUpper(MatrixView<const T> triangle, MatrixView<T> x)
+{ // static function
+    const size_t rows  = triangle.GetHeight();
+    const size_t width = x.GetWidth();
+
+    if (rows > LEAF)
+    {
+        const size_t top    = rows / 2;
+        const size_t bottom = rows - top;
+
+        solveUpper(triangle.Block(top, top, bottom, bottom), x.Block(top, 0, bottom, width));
+        multiply(
+            triangle.Block(0, top, top, bottom), x.Block(top, 0, bottom, width),
+            static_cast<T>(-1), static_cast<T>(1), x.Block(0, 0, top, width)
+        );
+        solveUpper(triangle.Block(0, 0, top, top), x.Block(0, 0, top, width));
+        return;
+    }
+
+    const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+    const size_t minColumns = std::max<size_t>(Matrix<T>::MIN_OPERATIONS_PER_THREAD / std::max<size_t>(rows * rows / 2, 1), 1);
+
+    ThreadPool::ParallelFor(width, minColumns, [&](size_t begin, size_t end) {
+        for (size_t i = rows; i-- > 0;)
+        {
+            T* row = x.Data() + i * x.GetLeadingDimension() + begin;
+            for (size_t r = i + 1; r < rows; ++r) {
+                kernels.Axpy(-triangle(i, r), x.Data() + r * x.GetLeadingDimension() + begin, row, end - begin);
+            }
+            kernels.Scale(static_cast<T>(1) / triangle(i, i), row, row, end - begin);
+        }
+    });
+}
+
+
+/****************************************
+ * LU factorization
+ ****************************************/
+template<class T>
+LuDecomposition<T>::LuDecomposition(const Matrix<T>& matrix)
+    : _factors(squareRowMajor(matrix))
+    , _pivots(matrix.GetHeight())
+    , _singular(false)
+{
+    const size_t n = GetSize();
+    const MatrixView<T> view = _factors.View();
+
+    for (size_t k = 0; k < n; k += BLOCK_SIZE)
+    {
+        const size_t width = std::min(BLOCK_SIZE, n - k);
+        const size_t rest  = n - k - width;
+
+        factorPanel(k, width);
+
+        if (rest > 0)
+        {
+            // U12 = L11^-1 * A12 and A22 -= L21 * U12.
+            solveUnitLower(view.Block(k, k, width, width), view.Block(k, k + width, width, rest));
+            multiply(
+                view.Block(k + width, k, rest, width), view.Block(k, k + width, width, rest),
+                static_cast<T>(-1), static_cast<T>(1), view.Block(k + width, k + width, rest, rest)
+            );
+        }
+    }
+}
+
+template<class T> void
+LuDecomposition<T>::factorPanel(size_t col, size_t width)
+{
+    const size_t n = GetSize();
+    const MatrixView<T> view = _factors.View();
+
+    if (width > LEAF)
+    {
+        const size_t left  = width / 2;
+        const size_t right = width - left;
+        const size_t below = n - col - left;
+
+        factorPanel(col, left);
+        solveUnitLower(view.Block(col, col, left, left), view.Block(col, col + left, left, right));
+        multiply(
+            view.Block(col + left, col, below, left), view.Block(col, col + left, left, right),
+            static_cast<T>(-1), static_cast<T>(1), view.Block(col + left, col + left, below, right)
+        );
+        factorPanel(col + left, right);
+        return;
+    }
+
+    T* a = view.Data();
+    const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+
+    for (size_t j = col; j < col + width; ++j)
+    {
+        size_t pivot = j;
+        for (size_t i = j + 1; i < n; ++i) {
+            if (std::abs(a[i * n + j]) > std::abs(a[pivot * n + j])) {
+                pivot = i;
+            }
+        }
+
+        // Whole rows are exchanged, the columns left of the panel belong to L and the ones
+        // right of it are updated with the exchanged rows later.
+        _pivots[j] = pivot;
+        if (pivot != j) {
+            std::swap_ranges(a + j * n, a + (j + 1) * n, a + pivot * n);
+        }
+
+        const T diagonal = a[j * n + j];
+        if (diagonal == static_cast<T>(0)) {
+            _singular = true;
+            continue;
+        }
+
+        // Eliminate the column below the pivot from the rest of the panel.
+        const T* pivotRow = a + j * n + j + 1;
+        const size_t rest = col + width - j - 1;
+        const size_t minRows = std::max<size_t>(Matrix<T>::MIN_OPERATIONS_PER_THREAD / std::max<size_t>(rest, 1), 1);
+
+        ThreadPool::ParallelFor(n - j - 1, minRows, [&](size_t begin, size_t end) {
+            for (size_t i = j + 1 + begin; i < j + 1 + end; ++i)
+            {
+                T* row = a + i * n + j;
+                row[0] /= diagonal;
+                kernels.Axpy(-row[0], pivotRow, row + 1, rest);
+            }
+        });
+    }
+}
+
+
+template<class T> size_t
+LuDecomposition<T>::GetSize() const
+{
+    return _factors.GetHeight();
+}
+
+template<class T> const std::vector<size_t>&
+LuDecomposition<T>::GetPivots() const
+{
+    return _pivots;
+}
+
+template<class T> Matrix<T>
+LuDecomposition<T>::GetLower() const
+{
+    const size_t n = GetSize();
+    Matrix<T> lower(n, n);
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            lower[i][j] = _factors[i][j];
+        }
+        lower[i][i] = static_cast<T>(1);
+    }
+
+    return lower;
+}
+
+template<class T> Matrix<T>
+LuDecomposition<T>::GetUpper() const
+{
+    const size_t n = GetSize();
+    Matrix<T> upper(n, n);
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i; j < n; ++j) {
+            upper[i][j] = _factors[i][j];
+        }
+    }
+
+    return upper;
+}
+
+template<class T> bool
+LuDecomposition<T>::IsSingular() const
+{
+    return _singular;
+}
+
+
+template<class T> T
+LuDecomposition<T>::Determinant() const
+{
+    // The product of the other pivots may overflow, which must not turn zero into NaN.
+    if (_singular) {
+        return static_cast<T>(0);
+    }
+
+    T determinant = static_cast<T>(1);
+
+    for (size_t i = 0; i < GetSize(); ++i)
+    {
+        determinant *= _factors[i][i];
+        if (_pivots[i] != i) {
+            determinant = -determinant;
+        }
+    }
+
+    return determinant;
+}
+
+template<class T> Matrix<T>
+LuDecomposition<T>::Solve(const Matrix<T>& rhs) const
+{
+    const size_t n = GetSize();
+
+    if (rhs.GetHeight() != n) {
+        throw std::invalid_argument("Mismatching matrix dimensions for solving, the right hand side has " +
+                                    std::to_string(rhs.GetHeight()) + " rows instead of " + std::to_string(n) + ".");
+    }
+    if (_singular) {
+        throw std::runtime_error("The matrix is singular.");
+    }
+
+    Matrix<T> x = rhs.ToOrdering(Matrix<T>::Ordering::RowMajor);
+    if (x.GetWidth() == 0) {
+        return x;
+    }
+
+    exchangeRows(x.View().Data(), x.GetWidth(), _pivots);
+    solveUnitLower(_factors.View(), x.View());
+    solveUpper(_factors.View(), x.View());
+
+    return x;
+}
+
+template<class T> Matrix<T>
+LuDecomposition<T>::Inverse() const
+{
+    return Solve(Matrix<T>::ID(GetSize()));
+}
+
+
+/****************************************
+ * QR factorization
+ ****************************************/
+template<class T>
+QrDecomposition<T>::QrDecomposition(const Matrix<T>& matrix)
+    : _factors(matrix.ToOrdering(Matrix<T>::Ordering::RowMajor))
+{
+    factor();
+}
+
+template<class T>
+QrDecomposition<T>::QrDecomposition(Matrix<T>&& matrix)
+    : _factors(std::move(matrix))
+{
+    if (_factors.GetOrdering() != Matrix<T>::Ordering::RowMajor) {
+        _factors = _factors.ToOrdering(Matrix<T>::Ordering::RowMajor);
+    }
+    factor();
+}
+
+template<class T> void
+QrDecomposition<T>::factor()
+{
+    const size_t m = GetHeight();
+    const size_t n = GetWidth();
+    const size_t p = std::min(m, n);
+    const MatrixView<T> view = _factors.View();
+
+    _scales.resize(p);
+
+    for (size_t k = 0; k < p; k += BLOCK_SIZE)
+    {
+        const size_t width = std::min(BLOCK_SIZE, p - k);
+
+        factorPanel(k, width);
+        _triangles.push_back(triangularFactor(k, width));
+
+        // A22 = Q^T * A22 with Q = I - V * T * V^T of the panel.
+        applyReflections(k, _triangles.back(), view.Block(k, k + width, m - k, n - k - width), true);
+    }
+}
+
+template<class T> void
+QrDecomposition<T>::factorPanel(size_t col, size_t width)
+{
+    const size_t m = GetHeight();
+    const size_t n = GetWidth();
+    const MatrixView<T> view = _factors.View();
+
+    if (width > LEAF)
+    {
+        const size_t left = width / 2;
+
+        factorPanel(col, left);
+        applyReflections(col, triangularFactor(col, left), view.Block(col, col + left, m - col, width - left), true);
+        factorPanel(col + left, width - left);
+        return;
+    }
+
+    // The narrow panel is copied to a column major scratch buffer, so that the reflections are
+    // dot products and updates of whole columns. Its allocation is hidden by the panel work.
+    const size_t rows = m - col;
+    const Memory::Buffer<T> scratch = Memory::Allocate<T>(rows * width + width);
+    T* panel = scratch.get();
+    T* w = scratch.get() + rows * width;
+    T* a = view.Data() + col * n + col;
+
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t c = 0; c < width; ++c) {
+            panel[c * rows + i] = a[i * n + c];
+        }
+    }
+
+    const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+
+    for (size_t j = 0; j < width; ++j)
+    {
+        // The reflection with H * x = (mu, 0, ..., 0) and mu = |x| >= 0 for the column x from
+        // the diagonal down, with v_0 = 1 and the rest of v stored in place of the zeros, see
+        // Golub and Van Loan, Matrix Computations, 4th ed., Alg. 5.1.1.
+        T* x = panel + j * rows + j;
+        const size_t length = rows - j;
+
+        T sigma = 0;
+        kernels.DotRows(1, length - 1, x + 1, 0, x + 1, &sigma);
+
+        const T x0 = x[0];
+        T tau = 0;
+        T mu = std::abs(x0);
+        if (sigma == static_cast<T>(0))
+        {
+            // The column is already reduced, only a negative diagonal is reflected.
+            tau = x0 < static_cast<T>(0) ? static_cast<T>(2) : static_cast<T>(0);
+        }
+        else
+        {
+            mu = std::sqrt(x0 * x0 + sigma);
+            const T v0 = x0 <= static_cast<T>(0) ? x0 - mu : -sigma / (x0 + mu);
+            tau = static_cast<T>(2) * v0 * v0 / (sigma + v0 * v0);
+            kernels.Scale(static_cast<T>(1) / v0, x + 1, x + 1, length - 1);
+        }
+        _scales[col + j] = tau;
+
+        // Reflect the rest of the panel: w = A^T * v and A -= tau * v * w^T.
+        const size_t rest = width - j - 1;
+        if (tau != static_cast<T>(0) && rest > 0)
+        {
+            x[0] = static_cast<T>(1);
+            kernels.DotRows(rest, length, x + rows, rows, x, w);
+            for (size_t c = 0; c < rest; ++c) {
+                kernels.Axpy(-tau * w[c], x, x + (c + 1) * rows, length);
+            }
+        }
+        x[0] = mu;
+    }
+
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t c = 0; c < width; ++c) {
+            a[i * n + c] = panel[c * rows + i];
+        }
+    }
+}
+
+
+template<class T> Matrix<T>
+QrDecomposition<T>::reflectionVectors(size_t col, size_t width) const
+{
+    const size_t rows = GetHeight() - col;
+    Matrix<T> v(rows, width);
+
+    for (size_t i = 0; i < rows; ++i)
+    {
+        const size_t diagonal = std::min(i, width);
+        std::copy(&_factors[col + i][col], &_factors[col + i][col] + diagonal, &v[i][0]);
+        if (i < width) {
+            v[i][i] = static_cast<T>(1);
+        }
+    }
+
+    return v;
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::triangularFactor(size_t col, size_t width) const
+{
+    // T(0:i, i) = -tau_i * T(0:i, 0:i) * V(:, 0:i)^T * v_i, with the inner products of the
+    // reflection vectors computed by one product.
+    const Matrix<T> v = reflectionVectors(col, width);
+    const MatrixView<const T> vt(v.View().Data(), width, v.GetHeight(), width, Matrix<T>::Ordering::ColumnMajor);
+
+    Matrix<T> gram(width, width);
+    multiply(vt, v.View(), static_cast<T>(1), static_cast<T>(0), gram.View());
+
+    Matrix<T> triangle(width, width);
+    for (size_t i = 0; i < width; ++i)
+    {
+        const T tau = _scales[col + i];
+        triangle[i][i] = tau;
+        for (size_t r = 0; r < i; ++r)
+        {
+            T sum = 0;
+            for (size_t c = r; c < i; ++c) {
+                sum += triangle[r][c] * gram[c][i];
+            }
+            triangle[r][i] = -tau * sum;
+        }
+    }
+
+    return triangle;
+}
+
+template<class T> void
+QrDecomposition<T>::applyReflections(size_t col, const Matrix<T>& triangle, MatrixView<T> c, bool transpose) const
+{
+    const size_t width   = triangle.GetWidth();
+    const size_t columns = c.GetWidth();
+    if (columns == 0) {
+        return;
+    }
+
+    // C -= V * (T * (V^T * C)), with T^T for Q^T.
+    const Matrix<T> v = reflectionVectors(col, width);
+    const MatrixView<const T> vt(v.View().Data(), width, v.GetHeight(), width, Matrix<T>::Ordering::ColumnMajor);
+    const MatrixView<const T> t = transpose
+        ? MatrixView<const T>(triangle.View().Data(), width, width, width, Matrix<T>::Ordering::ColumnMajor)
+        : triangle.View();
+
+    Matrix<T> product(width, columns);
+    Matrix<T> scaled(width, columns);
+    multiply(vt, c, static_cast<T>(1), static_cast<T>(0), product.View());
+    multiply(t, product.View(), static_cast<T>(1), static_cast<T>(0), scaled.View());
+    multiply(v.View(), scaled.View(), static_cast<T>(-1), static_cast<T>(1), c);
+}
+
+template<class T> size_t
+QrDecomposition<T>::GetHeight() const
+{
+    return _factors.GetHeight();
+}
+
+template<class T> size_t
+QrDecomposition<T>::GetWidth() const
+{
+    return _factors.GetWidth();
+}
+
+template<class T> const std::vector<T>&
+QrDecomposition<T>::GetScales() const
+{
+    return _scales;
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::GetR() const
+{
+    const size_t p = _scales.size();
+    Matrix<T> r(p, GetWidth());
+
+    for (size_t i = 0; i < p; ++i) {
+        for (size_t j = i; j < GetWidth(); ++j) {
+            r[i][j] = _factors[i][j];
+        }
+    }
+
+    return r;
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::GetQ() const
+{
+    const size_t p = _scales.size();
+    Matrix<T> identity(GetHeight(), p);
+
+    for (size_t i = 0; i < p; ++i) {
+        identity[i][i] = static_cast<T>(1);
+    }
+
+    return MultiplyQ(identity);
+}
+
+template<class T> bool
+QrDecomposition<T>::IsRankDeficient() const
+{
+    for (size_t i = 0; i < _scales.size(); ++i) {
+        if (_factors[i][i] == static_cast<T>(0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::MultiplyQ(const Matrix<T>& rhs) const
+{
+    if (rhs.GetHeight() != GetHeight()) {
+        throw std::invalid_argument("Mismatching matrix dimensions for the multiplication with Q.");
+    }
+
+    Matrix<T> x = rhs.ToOrdering(Matrix<T>::Ordering::RowMajor);
+
+    // Q = Q_0 * Q_1 * ..., the last panel is applied first.
+    for (size_t k = _triangles.size(); k-- > 0;)
+    {
+        const size_t col = k * BLOCK_SIZE;
+        applyReflections(col, _triangles[k], x.Block(col, 0, GetHeight() - col, x.GetWidth()), false);
+    }
+
+    return x;
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::MultiplyQTranspose(const Matrix<T>& rhs) const
+{
+    if (rhs.GetHeight() != GetHeight()) {
+        throw std::invalid_argument("Mismatching matrix dimensions for the multiplication with Q^T.");
+    }
+
+    Matrix<T> x = rhs.ToOrdering(Matrix<T>::Ordering::RowMajor);
+
+    for (size_t k = 0; k < _triangles.size(); ++k)
+    {
+        const size_t col = k * BLOCK_SIZE;
+        applyReflections(col, _triangles[k], x.Block(col, 0, GetHeight() - col, x.GetWidth()), true);
+    }
+
+    return x;
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::Solve(const Matrix<T>& rhs) const
+{
+    const size_t n = GetWidth();
+
+    checkLeastSquares(GetHeight(), n, rhs.GetHeight());
+    if (IsRankDeficient()) {
+        throw std::runtime_error("The matrix is rank deficient.");
+    }
+
+    const Matrix<T> y = MultiplyQTranspose(rhs);
+    Matrix<T> x(n, rhs.GetWidth());
+    x.View().CopyFrom(y.Block(0, 0, n, rhs.GetWidth()));
+
+    solveUpper(_factors.Block(0, 0, n, n), x.View());
+    return x;
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::TallSkinnyR(const Matrix<T>& matrix)
+{ // static function
+    const MatrixView<const T> a = matrix.View();
+    return tallSkinny(a, MatrixView<const T>(a.Data(), matrix.GetHeight(), 0, 0));
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::TallSkinnySolve(const Matrix<T>& a, const Matrix<T>& rhs)
+{ // static function
+    const size_t n = a.GetWidth();
+    const size_t k = rhs.GetWidth();
+
+    checkLeastSquares(a.GetHeight(), n, rhs.GetHeight());
+
+    const Matrix<T> r = tallSkinny(a.View(), rhs.View());
+    for (size_t i = 0; i < n; ++i) {
+        if (r[i][i] == static_cast<T>(0)) {
+            throw std::runtime_error("The matrix is rank deficient.");
+        }
+    }
+
+    Matrix<T> x(n, k);
+    x.View().CopyFrom(r.Block(0, n, n, k));
+
+    solveUpper(r.Block(0, 0, n, n), x.View());
+    return x;
+}
+
+template<class T> Matrix<T>
+QrDecomposition<T>::tallSkinny(MatrixView<const T> a, MatrixView<const T> b)
+{ // static function
+    const size_t m = a.GetHeight();
+    const size_t n = a.GetWidth() + b.GetWidth();
+
+    if (m == 0 || n == 0) {
+        return Matrix<T>(0, n);
+    }
+
+    // The last block also takes the remaining rows, every block has at least blockRows rows.
+    const size_t blockRows = std::max(TALL_SKINNY_ROWS * n, MIN_TALL_SKINNY_ROWS);
+    const size_t blocks = std::max<size_t>(m / blockRows, 1);
+    const size_t minBlocks = std::max<size_t>(Matrix<T>::MIN_OPERATIONS_PER_THREAD / (2 * blockRows * n * n), 1);
+
+    // Returns R of the rows of [a, b] stacked below the triangle.
+    const auto factorStacked = [&](const Matrix<T>& top, size_t row, size_t rows)
+    {
+        Matrix<T> stacked(top.GetHeight() + rows, n);
+        stacked.Block(0, 0, top.GetHeight(), n).CopyFrom(top.View());
+        stacked.Block(top.GetHeight(), 0, rows, a.GetWidth()).CopyFrom(a.Block(row, 0, rows, a.GetWidth()));
+        stacked.Block(top.GetHeight(), a.GetWidth(), rows, b.GetWidth()).CopyFrom(b.Block(row, 0, rows, b.GetWidth()));
+        return QrDecomposition(std::move(stacked)).GetR();
+    };
+
+    std::vector<Matrix<T>> level(blocks, Matrix<T>(0, n));
+
+    ThreadPool::ParallelFor(blocks, minBlocks, [&](size_t begin, size_t end) {
+        Matrix<T> r(0, n);
+        for (size_t i = begin; i < end; ++i)
+        {
+            const size_t row = i * blockRows;
+            r = factorStacked(r, row, i + 1 == blocks ? m - row : blockRows);
+        }
+        level[begin] = std::move(r);
+    });
+
+    level.erase(std::remove_if(level.begin(), level.end(), [](const Matrix<T>& r) { return r.GetHeight() == 0; }), level.end());
+
+    // Merge pairs of triangles until one is left.
+    while (level.size() > 1)
+    {
+        const size_t pairs = level.size() / 2;
+        std::vector<Matrix<T>> next(pairs, Matrix<T>(0, n));
+
+        ThreadPool::ParallelFor(pairs, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Matrix<T>& bottom = level[2 * i + 1];
+                Matrix<T> stacked(level[2 * i].GetHeight() + bottom.GetHeight(), n);
+                stacked.Block(0, 0, level[2 * i].GetHeight(), n).CopyFrom(level[2 * i].View());
+                stacked.Block(level[2 * i].GetHeight(), 0, bottom.GetHeight(), n).CopyFrom(bottom.View());
+                next[i] = QrDecomposition(std::move(stacked)).GetR();
+            }
+        });
+
+        if (level.size() % 2 == 1) {
+            next.push_back(std::move(level.back()));
+        }
+        level = std::move(next);
+    }
+
+    return std::move(level.front());
+}
+
+
+/****************************************
+ * Matrix functions
+ ****************************************/
+template<class T> Matrix<T>
+Matrix<T>::Inverse() const
+{
+    return LuDecomposition<T>(*this).Inverse();
+}
+
+template<class T> T
+Matrix<T>::Determinant() const
+{
+    return LuDecomposition<T>(*this).Determinant();
+}
+
+
+template class Decomposition<float>;
+template class Decomposition<double>;
+template class LuDecomposition<float>;
+template class LuDecomposition<double>;
+template class QrDecomposition<float>;
+template class QrDecomposition<double>;
+
+template Matrix<float> Matrix<float>::Inverse() const;
+template Matrix<double> Matrix<double>::Inverse() const;
+template float Matrix<float>::Determinant() const;
+template double Matrix<double>::Determinant() const;
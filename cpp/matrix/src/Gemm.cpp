@@ -0,0 +1,872 @@
+#include "Gemm.hpp"
+#include "Memory.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+namespace
+{
+    /// @brief Packs a mc x kc block of A into row panels of MR rows. Inside a panel the MR
+    ///        elements of one column are contiguous, so the micro-kernel reads A sequentially.
+    ///        Rows past mc in the last panel are padded with zeros. The elements are converted
+    ///        to the packed type P, the accumulator type of T.
+    template<typename T, typename P> void
+    packA(size_t mc, size_t kc, const T* a, Gemm::Strides as, size_t MR, P* packed)
+    {
+        for (size_t ir = 0; ir < mc; ir += MR, packed += kc * MR)
+        {
+            const size_t mr = std::min(MR, mc - ir);
+            const T* ai = a + ir * as.Row;
+
+            if (as.Col == 1)
+            { // RowMajor, read along the rows of A.
+                for (size_t i = 0; i < mr; ++i) {
+                    const T* row = ai + i * as.Row;
+                    for (size_t p = 0; p < kc; ++p) {
+                        packed[p * MR + i] = row[p];
+                    }
+                }
+            }
+            else
+            { // ColumnMajor (or strided), read along the columns of A.
+                for (size_t p = 0; p < kc; ++p) {
+                    const T* col = ai + p * as.Col;
+                    for (size_t i = 0; i < mr; ++i) {
+                        packed[p * MR + i] = col[i * as.Row];
+                    }
+                }
+            }
+
+            for (size_t p = 0; p < kc; ++p) {
+                for (size_t i = mr; i < MR; ++i) {
+                    packed[p * MR + i] = static_cast<P>(0);
+                }
+            }
+        }
+    }
+
+    /// @brief Packs a kc x nc block of B into column panels of NR columns. Inside a panel the
+    ///        NR elements of one row are contiguous, so the micro-kernel reads B sequentially.
+    ///        Columns past nc in the last panel are padded with zeros. The elements are converted
+    ///        to the packed type P, the accumulator type of T, with the vector kernel widen for
+    ///        contiguous lines of B since the panels of the 16 bit types are packed repeatedly.
+    template<typename T, typename P> void
+    packB(size_t kc, size_t nc, const T* b, Gemm::Strides bs, size_t NR, P* packed, void (*widen)(const T*, P*, size_t))
+    {
+        for (size_t jr = 0; jr < nc; jr += NR, packed += kc * NR)
+        {
+            const size_t nr = std::min(NR, nc - jr);
+            const T* bj = b + jr * bs.Col;
+
+            if (bs.Col == 1)
+            { // RowMajor, read along the rows of B.
+                for (size_t p = 0; p < kc; ++p) {
+                    const T* row = bj + p * bs.Row;
+                    if constexpr (std::is_same<T, P>()) {
+                        for (size_t j = 0; j < nr; ++j) {
+                            packed[p * NR + j] = row[j];
+                        }
+                    } else {
+                        widen(row, packed + p * NR, nr);
+                    }
+                }
+            }
+            else
+            { // ColumnMajor (or strided), read along the columns of B.
+                for (size_t j = 0; j < nr; ++j) {
+                    const T* col = bj + j * bs.Col;
+                    if constexpr (!std::is_same<T, P>())
+                    {
+                        if (bs.Row == 1)
+                        { // Widened into a contiguous column first, kc is at most KC.
+                            alignas(64) P column[Gemm::BlockSizes<P>::KC];
+                            widen(col, column, kc);
+                            for (size_t p = 0; p < kc; ++p) {
+                                packed[p * NR + j] = column[p];
+                            }
+                            continue;
+                        }
+                    }
+                    for (size_t p = 0; p < kc; ++p) {
+                        packed[p * NR + j] = col[p * bs.Row];
+                    }
+                }
+            }
+
+            for (size_t p = 0; p < kc; ++p) {
+                for (size_t j = nr; j < NR; ++j) {
+                    packed[p * NR + j] = static_cast<P>(0);
+                }
+            }
+        }
+    }
+
+    /// @brief Writes the mr x nr elements of a computed tile into C as C = alpha * tile + beta * C.
+    ///        If beta is zero, the existing values of C are not read. The tile and the scalars
+    ///        are of the accumulator type S of T, C is only rounded to T when it is written.
+    template<typename S, typename T> void
+    storeTile(const S* tile, size_t NR, S alpha, S beta, T* c, Gemm::Strides cs, size_t mr, size_t nr)
+    {
+        for (size_t i = 0; i < mr; ++i)
+        {
+            T* ci = c + i * cs.Row;
+            const S* ti = tile + i * NR;
+            if (beta == static_cast<S>(0)) {
+                for (size_t j = 0; j < nr; ++j) {
+                    ci[j * cs.Col] = alpha * ti[j];
+                }
+            } else if (beta == static_cast<S>(1)) {
+                for (size_t j = 0; j < nr; ++j) {
+                    ci[j * cs.Col] += alpha * ti[j];
+                }
+            } else {
+                for (size_t j = 0; j < nr; ++j) {
+                    ci[j * cs.Col] = alpha * ti[j] + beta * ci[j * cs.Col];
+                }
+            }
+        }
+    }
+
+    /// @brief Packs a mc x kc block of 8 bit A into row panels of MR rows in the layout of the
+    ///        quantized micro-kernels, see Simd::QuantizedKernels. Signed elements are offset by
+    ///        128 to unsigned. Rows past mc and the elements past kc in the last group are padded
+    ///        with zeros.
+    template<typename L> void
+    packQuantizedA(size_t mc, size_t kc, const L* a, Gemm::Strides as, size_t MR, uint8_t* packed)
+    {
+        constexpr size_t G = Simd::QUANTIZED_GROUP;
+        const size_t kPadded = (kc + G - 1) / G * G;
+
+        for (size_t ir = 0; ir < mc; ir += MR, packed += kPadded * MR)
+        {
+            const size_t mr = std::min(MR, mc - ir);
+            const L* ai = a + ir * as.Row;
+
+            for (size_t i = 0; i < MR; ++i) {
+                for (size_t p = 0; p < kPadded; ++p)
+                {
+                    const int value = i < mr && p < kc ? ai[i * as.Row + p * as.Col] + (std::is_signed<L>() ? 128 : 0) : 0;
+                    packed[(p / G * MR + i) * G + p % G] = static_cast<uint8_t>(value);
+                }
+            }
+        }
+    }
+
+    /// @brief Packs a kc x nc block of int8 B into column panels of NR columns in the layout of
+    ///        the quantized micro-kernels. Columns past nc and the elements past kc in the last
+    ///        group are padded with zeros.
+    void
+    packQuantizedB(size_t kc, size_t nc, const int8_t* b, Gemm::Strides bs, size_t NR, int8_t* packed)
+    {
+        constexpr size_t G = Simd::QUANTIZED_GROUP;
+        const size_t kPadded = (kc + G - 1) / G * G;
+
+        for (size_t jr = 0; jr < nc; jr += NR, packed += kPadded * NR)
+        {
+            const size_t nr = std::min(NR, nc - jr);
+            const int8_t* bj = b + jr * bs.Col;
+
+            std::fill(packed, packed + kPadded * NR, static_cast<int8_t>(0));
+
+            if (bs.Col == 1)
+            { // RowMajor, read along the rows of B.
+                for (size_t p = 0; p < kc; ++p) {
+                    for (size_t j = 0; j < nr; ++j) {
+                        packed[(p / G * NR + j) * G + p % G] = bj[p * bs.Row + j];
+                    }
+                }
+            }
+            else
+            { // ColumnMajor (or strided), read along the columns of B.
+                for (size_t j = 0; j < nr; ++j) {
+                    for (size_t p = 0; p < kc; ++p) {
+                        packed[(p / G * NR + j) * G + p % G] = bj[j * bs.Col + p * bs.Row];
+                    }
+                }
+            }
+        }
+    }
+
+    size_t roundUp(size_t value, size_t multiple)
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    /****************************************
+     * Strassen-Winograd helpers
+     ****************************************/
+
+    /// @brief The seven products of the Winograd variant, as coefficients of the quadrants
+    ///        (11, 12, 21, 22) of A and B forming the operands, and of the quadrants of C
+    ///        the product contributes to. Written out, with S and T as in the literature:
+    ///        P1 = A11 * B11, P2 = A12 * B21, P3 = S4 * B22, P4 = A22 * T4,
+    ///        P5 = S1 * T1,   P6 = S2 * T2,   P7 = S3 * T3,
+    ///        C11 = P1 + P2, C12 = P1 + P6 + P5 + P3, C21 = P1 + P6 + P7 - P4, C22 = P1 + P6 + P7 + P5.
+    struct StrassenProduct
+    {
+        int A[4];
+        int B[4];
+        int C[4];
+    };
+
+    constexpr StrassenProduct STRASSEN_WINOGRAD_PRODUCTS[7] = {
+        { {  1, 0,  0, 0 }, {  1,  0,  0, 0 }, { 1, 1,  1, 1 } }, // P1
+        { {  0, 1,  0, 0 }, {  0,  0,  1, 0 }, { 1, 0,  0, 0 } }, // P2
+        { {  1, 1, -1,-1 }, {  0,  0,  0, 1 }, { 0, 1,  0, 0 } }, // P3 = S4 * B22
+        { {  0, 0,  0, 1 }, {  1, -1, -1, 1 }, { 0, 0, -1, 0 } }, // P4 = A22 * T4
+        { {  0, 0,  1, 1 }, { -1,  1,  0, 0 }, { 0, 1,  0, 1 } }, // P5 = S1 * T1
+        { { -1, 0,  1, 1 }, {  1, -1,  0, 1 }, { 0, 1,  1, 1 } }, // P6 = S2 * T2
+        { {  1, 0, -1, 0 }, {  0, -1,  0, 1 }, { 0, 0,  1, 1 } }, // P7 = S3 * T3
+    };
+
+    /// @brief Forms the linear combination of the four quadrants given by coefs. If the combination
+    ///        is a single quadrant, no copy is made and the quadrant itself is returned.
+    /// @param buffer Output buffer of rows * cols elements for the combination, stored in row major order.
+    /// @param outStrides Set to the strides of the returned operand.
+    template<typename T> const T*
+    combineQuadrants(
+        const T* const quadrants[4], Gemm::Strides s, const int coefs[4],
+        size_t rows, size_t cols, T* buffer, Gemm::Strides& outStrides)
+    {
+        size_t nonZero = 0;
+        size_t last = 0;
+        for (size_t q = 0; q < 4; ++q) {
+            if (coefs[q] != 0) {
+                ++nonZero;
+                last = q;
+            }
+        }
+
+        if (nonZero == 1 && coefs[last] == 1) {
+            outStrides = s;
+            return quadrants[last];
+        }
+
+        outStrides = { cols, 1 };
+        for (size_t i = 0; i < rows; ++i)
+        {
+            T* out = buffer + i * cols;
+            for (size_t j = 0; j < cols; ++j) {
+                out[j] = static_cast<T>(0);
+            }
+            for (size_t q = 0; q < 4; ++q)
+            {
+                const T* in = quadrants[q] + i * s.Row;
+                if (coefs[q] == 1) {
+                    for (size_t j = 0; j < cols; ++j) {
+                        out[j] += in[j * s.Col];
+                    }
+                } else if (coefs[q] == -1) {
+                    for (size_t j = 0; j < cols; ++j) {
+                        out[j] -= in[j * s.Col];
+                    }
+                }
+            }
+        }
+
+        return buffer;
+    }
+
+    /// @brief Adds (coef = 1), subtracts (coef = -1) or assigns (assign = true) the row major
+    ///        product p of size rows x cols into the quadrant c.
+    template<typename T> void
+    accumulateQuadrant(const T* p, size_t rows, size_t cols, T* c, Gemm::Strides cs, int coef, bool assign)
+    {
+        for (size_t i = 0; i < rows; ++i)
+        {
+            const T* pi = p + i * cols;
+            T* ci = c + i * cs.Row;
+            for (size_t j = 0; j < cols; ++j)
+            {
+                T& cij = ci[j * cs.Col];
+                if (assign) {
+                    cij = pi[j];
+                } else if (coef == 1) {
+                    cij += pi[j];
+                } else {
+                    cij -= pi[j];
+                }
+            }
+        }
+    }
+
+    template<typename T> void
+    strassenRecursive(
+        size_t m, size_t n, size_t k,
+        const T* a, Gemm::Strides as,
+        const T* b, Gemm::Strides bs,
+        T* c, Gemm::Strides cs,
+        size_t cutoff,
+        bool parallel)
+    {
+        if (std::min({ m, n, k }) <= std::max<size_t>(cutoff, 1)) {
+            Gemm::Multiply<T>(m, n, k, a, as, b, bs, c, cs);
+            return;
+        }
+
+        const size_t hm = m / 2;
+        const size_t hn = n / 2;
+        const size_t hk = k / 2;
+
+        const T* const aq[4] = { a, a + hk * as.Col, a + hm * as.Row, a + hm * as.Row + hk * as.Col };
+        const T* const bq[4] = { b, b + hn * bs.Col, b + hk * bs.Row, b + hk * bs.Row + hn * bs.Col };
+        T* const       cq[4] = { c, c + hn * cs.Col, c + hm * cs.Row, c + hm * cs.Row + hn * cs.Col };
+
+        // Scratch for one product: the combined operands (S and T) and the product P.
+        struct Scratch
+        {
+            Memory::Buffer<T> Lhs;
+            Memory::Buffer<T> Rhs;
+            Memory::Buffer<T> Product;
+        };
+
+        const auto allocateScratch = [hm, hn, hk]() {
+            return Scratch{
+                Memory::Allocate<T>(hm * hk),
+                Memory::Allocate<T>(hk * hn),
+                Memory::Allocate<T>(hm * hn)
+            };
+        };
+
+        const auto computeProduct = [&](size_t idx, Scratch& scratch)
+        {
+            const StrassenProduct& product = STRASSEN_WINOGRAD_PRODUCTS[idx];
+            Gemm::Strides sStrides;
+            Gemm::Strides tStrides;
+            const T* sOp = combineQuadrants(aq, as, product.A, hm, hk, scratch.Lhs.get(), sStrides);
+            const T* tOp = combineQuadrants(bq, bs, product.B, hk, hn, scratch.Rhs.get(), tStrides);
+            strassenRecursive<T>(hm, hn, hk, sOp, sStrides, tOp, tStrides, scratch.Product.get(), { hn, 1 }, cutoff, false);
+            return true;
+        };
+
+        const auto accumulateProduct = [&](size_t idx, const Scratch& scratch)
+        {
+            const StrassenProduct& product = STRASSEN_WINOGRAD_PRODUCTS[idx];
+            for (size_t q = 0; q < 4; ++q) {
+                if (product.C[q] != 0) {
+                    // P1 contributes to every quadrant and is accumulated first, so it initializes C.
+                    accumulateQuadrant(scratch.Product.get(), hm, hn, cq[q], cs, product.C[q], idx == 0);
+                }
+            }
+        };
+
+        if (parallel)
+        {
+            std::vector<Scratch> scratch;
+            for (size_t i = 0; i < 7; ++i) {
+                scratch.push_back(allocateScratch());
+            }
+
+            std::vector<std::future<bool>> threadResults;
+            for (size_t i = 1; i < 7; ++i) {
+                threadResults.push_back(ThreadPool::QueueTask(std::bind(computeProduct, i, std::ref(scratch[i]))));
+            }
+
+            computeProduct(0, scratch[0]);
+
+            for (auto& res : threadResults) {
+                res.get();
+            }
+
+            for (size_t i = 0; i < 7; ++i) {
+                accumulateProduct(i, scratch[i]);
+            }
+        }
+        else
+        {
+            Scratch scratch = allocateScratch();
+            for (size_t i = 0; i < 7; ++i) {
+                computeProduct(i, scratch);
+                accumulateProduct(i, scratch);
+            }
+        }
+
+        // Fix up the peeled off parts of odd dimensions with the classic kernel.
+        if (k > 2 * hk)
+        { // C[0:2hm, 0:2hn] += A[0:2hm, k-1] * B[k-1, 0:2hn]
+            Gemm::Multiply<T>(
+                2 * hm, 2 * hn, 1,
+                static_cast<T>(1),
+                a + (k - 1) * as.Col, as,
+                b + (k - 1) * bs.Row, bs,
+                static_cast<T>(1),
+                c, cs
+            );
+        }
+        if (n > 2 * hn)
+        { // C[0:2hm, n-1] = A[0:2hm, :] * B[:, n-1]
+            Gemm::Multiply<T>(2 * hm, 1, k, a, as, b + (n - 1) * bs.Col, bs, c + (n - 1) * cs.Col, cs);
+        }
+        if (m > 2 * hm)
+        { // C[m-1, :] = A[m-1, :] * B
+            Gemm::Multiply<T>(1, n, k, a + (m - 1) * as.Row, as, b, bs, c + (m - 1) * cs.Row, cs);
+        }
+    }
+
+} // end anonymous namespace
+
+
+size_t
+Gemm::Partition::Bound(size_t extent, size_t parts, size_t i, size_t grain)
+{ // static function
+    if (i >= parts) {
+        return extent;
+    }
+
+    const size_t bound = extent / parts * i + extent % parts * i / parts;
+    return extent / parts >= grain ? bound / grain * grain : bound;
+}
+
+Gemm::Partition
+Gemm::PlanPartition(size_t m, size_t n, size_t k, size_t tasks, size_t minOperationsPerTask)
+{
+    // Tiles of C thinner than this pack too little of A or B per block to run at full speed.
+    constexpr size_t MIN_TILE_EDGE = 64;
+    constexpr size_t MIN_DEPTH     = BlockSizes<double>::KC;
+
+    const double operations = static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(k);
+    const double maxTasks   = operations / static_cast<double>(std::max<size_t>(minOperationsPerTask, 1));
+    if (maxTasks < static_cast<double>(tasks)) {
+        tasks = static_cast<size_t>(std::max(maxTasks, 1.0));
+    }
+
+    Partition partition = { 1, 1, 1 };
+
+    // Assign the largest prime factors first, while the extents are still large.
+    std::vector<size_t> factors;
+    for (size_t p = 2; p * p <= tasks; ++p) {
+        for (; tasks % p == 0; tasks /= p) {
+            factors.push_back(p);
+        }
+    }
+    if (tasks > 1) {
+        factors.push_back(tasks);
+    }
+
+    for (auto it = factors.rbegin(); it != factors.rend(); ++it)
+    {
+        const size_t p = *it;
+        const size_t rows    = m / partition.Rows;
+        const size_t columns = n / partition.Columns;
+        const size_t depth   = k / partition.Depth;
+
+        if (std::max(rows, columns) / p >= MIN_TILE_EDGE)
+        {
+            (rows >= columns ? partition.Rows : partition.Columns) *= p;
+        }
+        else if (depth / p >= MIN_DEPTH)
+        {
+            partition.Depth *= p;
+        }
+        else if (std::max(rows, columns) >= p)
+        {
+            (rows >= columns ? partition.Rows : partition.Columns) *= p;
+        }
+    }
+
+    return partition;
+}
+
+
+template<typename T> void
+Gemm::Multiply(
+    size_t m, size_t n, size_t k,
+    T alpha,
+    const T* a, Strides as,
+    const T* b, Strides bs,
+    T beta,
+    T* c, Strides cs)
+{
+    using S = AccumulatorType<T>;
+    using Blocks = BlockSizes<S>;
+
+    if (k == 0)
+    { // Empty inner dimension, the product is a zero matrix.
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                T& cij = c[i * cs.Row + j * cs.Col];
+                cij = beta == static_cast<T>(0) ? static_cast<T>(0) : static_cast<T>(beta * cij);
+            }
+        }
+        return;
+    }
+
+    if (m == 0 || n == 0) {
+        return;
+    }
+
+    const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+    const size_t MR = kernels.MR;
+    const size_t NR = kernels.NR;
+    const size_t MC = std::max(MR, Blocks::MC / MR * MR);
+
+    // The packing buffers are not initialized, the packing routines overwrite every element they use.
+    const size_t kcMax = std::min(Blocks::KC, k);
+    const Memory::Buffer<S> aPacked = Memory::Allocate<S>(roundUp(std::min(MC, m), MR) * kcMax);
+    const Memory::Buffer<S> bPacked = Memory::Allocate<S>(roundUp(std::min(Blocks::NC, n), NR) * kcMax);
+    const Strides packedAStrides = { 1, MR };
+
+    alignas(64) S tile[Simd::MAX_TILE_ELEMENTS];
+
+    if constexpr (std::is_same<T, S>())
+    {
+        // Loop order (outermost first): L3 panel of B, L2 block of A, L1 sliver of B, register tile.
+        for (size_t jc = 0; jc < n; jc += Blocks::NC)
+        {
+            const size_t nc = std::min(Blocks::NC, n - jc);
+
+            for (size_t pc = 0; pc < k; pc += Blocks::KC)
+            {
+                const size_t kc = std::min(Blocks::KC, k - pc);
+                const T betaBlock = pc == 0 ? beta : static_cast<T>(1);
+
+                packB(kc, nc, b + pc * bs.Row + jc * bs.Col, bs, NR, bPacked.get(), kernels.Widen);
+
+                for (size_t ic = 0; ic < m; ic += MC)
+                {
+                    const size_t mc = std::min(MC, m - ic);
+
+                    packA(mc, kc, a + ic * as.Row + pc * as.Col, as, MR, aPacked.get());
+
+                    for (size_t jr = 0; jr < nc; jr += NR)
+                    {
+                        const size_t nr = std::min(NR, nc - jr);
+                        const T* bSliver = bPacked.get() + jr * kc;
+
+                        for (size_t ir = 0; ir < mc; ir += MR)
+                        {
+                            const size_t mr = std::min(MR, mc - ir);
+
+                            kernels.MicroKernel(kc, aPacked.get() + ir * kc, packedAStrides, bSliver, NR, tile);
+                            storeTile(tile, NR, alpha, betaBlock, c + (ic + ir) * cs.Row + (jc + jr) * cs.Col, cs, mr, nr);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        // The 16 bit types would lose the partial sums of the inner blocks to rounding if they
+        // were accumulated in C, so a block of C is summed in a float block and rounded once.
+        // The inner blocks loop inside the blocks of A, which packs every panel of B once per
+        // block of A, a fraction 1 / MC of the multiply-adds.
+        const size_t ncMax = std::min(Blocks::NC, n);
+        const Memory::Buffer<S> sums = Memory::Allocate<S>(std::min(MC, m) * ncMax);
+
+        for (size_t jc = 0; jc < n; jc += Blocks::NC)
+        {
+            const size_t nc = std::min(Blocks::NC, n - jc);
+
+            for (size_t ic = 0; ic < m; ic += MC)
+            {
+                const size_t mc = std::min(MC, m - ic);
+
+                for (size_t pc = 0; pc < k; pc += Blocks::KC)
+                {
+                    const size_t kc = std::min(Blocks::KC, k - pc);
+                    const S betaBlock = pc == 0 ? static_cast<S>(0) : static_cast<S>(1);
+
+                    packB(kc, nc, b + pc * bs.Row + jc * bs.Col, bs, NR, bPacked.get(), kernels.Widen);
+                    packA(mc, kc, a + ic * as.Row + pc * as.Col, as, MR, aPacked.get());
+
+                    for (size_t jr = 0; jr < nc; jr += NR)
+                    {
+                        const size_t nr = std::min(NR, nc - jr);
+                        const S* bSliver = bPacked.get() + jr * kc;
+
+                        for (size_t ir = 0; ir < mc; ir += MR)
+                        {
+                            const size_t mr = std::min(MR, mc - ir);
+
+                            kernels.MicroKernel(kc, aPacked.get() + ir * kc, packedAStrides, bSliver, NR, tile);
+                            storeTile(tile, NR, static_cast<S>(1), betaBlock, sums.get() + ir * ncMax + jr, { ncMax, 1 }, mr, nr);
+                        }
+                    }
+                }
+
+                storeTile(sums.get(), ncMax, static_cast<S>(alpha), static_cast<S>(beta), c + ic * cs.Row + jc * cs.Col, cs, mc, nc);
+            }
+        }
+    }
+}
+
+template<typename L> void
+Gemm::MultiplyQuantized(
+    size_t m, size_t n, size_t k,
+    const L* a, Strides as,
+    const int8_t* b, Strides bs,
+    int32_t* c, Strides cs)
+{
+    using Blocks = BlockSizes<int8_t>;
+    constexpr size_t G = Simd::QUANTIZED_GROUP;
+
+    if (m == 0 || n == 0) {
+        return;
+    }
+
+    // The offset of the signed elements of A adds 128 times the column sums of B to every row
+    // of C, which is subtracted when the first inner block is stored.
+    std::vector<int32_t> offsets(n, 0);
+    if constexpr (std::is_signed<L>())
+    {
+        for (size_t p = 0; p < k; ++p) {
+            for (size_t j = 0; j < n; ++j) {
+                offsets[j] -= 128 * b[p * bs.Row + j * bs.Col];
+            }
+        }
+    }
+
+    if (k == 0)
+    { // Empty inner dimension, the product is a zero matrix.
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                c[i * cs.Row + j * cs.Col] = 0;
+            }
+        }
+        return;
+    }
+
+    const Simd::QuantizedKernels& kernels = Simd::GetQuantizedKernels();
+    const size_t MR = kernels.MR;
+    const size_t NR = kernels.NR;
+    const size_t MC = std::max(MR, Blocks::MC / MR * MR);
+
+    const size_t kcMax = roundUp(std::min(Blocks::KC, k), G);
+    const Memory::Buffer<uint8_t> aPacked = Memory::Allocate<uint8_t>(roundUp(std::min(MC, m), MR) * kcMax);
+    const Memory::Buffer<int8_t> bPacked = Memory::Allocate<int8_t>(roundUp(std::min(Blocks::NC, n), NR) * kcMax);
+
+    alignas(64) int32_t tile[Simd::MAX_TILE_ELEMENTS];
+
+    // Loop order (outermost first): L3 panel of B, L2 block of A, L1 sliver of B, register tile.
+    for (size_t jc = 0; jc < n; jc += Blocks::NC)
+    {
+        const size_t nc = std::min(Blocks::NC, n - jc);
+
+        for (size_t pc = 0; pc < k; pc += Blocks::KC)
+        {
+            const size_t kc = std::min(Blocks::KC, k - pc);
+            const size_t groups = (kc + G - 1) / G;
+
+            packQuantizedB(kc, nc, b + pc * bs.Row + jc * bs.Col, bs, NR, bPacked.get());
+
+            for (size_t ic = 0; ic < m; ic += MC)
+            {
+                const size_t mc = std::min(MC, m - ic);
+
+                packQuantizedA(mc, kc, a + ic * as.Row + pc * as.Col, as, MR, aPacked.get());
+
+                for (size_t jr = 0; jr < nc; jr += NR)
+                {
+                    const size_t nr = std::min(NR, nc - jr);
+                    const int8_t* bSliver = bPacked.get() + jr * groups * G;
+                    const int32_t* offset = offsets.data() + jc + jr;
+
+                    for (size_t ir = 0; ir < mc; ir += MR)
+                    {
+                        const size_t mr = std::min(MR, mc - ir);
+
+                        kernels.MicroKernel(groups, aPacked.get() + ir * groups * G, bSliver, tile);
+
+                        for (size_t i = 0; i < mr; ++i)
+                        {
+                            int32_t* ci = c + (ic + ir + i) * cs.Row + (jc + jr) * cs.Col;
+                            const int32_t* ti = tile + i * NR;
+                            if (pc == 0) {
+                                for (size_t j = 0; j < nr; ++j) {
+                                    ci[j * cs.Col] = ti[j] + offset[j];
+                                }
+                            } else {
+                                for (size_t j = 0; j < nr; ++j) {
+                                    ci[j * cs.Col] += ti[j];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+template<typename T> size_t
+Gemm::StrassenCutoff()
+{
+    // Crossover points measured on a single core, the vectorized kernels are fast
+    // enough that only large blocks benefit from trading multiplications for additions.
+    switch (Simd::GetKernels<T>().InstructionSet)
+    {
+        case Simd::Isa::Scalar: return 128;
+        case Simd::Isa::SSE2:   return 256;
+        case Simd::Isa::AVX2:   return 512;
+        case Simd::Isa::AVX512: return 1024;
+    }
+
+    return 512;
+}
+
+template<typename T> double
+Gemm::StrassenErrorBound(size_t n, size_t cutoff)
+{
+    const double n0 = static_cast<double>(std::max<size_t>(std::min(n, cutoff), 1));
+    const double levels = static_cast<double>(n) / n0;
+    const double unitRoundoff = static_cast<double>(std::numeric_limits<T>::epsilon()) / 2.0;
+
+    return (std::pow(levels, std::log2(18.0)) * (n0 * n0 + 6.0 * n0) - 6.0 * static_cast<double>(n)) * unitRoundoff;
+}
+
+template<typename T> void
+Gemm::Strassen(
+    size_t m, size_t n, size_t k,
+    const T* a, Strides as,
+    const T* b, Strides bs,
+    T* c, Strides cs,
+    size_t cutoff,
+    bool parallel)
+{
+    strassenRecursive<T>(m, n, k, a, as, b, bs, c, cs, cutoff, parallel);
+}
+
+
+template<typename T> void
+Gemm::MultiplyBatched(
+    size_t count,
+    size_t m, size_t n, size_t k,
+    T alpha,
+    const T* a, BatchStrides as,
+    const T* b, BatchStrides bs,
+    T beta,
+    T* c, BatchStrides cs,
+    size_t minOperationsPerTask)
+{
+    if (count == 0 || m == 0 || n == 0) {
+        return;
+    }
+
+    const size_t minMatrices = std::max<size_t>(minOperationsPerTask / std::max<size_t>(m * n * k, 1), 1);
+
+    if (std::min({ m, n, k }) >= BATCH_BLOCKED_MIN)
+    {
+        ThreadPool::ParallelFor(count, minMatrices, [=](size_t first, size_t end) {
+            for (size_t i = first; i < end; ++i) {
+                Multiply<T>(m, n, k, alpha, a + i * as.Batch, { as.Row, as.Col }, b + i * bs.Batch, { bs.Row, bs.Col },
+                            beta, c + i * cs.Batch, { cs.Row, cs.Col });
+            }
+        });
+        return;
+    }
+
+    // Matrices per group: enough lanes for several vectors of every instruction set, while the
+    // packed operands of a group stay in the L2 cache.
+    constexpr size_t LANES = 64;
+
+    const auto multiplyGroups = [=](size_t first, size_t end)
+    {
+        const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+
+        // Operands that are not interleaved are packed with the elements in RowMajor ordering.
+        const Memory::Buffer<T> aPacked = Memory::Allocate<T>(as.Batch == 1 ? 0 : m * k * LANES);
+        const Memory::Buffer<T> bPacked = Memory::Allocate<T>(bs.Batch == 1 ? 0 : k * n * LANES);
+        const auto pack = [=](const T* src, BatchStrides ss, size_t rows, size_t cols, size_t lanes, T* dst) {
+            for (size_t l = 0; l < lanes; ++l) {
+                for (size_t r = 0; r < rows; ++r) {
+                    for (size_t col = 0; col < cols; ++col) {
+                        dst[(r * cols + col) * LANES + l] = src[l * ss.Batch + r * ss.Row + col * ss.Col];
+                    }
+                }
+            }
+        };
+
+        alignas(64) T sums[LANES];
+
+        for (size_t group = first; group < end; group += LANES)
+        {
+            const size_t lanes = std::min(LANES, end - group);
+
+            const T* aLanes = a + group * as.Batch;
+            Strides aStrides = { as.Row, as.Col };
+            if (as.Batch != 1) {
+                pack(aLanes, as, m, k, lanes, aPacked.get());
+                aLanes = aPacked.get();
+                aStrides = { k * LANES, LANES };
+            }
+
+            const T* bLanes = b + group * bs.Batch;
+            Strides bStrides = { bs.Row, bs.Col };
+            if (bs.Batch != 1) {
+                pack(bLanes, bs, k, n, lanes, bPacked.get());
+                bLanes = bPacked.get();
+                bStrides = { n * LANES, LANES };
+            }
+
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < n; ++j)
+                {
+                    kernels.DotBatch(k, lanes, aLanes + i * aStrides.Row, aStrides.Col, bLanes + j * bStrides.Col, bStrides.Row, sums);
+
+                    T* cij = c + group * cs.Batch + i * cs.Row + j * cs.Col;
+                    if (cs.Batch == 1)
+                    {
+                        if (beta == static_cast<T>(0)) {
+                            kernels.Scale(alpha, sums, cij, lanes);
+                            continue;
+                        }
+                        if (beta != static_cast<T>(1)) {
+                            kernels.Scale(beta, cij, cij, lanes);
+                        }
+                        kernels.Axpy(alpha, sums, cij, lanes);
+                    }
+                    else
+                    {
+                        for (size_t l = 0; l < lanes; ++l) {
+                            T& value = cij[l * cs.Batch];
+                            value = beta == static_cast<T>(0) ? alpha * sums[l] : beta * value + alpha * sums[l];
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    ThreadPool::ParallelFor(count, std::max(minMatrices, LANES), multiplyGroups);
+}
+
+
+template void Gemm::Multiply<int>(size_t, size_t, size_t, int, const int*, Strides, const int*, Strides, int, int*, Strides);
+template void Gemm::Multiply<size_t>(size_t, size_t, size_t, size_t, const size_t*, Strides, const size_t*, Strides, size_t, size_t*, Strides);
+template void Gemm::Multiply<float>(size_t, size_t, size_t, float, const float*, Strides, const float*, Strides, float, float*, Strides);
+template void Gemm::Multiply<double>(size_t, size_t, size_t, double, const double*, Strides, const double*, Strides, double, double*, Strides);
+template void Gemm::Multiply<BFloat16>(size_t, size_t, size_t, BFloat16, const BFloat16*, Strides, const BFloat16*, Strides, BFloat16, BFloat16*, Strides);
+template void Gemm::Multiply<Float16>(size_t, size_t, size_t, Float16, const Float16*, Strides, const Float16*, Strides, Float16, Float16*, Strides);
+template void Gemm::MultiplyQuantized<uint8_t>(size_t, size_t, size_t, const uint8_t*, Strides, const int8_t*, Strides, int32_t*, Strides);
+template void Gemm::MultiplyQuantized<int8_t>(size_t, size_t, size_t, const int8_t*, Strides, const int8_t*, Strides, int32_t*, Strides);
+template size_t Gemm::StrassenCutoff<int>();
+template size_t Gemm::StrassenCutoff<size_t>();
+template size_t Gemm::StrassenCutoff<float>();
+template size_t Gemm::StrassenCutoff<double>();
+template size_t Gemm::StrassenCutoff<BFloat16>();
+template size_t Gemm::StrassenCutoff<Float16>();
+template double Gemm::StrassenErrorBound<float>(size_t, size_t);
+template double Gemm::StrassenErrorBound<double>(size_t, size_t);
+template void Gemm::Strassen<int>(size_t, size_t, size_t, const int*, Strides, const int*, Strides, int*, Strides, size_t, bool);
+template void Gemm::Strassen<size_t>(size_t, size_t, size_t, const size_t*, Strides, const size_t*, Strides, size_t*, Strides, size_t, bool);
+template void Gemm::Strassen<float>(size_t, size_t, size_t, const float*, Strides, const float*, Strides, float*, Strides, size_t, bool);
+template void Gemm::Strassen<double>(size_t, size_t, size_t, const double*, Strides, const double*, Strides, double*, Strides, size_t, bool);
+template void Gemm::Strassen<BFloat16>(size_t, size_t, size_t, const BFloat16*, Strides, const BFloat16*, Strides, BFloat16*, Strides, size_t, bool);
+template void Gemm::Strassen<Float16>(size_t, size_t, size_t, const Float16*, Strides, const Float16*, Strides, Float16*, Strides, size_t, bool);
+template void Gemm::MultiplyBatched<int>(size_t, size_t, size_t, size_t, int, const int*, BatchStrides, const int*, BatchStrides, int, int*, BatchStrides, size_t);
+template void Gemm::MultiplyBatched<size_t>(size_t, size_t, size_t, size_t, size_t, const size_t*, BatchStrides, const size_t*, BatchStrides, size_t, size_t*, BatchStrides, size_t);
+template void Gemm::MultiplyBatched<float>(size_t, size_t, size_t, size_t, float, const float*, BatchStrides, const float*, BatchStrides, float, float*, BatchStrides, size_t);
+template void Gemm::MultiplyBatched<double>(size_t, size_t, size_t, size_t, double, const double*, BatchStrides, const double*, BatchStrides, double, double*, BatchStrides, size_t);
+template void Gemm::MultiplyBatched<BFloat16>(size_t, size_t, size_t, size_t, BFloat16, const BFloat16*, BatchStrides, const BFloat16*, BatchStrides, BFloat16, BFloat16*, BatchStrides, size_t);
+template void Gemm::MultiplyBatched<Float16>(size_t, size_t, size_t, size_t, Float16, const Float16*, BatchStrides, const Float16*, BatchStrides, Float16, Float16*, BatchStrides, size_t);
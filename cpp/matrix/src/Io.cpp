@@ -1,8 +1,533 @@
 #include "Io.hpp"
+#include "ThreadPool.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <future>
+#include <limits>
+#include <stdexcept>
 #include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define IO_MAP_FILES
+#endif
+
+
+namespace
+{
+    constexpr char MATRIX_FILE_MAGIC[8] = { 'M', 'A', 'T', 'R', 'I', 'X', 'E', 'R' };
+    constexpr char NPY_MAGIC[6] = { '\x93', 'N', 'U', 'M', 'P', 'Y' };
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // Npy headers are padded so that the elements start at a multiple of 64 bytes.
+    constexpr size_t NPY_ALIGNMENT = 64;
+
+    /// @brief Elements of a binary matrix file or .npy file.
+    struct Layout
+    {
+        IO::DataType Type;
+        size_t       Rows;
+        size_t       Columns;
+        bool         ColumnMajor;
+        size_t       DataOffset;
+    };
+
+    struct Mapping
+    {
+        void*  Address;
+        size_t Bytes;
+    };
+
+    bool isLittleEndian()
+    {
+        const uint16_t probe = 1;
+        unsigned char first = 0;
+        std::memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    template<typename T> constexpr IO::DataType
+    dataTypeOf()
+    {
+        if constexpr (std::is_same_v<T, float>) {
+            return IO::DataType::Float32;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return IO::DataType::Float64;
+        } else if constexpr (std::is_same_v<T, Float16>) {
+            return IO::DataType::Float16;
+        } else if constexpr (std::is_same_v<T, BFloat16>) {
+            return IO::DataType::BFloat16;
+        } else if constexpr (std::is_signed_v<T>) {
+            static_assert(sizeof(T) == 4, "Signed integers are saved as Int32.");
+            return IO::DataType::Int32;
+        } else {
+            static_assert(sizeof(T) == 8, "Unsigned integers are saved as UInt64.");
+            return IO::DataType::UInt64;
+        }
+    }
+
+    size_t elementSize(IO::DataType type)
+    {
+        switch (type)
+        {
+            case IO::DataType::Float16:
+            case IO::DataType::BFloat16: return 2;
+            case IO::DataType::Int32:
+            case IO::DataType::Float32:  return 4;
+            case IO::DataType::UInt64:
+            case IO::DataType::Float64:  return 8;
+        }
+        return 0;
+    }
+
+    /// @brief Returns the numpy type string of the elements, without the byte order. Numpy has
+    ///        no bfloat16 type, its string is empty.
+    const char* npyType(IO::DataType type)
+    {
+        switch (type)
+        {
+            case IO::DataType::Int32:    return "i4";
+            case IO::DataType::UInt64:   return "u8";
+            case IO::DataType::Float32:  return "f4";
+            case IO::DataType::Float64:  return "f8";
+            case IO::DataType::Float16:  return "f2";
+            case IO::DataType::BFloat16: return "";
+        }
+        return "";
+    }
+
+    [[noreturn]] void throwFormatError(const std::string& fpath, const std::string& reason)
+    {
+        throw std::runtime_error("Invalid matrix file \'" + fpath + "\': " + reason + ".");
+    }
+
+    /// @brief Writes the elements of the matrix line by line, without the gaps between lines of views.
+    template<typename T> void
+    writeElements(std::ofstream& out, MatrixView<const T> matrix)
+    {
+        const bool   rowMajor   = matrix.GetOrdering() == Matrix<T>::Ordering::RowMajor;
+        const size_t lines      = rowMajor ? matrix.GetHeight() : matrix.GetWidth();
+        const size_t lineLength = rowMajor ? matrix.GetWidth() : matrix.GetHeight();
+
+        if (lines == 0 || lineLength == 0) {
+            return;
+        }
+
+        if (matrix.IsContiguous()) {
+            out.write(reinterpret_cast<const char*>(matrix.Data()), static_cast<std::streamsize>(lines * lineLength * sizeof(T)));
+            return;
+        }
+
+        for (size_t line = 0; line < lines; ++line) {
+            out.write(reinterpret_cast<const char*>(matrix.Data() + line * matrix.GetLeadingDimension()),
+                      static_cast<std::streamsize>(lineLength * sizeof(T)));
+        }
+    }
+
+    /// @brief Writes the header of a binary matrix file and the padding up to its elements.
+    template<typename T> void
+    writeMatrixFileHeader(std::ofstream& out, size_t rows, size_t columns, bool columnMajor)
+    {
+        IO::MatrixFileHeader header = {};
+        std::memcpy(header.Magic, MATRIX_FILE_MAGIC, sizeof(MATRIX_FILE_MAGIC));
+        header.Version     = IO::MATRIX_FILE_VERSION;
+        header.ByteOrder   = BYTE_ORDER_MARK;
+        header.Type        = static_cast<uint32_t>(dataTypeOf<T>());
+        header.ElementSize = sizeof(T);
+        header.Rows        = rows;
+        header.Columns     = columns;
+        header.Ordering    = columnMajor ? 1 : 0;
+        header.Alignment   = IO::MATRIX_FILE_ALIGNMENT;
+        header.DataOffset  = IO::MATRIX_FILE_ALIGNMENT;
+
+        const std::vector<char> padding(IO::MATRIX_FILE_ALIGNMENT - sizeof(header), '\0');
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    }
+
+    std::ofstream openForWriting(const std::string& fpath)
+    {
+        std::ofstream out(fpath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::system_error(errno, std::generic_category(), "Unable to open file \'" + fpath + "\' for writing");
+        }
+        return out;
+    }
+
+    void closeAfterWriting(std::ofstream& out, const std::string& fpath)
+    {
+        out.close();
+        if (!out) {
+            throw std::system_error(errno, std::generic_category(), "Unable to write file \'" + fpath + "\'");
+        }
+    }
+
+    /// @brief Maps the whole file read only, or reads it into a buffer where mapping is not supported.
+    Mapping mapFile(const std::string& fpath)
+    {
+#if defined(IO_MAP_FILES)
+        const int fd = open(fpath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Unable to open file \'" + fpath + "\'");
+        }
+
+        struct stat status;
+        if (fstat(fd, &status) != 0) {
+            const int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "Unable to read the size of file \'" + fpath + "\'");
+        }
+
+        const size_t bytes = static_cast<size_t>(status.st_size);
+        if (bytes == 0) {
+            close(fd);
+            throwFormatError(fpath, "the file is empty");
+        }
+
+        void* address = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        const int error = errno;
+        close(fd); // The mapping keeps the file open
+
+        if (address == MAP_FAILED) {
+            throw std::system_error(error, std::generic_category(), "Unable to map file \'" + fpath + "\'");
+        }
+        return { address, bytes };
+#else
+        std::ifstream in(fpath, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!in) {
+            throw std::system_error(errno, std::generic_category(), "Unable to open file \'" + fpath + "\'");
+        }
+
+        const size_t bytes = static_cast<size_t>(in.tellg());
+        if (bytes == 0) {
+            throwFormatError(fpath, "the file is empty");
+        }
+
+        void* address = Memory::DefaultAllocator().Allocate(bytes);
+        in.seekg(0);
+        if (!in.read(static_cast<char*>(address), static_cast<std::streamsize>(bytes))) {
+            Memory::DefaultAllocator().Deallocate(address, bytes);
+            throw std::system_error(errno, std::generic_category(), "Unable to read file \'" + fpath + "\'");
+        }
+        return { address, bytes };
+#endif
+    }
+
+    void unmapFile(void* address, size_t bytes) noexcept
+    {
+        if (address == nullptr) {
+            return;
+        }
+#if defined(IO_MAP_FILES)
+        munmap(address, bytes);
+#else
+        Memory::DefaultAllocator().Deallocate(address, bytes);
+#endif
+    }
+
+    Layout parseMatrixFile(const char* data, size_t bytes, const std::string& fpath)
+    {
+        IO::MatrixFileHeader header;
+        if (bytes < sizeof(header)) {
+            throwFormatError(fpath, "the header is incomplete");
+        }
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.ByteOrder != BYTE_ORDER_MARK) {
+            throwFormatError(fpath, "the file was written with another byte order");
+        }
+        if (header.Version == 0 || header.Version > IO::MATRIX_FILE_VERSION) {
+            throwFormatError(fpath, "unsupported version " + std::to_string(header.Version));
+        }
+
+        const auto type = static_cast<IO::DataType>(header.Type);
+        if (header.Type < 1 || header.Type > 6 || header.ElementSize != elementSize(type)) {
+            throwFormatError(fpath, "unknown element type " + std::to_string(header.Type));
+        }
+        if (header.Ordering > 1) {
+            throwFormatError(fpath, "unknown ordering " + std::to_string(header.Ordering));
+        }
+        if (header.Rows > std::numeric_limits<size_t>::max() || header.Columns > std::numeric_limits<size_t>::max() ||
+            header.DataOffset < sizeof(header) || header.DataOffset > bytes)
+        {
+            throwFormatError(fpath, "the dimensions or the data offset are out of range");
+        }
+
+        return { type, static_cast<size_t>(header.Rows), static_cast<size_t>(header.Columns), header.Ordering == 1,
+                 static_cast<size_t>(header.DataOffset) };
+    }
+
+    /// @brief Returns the value of the key in the dictionary of a npy header, up to the next
+    ///        separator that is not inside parentheses or quotes.
+    std::string_view npyValue(std::string_view dict, std::string_view key, const std::string& fpath)
+    {
+        const size_t keyPosition = dict.find(key);
+        const size_t colon = keyPosition == std::string_view::npos ? keyPosition : dict.find(':', keyPosition + key.size());
+        if (colon == std::string_view::npos) {
+            throwFormatError(fpath, "the npy header has no " + std::string(key));
+        }
+
+        size_t begin = dict.find_first_not_of(' ', colon + 1);
+        size_t end = begin;
+        if (begin != std::string_view::npos && (dict[begin] == '(' || dict[begin] == '\'' || dict[begin] == '"')) {
+            const char close = dict[begin] == '(' ? ')' : dict[begin];
+            end = dict.find(close, begin + 1);
+            end = end == std::string_view::npos ? end : end + 1;
+        } else if (begin != std::string_view::npos) {
+            end = dict.find_first_of(",}", begin);
+        }
+
+        if (begin == std::string_view::npos || end == std::string_view::npos) {
+            throwFormatError(fpath, "the npy header has no value for " + std::string(key));
+        }
+        return dict.substr(begin, end - begin);
+    }
+
+    Layout parseNpyFile(const char* data, size_t bytes, const std::string& fpath)
+    {
+        const auto byte = [data](size_t i) { return static_cast<size_t>(static_cast<unsigned char>(data[i])); };
+
+        if (bytes < 10) {
+            throwFormatError(fpath, "the npy header is incomplete");
+        }
+
+        // Version 1.0 saves the header length in 2 bytes, versions 2.0 and 3.0 in 4 bytes, little endian.
+        const size_t major = byte(6);
+        if (major < 1 || major > 3) {
+            throwFormatError(fpath, "unsupported npy version " + std::to_string(major));
+        }
+        const size_t lengthBytes = major == 1 ? 2 : 4;
+        if (bytes < 8 + lengthBytes) {
+            throwFormatError(fpath, "the npy header is incomplete");
+        }
+
+        size_t headerLength = 0;
+        for (size_t i = lengthBytes; i-- > 0;) {
+            headerLength = headerLength << 8 | byte(8 + i);
+        }
+        const size_t dataOffset = 8 + lengthBytes + headerLength;
+        if (dataOffset > bytes) {
+            throwFormatError(fpath, "the npy header is incomplete");
+        }
+
+        const std::string_view dict(data + 8 + lengthBytes, headerLength);
+
+        // descr: byte order ('<', '>', '|' or '=') followed by the type, e.g. '<f8'
+        std::string_view descr = npyValue(dict, "'descr'", fpath);
+        descr = descr.substr(1, descr.size() - 2);
+        if (!descr.empty() && (descr[0] == '<' || descr[0] == '>' || descr[0] == '|' || descr[0] == '='))
+        {
+            if ((descr[0] == '<' && !isLittleEndian()) || (descr[0] == '>' && isLittleEndian())) {
+                throwFormatError(fpath, "the npy file was written with another byte order");
+            }
+            descr.remove_prefix(1);
+        }
+
+        std::optional<IO::DataType> type;
+        for (IO::DataType t : { IO::DataType::Int32, IO::DataType::UInt64, IO::DataType::Float32, IO::DataType::Float64, IO::DataType::Float16 }) {
+            if (descr == npyType(t)) {
+                type = t;
+            }
+        }
+        if (!type) {
+            throwFormatError(fpath, "unsupported npy type \'" + std::string(descr) + "\'");
+        }
+
+        const std::string_view fortranOrder = npyValue(dict, "'fortran_order'", fpath);
+        if (fortranOrder != "True" && fortranOrder != "False") {
+            throwFormatError(fpath, "invalid fortran_order " + std::string(fortranOrder));
+        }
+
+        // shape: (), (n,) or (rows, columns)
+        const std::string_view shape = npyValue(dict, "'shape'", fpath);
+        std::vector<size_t> dimensions;
+        for (size_t i = 1; i + 1 < shape.size();)
+        {
+            i = shape.find_first_not_of(" ,", i);
+            if (i == std::string_view::npos || i + 1 >= shape.size()) {
+                break;
+            }
+
+            size_t dimension = 0;
+            const size_t first = i;
+            for (; i < shape.size() && shape[i] >= '0' && shape[i] <= '9'; ++i) {
+                if (dimension > (std::numeric_limits<size_t>::max() - 9) / 10) {
+                    throwFormatError(fpath, "the npy shape is out of range");
+                }
+                dimension = dimension * 10 + static_cast<size_t>(shape[i] - '0');
+            }
+            if (i == first) {
+                throwFormatError(fpath, "invalid npy shape " + std::string(shape));
+            }
+            dimensions.push_back(dimension);
+        }
+        if (dimensions.size() > 2) {
+            throwFormatError(fpath, "the npy array has more than 2 dimensions");
+        }
+
+        const size_t rows    = dimensions.size() > 0 ? dimensions[0] : 1;
+        const size_t columns = dimensions.size() > 1 ? dimensions[1] : 1;
+
+        return { *type, rows, columns, fortranOrder == "True", dataOffset };
+    }
+
+    Layout parseLayout(const char* data, size_t bytes, const std::string& fpath)
+    {
+        if (bytes >= sizeof(MATRIX_FILE_MAGIC) && std::memcmp(data, MATRIX_FILE_MAGIC, sizeof(MATRIX_FILE_MAGIC)) == 0) {
+            return parseMatrixFile(data, bytes, fpath);
+        }
+        if (bytes >= sizeof(NPY_MAGIC) && std::memcmp(data, NPY_MAGIC, sizeof(NPY_MAGIC)) == 0) {
+            return parseNpyFile(data, bytes, fpath);
+        }
+        throwFormatError(fpath, "neither a binary matrix file nor a npy file");
+    }
+
+    // Bytes of text per task of ParseTextMatrix, the chunks are extended to the end of their last line.
+    constexpr size_t TEXT_CHUNK_BYTES = 1 << 20;
+
+    bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    /// @brief Returns the position of the first line that starts at or after chunk * TEXT_CHUNK_BYTES.
+    size_t chunkBegin(std::string_view text, size_t chunk)
+    {
+        const size_t nominal = chunk * TEXT_CHUNK_BYTES;
+        if (chunk == 0 || nominal >= text.size()) {
+            return std::min(nominal, text.size());
+        }
+
+        const size_t newline = text.find('\n', nominal - 1);
+        return newline == std::string_view::npos ? text.size() : newline + 1;
+    }
+
+    /// @brief Calls func(first, end) for each line in the text that contains elements, with first
+    ///        the first character that is not blank and end the end of the line or of its comment.
+    template<class F> void
+    forEachRow(std::string_view text, const F& func)
+    {
+        const char* begin = text.data();
+        const char* end   = text.data() + text.size();
+
+        while (begin < end)
+        {
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+            const char* lineEnd = newline == nullptr ? end : newline;
+
+            while (begin < lineEnd && isBlank(*begin)) {
+                ++begin;
+            }
+            if (begin < lineEnd && *begin != '#') {
+                const char* comment = static_cast<const char*>(std::memchr(begin, '#', static_cast<size_t>(lineEnd - begin)));
+                func(begin, comment == nullptr ? lineEnd : comment);
+            }
+
+            begin = lineEnd + 1;
+        }
+    }
+
+    /// @brief Parses the elements of the row into values.
+    /// @return true if the row is exactly columns numbers, false otherwise.
+    template<typename T> bool
+    parseRow(const char* first, const char* end, T* values, size_t columns)
+    {
+        for (size_t count = 0; count < columns; ++count)
+        {
+            while (first < end && isBlank(*first)) {
+                ++first;
+            }
+
+            const std::from_chars_result result = std::from_chars(first, end, values[count]);
+            if (result.ec != std::errc() || (result.ptr < end && !isBlank(*result.ptr))) {
+                return false;
+            }
+            first = result.ptr;
+        }
+
+        while (first < end && isBlank(*first)) {
+            ++first;
+        }
+        return first == end;
+    }
+
+
+    /// @brief Binary matrix file or .npy file that is read block by block.
+    struct BlockFile
+    {
+        std::ifstream Stream;
+        std::string   Path;
+        Layout        Elements;
+    };
+
+    template<typename T> BlockFile
+    openBlockFile(const std::string& fpath)
+    {
+        BlockFile file = { std::ifstream(fpath, std::ios::in | std::ios::binary), fpath, {} };
+        if (!file.Stream) {
+            throw std::system_error(errno, std::generic_category(), "Unable to open file \'" + fpath + "\'");
+        }
+
+        // The elements of binary matrix files start after the first page, npy headers are shorter.
+        std::string header(IO::MATRIX_FILE_ALIGNMENT, '\0');
+        file.Stream.read(header.data(), static_cast<std::streamsize>(header.size()));
+        header.resize(static_cast<size_t>(file.Stream.gcount()));
+        file.Stream.clear();
+
+        const Layout& elements = file.Elements = parseLayout(header.data(), header.size(), fpath);
+        if (elements.Type != dataTypeOf<T>()) {
+            throwFormatError(fpath, "the elements are of another type");
+        }
+
+        const size_t bytes = static_cast<size_t>(std::filesystem::file_size(fpath));
+        if (elements.Columns != 0 && elements.Rows > (bytes - elements.DataOffset) / sizeof(T) / elements.Columns) {
+            throwFormatError(fpath, "the file is smaller than its " + std::to_string(elements.Rows) + 'X' +
+                                    std::to_string(elements.Columns) + " elements");
+        }
+        return file;
+    }
+
+    /// @brief Reads the rows X columns block whose first element is (row, col) into dst, in the
+    ///        ordering of the file, with the lines of the block next to each other.
+    template<typename T> void
+    readBlock(BlockFile& file, size_t row, size_t col, size_t rows, size_t columns, T* dst)
+    {
+        const Layout& elements = file.Elements;
+        const size_t lines          = elements.ColumnMajor ? columns : rows;
+        const size_t lineLength     = elements.ColumnMajor ? rows : columns;
+        const size_t fileLineLength = elements.ColumnMajor ? elements.Rows : elements.Columns;
+        const size_t firstLine      = elements.ColumnMajor ? col : row;
+        const size_t lineOffset     = elements.ColumnMajor ? row : col;
+
+        // Blocks of whole lines are contiguous in the file and read at once.
+        const bool   wholeLines = lineLength == fileLineLength;
+        const size_t reads      = wholeLines ? std::min<size_t>(lines, 1) : lines;
+        const size_t readLength = wholeLines ? lines * lineLength : lineLength;
+
+        for (size_t i = 0; i < reads; ++i)
+        {
+            file.Stream.seekg(static_cast<std::streamoff>(elements.DataOffset + ((firstLine + i) * fileLineLength + lineOffset) * sizeof(T)));
+            file.Stream.read(reinterpret_cast<char*>(dst + i * lineLength), static_cast<std::streamsize>(readLength * sizeof(T)));
+        }
+
+        if (!file.Stream) {
+            throw std::system_error(errno, std::generic_category(), "Unable to read file \'" + file.Path + "\'");
+        }
+    }
+
+} // end anonymous namespace
 
 
 namespace IO
@@ -67,4 +592,412 @@ namespace IO
         return fileLines;
     }
 
+
+    /****************************************
+     * Binary matrix files
+     ****************************************/
+    template<typename T> void
+    WriteMatrixFile(const std::string& fpath, MatrixView<const T> matrix)
+    {
+        std::ofstream out = openForWriting(fpath);
+
+        writeMatrixFileHeader<T>(out, matrix.GetHeight(), matrix.GetWidth(), matrix.GetOrdering() == Matrix<T>::Ordering::ColumnMajor);
+        writeElements(out, matrix);
+
+        closeAfterWriting(out, fpath);
+    }
+
+    template<typename T> void
+    WriteNpyFile(const std::string& fpath, MatrixView<const T> matrix)
+    {
+        std::string dict = std::string("{'descr': '") + (isLittleEndian() ? '<' : '>') + npyType(dataTypeOf<T>()) + "', " +
+                           "'fortran_order': " + (matrix.GetOrdering() == Matrix<T>::Ordering::ColumnMajor ? "True" : "False") + ", " +
+                           "'shape': (" + std::to_string(matrix.GetHeight()) + ", " + std::to_string(matrix.GetWidth()) + "), }";
+
+        // Pad with spaces and a final newline, so that the elements start at a multiple of NPY_ALIGNMENT.
+        const size_t prefixBytes = sizeof(NPY_MAGIC) + 4;
+        dict.append(NPY_ALIGNMENT - (prefixBytes + dict.size() + 1) % NPY_ALIGNMENT, ' ');
+        dict.push_back('\n');
+
+        if (dict.size() > 0xFFFF) {
+            throw std::invalid_argument("The npy header of the matrix is too long.");
+        }
+
+        const char prefix[prefixBytes] = {
+            NPY_MAGIC[0], NPY_MAGIC[1], NPY_MAGIC[2], NPY_MAGIC[3], NPY_MAGIC[4], NPY_MAGIC[5],
+            1, 0, // version 1.0
+            static_cast<char>(dict.size() & 0xFF), static_cast<char>(dict.size() >> 8)
+        };
+
+        std::ofstream out = openForWriting(fpath);
+
+        out.write(prefix, sizeof(prefix));
+        out.write(dict.data(), static_cast<std::streamsize>(dict.size()));
+        writeElements(out, matrix);
+
+        closeAfterWriting(out, fpath);
+    }
+
+    template<typename T>
+    MappedMatrix<T>::MappedMatrix(const std::string& fpath)
+        : _address(nullptr)
+        , _bytes(0)
+        , _view(nullptr, 0, 0, 0)
+    {
+        const Mapping mapping = mapFile(fpath);
+        _address = mapping.Address;
+        _bytes = mapping.Bytes;
+
+        try
+        {
+            const char* data = static_cast<const char*>(_address);
+            const Layout layout = parseLayout(data, _bytes, fpath);
+
+            if (layout.Type != dataTypeOf<T>()) {
+                throwFormatError(fpath, "the elements are of another type");
+            }
+            if (layout.DataOffset % alignof(T) != 0) {
+                throwFormatError(fpath, "the elements are not aligned");
+            }
+            if (layout.Columns != 0 && layout.Rows > (_bytes - layout.DataOffset) / sizeof(T) / layout.Columns) {
+                throwFormatError(fpath, "the file is smaller than its " + std::to_string(layout.Rows) + 'X' +
+                                        std::to_string(layout.Columns) + " elements");
+            }
+
+            const auto ordering = layout.ColumnMajor ? Matrix<T>::Ordering::ColumnMajor : Matrix<T>::Ordering::RowMajor;
+            const size_t leadingDimension = layout.ColumnMajor ? layout.Rows : layout.Columns;
+
+            _view = MatrixView<const T>(reinterpret_cast<const T*>(data + layout.DataOffset), layout.Rows, layout.Columns,
+                                        leadingDimension, ordering);
+        }
+        catch (...)
+        {
+            unmapFile(_address, _bytes);
+            throw;
+        }
+    }
+
+    template<typename T>
+    MappedMatrix<T>::~MappedMatrix()
+    {
+        unmapFile(_address, _bytes);
+    }
+
+    template<typename T>
+    MappedMatrix<T>::MappedMatrix(MappedMatrix&& other) noexcept
+        : _address(std::exchange(other._address, nullptr))
+        , _bytes(std::exchange(other._bytes, 0))
+        , _view(std::exchange(other._view, MatrixView<const T>(nullptr, 0, 0, 0)))
+    {}
+
+    template<typename T> MappedMatrix<T>&
+    MappedMatrix<T>::operator=(MappedMatrix&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmapFile(_address, _bytes);
+
+            // Views are rebound by assignment, the mapped elements are never copied.
+            _address = std::exchange(other._address, nullptr);
+            _bytes = std::exchange(other._bytes, 0);
+            _view = std::exchange(other._view, MatrixView<const T>(nullptr, 0, 0, 0));
+        }
+        return *this;
+    }
+
+    template<typename T> Matrix<T>
+    ReadMatrixFile(const std::string& fpath)
+    {
+        const MappedMatrix<T> mapped(fpath);
+        return Matrix<T>(mapped.View());
+    }
+
+
+
+    /****************************************
+     * Text matrix files
+     ****************************************/
+    template<typename T> Matrix<T>
+    ParseTextMatrix(std::string_view text)
+    {
+        const size_t chunks = (text.size() + TEXT_CHUNK_BYTES - 1) / TEXT_CHUNK_BYTES;
+
+        // First pass: the rows of each chunk, to know where the rows of a chunk are saved.
+        std::vector<size_t> chunkRows(chunks + 1, 0);
+        ThreadPool::ParallelFor(chunks, 1, [&](size_t first, size_t end) {
+            for (size_t chunk = first; chunk < end; ++chunk) {
+                const size_t begin = chunkBegin(text, chunk);
+                forEachRow(text.substr(begin, chunkBegin(text, chunk + 1) - begin), [&](const char*, const char*) { ++chunkRows[chunk + 1]; });
+            }
+        });
+
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            chunkRows[chunk + 1] += chunkRows[chunk];
+        }
+
+        const size_t rows = chunkRows[chunks];
+        if (rows == 0) {
+            return Matrix<T>(0, 0);
+        }
+
+        // The elements of the first row set the width of the matrix.
+        size_t columns = 0;
+        bool   firstRow = true;
+        forEachRow(text.substr(0, chunkBegin(text, 1)), [&columns, &firstRow](const char* first, const char* end) {
+            for (bool inElement = false; firstRow && first < end; ++first) {
+                columns += !inElement && !isBlank(*first);
+                inElement = !isBlank(*first);
+            }
+            firstRow = false;
+        });
+
+        if (columns != 0 && rows > std::numeric_limits<size_t>::max() / columns) {
+            throw std::runtime_error("The text matrix of " + std::to_string(rows) + " rows is too large.");
+        }
+        Memory::Buffer<T> data = Memory::Allocate<T>(rows * columns);
+
+        // Second pass: parse the rows of each chunk into the elements.
+        ThreadPool::ParallelFor(chunks, 1, [&](size_t first, size_t end) {
+            for (size_t chunk = first; chunk < end; ++chunk)
+            {
+                size_t row = chunkRows[chunk];
+                const size_t begin = chunkBegin(text, chunk);
+
+                forEachRow(text.substr(begin, chunkBegin(text, chunk + 1) - begin), [&](const char* firstElement, const char* lineEnd) {
+                    if (!parseRow(firstElement, lineEnd, data.get() + row * columns, columns)) {
+                        throw std::runtime_error("Row " + std::to_string(row) + " of the text matrix is not " +
+                                                 std::to_string(columns) + " numbers: \'" + std::string(firstElement, lineEnd) + "\'.");
+                    }
+                    ++row;
+                });
+            }
+        });
+
+        return Matrix<T>(rows, columns, std::move(data));
+    }
+
+    template<typename T> Matrix<T>
+    ReadTextMatrix(const std::string& fpath)
+    {
+        const Mapping mapping = mapFile(fpath);
+
+        try
+        {
+            Matrix<T> result = ParseTextMatrix<T>(std::string_view(static_cast<const char*>(mapping.Address), mapping.Bytes));
+            unmapFile(mapping.Address, mapping.Bytes);
+            return result;
+        }
+        catch (const std::runtime_error& e)
+        {
+            unmapFile(mapping.Address, mapping.Bytes);
+            throw std::runtime_error("Invalid text matrix file \'" + fpath + "\': " + e.what());
+        }
+        catch (...)
+        {
+            unmapFile(mapping.Address, mapping.Bytes);
+            throw;
+        }
+    }
+
+
+    /****************************************
+     * Out-of-core products
+     ****************************************/
+    template<typename T> void
+    MultiplyMatrixFiles(const std::string& aPath, const std::string& bPath, const std::string& cPath, size_t memoryBudget)
+    {
+        using Ordering = typename Matrix<T>::Ordering;
+
+        BlockFile aFile = openBlockFile<T>(aPath);
+        BlockFile bFile = openBlockFile<T>(bPath);
+
+        const size_t m = aFile.Elements.Rows;
+        const size_t k = aFile.Elements.Columns;
+        const size_t n = bFile.Elements.Columns;
+
+        if (bFile.Elements.Rows != k) {
+            throw std::invalid_argument("Mismatching matrix dimensions for the product of \'" + aPath + "\' and \'" + bPath + "\'.");
+        }
+
+        // The memory holds a mb X nb tile of C and two sets of mb X kb and kb X nb blocks of A and B.
+        // Square tiles with kb = mb = nb minimize the reads for a budget, unless A or B is thin.
+        const size_t budget = memoryBudget / sizeof(T);
+        const size_t side = std::max<size_t>(static_cast<size_t>(std::sqrt(static_cast<double>(budget) / 5.0)), 1);
+
+        size_t mb = std::max<size_t>(std::min(m, side), 1);
+        size_t nb = std::max<size_t>(std::min(n, side), 1);
+        if (mb < side) {
+            nb = std::max<size_t>(std::min(n, budget / (5 * mb)), 1);
+        } else if (nb < side) {
+            mb = std::max<size_t>(std::min(m, budget / (5 * nb)), 1);
+        }
+
+        if (budget < mb * nb + 2 * (mb + nb)) {
+            throw std::invalid_argument("The memory budget of " + std::to_string(memoryBudget) + " bytes is too small for the product.");
+        }
+        const size_t kb = std::clamp<size_t>((budget - mb * nb) / (2 * (mb + nb)), 1, std::max<size_t>(k, 1));
+
+        {
+            std::ofstream out = openForWriting(cPath);
+            writeMatrixFileHeader<T>(out, m, n, false);
+            closeAfterWriting(out, cPath);
+        }
+        std::filesystem::resize_file(cPath, MATRIX_FILE_ALIGNMENT + m * n * sizeof(T));
+
+        if (m == 0 || n == 0) {
+            return;
+        }
+
+        std::fstream cFile(cPath, std::ios::in | std::ios::out | std::ios::binary);
+        if (!cFile) {
+            throw std::system_error(errno, std::generic_category(), "Unable to open file \'" + cPath + "\' for writing");
+        }
+
+        const size_t tileColumns = (n + nb - 1) / nb;
+        const size_t tiles = (m + mb - 1) / mb * tileColumns;
+        const size_t depth = std::max<size_t>((k + kb - 1) / kb, 1);
+        const size_t steps = tiles * depth;
+
+        const auto extent = [](size_t length, size_t block, size_t index) { return std::min(block, length - index * block); };
+
+        struct Blocks
+        {
+            Memory::Buffer<T> A;
+            Memory::Buffer<T> B;
+        };
+        std::array<Blocks, 2> blocks = { Blocks{ Memory::Allocate<T>(mb * kb), Memory::Allocate<T>(kb * nb) },
+                                         Blocks{ Memory::Allocate<T>(mb * kb), Memory::Allocate<T>(kb * nb) } };
+        const Memory::Buffer<T> tile = Memory::Allocate<T>(mb * nb);
+
+        // Step s multiplies the blocks p = s % depth of the inner dimension for tile t = s / depth of C.
+        const auto load = [&](size_t step)
+        {
+            const size_t t = step / depth;
+            const size_t p = step % depth;
+            const size_t i = t / tileColumns;
+            const size_t j = t % tileColumns;
+
+            readBlock(aFile, i * mb, p * kb, extent(m, mb, i), extent(k, kb, p), blocks[step % 2].A.get());
+            readBlock(bFile, p * kb, j * nb, extent(k, kb, p), extent(n, nb, j), blocks[step % 2].B.get());
+        };
+
+        const auto prefetch = [&load](size_t step) -> std::future<void>
+        {
+            if (ThreadPool::IsStarted() && !ThreadPool::IsWorkerThread()) {
+                return ThreadPool::QueueTask([&load, step] { load(step); });
+            }
+            return std::async(std::launch::deferred, [&load, step] { load(step); });
+        };
+
+        const auto multiply = [&](size_t step)
+        {
+            const size_t t = step / depth;
+            const size_t p = step % depth;
+            const size_t i = t / tileColumns;
+            const size_t j = t % tileColumns;
+
+            const size_t rows    = extent(m, mb, i);
+            const size_t columns = extent(n, nb, j);
+            const size_t inner   = extent(k, kb, p);
+
+            const bool aColumnMajor = aFile.Elements.ColumnMajor;
+            const bool bColumnMajor = bFile.Elements.ColumnMajor;
+            const MatrixView<const T> aBlock(blocks[step % 2].A.get(), rows, inner, aColumnMajor ? rows : inner,
+                                             aColumnMajor ? Ordering::ColumnMajor : Ordering::RowMajor);
+            const MatrixView<const T> bBlock(blocks[step % 2].B.get(), inner, columns, bColumnMajor ? inner : columns,
+                                             bColumnMajor ? Ordering::ColumnMajor : Ordering::RowMajor);
+            MatrixView<T> cTile(tile.get(), rows, columns, columns);
+
+            if (p == 0) {
+                cTile = aBlock * bBlock;
+            } else {
+                cTile += aBlock * bBlock;
+            }
+
+            if (p + 1 < depth) {
+                return;
+            }
+
+            // Tiles of whole rows are contiguous in the file and written at once.
+            const size_t writes = columns == n ? 1 : rows;
+            const size_t writeLength = columns == n ? rows * columns : columns;
+            for (size_t r = 0; r < writes; ++r)
+            {
+                cFile.seekp(static_cast<std::streamoff>(MATRIX_FILE_ALIGNMENT + ((i * mb + r) * n + j * nb) * sizeof(T)));
+                cFile.write(reinterpret_cast<const char*>(tile.get() + r * columns), static_cast<std::streamsize>(writeLength * sizeof(T)));
+            }
+            if (!cFile) {
+                throw std::system_error(errno, std::generic_category(), "Unable to write file \'" + cPath + "\'");
+            }
+        };
+
+        // Double buffering: the blocks of the next step are read while the current ones are multiplied.
+        load(0);
+        for (size_t step = 0; step < steps; ++step)
+        {
+            std::future<void> next = step + 1 < steps ? prefetch(step + 1) : std::future<void>();
+
+            try {
+                multiply(step);
+            } catch (...) {
+                if (next.valid()) {
+                    next.wait(); // The read references the blocks
+                }
+                throw;
+            }
+
+            if (next.valid()) {
+                next.get();
+            }
+        }
+
+        cFile.close();
+        if (!cFile) {
+            throw std::system_error(errno, std::generic_category(), "Unable to write file \'" + cPath + "\'");
+        }
+    }
+
+
+    template void WriteMatrixFile<int>(const std::string&, MatrixView<const int>);
+    template void WriteMatrixFile<size_t>(const std::string&, MatrixView<const size_t>);
+    template void WriteMatrixFile<float>(const std::string&, MatrixView<const float>);
+    template void WriteMatrixFile<double>(const std::string&, MatrixView<const double>);
+    template void WriteMatrixFile<BFloat16>(const std::string&, MatrixView<const BFloat16>);
+    template void WriteMatrixFile<Float16>(const std::string&, MatrixView<const Float16>);
+
+    template void WriteNpyFile<int>(const std::string&, MatrixView<const int>);
+    template void WriteNpyFile<size_t>(const std::string&, MatrixView<const size_t>);
+    template void WriteNpyFile<float>(const std::string&, MatrixView<const float>);
+    template void WriteNpyFile<double>(const std::string&, MatrixView<const double>);
+    template void WriteNpyFile<Float16>(const std::string&, MatrixView<const Float16>);
+
+    template class MappedMatrix<int>;
+    template class MappedMatrix<size_t>;
+    template class MappedMatrix<float>;
+    template class MappedMatrix<double>;
+    template class MappedMatrix<BFloat16>;
+    template class MappedMatrix<Float16>;
+
+    template Matrix<int> ReadMatrixFile<int>(const std::string&);
+    template Matrix<size_t> ReadMatrixFile<size_t>(const std::string&);
+    template Matrix<float> ReadMatrixFile<float>(const std::string&);
+    template Matrix<double> ReadMatrixFile<double>(const std::string&);
+    template Matrix<BFloat16> ReadMatrixFile<BFloat16>(const std::string&);
+    template Matrix<Float16> ReadMatrixFile<Float16>(const std::string&);
+
+    template Matrix<int> ParseTextMatrix<int>(std::string_view);
+    template Matrix<size_t> ParseTextMatrix<size_t>(std::string_view);
+    template Matrix<float> ParseTextMatrix<float>(std::string_view);
+    template Matrix<double> ParseTextMatrix<double>(std::string_view);
+
+    template Matrix<int> ReadTextMatrix<int>(const std::string&);
+    template Matrix<size_t> ReadTextMatrix<size_t>(const std::string&);
+    template Matrix<float> ReadTextMatrix<float>(const std::string&);
+    template Matrix<double> ReadTextMatrix<double>(const std::string&);
+
+    template void MultiplyMatrixFiles<int>(const std::string&, const std::string&, const std::string&, size_t);
+    template void MultiplyMatrixFiles<size_t>(const std::string&, const std::string&, const std::string&, size_t);
+    template void MultiplyMatrixFiles<float>(const std::string&, const std::string&, const std::string&, size_t);
+    template void MultiplyMatrixFiles<double>(const std::string&, const std::string&, const std::string&, size_t);
+
 } // end namespace IO
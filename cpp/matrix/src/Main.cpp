@@ -38,7 +38,7 @@ main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
 
     int64_t elapsed;
     int64_t total = 0;
-    Matrix<TEST_DT>* BCptr = nullptr;
+    std::unique_ptr<Matrix<TEST_DT>> BCptr;
 
     std::cout << "Running timing tests for generation and multiplication of matrices.\n"
               << "All printed times are real wall clock times of the different\n"
@@ -70,12 +70,13 @@ main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
         std::cout << "Generated C in: " << elapsed << " ms." << std::endl;
 
         tim.Reset();
-        auto BC = B * C;
+        const Matrix<TEST_DT> BC = B * C;
         elapsed = tim.Elapsed<std::chrono::milliseconds>();
         total += elapsed;
         std::cout << "Computed BC in: " << elapsed << " ms." << std::endl;
 
-        BCptr = &BC;
+        // B and C are released at the end of this scope, keep a copy of the (small) product.
+        BCptr = std::make_unique<Matrix<TEST_DT>>(BC);
     }
 
     if (BCptr == nullptr) {
@@ -93,7 +94,7 @@ main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
     std::cout << "Generated A in: " << elapsed << " ms." << std::endl;
 
     tim.Reset();
-    auto ABC = A * *BCptr;
+    const Matrix<TEST_DT> ABC = A * *BCptr;
     elapsed = tim.Elapsed<std::chrono::milliseconds>();
     total += elapsed;
     std::cout << "Computed A*BC in: " << elapsed << " ms.\n"
@@ -1,10 +1,13 @@
 #include "Math.hpp"
+#include "Float16.hpp"
+#include "Simd.hpp"
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <limits>
 #include <random>
+#include <stdexcept>
 #include <type_traits>
 
 
@@ -16,6 +19,13 @@ Math::AreEqual(const T& val1, const T& val2, [[maybe_unused]] const T realTypeTo
         const T EPSILON = realTypeToleranceFactor * std::numeric_limits<T>::epsilon();
         return std::fabs(val1 - val2) < EPSILON * std::max({ static_cast<T>(1.0), std::fabs(val1), std::fabs(val2) });
     }
+    else if constexpr (IsFloat16<T>)
+    {
+        const float EPSILON = realTypeToleranceFactor * static_cast<float>(std::numeric_limits<T>::epsilon());
+        const float lhs = val1;
+        const float rhs = val2;
+        return std::fabs(lhs - rhs) < EPSILON * std::max({ 1.0f, std::fabs(lhs), std::fabs(rhs) });
+    }
     else
     {
         static_assert(
@@ -29,6 +39,8 @@ Math::AreEqual(const T& val1, const T& val2, [[maybe_unused]] const T realTypeTo
 
 template bool Math::AreEqual<float>(const float&, const float&, const float);
 template bool Math::AreEqual<double>(const double&, const double&, const double);
+template bool Math::AreEqual<BFloat16>(const BFloat16&, const BFloat16&, const BFloat16);
+template bool Math::AreEqual<Float16>(const Float16&, const Float16&, const Float16);
 template bool Math::AreEqual<int>(const int&, const int&, const int);
 template bool Math::AreEqual<size_t>(const size_t&, const size_t&, const size_t);
 
@@ -47,6 +59,10 @@ Random::UniformlyDistributed(T minInclusive, T maxInclusive)
         );
         return distribution(generator);
     }
+    else if constexpr (IsFloat16<T>)
+    { // Rounding keeps the values in the range, since its bounds are representable.
+        return static_cast<T>(UniformlyDistributed<float>(minInclusive, maxInclusive));
+    }
     else if constexpr (std::is_same<T, int>() || std::is_same<T, size_t>())
     {
         std::uniform_int_distribution<T> distribution(minInclusive, maxInclusive);
@@ -72,6 +88,10 @@ Random::Fast(T minInclusive, T maxInclusive)
             (static_cast<T>(generator()) /
             (static_cast<T>(generator.max()) / (maxInclusive - minInclusive)));
     }
+    else if constexpr (IsFloat16<T>)
+    {
+        return static_cast<T>(Fast<float>(minInclusive, maxInclusive));
+    }
     else if constexpr (std::is_same<T, int>())
     {
         return minInclusive +
@@ -85,11 +105,116 @@ Random::Fast(T minInclusive, T maxInclusive)
 }
 
 
-template float  Random::UniformlyDistributed<float>(float, float);
-template double Random::UniformlyDistributed<double>(double, double);
-template int    Random::UniformlyDistributed<int>(int, int);
-template size_t Random::UniformlyDistributed<size_t>(size_t, size_t);
+Random::Philox::Philox(uint64_t seed, uint64_t stream)
+    : _seed(seed)
+    , _stream(stream)
+{
+    //
+}
+
+uint64_t
+Random::Philox::GetSeed() const
+{
+    return _seed;
+}
+
+uint64_t
+Random::Philox::GetStream() const
+{
+    return _stream;
+}
+
+void
+Random::Philox::Generate(uint64_t firstGroup, size_t groups, uint32_t* out) const
+{
+    Simd::GetRandomKernels().Philox(_seed, _stream, firstGroup, groups, out);
+}
+
+template<typename T> void
+Random::Philox::Fill(T* out, size_t n, uint64_t first, T minInclusive, T maxInclusive) const
+{
+    if (!(minInclusive <= maxInclusive)) {
+        throw std::invalid_argument("The minimum of a random range must not be larger than its maximum.");
+    }
+
+    constexpr size_t WORDS_PER_VALUE = sizeof(T) == 8 ? 2 : 1;
+    constexpr size_t GROUP_WORDS = 4 * Simd::PHILOX_LANES;
+    constexpr size_t BATCH_GROUPS = 16;
+
+    // The words are generated in batches that stay in L1 and converted to T in place of the output.
+    alignas(64) uint32_t words[BATCH_GROUPS * GROUP_WORDS];
+    uint64_t word = first * WORDS_PER_VALUE;
+
+    while (n > 0)
+    {
+        const size_t skip = static_cast<size_t>(word % GROUP_WORDS);
+        const size_t groups = std::min(BATCH_GROUPS, (skip + n * WORDS_PER_VALUE + GROUP_WORDS - 1) / GROUP_WORDS);
+        const size_t count = std::min(n, (groups * GROUP_WORDS - skip) / WORDS_PER_VALUE);
+        Generate(word / GROUP_WORDS, groups, words);
+
+        const uint32_t* w = words + skip;
+        if constexpr (std::is_same<T, double>())
+        {
+            const double range = maxInclusive - minInclusive;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const uint64_t bits = (static_cast<uint64_t>(w[2 * i]) << 21) | (w[2 * i + 1] >> 11);
+                out[i] = std::min(minInclusive + static_cast<double>(bits) * 0x1p-53 * range, maxInclusive);
+            }
+        }
+        else if constexpr (std::is_same<T, float>() || IsFloat16<T>)
+        {
+            const float lowest = minInclusive;
+            const float highest = maxInclusive;
+            const float range = highest - lowest;
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = static_cast<T>(std::min(lowest + static_cast<float>(w[i] >> 8) * 0x1p-24f * range, highest));
+            }
+        }
+        else if constexpr (std::is_same<T, int>())
+        { // The range of an int has at most 2^32 values, a multiplication maps the words onto it.
+            const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(maxInclusive) - minInclusive) + 1;
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = static_cast<int>(minInclusive + static_cast<int64_t>((w[i] * range) >> 32));
+            }
+        }
+        else if constexpr (std::is_same<T, size_t>())
+        {
+            const size_t range = maxInclusive - minInclusive + 1; // Zero for the full range
+            for (size_t i = 0; i < count; ++i)
+            {
+                const uint64_t bits = (static_cast<uint64_t>(w[2 * i]) << 32) | w[2 * i + 1];
+                out[i] = minInclusive + (range == 0 ? bits : bits % range);
+            }
+        }
+        else
+        {
+            static_assert(!sizeof(T*), "Random::Philox::Fill unsupported template type");
+        }
+
+        out += count;
+        n -= count;
+        word += count * WORDS_PER_VALUE;
+    }
+}
+
+
+template float    Random::UniformlyDistributed<float>(float, float);
+template double   Random::UniformlyDistributed<double>(double, double);
+template int      Random::UniformlyDistributed<int>(int, int);
+template size_t   Random::UniformlyDistributed<size_t>(size_t, size_t);
+template BFloat16 Random::UniformlyDistributed<BFloat16>(BFloat16, BFloat16);
+template Float16  Random::UniformlyDistributed<Float16>(Float16, Float16);
+
+template float    Random::Fast<float>(float, float);
+template double   Random::Fast<double>(double, double);
+template int      Random::Fast<int>(int, int);
+template BFloat16 Random::Fast<BFloat16>(BFloat16, BFloat16);
+template Float16  Random::Fast<Float16>(Float16, Float16);
 
-template float  Random::Fast<float>(float, float);
-template double Random::Fast<double>(double, double);
-template int    Random::Fast<int>(int, int);
+template void Random::Philox::Fill<float>(float*, size_t, uint64_t, float, float) const;
+template void Random::Philox::Fill<double>(double*, size_t, uint64_t, double, double) const;
+template void Random::Philox::Fill<int>(int*, size_t, uint64_t, int, int) const;
+template void Random::Philox::Fill<size_t>(size_t*, size_t, uint64_t, size_t, size_t) const;
+template void Random::Philox::Fill<BFloat16>(BFloat16*, size_t, uint64_t, BFloat16, BFloat16) const;
+template void Random::Philox::Fill<Float16>(Float16*, size_t, uint64_t, Float16, Float16) const;
@@ -1,8 +1,12 @@
 #include "Matrix.hpp"
+#include "Gemm.hpp"
 #include "Math.hpp"
+#include "Memory.hpp"
+#include "Simd.hpp"
 #include "ThreadPool.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <functional>
@@ -13,6 +17,244 @@
 #include <utility>
 
 
+/****************************************
+ * Transpose kernels
+ ****************************************/
+namespace
+{
+    // Blocks of LEAF x LEAF elements of the source and the destination fit into the L1 cache together.
+    constexpr size_t LEAF = 32;
+
+    /// @brief Writes the transpose of the rows x cols array src into the cols x rows array dst.
+    ///        Both arrays are row major with the given row strides. The larger dimension is
+    ///        halved until the blocks fit into the L1 cache, which makes the accesses cache
+    ///        efficient for every cache level without tuning for their sizes.
+    template<typename T> void
+    transposeRecursive(size_t rows, size_t cols, const T* src, size_t srcStride, T* dst, size_t dstStride)
+    {
+        if (rows <= LEAF && cols <= LEAF)
+        {
+            // Contiguous writes along the destination rows, the source block stays in the L1 cache.
+            for (size_t c = 0; c < cols; ++c) {
+                for (size_t r = 0; r < rows; ++r) {
+                    dst[c * dstStride + r] = src[r * srcStride + c];
+                }
+            }
+        }
+        else if (rows >= cols)
+        {
+            const size_t half = rows / 2;
+            transposeRecursive(half, cols, src, srcStride, dst, dstStride);
+            transposeRecursive(rows - half, cols, src + half * srcStride, srcStride, dst + half, dstStride);
+        }
+        else
+        {
+            const size_t half = cols / 2;
+            transposeRecursive(rows, half, src, srcStride, dst, dstStride);
+            transposeRecursive(rows, cols - half, src + half, srcStride, dst + half * dstStride, dstStride);
+        }
+    }
+
+    /// @brief Writes the transpose of the row major rows x cols array src with the row stride
+    ///        srcStride into the contiguous array dst, in parallel slices along the larger
+    ///        dimension if the ThreadPool is started.
+    template<typename T> void
+    transpose(size_t rows, size_t cols, const T* src, size_t srcStride, T* dst, size_t minOperationsPerThread)
+    {
+        if (rows >= cols)
+        {
+            const size_t minRows = std::max<size_t>(minOperationsPerThread / std::max<size_t>(cols, 1), 1);
+            ThreadPool::ParallelFor(rows, minRows, [cols, rows, src, srcStride, dst](size_t row, size_t endRow) {
+                transposeRecursive(endRow - row, cols, src + row * srcStride, srcStride, dst + row, rows);
+            });
+        }
+        else
+        {
+            const size_t minCols = std::max<size_t>(minOperationsPerThread / std::max<size_t>(rows, 1), 1);
+            ThreadPool::ParallelFor(cols, minCols, [cols, rows, src, srcStride, dst](size_t col, size_t endCol) {
+                transposeRecursive(rows, endCol - col, src + col, srcStride, dst + col * rows, rows);
+            });
+        }
+    }
+
+    /// @brief Transposes the contiguous n x n array in place. Tiles above the diagonal are swapped
+    ///        with their mirrored tiles below it. Tile row i has n/LEAF - i tiles to process, so
+    ///        the rows i and (tiles - 1 - i) are paired to give every thread the same amount of work.
+    template<typename T> void
+    transposeSquareInPlace(size_t n, T* data, size_t minOperationsPerThread)
+    {
+        const size_t tiles = (n + LEAF - 1) / LEAF;
+
+        const auto processTileRow = [n, data](size_t i)
+        {
+            const size_t rowBegin = i * LEAF;
+            const size_t rowEnd   = std::min(rowBegin + LEAF, n);
+
+            // The diagonal tile.
+            for (size_t r = rowBegin; r < rowEnd; ++r) {
+                for (size_t c = r + 1; c < rowEnd; ++c) {
+                    std::swap(data[r * n + c], data[c * n + r]);
+                }
+            }
+
+            for (size_t colBegin = rowEnd; colBegin < n; colBegin += LEAF)
+            {
+                const size_t colEnd = std::min(colBegin + LEAF, n);
+                for (size_t r = rowBegin; r < rowEnd; ++r) {
+                    for (size_t c = colBegin; c < colEnd; ++c) {
+                        std::swap(data[r * n + c], data[c * n + r]);
+                    }
+                }
+            }
+        };
+
+        const size_t pairs = (tiles + 1) / 2;
+        const size_t minPairs = std::max<size_t>(minOperationsPerThread / std::max<size_t>(n * LEAF, 1), 1);
+
+        ThreadPool::ParallelFor(pairs, minPairs, [tiles, &processTileRow](size_t pair, size_t endPair) {
+            for (; pair < endPair; ++pair)
+            {
+                processTileRow(pair);
+                if (tiles - 1 - pair != pair) {
+                    processTileRow(tiles - 1 - pair);
+                }
+            }
+        });
+    }
+
+} // end anonymous namespace
+
+
+/****************************************
+ * Matrix-vector kernels
+ ****************************************/
+namespace
+{
+    /// @brief Computes y = alpha * A * x + beta * y for a rows x cols matrix A and contiguous
+    ///        vectors x and y, in parallel slices of y if the ThreadPool is started. beta is either
+    ///        zero, in which case y is not read, or one.
+    /// @return false, if neither the rows nor the columns of A are contiguous.
+    template<typename T> bool
+    multiplyVector(size_t rows, size_t cols, T alpha, const T* a, Gemm::Strides as, const T* x, T beta, T* y, size_t minOperationsPerThread)
+    {
+        const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+        const size_t minRows = std::max<size_t>(minOperationsPerThread / std::max<size_t>(cols, 1), 1);
+
+        if (as.Col == 1)
+        { // Dot products of the rows with x.
+            ThreadPool::ParallelFor(rows, minRows, [&kernels, cols, alpha, a, as, x, beta, y](size_t row, size_t endRow)
+            {
+                constexpr size_t BLOCK = 64;
+                T dots[BLOCK];
+                for (; row < endRow; row += BLOCK)
+                {
+                    const size_t count = std::min(BLOCK, endRow - row);
+                    kernels.DotRows(count, cols, a + row * as.Row, as.Row, x, dots);
+                    for (size_t i = 0; i < count; ++i) {
+                        y[row + i] = beta == static_cast<T>(0) ? alpha * dots[i] : y[row + i] + alpha * dots[i];
+                    }
+                }
+            });
+            return true;
+        }
+
+        if (as.Row == 1)
+        { // Sum of the columns scaled by x, over blocks of y that stay in the L1 cache.
+            ThreadPool::ParallelFor(rows, minRows, [&kernels, cols, alpha, a, as, x, beta, y](size_t row, size_t endRow)
+            {
+                constexpr size_t BLOCK = 2048;
+                for (; row < endRow; row += BLOCK)
+                {
+                    const size_t count = std::min(BLOCK, endRow - row);
+                    if (beta == static_cast<T>(0)) {
+                        std::fill(y + row, y + row + count, static_cast<T>(0));
+                    }
+                    kernels.AxpyColumns(cols, count, alpha, a + row, as.Col, x, y + row);
+                }
+            });
+            return true;
+        }
+
+        return false;
+    }
+
+    /// @brief Computes C = alpha * a * b^T + beta * C, the outer product of a vector a of rows
+    ///        elements and a vector b of cols elements with the element strides as and bs.
+    ///        Parallel over the rows or columns of C, whichever are contiguous.
+    /// @return false, if neither the rows nor the columns of C are contiguous together with b or a.
+    template<typename T> bool
+    multiplyOuter(size_t rows, size_t cols, T alpha, const T* a, size_t as, const T* b, size_t bs, T beta, T* c, Gemm::Strides cs, size_t minOperationsPerThread)
+    {
+        const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+
+        // Every line of C is the contiguous vector scaled by an element of the other vector.
+        const auto scaleLines = [&kernels, alpha, beta, c, minOperationsPerThread](
+            size_t lines, size_t length, const T* scales, size_t scalesStride, const T* vector, size_t lineStride)
+        {
+            const size_t minLines = std::max<size_t>(minOperationsPerThread / std::max<size_t>(length, 1), 1);
+            ThreadPool::ParallelFor(lines, minLines, [&](size_t line, size_t endLine) {
+                for (; line < endLine; ++line)
+                {
+                    const T scale = alpha * scales[line * scalesStride];
+                    if (beta == static_cast<T>(0)) {
+                        kernels.Scale(scale, vector, c + line * lineStride, length);
+                    } else {
+                        kernels.Axpy(scale, vector, c + line * lineStride, length);
+                    }
+                }
+            });
+        };
+
+        if (cs.Col == 1 && bs == 1) {
+            scaleLines(rows, cols, a, as, b, cs.Row);
+            return true;
+        }
+        if (cs.Row == 1 && as == 1) {
+            scaleLines(cols, rows, b, bs, a, cs.Col);
+            return true;
+        }
+
+        return false;
+    }
+
+} // end anonymous namespace
+
+
+/****************************************
+ * View helpers
+ ****************************************/
+namespace
+{
+    /// @brief Returns true if the views are of the same elements in the same layout.
+    template<typename T> bool
+    isSameView(const MatrixView<const T>& lhs, const MatrixView<const T>& rhs)
+    {
+        return lhs.Data() == rhs.Data() && lhs.GetHeight() == rhs.GetHeight() && lhs.GetWidth() == rhs.GetWidth() &&
+               lhs.GetStrides().Row == rhs.GetStrides().Row && lhs.GetStrides().Col == rhs.GetStrides().Col;
+    }
+
+    /// @brief Returns true if the address ranges spanned by the views intersect. Views with gaps,
+    ///        e.g. two blocks side by side, may span intersecting ranges without sharing elements.
+    template<typename T> bool
+    overlaps(const MatrixView<const T>& lhs, const MatrixView<const T>& rhs)
+    {
+        const auto span = [](const MatrixView<const T>& view) -> std::pair<const T*, const T*>
+        {
+            if (view.GetHeight() == 0 || view.GetWidth() == 0) {
+                return { view.Data(), view.Data() };
+            }
+            const Gemm::Strides strides = view.GetStrides();
+            return { view.Data(), view.Data() + (view.GetHeight() - 1) * strides.Row + (view.GetWidth() - 1) * strides.Col + 1 };
+        };
+
+        const auto [lhsBegin, lhsEnd] = span(lhs);
+        const auto [rhsBegin, rhsEnd] = span(rhs);
+        return std::less<const T*>()(lhsBegin, rhsEnd) && std::less<const T*>()(rhsBegin, lhsEnd);
+    }
+
+} // end anonymous namespace
+
+
 /****************************************
  * Matrix::Reference implemenentation
  ****************************************/
@@ -62,12 +304,11 @@ Matrix<T>::ConstReference::operator[](const size_t col) const
 template<class T> Matrix<T>
 Matrix<T>::ID(size_t size)
 { // static function
-    std::unique_ptr<T[]> data = std::make_unique<T[]>(size * size);
+    Memory::Buffer<T> data = uninitialized(size * size);
 
-    for (size_t r = 0; r < size; ++r) {
-        for (size_t c = 0; c < size; ++c) {
-            data[r*size + c] = static_cast<T>(r == c ? 1 : 0);
-        }
+    parallelFill(data.get(), size * size, static_cast<T>(0));
+    for (size_t i = 0; i < size; ++i) {
+        data[i*size + i] = static_cast<T>(1);
     }
 
     return Matrix(size, size, std::move(data));
@@ -82,49 +323,36 @@ Matrix<T>::Random(
 { // static function
     size_t length = rows*columns;
 
-    std::unique_ptr<T[]> data = std::make_unique<T[]>(length);
+    Memory::Buffer<T> data = uninitialized(length);
 
-    if (ThreadPool::IsStarted())
-    {
-        size_t lengthSlice = length / ThreadPool::GetThreadsCount();
-        if (lengthSlice < MIN_OPERATIONS_PER_THREAD) {
-            lengthSlice = MIN_OPERATIONS_PER_THREAD;
+    // Each thread fills a disjoint range of the data array.
+    ThreadPool::ParallelFor(length, MIN_OPERATIONS_PER_THREAD, [&data, &generatorFunc](size_t start, size_t end) {
+        while (start < end) {
+            data[start++] = generatorFunc();
         }
-        size_t i = 0;
+    });
 
-        std::vector<std::future<bool>> threadResults;
-
-        // Function for the worker threads to run.
-        const auto fillArrSegment = [&data, &generatorFunc](size_t start, size_t end)
-        {
-            while (start < end) {
-                data[start++] = generatorFunc();
-            }
-
-            return true;
-        };
+    return Matrix(rows, columns, std::move(data), ordering);
+}
 
-        for (; lengthSlice > 0 && (i+lengthSlice) <= length; i += lengthSlice) {
-            // Start threads, each thread fills a disjoint range of the data array.
-            threadResults.push_back(ThreadPool::QueueTask(std::bind(fillArrSegment, i, i+lengthSlice)));
-        }
+template<class T> Matrix<T>
+Matrix<T>::Random(
+    size_t rows,
+    size_t columns,
+    T minInclusive,
+    T maxInclusive,
+    uint64_t seed,
+    Matrix::Ordering ordering)
+{ // static function
+    const size_t length = rows * columns;
+    const ::Random::Philox generator(seed);
 
-        while (i < length) {
-            // Main thread fills the remainder range, with length < worker threads range.
-            data[i++] = generatorFunc();
-        }
+    Memory::Buffer<T> data = uninitialized(length);
 
-        for (auto& r : threadResults) {
-            // Wait for all threads to complete before continuing.
-            r.get();
-        }
-    }
-    else
-    {
-        for (size_t i = 0; i < rows*columns; ++i) {
-            data[i] = generatorFunc();
-        }
-    }
+    // Generation is bound by the memory bandwidth, every slice is an independent range of the sequence.
+    ThreadPool::ParallelFor(length, MIN_OPERATIONS_PER_THREAD, [&data, &generator, minInclusive, maxInclusive](size_t start, size_t end) {
+        generator.Fill(data.get() + start, end - start, start, minInclusive, maxInclusive);
+    });
 
     return Matrix(rows, columns, std::move(data), ordering);
 }
@@ -135,11 +363,52 @@ Matrix<T>::Matrix(const Matrix& other)
     : _rows(other._rows)
     , _columns(other._columns)
     , _ordering(other._ordering)
-    , _data(std::make_unique<T[]>(other.getLength()))
+    , _data(uninitialized(other.getLength()))
 {
-    for (size_t i = 0; i < other.getLength(); ++i) {
-        _data[i] = other._data[i];
+    parallelCopy(other._data.get(), _data.get(), other.getLength());
+}
+
+template<class T>
+Matrix<T>::Matrix(Matrix&& other) noexcept
+    : _rows(std::exchange(other._rows, 0))
+    , _columns(std::exchange(other._columns, 0))
+    , _ordering(other._ordering)
+    , _data(std::move(other._data))
+{
+    //
+}
+
+template<class T> Matrix<T>&
+Matrix<T>::operator=(const Matrix& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+
+    if (getLength() != other.getLength()) {
+        _data = uninitialized(other.getLength());
     }
+
+    _rows     = other._rows;
+    _columns  = other._columns;
+    _ordering = other._ordering;
+    parallelCopy(other._data.get(), _data.get(), other.getLength());
+
+    return *this;
+}
+
+template<class T> Matrix<T>&
+Matrix<T>::operator=(Matrix&& other) noexcept
+{
+    if (this != &other)
+    {
+        _rows     = std::exchange(other._rows, 0);
+        _columns  = std::exchange(other._columns, 0);
+        _ordering = other._ordering;
+        _data     = std::move(other._data);
+    }
+
+    return *this;
 }
 
 template<class T>
@@ -147,12 +416,9 @@ Matrix<T>::Matrix(size_t rows, size_t columns, Matrix::Ordering ordering)
     : _rows(rows)
     , _columns(columns)
     , _ordering(ordering)
-    , _data(std::make_unique<T[]>(_rows * _columns))
+    , _data(uninitialized(_rows * _columns))
 {
-    assert(_rows * _columns == getLength());
-    for (size_t i = 0; i < getLength(); ++i) {
-        _data[i] = static_cast<T>(0);
-    }
+    parallelFill(_data.get(), getLength(), static_cast<T>(0));
 }
 
 template<class T>
@@ -160,16 +426,24 @@ Matrix<T>::Matrix(size_t rows, size_t columns, const std::vector<T>& data, Matri
     : _rows(rows)
     , _columns(columns)
     , _ordering(ordering)
-    , _data(std::make_unique<T[]>(data.size()))
+    , _data(uninitialized(data.size()))
 {
     assert(getLength() == data.size());
-    for (size_t i = 0; i < getLength(); ++i) {
-        _data[i] = data[i];
-    }
+    parallelCopy(data.data(), _data.get(), getLength());
 }
 
 template<class T>
 Matrix<T>::Matrix(size_t rows, size_t columns, std::unique_ptr<T[]>&& data, Matrix::Ordering ordering)
+    : _rows(rows)
+    , _columns(columns)
+    , _ordering(ordering)
+    , _data(Memory::Adopt(std::move(data)))
+{
+    //
+}
+
+template<class T>
+Matrix<T>::Matrix(size_t rows, size_t columns, Memory::Buffer<T>&& data, Matrix::Ordering ordering)
     : _rows(rows)
     , _columns(columns)
     , _ordering(ordering)
@@ -183,7 +457,7 @@ Matrix<T>::Matrix(const std::initializer_list<std::initializer_list<T>> twoDimLi
     : _rows(twoDimList.size())
     , _columns(twoDimList.begin()->size())
     , _ordering(ordering)
-    , _data(std::make_unique<T[]>(_rows * _columns))
+    , _data(uninitialized(_rows * _columns))
 {
     // NOTE: Amount of rows is always > 0 if this ctor is called
     if (_columns == 0) {
@@ -232,10 +506,39 @@ Matrix<T>::operator[](size_t row) const {
     return Matrix::ConstReference(*this, row);
 }
 
-template<class T> Matrix<T>
-Matrix<T>::operator*(const Matrix<T>& rhs) const
+template<class T> MatrixView<T>
+Matrix<T>::View()
 {
+    return MatrixView<T>(_data.get(), GetHeight(), GetWidth(), physicalColumns(), GetOrdering());
+}
 
+template<class T> MatrixView<const T>
+Matrix<T>::View() const
+{
+    return MatrixView<const T>(_data.get(), GetHeight(), GetWidth(), physicalColumns(), GetOrdering());
+}
+
+template<class T> MatrixView<T>
+Matrix<T>::Row(size_t row) { return View().Row(row); }
+
+template<class T> MatrixView<const T>
+Matrix<T>::Row(size_t row) const { return View().Row(row); }
+
+template<class T> MatrixView<T>
+Matrix<T>::Column(size_t col) { return View().Column(col); }
+
+template<class T> MatrixView<const T>
+Matrix<T>::Column(size_t col) const { return View().Column(col); }
+
+template<class T> MatrixView<T>
+Matrix<T>::Block(size_t row, size_t col, size_t rows, size_t columns) { return View().Block(row, col, rows, columns); }
+
+template<class T> MatrixView<const T>
+Matrix<T>::Block(size_t row, size_t col, size_t rows, size_t columns) const { return View().Block(row, col, rows, columns); }
+
+template<class T> Matrix<T>
+Matrix<T>::Multiply(const Matrix<T>& rhs, Matrix::Ordering resultOrdering) const
+{
     if (this->GetWidth() != rhs.GetHeight()) {
         throw std::invalid_argument("Mismatching matrix dimensions for multiplication.");
     }
@@ -243,132 +546,143 @@ Matrix<T>::operator*(const Matrix<T>& rhs) const
     const size_t height = this->GetHeight();
     const size_t width  = rhs.GetWidth();
 
-    std::unique_ptr<T[]> data = std::make_unique<T[]>(height * width);
+    Matrix result(height, width, uninitialized(height * width), resultOrdering);
+    multiplyInto(View(), rhs.View(), static_cast<T>(1), static_cast<T>(0), result.View());
 
-    if (ThreadPool::IsStarted())
-    {
-        size_t rowSlice = height / ThreadPool::GetThreadsCount();
-        if ((rowSlice * this->GetWidth()) < MIN_OPERATIONS_PER_THREAD) {
-            rowSlice = MIN_OPERATIONS_PER_THREAD / this->GetWidth();
-        }
-
-        size_t r = 0;
+    return result;
+}
 
-        std::vector<std::future<bool>> threadResults;
+template<class T> Matrix<T>
+Matrix<T>::MultiplyStrassen(const Matrix<T>& rhs, size_t cutoff) const
+{
+    if (this->GetWidth() != rhs.GetHeight()) {
+        throw std::invalid_argument("Mismatching matrix dimensions for multiplication.");
+    }
 
-        const auto computeRows = [this, &data, &width, &height, &rhs](size_t row, size_t endRow)
-        {
-            while (row < endRow)
-            {
-                for (size_t c = 0; c < width; ++c)
-                {
-                    T sum = static_cast<T>(0);
-                    for (size_t i = 0; i < this->GetWidth(); ++i)
-                    {
-                        sum += this->_data[this->getDataIdx(row, i)] * rhs._data[rhs.getDataIdx(i, c)];
-                    }
-                    data[row * width + c] = sum;
-                }
-                ++row;
-            }
+    const size_t height = this->GetHeight();
+    const size_t width  = rhs.GetWidth();
+    const size_t depth  = this->GetWidth();
 
-            return true;
-        };
+    if (cutoff == 0) {
+        cutoff = Gemm::StrassenCutoff<T>();
+    }
 
-        for (; rowSlice > 0 && (r+rowSlice) <= height; r += rowSlice) {
-            threadResults.push_back(ThreadPool::QueueTask(std::bind(computeRows, r, r+rowSlice)));
-        }
+    if (std::min({ height, width, depth }) <= cutoff) {
+        // No recursion would take place, use the classic (parallel) multiplication.
+        return Multiply(rhs, Ordering::RowMajor);
+    }
 
-        computeRows(r, height); // Compute possible remaining rows.
+    Memory::Buffer<T> data = uninitialized(height * width);
 
-        for (auto& res : threadResults) {
-            res.get();
-        }
-    }
-    else
-    {
-        for (size_t r = 0; r < height; ++r)
-        {
-            for (size_t c = 0; c < width; ++c)
-            {
-                T sum = static_cast<T>(0);
-                for (size_t i = 0; i < this->GetWidth(); ++i)
-                {
-                    sum += this->_data[this->getDataIdx(r, i)] * rhs._data[rhs.getDataIdx(i, c)];
-                }
-                data[r * width + c] = sum;
-            }
-        }
-    }
+    Gemm::Strassen<T>(
+        height, width, depth,
+        this->_data.get(), this->getStrides(),
+        rhs._data.get(), rhs.getStrides(),
+        data.get(), { width, 1 },
+        cutoff,
+        ThreadPool::IsStarted() && !ThreadPool::IsWorkerThread()
+    );
 
     return Matrix(height, width, std::move(data), Matrix<T>::Ordering::RowMajor);
 }
 
-template<class T> Matrix<T>
-Matrix<T>::operator+(const Matrix<T>& rhs) const{
-    if (this->GetHeight() != rhs.GetHeight() ||
-        this->GetWidth() != rhs.GetWidth())
-    {
-        throw std::invalid_argument("Mismatching matrix dimensions for addition");
+template<class T> Matrix<T>&
+Matrix<T>::operator*=(T factor)
+{
+    T* data = _data.get();
+    ThreadPool::ParallelFor(getLength(), MIN_OPERATIONS_PER_THREAD, [data, factor](size_t begin, size_t end) {
+        Simd::GetKernels<T>().Scale(factor, data + begin, data + begin, end - begin);
+    });
+    return *this;
+}
+
+template<class T> Matrix<T>&
+Matrix<T>::operator*=(const Matrix<T>& rhs)
+{
+    if (this->GetWidth() != rhs.GetHeight()) {
+        throw std::invalid_argument("Mismatching matrix dimensions for multiplication.");
     }
 
-    assert(this->getLength() == rhs.getLength());
+    if (this == &rhs || rhs.GetHeight() != rhs.GetWidth()) {
+        // The product reads all of this matrix while it is written, or has another shape.
+        return *this = Multiply(rhs, GetOrdering());
+    }
 
-    std::unique_ptr<T[]> data = std::make_unique<T[]>(this->getLength());
+    // Each block of rows of the product only depends on the same rows of this matrix, so the
+    // rows are copied out to a scratch panel and overwritten by their product with rhs.
+    // Blocks are large enough to amortize the packing of rhs in every Gemm::Multiply call.
+    constexpr size_t BLOCK_ROWS = 128;
 
-    if (this->GetOrdering() == rhs.GetOrdering())
-    {
-        for (size_t i = 0; i < this->getLength(); ++i) {
-            data[i] = this->_data[i] + rhs._data[i];
-        }
-    }
-    else
+    // The panel is drawn from the current allocator, a PoolAllocator serves it without reaching
+    // upstream when the same product is repeated.
+    const size_t depth = GetWidth();
+    const size_t blockRows = std::min(BLOCK_ROWS, GetHeight());
+    const Memory::Buffer<T> scratch = uninitialized(blockRows * depth);
+
+    const Gemm::Strides strides = getStrides();
+
+    for (size_t row = 0; row < GetHeight(); row += blockRows)
     {
-        for (size_t r = 0; r < this->GetHeight(); ++r) {
-            for (size_t c = 0; c < this->GetWidth(); ++c) {
-                data[getDataIdx(r, c)] =
-                    this->_data[getDataIdx(r, c)] + rhs._data[rhs.getDataIdx(r, c)];
+        const size_t rows = std::min(blockRows, GetHeight() - row);
+
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < depth; ++c) {
+                scratch[r * depth + c] = _data[(row + r) * strides.Row + c * strides.Col];
             }
         }
+
+        multiplyInto(
+            MatrixView<const T>(scratch.get(), rows, depth, depth), rhs.View(),
+            static_cast<T>(1), static_cast<T>(0), Block(row, 0, rows, GetWidth())
+        );
     }
 
-    return Matrix(this->GetHeight(), this->GetWidth(), std::move(data), this->GetOrdering());
+    return *this;
 }
 
 template<class T> Matrix<T>
-Matrix<T>::operator-(const Matrix<T>& rhs) const
+Matrix<T>::Transpose() const
 {
-    if (this->GetHeight() != rhs.GetHeight() ||
-        this->GetWidth() != rhs.GetWidth())
-    {
-        throw std::invalid_argument("Mismatching matrix dimensions for subtraction");
-    }
+    Matrix result(GetWidth(), GetHeight(), uninitialized(getLength()), GetOrdering());
+    transpose(physicalRows(), physicalColumns(), _data.get(), physicalColumns(), result._data.get(), MIN_OPERATIONS_PER_THREAD);
+    return result;
+}
 
-    assert(this->getLength() == rhs.getLength());
+template<class T> void
+Matrix<T>::TransposeInPlace()
+{
+    if (GetHeight() != GetWidth()) {
+        *this = Transpose();
+        return;
+    }
 
-    std::unique_ptr<T[]> data = std::make_unique<T[]>(this->getLength());
+    transposeSquareInPlace(GetHeight(), _data.get(), MIN_OPERATIONS_PER_THREAD);
+}
 
-    if (this->GetOrdering() == rhs.GetOrdering())
-    {
-        for (size_t i = 0; i < this->getLength(); ++i) {
-            data[i] = this->_data[i] - rhs._data[i];
-        }
-    }
-    else
-    {
-        for (size_t r = 0; r < this->GetHeight(); ++r) {
-            for (size_t c = 0; c < this->GetWidth(); ++c) {
-                data[getDataIdx(r, c)] =
-                    this->_data[getDataIdx(r, c)] - rhs._data[rhs.getDataIdx(r, c)];
-            }
-        }
+template<class T> Matrix<T>
+Matrix<T>::ToOrdering(Matrix::Ordering ordering) const
+{
+    if (ordering == GetOrdering()) {
+        return Matrix(*this);
     }
 
-    return Matrix(this->GetHeight(), this->GetWidth(), std::move(data), this->GetOrdering());
+    // The data of the matrix in the other ordering is the transpose of the data array.
+    Matrix result(GetHeight(), GetWidth(), uninitialized(getLength()), ordering);
+    transpose(physicalRows(), physicalColumns(), _data.get(), physicalColumns(), result._data.get(), MIN_OPERATIONS_PER_THREAD);
+    return result;
+}
+
+template<class T> void
+Matrix<T>::Swap(Matrix& other) noexcept
+{
+    std::swap(_rows, other._rows);
+    std::swap(_columns, other._columns);
+    std::swap(_ordering, other._ordering);
+    std::swap(_data, other._data);
 }
 
 template<class T> bool
-Matrix<T>::operator==(const Matrix<T>& rhs) const
+Matrix<T>::Equals(const Matrix<T>& rhs) const
 {
     if (this->GetHeight()  != rhs.GetHeight() ||
         this->GetWidth()   != rhs.GetWidth())
@@ -378,32 +692,38 @@ Matrix<T>::operator==(const Matrix<T>& rhs) const
 
     assert(this->getLength() == rhs.getLength());
 
-    constexpr T realTEpsilonFactor = static_cast<T>(3);
+    constexpr AccumulatorType<T> realTEpsilonFactor = static_cast<AccumulatorType<T>>(3);
     // Use a wider than default factor for comparing values of RealType. This is
     // required for the tests, that compare matrices with float values, read from a
     // textual file that has been computed and saved by a python script.
     // TODO: Refactor Comparator so that the epsilon factor can be set from within the tests.
 
-    if (this->GetOrdering() == rhs.GetOrdering())
-    {
-        for (size_t i = 0; i < this->getLength(); ++i) {
-            if (!Math::AreEqual(this->_data[i], rhs._data[i], realTEpsilonFactor)) {
-                return false;
-            }
-        }
+    if (this->GetOrdering() != rhs.GetOrdering()) {
+        // Convert once instead of comparing with strided accesses to one of the matrices.
+        return Equals(rhs.ToOrdering(GetOrdering()));
     }
-    else
+
+    // Set by the first thread that finds a mismatch, all threads poll it to stop early.
+    std::atomic<bool> mismatch { false };
+
+    const T* lhsData = this->_data.get();
+    const T* rhsData = rhs._data.get();
+
+    ThreadPool::ParallelFor(getLength(), MIN_OPERATIONS_PER_THREAD, [&mismatch, lhsData, rhsData](size_t begin, size_t end)
     {
-        for (size_t i = 0; i < this->GetHeight(); ++i) {
-            for (size_t j = 0; j < this->GetWidth(); ++j) {
-                if (!Math::AreEqual(this->_data[getDataIdx(i, j)], rhs._data[rhs.getDataIdx(i, j)], realTEpsilonFactor)) {
-                    return false;
-                }
+        // Blocks small enough to react quickly to a mismatch found by another thread.
+        constexpr size_t BLOCK = 16384;
+
+        const auto& kernels = Simd::GetKernels<T>();
+        for (size_t i = begin; i < end && !mismatch.load(std::memory_order_relaxed); i += BLOCK)
+        {
+            if (!kernels.AreEqual(lhsData + i, rhsData + i, std::min(BLOCK, end - i), realTEpsilonFactor)) {
+                mismatch.store(true, std::memory_order_relaxed);
             }
         }
-    }
+    });
 
-    return true;
+    return !mismatch.load();
 }
 
 
@@ -429,10 +749,316 @@ Matrix<T>::getDataIdx(size_t row, size_t col, Matrix<T>::Ordering ordering) cons
     __builtin_unreachable();
 }
 
+template<class T> Gemm::Strides
+Matrix<T>::getStrides() const
+{
+    switch (GetOrdering())
+    {
+        case Ordering::RowMajor:    return { GetWidth(), 1 };
+        case Ordering::ColumnMajor: return { 1, GetHeight() };
+    }
+
+    assert(false);
+    __builtin_unreachable();
+}
+
 template<class T> size_t
 Matrix<T>::getLength() const
 { return GetHeight() * GetWidth(); }
 
+template<class T> size_t
+Matrix<T>::physicalRows() const
+{ return GetOrdering() == Ordering::RowMajor ? GetHeight() : GetWidth(); }
+
+template<class T> size_t
+Matrix<T>::physicalColumns() const
+{ return GetOrdering() == Ordering::RowMajor ? GetWidth() : GetHeight(); }
+
+template<class T> void
+Matrix<T>::parallelCopy(const T* src, T* dst, size_t length)
+{ // static function
+    ThreadPool::ParallelFor(length, MIN_OPERATIONS_PER_THREAD, [src, dst](size_t begin, size_t end) {
+        std::copy(src + begin, src + end, dst + begin);
+    });
+}
+
+template<class T> void
+Matrix<T>::parallelFill(T* dst, size_t length, T value)
+{ // static function
+    ThreadPool::ParallelFor(length, MIN_OPERATIONS_PER_THREAD, [dst, value](size_t begin, size_t end) {
+        std::fill(dst + begin, dst + end, value);
+    });
+}
+
+template<class T> Memory::Buffer<T>
+Matrix<T>::uninitialized(size_t length)
+{ // static function
+    // The elements are overwritten by the caller.
+    return Memory::Allocate<T>(length);
+}
+
+template<class T> void
+Matrix<T>::assign(const MatrixExpression::Terms<T>& terms)
+{
+    evaluate(View(), terms);
+}
+
+template<class T> void
+Matrix<T>::evaluate(MatrixView<T> result, const MatrixExpression::Terms<T>& terms)
+{ // static function
+    const MatrixView<const T> output(result);
+
+    // Products would read elements of the result that are already overwritten, and so would
+    // linear terms that share elements with the result in other positions.
+    bool hazard = false;
+    for (const auto& product : terms.Products) {
+        hazard = hazard || overlaps(product.Lhs, output) || overlaps(product.Rhs, output);
+    }
+    for (const auto& linear : terms.Linears) {
+        hazard = hazard || (overlaps(linear.Operand, output) && !isSameView(linear.Operand, output));
+    }
+
+    if (hazard)
+    {
+        Matrix<T> value(result.GetHeight(), result.GetWidth(), uninitialized(result.GetHeight() * result.GetWidth()), result.GetOrdering());
+        value.assign(terms);
+        evaluateLinear(result, { { static_cast<T>(1), value.View() } });
+        return;
+    }
+
+    if (!terms.Linears.empty()) {
+        evaluateLinear(result, terms.Linears);
+    }
+
+    bool accumulate = !terms.Linears.empty();
+    for (const auto& product : terms.Products)
+    {
+        multiplyInto(product.Lhs, product.Rhs, product.Scale, static_cast<T>(accumulate ? 1 : 0), result);
+        accumulate = true;
+    }
+}
+
+template<class T> void
+Matrix<T>::evaluateLinear(MatrixView<T> result, const std::vector<typename MatrixExpression::Terms<T>::Linear>& linears)
+{ // static function
+    using Linear = typename MatrixExpression::Terms<T>::Linear;
+
+    const MatrixView<const T> output(result);
+
+    // Merge repeated operands, and move the result to the front if it is an operand, since
+    // the first term overwrites the result before the other terms are read.
+    std::vector<Linear> terms;
+    terms.reserve(linears.size());
+    for (const Linear& term : linears)
+    {
+        const auto it = std::find_if(terms.begin(), terms.end(),
+                                     [&term](const Linear& t) { return isSameView(t.Operand, term.Operand); });
+        if (it != terms.end()) {
+            it->Scale = static_cast<T>(it->Scale + term.Scale);
+        } else if (isSameView(term.Operand, output)) {
+            terms.insert(terms.begin(), term);
+        } else {
+            terms.push_back(term);
+        }
+    }
+
+    // The result is swept along its contiguous lines: its rows if consecutive columns are
+    // adjacent in memory, its columns otherwise.
+    const Gemm::Strides strides = result.GetStrides();
+    const bool byRows = strides.Col == 1;
+    const size_t lines      = byRows ? result.GetHeight() : result.GetWidth();
+    const size_t lineLength = byRows ? result.GetWidth() : result.GetHeight();
+    const auto lineStride    = [byRows](Gemm::Strides s) { return byRows ? s.Row : s.Col; };
+    const auto elementStride = [byRows](Gemm::Strides s) { return byRows ? s.Col : s.Row; };
+
+    // Operands whose lines run the other way are converted once, so that all operands are read
+    // contiguously. The data of the converted operand is the transpose of its data array.
+    std::vector<Matrix<T>> converted;
+    converted.reserve(terms.size());
+    for (Linear& term : terms)
+    {
+        const MatrixView<const T>& operand = term.Operand;
+        if (lineLength > 1 && elementStride(operand.GetStrides()) != 1)
+        {
+            const bool rowMajor = operand.GetOrdering() == Ordering::RowMajor;
+            const size_t dataRows    = rowMajor ? operand.GetHeight() : operand.GetWidth();
+            const size_t dataColumns = rowMajor ? operand.GetWidth() : operand.GetHeight();
+
+            converted.emplace_back(operand.GetHeight(), operand.GetWidth(), uninitialized(dataRows * dataColumns),
+                                   rowMajor ? Ordering::ColumnMajor : Ordering::RowMajor);
+            transpose(dataRows, dataColumns, operand.Data(), operand.GetLeadingDimension(), converted.back()._data.get(), MIN_OPERATIONS_PER_THREAD);
+            term.Operand = std::as_const(converted.back()).View();
+        }
+    }
+
+    // Without gaps between the lines of the result and of all operands, the whole matrix is one line.
+    bool contiguous = lines <= 1 || lineStride(strides) == lineLength;
+    for (const Linear& term : terms) {
+        contiguous = contiguous && (lines <= 1 || lineStride(term.Operand.GetStrides()) == lineLength);
+    }
+    const size_t sweptLines  = contiguous ? std::min<size_t>(lines, 1) : lines;
+    const size_t sweptLength = contiguous ? lines * lineLength : lineLength;
+
+    T* out = result.Data();
+    const size_t outStride = lineStride(strides);
+
+    std::vector<std::pair<const T*, size_t>> inputs;
+    inputs.reserve(terms.size());
+    for (const Linear& term : terms) {
+        inputs.emplace_back(term.Operand.Data(), lineStride(term.Operand.GetStrides()));
+    }
+
+    const T one = static_cast<T>(1);
+    const bool add      = terms.size() == 2 && terms[0].Scale == one && terms[1].Scale == one;
+    const bool subtract = terms.size() == 2 && terms[0].Scale == one && terms[1].Scale == static_cast<T>(static_cast<T>(0) - one);
+
+    // Sweep the result in chunks that stay in the L1 cache while all terms are accumulated,
+    // so that every operand and the result are streamed through memory only once.
+    const auto sweep = [&](size_t begin, size_t sliceEnd)
+    {
+        constexpr size_t CHUNK = 2048;
+
+        const auto& kernels = Simd::GetKernels<T>();
+
+        for (size_t position = begin; position < sliceEnd;)
+        {
+            const size_t line   = position / sweptLength;
+            const size_t start  = position % sweptLength;
+            const size_t length = std::min({ CHUNK, sweptLength - start, sliceEnd - position });
+            T* chunk = out + line * outStride + start;
+
+            if (add || subtract)
+            {
+                const T* lhs = inputs[0].first + line * inputs[0].second + start;
+                const T* rhs = inputs[1].first + line * inputs[1].second + start;
+                if (add) {
+                    kernels.Add(lhs, rhs, chunk, length);
+                } else {
+                    kernels.Subtract(lhs, rhs, chunk, length);
+                }
+            }
+            else
+            {
+                for (size_t t = 0; t < terms.size(); ++t)
+                {
+                    const T* in = inputs[t].first + line * inputs[t].second + start;
+                    if (t > 0) {
+                        kernels.Axpy(terms[t].Scale, in, chunk, length);
+                    } else if (in != chunk || terms[t].Scale != one) {
+                        kernels.Scale(terms[t].Scale, in, chunk, length);
+                    }
+                }
+            }
+
+            position += length;
+        }
+    };
+
+    ThreadPool::ParallelFor(sweptLines * sweptLength, MIN_OPERATIONS_PER_THREAD, sweep);
+}
+
+template<class T> void
+Matrix<T>::multiplyInto(MatrixView<const T> lhs, MatrixView<const T> rhs, T alpha, T beta, MatrixView<T> result)
+{ // static function
+    const size_t height = lhs.GetHeight();
+    const size_t width  = rhs.GetWidth();
+    const size_t depth  = rhs.GetHeight();
+
+    // Resolve the orderings once, the kernels access the data through strides.
+    const T* a = lhs.Data();
+    const T* b = rhs.Data();
+    T* c = result.Data();
+    const Gemm::Strides as = lhs.GetStrides();
+    const Gemm::Strides bs = rhs.GetStrides();
+    const Gemm::Strides cs = result.GetStrides();
+
+    // Products with a vector are bound by the memory bandwidth, not by the multiply-adds, and
+    // skip the packing of the general kernel. A vector times a matrix is the transposed matrix
+    // times the vector.
+    if (height > 0 && width > 0 && depth > 0)
+    {
+        if (width == 1 && bs.Row == 1 && cs.Row == 1 &&
+            multiplyVector(height, depth, alpha, a, as, b, beta, c, MIN_OPERATIONS_PER_THREAD)) {
+            return;
+        }
+        if (height == 1 && as.Col == 1 && cs.Col == 1 &&
+            multiplyVector(width, depth, alpha, b, Gemm::Strides{ bs.Col, bs.Row }, a, beta, c, MIN_OPERATIONS_PER_THREAD)) {
+            return;
+        }
+        if (depth == 1 &&
+            multiplyOuter(height, width, alpha, a, as.Row, b, bs.Col, beta, c, cs, MIN_OPERATIONS_PER_THREAD)) {
+            return;
+        }
+    }
+
+    // One tile per thread, sized by the number of multiply-adds rather than by the rows of C.
+    const size_t threads = ThreadPool::IsStarted() && !ThreadPool::IsWorkerThread() ? ThreadPool::GetThreadsCount() + 1 : 1;
+    const Gemm::Partition grid = Gemm::PlanPartition(height, width, depth, threads, MIN_OPERATIONS_PER_THREAD);
+
+    if (grid.Tiles() <= 1) {
+        Gemm::Multiply<T>(height, width, depth, alpha, a, as, b, bs, beta, c, cs);
+        return;
+    }
+
+    // The first range of the inner dimension accumulates into C, the others into row major
+    // partial products that are added to C afterwards, in a fixed order.
+    const size_t partialLength = height * width;
+    const Memory::Buffer<T> partials = uninitialized((grid.Depth - 1) * partialLength);
+
+    const auto computeTiles = [&](size_t begin, size_t end)
+    {
+        constexpr size_t GRAIN = 8;
+        for (size_t t = begin; t < end; ++t)
+        {
+            const size_t i = t / (grid.Columns * grid.Depth);
+            const size_t j = t / grid.Depth % grid.Columns;
+            const size_t p = t % grid.Depth;
+
+            const size_t row    = Gemm::Partition::Bound(height, grid.Rows, i, GRAIN);
+            const size_t endRow = Gemm::Partition::Bound(height, grid.Rows, i + 1, GRAIN);
+            const size_t col    = Gemm::Partition::Bound(width, grid.Columns, j, GRAIN);
+            const size_t endCol = Gemm::Partition::Bound(width, grid.Columns, j + 1, GRAIN);
+            const size_t inner    = Gemm::Partition::Bound(depth, grid.Depth, p, Gemm::BlockSizes<T>::KC);
+            const size_t endInner = Gemm::Partition::Bound(depth, grid.Depth, p + 1, Gemm::BlockSizes<T>::KC);
+
+            T* out = c + row * cs.Row + col * cs.Col;
+            Gemm::Strides outStrides = cs;
+            if (p > 0) {
+                out = partials.get() + (p - 1) * partialLength + row * width + col;
+                outStrides = { width, 1 };
+            }
+
+            Gemm::Multiply<T>(
+                endRow - row, endCol - col, endInner - inner,
+                alpha,
+                a + row * as.Row + inner * as.Col, as,
+                b + inner * bs.Row + col * bs.Col, bs,
+                p > 0 ? static_cast<T>(0) : beta,
+                out, outStrides
+            );
+        }
+    };
+
+    ThreadPool::ParallelFor(grid.Tiles(), 1, computeTiles);
+
+    if (grid.Depth > 1)
+    {
+        const size_t minRows = std::max<size_t>(MIN_OPERATIONS_PER_THREAD / std::max<size_t>(width * (grid.Depth - 1), 1), 1);
+        ThreadPool::ParallelFor(height, minRows, [&](size_t row, size_t endRow)
+        {
+            for (size_t p = 0; p + 1 < grid.Depth; ++p)
+            {
+                const T* partial = partials.get() + p * partialLength;
+                for (size_t i = row; i < endRow; ++i) {
+                    for (size_t j = 0; j < width; ++j) {
+                        c[i * cs.Row + j * cs.Col] += partial[i * width + j];
+                    }
+                }
+            }
+        });
+    }
+}
+
 
 /****************************************
  * Friend functions
@@ -518,8 +1144,12 @@ template class Matrix<int>;
 template class Matrix<size_t>;
 template class Matrix<float>;
 template class Matrix<double>;
+template class Matrix<BFloat16>;
+template class Matrix<Float16>;
 
 template typename std::ostream& operator<<(std::ostream& out, const Matrix<int>& mat);
 template typename std::ostream& operator<<(std::ostream& out, const Matrix<size_t>& mat);
 template typename std::ostream& operator<<(std::ostream& out, const Matrix<float>& mat);
 template typename std::ostream& operator<<(std::ostream& out, const Matrix<double>& mat);
+template typename std::ostream& operator<<(std::ostream& out, const Matrix<BFloat16>& mat);
+template typename std::ostream& operator<<(std::ostream& out, const Matrix<Float16>& mat);
@@ -0,0 +1,362 @@
+#include "MatrixChain.hpp"
+#include "Float16.hpp"
+#include "Gemm.hpp"
+#include "Memory.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <future>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+
+namespace
+{
+    /// @brief The best splits of all subchains [i, j] of a chain for one amount of threads.
+    struct ChainTable
+    {
+        explicit ChainTable(size_t n)
+            : Size(n), Time(n * n, 0.0), Peak(n * n, 0), Split(n * n, 0), Concurrent(n * n, false)
+        {
+        }
+
+        size_t Index(size_t i, size_t j) const { return i * Size + j; }
+
+        size_t              Size;
+        std::vector<double> Time;       // estimated time of the subchain
+        std::vector<size_t> Peak;       // most elements alive while computing the subchain
+        std::vector<size_t> Split;      // the subchain is [i, Split] * [Split + 1, j]
+        std::vector<bool>   Concurrent; // the two subchains are computed at the same time
+    };
+
+    /// @brief Returns the time of a product of the given multiply-adds on up to threads threads,
+    ///        split like the products of Matrix into slices of at least MIN_OPERATIONS_PER_THREAD.
+    double
+    productTime(double operations, size_t threads)
+    {
+        const double slices = std::floor(operations / static_cast<double>(Matrix<double>::MIN_OPERATIONS_PER_THREAD));
+        return operations / std::clamp(slices, 1.0, static_cast<double>(threads));
+    }
+
+    /// @brief Returns true if a split of the given time and peak is better than the best one so
+    ///        far: the fastest of the splits that fit into maxElements, or the smallest if none fits.
+    bool
+    isBetter(double time, size_t peak, double bestTime, size_t bestPeak, size_t maxElements)
+    {
+        const bool fits     = maxElements == 0 || peak <= maxElements;
+        const bool bestFits = maxElements == 0 || bestPeak <= maxElements;
+
+        if (fits != bestFits) {
+            return fits;
+        }
+        if (fits) {
+            return time < bestTime || (time == bestTime && peak < bestPeak);
+        }
+        return peak < bestPeak || (peak == bestPeak && time < bestTime);
+    }
+
+    /// @brief Fills the table by dynamic programming over the lengths of the subchains. The two
+    ///        subchains of a split are computed one after the other on all threads, or at the same
+    ///        time by one thread each with the splits of the serial table, if it is given.
+    ChainTable
+    fillTable(const std::vector<size_t>& dims, size_t threads, size_t maxElements, const ChainTable* serial)
+    {
+        const size_t n = dims.size() - 1;
+        ChainTable table(n);
+
+        // The elements of the result of a subchain, the operands themselves are not counted.
+        const auto elements = [&dims](size_t i, size_t j) {
+            return i == j ? size_t(0) : dims[i] * dims[j + 1];
+        };
+
+        for (size_t length = 2; length <= n; ++length)
+        {
+            for (size_t i = 0; i + length <= n; ++i)
+            {
+                const size_t j   = i + length - 1;
+                const size_t idx = table.Index(i, j);
+                const size_t own = elements(i, j);
+
+                bool first = true;
+                for (size_t k = i; k < j; ++k)
+                {
+                    const size_t lhs = table.Index(i, k);
+                    const size_t rhs = table.Index(k + 1, j);
+                    const size_t operands = elements(i, k) + elements(k + 1, j);
+
+                    const double operations = static_cast<double>(dims[i]) * static_cast<double>(dims[k + 1]) * static_cast<double>(dims[j + 1]);
+                    const double product    = productTime(operations, threads);
+
+                    // One after the other: the left result is kept while the right one is computed.
+                    const double time = table.Time[lhs] + table.Time[rhs] + product;
+                    const size_t peak = std::max({ table.Peak[lhs], elements(i, k) + table.Peak[rhs], operands + own });
+
+                    if (first || isBetter(time, peak, table.Time[idx], table.Peak[idx], maxElements))
+                    {
+                        table.Time[idx]       = time;
+                        table.Peak[idx]       = peak;
+                        table.Split[idx]      = k;
+                        table.Concurrent[idx] = false;
+                        first = false;
+                    }
+
+                    // At the same time, only worth it if both sides are products.
+                    if (serial != nullptr && threads > 1 && k > i && k + 1 < j)
+                    {
+                        const double concurrentTime = std::max(serial->Time[lhs], serial->Time[rhs]) + product;
+                        const size_t concurrentPeak = std::max(serial->Peak[lhs] + serial->Peak[rhs], operands + own);
+
+                        if (isBetter(concurrentTime, concurrentPeak, table.Time[idx], table.Peak[idx], maxElements))
+                        {
+                            table.Time[idx]       = concurrentTime;
+                            table.Peak[idx]       = concurrentPeak;
+                            table.Split[idx]      = k;
+                            table.Concurrent[idx] = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        return table;
+    }
+
+    /// @brief Appends the products of the subchain [i, j] to the plan in post-order and returns
+    ///        the node of its result. The subchains of concurrent products use the serial table.
+    size_t
+    appendProducts(MatrixChain::Plan& plan, const ChainTable& table, const ChainTable& serial, size_t i, size_t j)
+    {
+        if (i == j) {
+            return i;
+        }
+
+        const size_t idx        = table.Index(i, j);
+        const size_t k          = table.Split[idx];
+        const bool   concurrent = table.Concurrent[idx];
+        const ChainTable& sides = concurrent ? serial : table;
+
+        MatrixChain::Product product;
+        product.Left       = appendProducts(plan, sides, serial, i, k);
+        product.Right      = appendProducts(plan, sides, serial, k + 1, j);
+        product.Height     = plan.Dimensions[i];
+        product.Width      = plan.Dimensions[j + 1];
+        product.Depth      = plan.Dimensions[k + 1];
+        product.Concurrent = concurrent;
+
+        plan.Operations += static_cast<double>(product.Height) * static_cast<double>(product.Width) * static_cast<double>(product.Depth);
+        plan.Products.push_back(product);
+
+        return plan.Dimensions.size() - 1 + plan.Products.size() - 1;
+    }
+
+    /// @brief Computes the products of a plan, releasing every intermediate once it was used.
+    template<typename T>
+    class ChainEvaluation
+    {
+    public:
+        ChainEvaluation(const MatrixChain::Plan& plan, const std::vector<const Matrix<T>*>& operands)
+            : _plan(plan), _operands(operands), _results(plan.Products.size())
+        {
+        }
+
+        Matrix<T> Evaluate()
+        {
+            evaluate(_plan.Products.size() - 1, false);
+            return std::move(*_results.back());
+        }
+
+    private:
+        const Matrix<T>& node(size_t id) const
+        {
+            return id < _operands.size() ? *_operands[id] : *_results[id - _operands.size()];
+        }
+
+        void evaluateNode(size_t id, bool serial)
+        {
+            if (id >= _operands.size()) {
+                evaluate(id - _operands.size(), serial);
+            }
+        }
+
+        void release(size_t id)
+        {
+            if (id >= _operands.size()) {
+                _results[id - _operands.size()].reset();
+            }
+        }
+
+        /// @brief Computes product p and its subchains. Serial products run on the calling
+        ///        thread only, the others with the parallel products of Matrix.
+        void evaluate(size_t p, bool serial)
+        {
+            const MatrixChain::Product& product = _plan.Products[p];
+
+            if (product.Concurrent && !serial && ThreadPool::IsStarted() && !ThreadPool::IsWorkerThread())
+            {
+                std::future<void> right = ThreadPool::QueueTask([this, &product] { evaluateNode(product.Right, true); });
+
+                // The task references this, it must complete before returning, even on errors.
+                std::exception_ptr error;
+                try {
+                    evaluateNode(product.Left, true);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                try {
+                    right.get();
+                } catch (...) {
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+            else
+            {
+                evaluateNode(product.Left, serial);
+                evaluateNode(product.Right, serial);
+            }
+
+            const Matrix<T>& lhs = node(product.Left);
+            const Matrix<T>& rhs = node(product.Right);
+
+            if (serial && product.Depth == 0)
+            {
+                // The product of empty inner dimensions is all zeros.
+                _results[p].emplace(product.Height, product.Width);
+            }
+            else if (serial)
+            {
+                // Gemm::Multiply overwrites every element, the result is not zeroed first.
+                Matrix<T> result(product.Height, product.Width, Memory::Allocate<T>(product.Height * product.Width));
+                if (product.Height > 0 && product.Width > 0)
+                {
+                    const MatrixView<const T> a = lhs.View();
+                    const MatrixView<const T> b = rhs.View();
+                    const MatrixView<T>       c = result.View();
+                    Gemm::Multiply<T>(
+                        product.Height, product.Width, product.Depth,
+                        a.Data(), a.GetStrides(),
+                        b.Data(), b.GetStrides(),
+                        c.Data(), c.GetStrides()
+                    );
+                }
+                _results[p].emplace(std::move(result));
+            }
+            else
+            {
+                _results[p].emplace(lhs.Multiply(rhs, Matrix<T>::Ordering::RowMajor));
+            }
+
+            release(product.Left);
+            release(product.Right);
+        }
+
+    private:
+        const MatrixChain::Plan&              _plan;
+        const std::vector<const Matrix<T>*>&  _operands;
+        std::vector<std::optional<Matrix<T>>> _results;
+    };
+
+} // end anonymous namespace
+
+
+/****************************************
+ * Planning
+ ****************************************/
+std::string
+MatrixChain::Plan::ToString() const
+{
+    const size_t n = Dimensions.size() - 1;
+
+    std::vector<std::string> nodes;
+    for (size_t i = 0; i < n; ++i) {
+        nodes.push_back("A" + std::to_string(i));
+    }
+    for (const Product& product : Products) {
+        nodes.push_back("(" + nodes[product.Left] + (product.Concurrent ? "|" : " ") + nodes[product.Right] + ")");
+    }
+
+    return nodes.back();
+}
+
+MatrixChain::Plan
+MatrixChain::MakePlan(const std::vector<size_t>& dimensions, size_t threads, size_t maxElements)
+{
+    if (dimensions.size() < 2) {
+        throw std::invalid_argument("A chain of matrices needs at least two dimensions, got " +
+                                    std::to_string(dimensions.size()) + ".");
+    }
+    if (threads == 0) {
+        throw std::invalid_argument("Planning a chain of matrices needs at least one thread.");
+    }
+
+    const size_t n = dimensions.size() - 1;
+
+    const ChainTable serial = fillTable(dimensions, 1, maxElements, nullptr);
+    const ChainTable table  = threads > 1 ? fillTable(dimensions, threads, maxElements, &serial) : serial;
+
+    Plan plan;
+    plan.Dimensions   = dimensions;
+    plan.Operations   = 0.0;
+    plan.Time         = table.Time[table.Index(0, n - 1)];
+    plan.PeakElements = table.Peak[table.Index(0, n - 1)];
+
+    plan.Products.reserve(n - 1);
+    appendProducts(plan, table, serial, 0, n - 1);
+
+    return plan;
+}
+
+
+/****************************************
+ * Multiplication
+ ****************************************/
+template<class T> Matrix<T>
+MatrixChain::Multiply(const std::vector<const Matrix<T>*>& matrices, size_t memoryBudget)
+{
+    if (matrices.empty()) {
+        throw std::invalid_argument("A chain of matrices needs at least one matrix.");
+    }
+
+    std::vector<size_t> dimensions;
+    for (size_t i = 0; i < matrices.size(); ++i)
+    {
+        if (matrices[i] == nullptr) {
+            throw std::invalid_argument("Matrix " + std::to_string(i) + " of the chain is null.");
+        }
+        if (i > 0 && matrices[i]->GetHeight() != matrices[i - 1]->GetWidth()) {
+            throw std::invalid_argument("Mismatching matrix dimensions for multiplication, matrix " + std::to_string(i) +
+                                        " of the chain has " + std::to_string(matrices[i]->GetHeight()) +
+                                        " rows instead of " + std::to_string(matrices[i - 1]->GetWidth()) + ".");
+        }
+        dimensions.push_back(matrices[i]->GetHeight());
+    }
+    dimensions.push_back(matrices.back()->GetWidth());
+
+    if (matrices.size() == 1) {
+        return matrices.front()->ToOrdering(Matrix<T>::Ordering::RowMajor);
+    }
+
+    const size_t threads = ThreadPool::IsStarted() && !ThreadPool::IsWorkerThread() ? ThreadPool::GetThreadsCount() + 1 : 1;
+    const size_t maxElements = memoryBudget > 0 ? std::max<size_t>(memoryBudget / sizeof(T), 1) : 0;
+    const Plan plan = MakePlan(dimensions, threads, maxElements);
+
+    return ChainEvaluation<T>(plan, matrices).Evaluate();
+}
+
+
+template Matrix<int> MatrixChain::Multiply(const std::vector<const Matrix<int>*>&, size_t);
+template Matrix<size_t> MatrixChain::Multiply(const std::vector<const Matrix<size_t>*>&, size_t);
+template Matrix<float> MatrixChain::Multiply(const std::vector<const Matrix<float>*>&, size_t);
+template Matrix<double> MatrixChain::Multiply(const std::vector<const Matrix<double>*>&, size_t);
+template Matrix<BFloat16> MatrixChain::Multiply(const std::vector<const Matrix<BFloat16>*>&, size_t);
+template Matrix<Float16> MatrixChain::Multiply(const std::vector<const Matrix<Float16>*>&, size_t);
@@ -0,0 +1,487 @@
+#include "Memory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+#endif
+
+
+namespace
+{
+    std::atomic<Memory::Allocator*> s_allocator { nullptr };
+
+    // Guards the registration of the thread caches of the pools, see PoolAllocator::ThreadCaches.
+    std::mutex s_threadCacheMutex;
+
+    // Set when the thread caches of the thread are destroyed, later releases go to the shards.
+    thread_local bool s_threadExiting = false;
+
+    size_t roundUp(size_t value, size_t multiple)
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+} // end anonymous namespace
+
+
+/****************************************
+ * AlignedAllocator implementation
+ ****************************************/
+Memory::AlignedAllocator::AlignedAllocator(size_t hugePageThreshold)
+    : _hugePageThreshold(hugePageThreshold)
+{
+    //
+}
+
+void*
+Memory::AlignedAllocator::Allocate(size_t bytes)
+{
+    if (bytes == 0) {
+        return nullptr;
+    }
+
+    const bool   huge      = bytes >= _hugePageThreshold;
+    const size_t alignment = huge ? HUGE_PAGE_SIZE : ALIGNMENT;
+    const size_t size      = roundUp(bytes, alignment); // aligned_alloc requires a multiple of the alignment
+
+    if (size < bytes) {
+        throw std::bad_alloc();
+    }
+
+    void* ptr = std::aligned_alloc(alignment, size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (huge) {
+        // Only advisory, fails harmlessly if transparent huge pages are disabled.
+        madvise(ptr, size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return ptr;
+}
+
+void
+Memory::AlignedAllocator::Deallocate(void* ptr, [[maybe_unused]] size_t bytes) noexcept
+{
+    std::free(ptr);
+}
+
+
+/****************************************
+ * PoolAllocator implementation
+ ****************************************/
+struct Memory::PoolAllocator::ThreadCache
+{
+    // Set to nullptr under s_threadCacheMutex when the pool is destroyed before the thread exits.
+    std::atomic<PoolAllocator*> Pool { nullptr };
+
+    std::array<size_t, CLASS_COUNT> Counts {};
+    std::array<std::array<void*, CACHE_BLOCKS>, CLASS_COUNT> Blocks;
+};
+
+class Memory::PoolAllocator::ThreadCaches
+{
+public:
+    ThreadCaches() = default;
+
+    ThreadCaches(const ThreadCaches& other) = delete;
+    ThreadCaches& operator=(const ThreadCaches& other) = delete;
+
+    /// @brief Moves the cached blocks to the shards of their pools when the thread exits.
+    ~ThreadCaches()
+    {
+        s_threadExiting = true;
+
+        std::lock_guard<std::mutex> lock(s_threadCacheMutex);
+        for (const std::unique_ptr<ThreadCache>& cache : _caches)
+        {
+            PoolAllocator* pool = cache->Pool.load(std::memory_order_relaxed);
+            if (pool != nullptr)
+            {
+                pool->flush(*cache, false);
+                std::vector<ThreadCache*>& registered = pool->_threadCaches;
+                registered.erase(std::find(registered.begin(), registered.end(), cache.get()));
+            }
+        }
+    }
+
+    ThreadCache* Find(const PoolAllocator& pool) const
+    {
+        for (const std::unique_ptr<ThreadCache>& cache : _caches) {
+            if (cache->Pool.load(std::memory_order_acquire) == &pool) {
+                return cache.get();
+            }
+        }
+        return nullptr;
+    }
+
+    /// @brief Returns the cache for the pool, and creates it on the first use of the pool.
+    /// @throws std::bad_alloc if the cache can not be created.
+    ThreadCache& Get(PoolAllocator& pool)
+    {
+        if (ThreadCache* cache = Find(pool)) {
+            return *cache;
+        }
+
+        // The caches of destroyed pools were emptied by their destructors.
+        _caches.erase(std::remove_if(_caches.begin(), _caches.end(), [](const std::unique_ptr<ThreadCache>& cache) {
+            return cache->Pool.load(std::memory_order_acquire) == nullptr;
+        }), _caches.end());
+
+        std::unique_ptr<ThreadCache> cache = std::make_unique<ThreadCache>();
+        cache->Pool.store(&pool, std::memory_order_relaxed);
+        _caches.reserve(_caches.size() + 1);
+        {
+            std::lock_guard<std::mutex> lock(s_threadCacheMutex);
+            pool._threadCaches.push_back(cache.get());
+        }
+        _caches.push_back(std::move(cache));
+        return *_caches.back();
+    }
+
+private:
+    std::vector<std::unique_ptr<ThreadCache>> _caches;
+};
+
+Memory::PoolAllocator::PoolAllocator(size_t maxRetainedBytes, Allocator* upstream)
+    : _upstream(upstream != nullptr ? *upstream : DefaultAllocator())
+    , _maxRetainedBytes(maxRetainedBytes)
+    , _shards(std::make_unique<Shard[]>(SHARD_COUNT))
+    , _shardBlocks(std::make_unique<std::atomic<size_t>[]>(CLASS_COUNT))
+{
+    //
+}
+
+Memory::PoolAllocator::~PoolAllocator()
+{
+    {
+        std::lock_guard<std::mutex> lock(s_threadCacheMutex);
+        for (ThreadCache* cache : _threadCaches)
+        {
+            flush(*cache, true);
+            cache->Pool.store(nullptr, std::memory_order_release);
+        }
+        _threadCaches.clear();
+    }
+
+    Trim();
+}
+
+void*
+Memory::PoolAllocator::Allocate(size_t bytes)
+{
+    if (bytes == 0) {
+        return nullptr;
+    }
+
+    size_t blockSize;
+    const size_t idx = sizeClass(bytes, blockSize);
+
+    void* block = nullptr;
+    ThreadCache* cache = threadCache();
+    if (cache != nullptr && cache->Counts[idx] > 0) {
+        block = cache->Blocks[idx][--cache->Counts[idx]];
+    } else {
+        block = takeBlock(idx);
+    }
+
+    if (block != nullptr)
+    {
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        _retainedBytes.fetch_sub(blockSize, std::memory_order_relaxed);
+        _retainedBlocks.fetch_sub(1, std::memory_order_relaxed);
+        return block;
+    }
+
+    _misses.fetch_add(1, std::memory_order_relaxed);
+    return _upstream.Allocate(blockSize);
+}
+
+void
+Memory::PoolAllocator::Deallocate(void* ptr, size_t bytes) noexcept
+{
+    if (ptr == nullptr) {
+        return;
+    }
+
+    size_t blockSize;
+    const size_t idx = sizeClass(bytes, blockSize);
+
+    if (_retainedBytes.fetch_add(blockSize, std::memory_order_relaxed) + blockSize > _maxRetainedBytes)
+    {
+        _retainedBytes.fetch_sub(blockSize, std::memory_order_relaxed);
+        _upstream.Deallocate(ptr, blockSize);
+        return;
+    }
+    _retainedBlocks.fetch_add(1, std::memory_order_relaxed);
+
+    if (ThreadCache* cache = threadCache())
+    {
+        // The oldest half of a full cache is moved to the shards, the newest blocks stay.
+        if (cache->Counts[idx] == CACHE_BLOCKS) {
+            spill(*cache, idx, CACHE_BLOCKS / 2);
+        }
+        if (cache->Counts[idx] < CACHE_BLOCKS)
+        {
+            cache->Blocks[idx][cache->Counts[idx]++] = ptr;
+            return;
+        }
+    }
+
+    Shard& shard = _shards[shardIndex()];
+    try
+    {
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        shard.FreeLists[idx].push_back(ptr);
+        _shardBlocks[idx].fetch_add(1, std::memory_order_relaxed);
+    }
+    catch (...)
+    {
+        // The free list could not grow, release the block instead.
+        release(ptr, blockSize);
+    }
+}
+
+void
+Memory::PoolAllocator::Trim()
+{
+    if (ThreadCaches* caches = threadCaches()) {
+        if (ThreadCache* cache = caches->Find(*this)) {
+            flush(*cache, true);
+        }
+    }
+
+    for (size_t s = 0; s < SHARD_COUNT; ++s)
+    {
+        std::lock_guard<std::mutex> lock(_shards[s].Mutex);
+        for (size_t idx = 0; idx < CLASS_COUNT; ++idx)
+        {
+            std::vector<void*>& freeList = _shards[s].FreeLists[idx];
+            if (freeList.empty()) {
+                continue;
+            }
+
+            const size_t blockSize = classBlockSize(idx);
+            for (void* block : freeList) {
+                _upstream.Deallocate(block, blockSize);
+            }
+            _retainedBytes.fetch_sub(blockSize * freeList.size(), std::memory_order_relaxed);
+            _retainedBlocks.fetch_sub(freeList.size(), std::memory_order_relaxed);
+            _shardBlocks[idx].fetch_sub(freeList.size(), std::memory_order_relaxed);
+            freeList.clear();
+            freeList.shrink_to_fit();
+        }
+    }
+}
+
+Memory::PoolAllocator::Stats
+Memory::PoolAllocator::GetStats() const
+{
+    return {
+        _hits.load(std::memory_order_relaxed),
+        _misses.load(std::memory_order_relaxed),
+        _retainedBytes.load(std::memory_order_relaxed),
+        _retainedBlocks.load(std::memory_order_relaxed)
+    };
+}
+
+double
+Memory::PoolAllocator::Stats::HitRate() const
+{
+    const size_t total = Hits + Misses;
+    return total > 0 ? static_cast<double>(Hits) / static_cast<double>(total) : 0.0;
+}
+
+size_t
+Memory::PoolAllocator::sizeClass(size_t bytes, size_t& blockSize)
+{ // static function
+    if (bytes <= MIN_BLOCK_SIZE) {
+        blockSize = MIN_BLOCK_SIZE;
+        return 0;
+    }
+    if (bytes > std::numeric_limits<size_t>::max() / 2) {
+        // The block sizes of the top power of two overflow.
+        throw std::bad_alloc();
+    }
+
+    // 2^power < bytes <= 2^(power+1), split into CLASSES_PER_POWER classes of equal steps.
+    const size_t power = static_cast<size_t>(63 - __builtin_clzll(bytes - 1));
+    const size_t base  = static_cast<size_t>(1) << power;
+    const size_t step  = base / CLASSES_PER_POWER;
+    const size_t i     = (bytes - base + step - 1) / step; // in [1, CLASSES_PER_POWER]
+
+    const size_t idx = 1 + (power - 6) * CLASSES_PER_POWER + (i - 1);
+    blockSize = classBlockSize(idx);
+    return idx;
+}
+
+size_t
+Memory::PoolAllocator::classBlockSize(size_t idx)
+{ // static function
+    if (idx == 0) {
+        return MIN_BLOCK_SIZE;
+    }
+
+    const size_t power = (idx - 1) / CLASSES_PER_POWER + 6;
+    const size_t base  = static_cast<size_t>(1) << power;
+    return base + ((idx - 1) % CLASSES_PER_POWER + 1) * (base / CLASSES_PER_POWER);
+}
+
+size_t
+Memory::PoolAllocator::shardIndex()
+{ // static function
+    static std::atomic<size_t> s_nextThread { 0 };
+    thread_local const size_t index = s_nextThread.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+    return index;
+}
+
+Memory::PoolAllocator::ThreadCaches*
+Memory::PoolAllocator::threadCaches()
+{ // static function
+    if (s_threadExiting) {
+        return nullptr;
+    }
+
+    thread_local ThreadCaches caches;
+    return &caches;
+}
+
+Memory::PoolAllocator::ThreadCache*
+Memory::PoolAllocator::threadCache() noexcept
+{
+    ThreadCaches* caches = threadCaches();
+    if (caches == nullptr) {
+        return nullptr;
+    }
+
+    try {
+        return &caches->Get(*this);
+    } catch (...) {
+        // Without a cache the shards are used directly.
+        return nullptr;
+    }
+}
+
+void*
+Memory::PoolAllocator::takeBlock(size_t sizeClass)
+{
+    if (_shardBlocks[sizeClass].load(std::memory_order_relaxed) == 0) {
+        // Nothing to take from any shard, the lock of none of them is needed.
+        return nullptr;
+    }
+
+    const size_t own = shardIndex();
+
+    for (size_t s = 0; s < SHARD_COUNT; ++s)
+    {
+        Shard& shard = _shards[(own + s) % SHARD_COUNT];
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        std::vector<void*>& freeList = shard.FreeLists[sizeClass];
+        if (!freeList.empty())
+        {
+            void* block = freeList.back();
+            freeList.pop_back();
+            _shardBlocks[sizeClass].fetch_sub(1, std::memory_order_relaxed);
+            return block;
+        }
+    }
+
+    return nullptr;
+}
+
+bool
+Memory::PoolAllocator::spill(ThreadCache& cache, size_t sizeClass, size_t count) noexcept
+{
+    void** blocks = cache.Blocks[sizeClass].data();
+    Shard& shard = _shards[shardIndex()];
+    try
+    {
+        std::lock_guard<std::mutex> lock(shard.Mutex);
+        shard.FreeLists[sizeClass].insert(shard.FreeLists[sizeClass].end(), blocks, blocks + count);
+        _shardBlocks[sizeClass].fetch_add(count, std::memory_order_relaxed);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    std::copy(blocks + count, blocks + cache.Counts[sizeClass], blocks);
+    cache.Counts[sizeClass] -= count;
+    return true;
+}
+
+void
+Memory::PoolAllocator::flush(ThreadCache& cache, bool toUpstream) noexcept
+{
+    for (size_t idx = 0; idx < CLASS_COUNT; ++idx)
+    {
+        const size_t count = cache.Counts[idx];
+        if (count == 0 || (!toUpstream && spill(cache, idx, count))) {
+            continue;
+        }
+
+        const size_t blockSize = classBlockSize(idx);
+        for (size_t i = 0; i < count; ++i) {
+            release(cache.Blocks[idx][i], blockSize);
+        }
+        cache.Counts[idx] = 0;
+    }
+}
+
+void
+Memory::PoolAllocator::release(void* block, size_t blockSize) noexcept
+{
+    _upstream.Deallocate(block, blockSize);
+    _retainedBytes.fetch_sub(blockSize, std::memory_order_relaxed);
+    _retainedBlocks.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+/****************************************
+ * AllocatorScope implementation
+ ****************************************/
+Memory::AllocatorScope::AllocatorScope(Allocator& allocator)
+    : _previous(SetAllocator(&allocator))
+{
+    //
+}
+
+Memory::AllocatorScope::~AllocatorScope()
+{
+    SetAllocator(_previous);
+}
+
+
+/****************************************
+ * Allocator selection
+ ****************************************/
+Memory::Allocator&
+Memory::DefaultAllocator()
+{
+    // Never destroyed, since buffers of matrices with static storage duration may be
+    // released after the function local statics are destroyed.
+    static AlignedAllocator* const allocator = new AlignedAllocator();
+    return *allocator;
+}
+
+Memory::Allocator&
+Memory::GetAllocator()
+{
+    Allocator* allocator = s_allocator.load(std::memory_order_acquire);
+    return allocator != nullptr ? *allocator : DefaultAllocator();
+}
+
+Memory::Allocator*
+Memory::SetAllocator(Allocator* allocator)
+{
+    Allocator* previous = s_allocator.exchange(allocator, std::memory_order_acq_rel);
+    return previous != nullptr ? previous : &DefaultAllocator();
+}
@@ -0,0 +1,361 @@
+#include "QuantizedMatrix.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+namespace
+{
+    /// @brief Rounds the value to nearest even and saturates it to the range of U.
+    template<typename U> U
+    saturate(float value)
+    {
+        constexpr float LOWEST = static_cast<float>(std::numeric_limits<U>::lowest());
+        constexpr float MAX    = static_cast<float>(std::numeric_limits<U>::max());
+        return static_cast<U>(std::clamp(std::nearbyint(value), LOWEST, MAX));
+    }
+
+    template<typename U> bool
+    isValid(float scale, int32_t zeroPoint)
+    {
+        return std::isfinite(scale) && scale > 0.0f &&
+               zeroPoint >= std::numeric_limits<U>::lowest() && zeroPoint <= std::numeric_limits<U>::max();
+    }
+
+} // end anonymous namespace
+
+
+/****************************************
+ * Constructors
+ ****************************************/
+template<class T>
+QuantizedMatrix<T>::QuantizedMatrix(size_t rows, size_t columns, std::vector<T> values, std::vector<Parameters> parameters, Axis axis)
+    : _rows(rows)
+    , _columns(columns)
+    , _axis(axis)
+    , _values(std::move(values))
+    , _parameters(std::move(parameters))
+{
+    validate();
+}
+
+template<class T> QuantizedMatrix<T>
+QuantizedMatrix<T>::Quantize(const Matrix<float>& values, Axis axis)
+{ // static function
+    const size_t rows    = values.GetHeight();
+    const size_t columns = values.GetWidth();
+    const MatrixView<const float> view = values.View();
+    const Gemm::Strides strides = view.GetStrides();
+    const size_t lineStride    = axis == Axis::Rows ? strides.Row : strides.Col;
+    const size_t elementStride = axis == Axis::Rows ? strides.Col : strides.Row;
+    const size_t lines  = axis == Axis::Rows ? rows : columns;
+    const size_t length = axis == Axis::Rows ? columns : rows;
+    const size_t minLines = std::max<size_t>(Matrix<float>::MIN_OPERATIONS_PER_THREAD / std::max<size_t>(length, 1), 1);
+
+    std::vector<T> quantized(rows * columns);
+    std::vector<Parameters> parameters(lines);
+
+    ThreadPool::ParallelFor(lines, minLines, [&](size_t line, size_t endLine) {
+        for (; line < endLine; ++line)
+        {
+            const float* data = view.Data() + line * lineStride;
+
+            float lowest  = 0.0f;
+            float highest = 0.0f;
+            for (size_t i = 0; i < length; ++i) {
+                lowest  = std::min(lowest, data[i * elementStride]);
+                highest = std::max(highest, data[i * elementStride]);
+            }
+
+            Parameters& p = parameters[line];
+            if constexpr (std::is_signed<T>()) {
+                p.Scale = std::max(-lowest, highest) / 127.0f;
+                p.ZeroPoint = 0;
+            } else {
+                p.Scale = (highest - lowest) / 255.0f;
+            }
+            if (!(p.Scale > 0.0f)) { // A line of zeros
+                p.Scale = 1.0f;
+            }
+            if constexpr (std::is_unsigned<T>()) {
+                p.ZeroPoint = saturate<T>(-lowest / p.Scale);
+            }
+
+            const float inverse = 1.0f / p.Scale;
+            const float zeroPoint = static_cast<float>(p.ZeroPoint);
+            for (size_t i = 0; i < length; ++i)
+            {
+                const size_t index = axis == Axis::Rows ? line * columns + i : i * columns + line;
+                quantized[index] = saturate<T>(std::nearbyint(data[i * elementStride] * inverse) + zeroPoint);
+            }
+        }
+    });
+
+    return QuantizedMatrix(rows, columns, std::move(quantized), std::move(parameters), axis);
+}
+
+
+/****************************************
+ * Getters
+ ****************************************/
+template<class T> size_t
+QuantizedMatrix<T>::GetWidth() const
+{
+    return _columns;
+}
+
+template<class T> size_t
+QuantizedMatrix<T>::GetHeight() const
+{
+    return _rows;
+}
+
+template<class T> typename QuantizedMatrix<T>::Axis
+QuantizedMatrix<T>::GetAxis() const
+{
+    return _axis;
+}
+
+template<class T> const std::vector<T>&
+QuantizedMatrix<T>::GetValues() const
+{
+    return _values;
+}
+
+template<class T> const std::vector<typename QuantizedMatrix<T>::Parameters>&
+QuantizedMatrix<T>::GetParameters() const
+{
+    return _parameters;
+}
+
+template<class T> T
+QuantizedMatrix<T>::At(size_t row, size_t col) const
+{
+    if (row >= _rows || col >= _columns) {
+        throw std::out_of_range("Element (" + std::to_string(row) + ", " + std::to_string(col) +
+                                ") is outside of the " + std::to_string(_rows) + "X" + std::to_string(_columns) + " matrix.");
+    }
+
+    return _values[row * _columns + col];
+}
+
+
+/****************************************
+ * Conversions
+ ****************************************/
+template<class T> Matrix<float>
+QuantizedMatrix<T>::Dequantize() const
+{
+    Memory::Buffer<float> data = Memory::Allocate<float>(_rows * _columns);
+
+    for (size_t i = 0; i < _rows; ++i) {
+        for (size_t j = 0; j < _columns; ++j)
+        {
+            const Parameters& p = _parameters[_axis == Axis::Rows ? i : j];
+            data[i * _columns + j] = p.Scale * static_cast<float>(_values[i * _columns + j] - p.ZeroPoint);
+        }
+    }
+
+    return Matrix<float>(_rows, _columns, std::move(data));
+}
+
+
+/****************************************
+ * Arithmetic
+ ****************************************/
+template<class T> Matrix<int>
+QuantizedMatrix<T>::MultiplyAccumulate(const QuantizedMatrix<int8_t>& rhs) const
+{
+    const size_t width = rhs.GetWidth();
+    Memory::Buffer<int> data = Memory::Allocate<int>(_rows * width);
+
+    forProductRows(rhs, [&data, width](const int32_t* accumulators, size_t row, size_t endRow) {
+        std::copy(accumulators, accumulators + (endRow - row) * width, data.get() + row * width);
+    });
+
+    return Matrix<int>(_rows, width, std::move(data));
+}
+
+template<class T> Matrix<float>
+QuantizedMatrix<T>::Multiply(const QuantizedMatrix<int8_t>& rhs) const
+{
+    const size_t width = rhs.GetWidth();
+    Memory::Buffer<float> data = Memory::Allocate<float>(_rows * width);
+
+    forProductRows(rhs, [&](const int32_t* accumulators, size_t row, size_t endRow) {
+        for (size_t i = row; i < endRow; ++i, accumulators += width)
+        {
+            const float rowScale = _parameters[i].Scale;
+            float* out = data.get() + i * width;
+            for (size_t j = 0; j < width; ++j) {
+                out[j] = rowScale * rhs._parameters[j].Scale * static_cast<float>(accumulators[j]);
+            }
+        }
+    });
+
+    return Matrix<float>(_rows, width, std::move(data));
+}
+
+template<class T> template<typename U> QuantizedMatrix<U>
+QuantizedMatrix<T>::MultiplyRequantized(const QuantizedMatrix<int8_t>& rhs, Parameters output) const
+{
+    if (!isValid<U>(output.Scale, output.ZeroPoint)) {
+        throw std::invalid_argument("The output scale must be positive and finite and the zero point a value of the output type.");
+    }
+
+    const size_t width = rhs.GetWidth();
+    std::vector<U> values(_rows * width);
+    const float zeroPoint = static_cast<float>(output.ZeroPoint);
+
+    forProductRows(rhs, [&](const int32_t* accumulators, size_t row, size_t endRow) {
+        for (size_t i = row; i < endRow; ++i, accumulators += width)
+        {
+            const float rowScale = _parameters[i].Scale / output.Scale;
+            U* out = values.data() + i * width;
+            for (size_t j = 0; j < width; ++j) {
+                out[j] = saturate<U>(std::nearbyint(rowScale * rhs._parameters[j].Scale * static_cast<float>(accumulators[j])) + zeroPoint);
+            }
+        }
+    });
+
+    return QuantizedMatrix<U>(_rows, width, std::move(values), std::vector<typename QuantizedMatrix<U>::Parameters>(_rows, { output.Scale, output.ZeroPoint }), QuantizedMatrix<U>::Axis::Rows);
+}
+
+template<class T> bool
+QuantizedMatrix<T>::Equals(const QuantizedMatrix& rhs) const
+{
+    const auto equalParameters = [](const Parameters& lhs, const Parameters& other) {
+        return lhs.Scale == other.Scale && lhs.ZeroPoint == other.ZeroPoint;
+    };
+
+    return _rows == rhs._rows && _columns == rhs._columns && _axis == rhs._axis && _values == rhs._values &&
+           std::equal(_parameters.begin(), _parameters.end(), rhs._parameters.begin(), rhs._parameters.end(), equalParameters);
+}
+
+
+/****************************************
+ * Private functions
+ ****************************************/
+template<class T> template<typename F> void
+QuantizedMatrix<T>::forProductRows(const QuantizedMatrix<int8_t>& rhs, const F& func) const
+{
+    if (_columns != rhs._rows) {
+        throw std::invalid_argument("Mismatching matrix dimensions for multiplication.");
+    }
+    if (_columns > MAX_DEPTH) {
+        throw std::invalid_argument("The inner dimension of a quantized product must be at most " + std::to_string(MAX_DEPTH) + ".");
+    }
+    if (_axis != Axis::Rows || rhs._axis != QuantizedMatrix<int8_t>::Axis::Columns) {
+        throw std::invalid_argument("The lhs of a quantized product must be quantized per row and the rhs per column.");
+    }
+
+    const size_t width = rhs._columns;
+    const size_t depth = _columns;
+
+    // The zero points expand the inner sums into
+    //     sum(a * b) - za * sum(b) - zb * sum(a) + depth * za * zb,
+    // of which only the first term depends on both operands.
+    std::vector<int32_t> columnSums(width, 0);
+    for (size_t p = 0; p < depth; ++p) {
+        for (size_t j = 0; j < width; ++j) {
+            columnSums[j] += rhs._values[p * width + j];
+        }
+    }
+
+    const size_t minRows = std::max<size_t>(Matrix<int>::MIN_OPERATIONS_PER_THREAD / std::max<size_t>(width * depth, 1), 1);
+
+    ThreadPool::ParallelFor(_rows, minRows, [&](size_t row, size_t endRow)
+    {
+        std::vector<int32_t> accumulators((endRow - row) * width);
+        Gemm::MultiplyQuantized<T>(
+            endRow - row, width, depth,
+            _values.data() + row * depth, { depth, 1 },
+            rhs._values.data(), { width, 1 },
+            accumulators.data(), { width, 1 }
+        );
+
+        // The terms are summed in 64 bit, only the inner sums themselves must fit into int32.
+        for (size_t i = row; i < endRow; ++i)
+        {
+            const int64_t za = _parameters[i].ZeroPoint;
+            int64_t rowSum = 0;
+            for (size_t p = 0; p < depth; ++p) {
+                rowSum += _values[i * depth + p];
+            }
+
+            int32_t* acc = accumulators.data() + (i - row) * width;
+            for (size_t j = 0; j < width; ++j)
+            {
+                const int64_t zb = rhs._parameters[j].ZeroPoint;
+                acc[j] = static_cast<int32_t>(acc[j] - za * columnSums[j] - zb * rowSum + static_cast<int64_t>(depth) * za * zb);
+            }
+        }
+
+        func(accumulators.data(), row, endRow);
+    });
+}
+
+template<class T> void
+QuantizedMatrix<T>::validate() const
+{
+    if (_values.size() != _rows * _columns) {
+        throw std::invalid_argument("A quantized matrix of " + std::to_string(_rows) + "X" + std::to_string(_columns) +
+                                    " elements cannot be initialized with " + std::to_string(_values.size()) + " values.");
+    }
+    if (_parameters.size() != (_axis == Axis::Rows ? _rows : _columns)) {
+        throw std::invalid_argument("A quantized matrix needs the parameters of every row or column of its axis.");
+    }
+
+    for (const Parameters& p : _parameters)
+    {
+        if (!isValid<T>(p.Scale, p.ZeroPoint)) {
+            throw std::invalid_argument("The scales of a quantized matrix must be positive and finite and the zero points values of its element type.");
+        }
+    }
+}
+
+
+/****************************************
+ * Friend functions
+ ****************************************/
+template<typename T>
+std::ostream& operator<<(std::ostream& out, const QuantizedMatrix<T>& mat)
+{
+    const bool rows = mat.GetAxis() == QuantizedMatrix<T>::Axis::Rows;
+
+    out << "| QuantizedMatrix of height X width: " << mat.GetHeight() << 'X' << mat.GetWidth()
+        << " quantized per " << (rows ? "row" : "column") << " |\n";
+
+    for (size_t i = 0; i < mat.GetHeight(); ++i)
+    {
+        out << '|';
+        for (size_t j = 0; j < mat.GetWidth(); ++j) {
+            out << ' ' << static_cast<int>(mat.At(i, j));
+        }
+        out << " |\n";
+    }
+
+    for (size_t line = 0; line < mat._parameters.size(); ++line) {
+        out << "| " << (rows ? "Row " : "Column ") << line << ": scale " << mat._parameters[line].Scale
+            << ", zero point " << mat._parameters[line].ZeroPoint << '\n';
+    }
+
+    return out;
+}
+
+template class QuantizedMatrix<int8_t>;
+template class QuantizedMatrix<uint8_t>;
+
+template QuantizedMatrix<int8_t>  QuantizedMatrix<int8_t>::MultiplyRequantized<int8_t>(const QuantizedMatrix<int8_t>&, Parameters) const;
+template QuantizedMatrix<uint8_t> QuantizedMatrix<int8_t>::MultiplyRequantized<uint8_t>(const QuantizedMatrix<int8_t>&, Parameters) const;
+template QuantizedMatrix<int8_t>  QuantizedMatrix<uint8_t>::MultiplyRequantized<int8_t>(const QuantizedMatrix<int8_t>&, Parameters) const;
+template QuantizedMatrix<uint8_t> QuantizedMatrix<uint8_t>::MultiplyRequantized<uint8_t>(const QuantizedMatrix<int8_t>&, Parameters) const;
+
+template typename std::ostream& operator<<(std::ostream& out, const QuantizedMatrix<int8_t>& mat);
+template typename std::ostream& operator<<(std::ostream& out, const QuantizedMatrix<uint8_t>& mat);
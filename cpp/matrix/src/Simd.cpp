@@ -0,0 +1,1055 @@
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(__x86_64__)
+    #define SIMD_X86
+    #include <cpuid.h>
+    #include <immintrin.h>
+#endif
+
+
+/****************************************
+ * Scalar kernels
+ ****************************************/
+namespace scalar
+{
+    // The 16 bit types are converted to float by every read, S is the type of their sums.
+    template<typename T> void
+    add(const T* a, const T* b, T* out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = a[i] + b[i];
+        }
+    }
+
+    template<typename T> void
+    subtract(const T* a, const T* b, T* out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = a[i] - b[i];
+        }
+    }
+
+    template<typename T> void
+    scale(AccumulatorType<T> alpha, const T* a, T* out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = alpha * a[i];
+        }
+    }
+
+    template<typename T> void
+    axpy(AccumulatorType<T> alpha, const T* a, T* out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] += alpha * a[i];
+        }
+    }
+
+    template<typename T> void
+    dotRows(size_t rows, size_t n, const T* a, size_t rowStride, const T* x, T* out)
+    {
+        using S = AccumulatorType<T>;
+
+        for (size_t r = 0; r < rows; ++r)
+        {
+            S sum = static_cast<S>(0);
+            for (size_t j = 0; j < n; ++j) {
+                sum += a[r * rowStride + j] * x[j];
+            }
+            out[r] = sum;
+        }
+    }
+
+    template<typename T> void
+    axpyColumns(size_t columns, size_t n, AccumulatorType<T> alpha, const T* a, size_t columnStride, const T* x, T* out)
+    {
+        using S = AccumulatorType<T>;
+
+        for (size_t c = 0; c < columns; ++c)
+        {
+            const S s = alpha * x[c];
+            for (size_t i = 0; i < n; ++i) {
+                out[i] += a[c * columnStride + i] * s;
+            }
+        }
+    }
+
+    template<typename T> void
+    dotBatch(size_t k, size_t n, const T* a, size_t aStride, const T* b, size_t bStride, T* out)
+    {
+        using S = AccumulatorType<T>;
+
+        for (size_t l = 0; l < n; ++l)
+        {
+            S sum = static_cast<S>(0);
+            for (size_t p = 0; p < k; ++p) {
+                sum += a[p * aStride + l] * b[p * bStride + l];
+            }
+            out[l] = sum;
+        }
+    }
+
+    template<typename T> bool
+    areEqual(const T* a, const T* b, size_t n, [[maybe_unused]] AccumulatorType<T> realTypeToleranceFactor)
+    {
+        if constexpr (std::is_floating_point<T>() || IsFloat16<T>)
+        {
+            using S = AccumulatorType<T>;
+
+            const S epsilon = realTypeToleranceFactor * static_cast<S>(std::numeric_limits<T>::epsilon());
+            for (size_t i = 0; i < n; ++i)
+            {
+                const S ai = a[i];
+                const S bi = b[i];
+                if (!(std::fabs(ai - bi) < epsilon * std::max({ static_cast<S>(1), std::fabs(ai), std::fabs(bi) }))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        else
+        {
+            return std::equal(a, a + n, b);
+        }
+    }
+
+    template<typename T> void
+    widen(const T* a, AccumulatorType<T>* out, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = a[i];
+        }
+    }
+
+    template<typename T, size_t MR, size_t NR> void
+    microKernel(size_t kc, const T* a, Gemm::Strides as, const T* b, size_t bRowStride, T* tile)
+    {
+        T acc[MR][NR] = {};
+
+        for (size_t p = 0; p < kc; ++p)
+        {
+            const T* ap = a + p * as.Col;
+            const T* bp = b + p * bRowStride;
+            for (size_t i = 0; i < MR; ++i)
+            {
+                const T ai = ap[i * as.Row];
+                for (size_t j = 0; j < NR; ++j) {
+                    acc[i][j] += ai * bp[j];
+                }
+            }
+        }
+
+        for (size_t i = 0; i < MR; ++i) {
+            for (size_t j = 0; j < NR; ++j) {
+                tile[i * NR + j] = acc[i][j];
+            }
+        }
+    }
+
+    template<size_t MR, size_t NR> void
+    quantizedMicroKernel(size_t groups, const uint8_t* a, const int8_t* b, int32_t* tile)
+    {
+        constexpr size_t G = Simd::QUANTIZED_GROUP;
+        int32_t acc[MR][NR] = {};
+
+        for (size_t g = 0; g < groups; ++g, a += MR * G, b += NR * G)
+        {
+            for (size_t i = 0; i < MR; ++i) {
+                for (size_t j = 0; j < NR; ++j) {
+                    for (size_t q = 0; q < G; ++q) {
+                        acc[i][j] += a[i * G + q] * b[j * G + q];
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < MR; ++i) {
+            for (size_t j = 0; j < NR; ++j) {
+                tile[i * NR + j] = acc[i][j];
+            }
+        }
+    }
+
+    // Multipliers and key increments of Philox4x32 (Salmon et al., "Parallel Random Numbers: As
+    // Easy as 1, 2, 3", SC 2011), the increments are the golden ratio and sqrt(3) - 1 in 0.32 bits.
+    constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+    constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+    constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+    constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+    constexpr size_t PHILOX_ROUNDS = 10;
+
+    void
+    philox(uint64_t key, uint64_t stream, uint64_t firstGroup, size_t groups, uint32_t* out)
+    {
+        constexpr size_t LANES = Simd::PHILOX_LANES;
+
+        for (size_t g = 0; g < groups; ++g, out += 4 * LANES) {
+            for (size_t lane = 0; lane < LANES; ++lane)
+            {
+                const uint64_t counter = (firstGroup + g) * LANES + lane;
+                uint32_t c[4] = {
+                    static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32),
+                    static_cast<uint32_t>(stream),  static_cast<uint32_t>(stream >> 32)
+                };
+                uint32_t k0 = static_cast<uint32_t>(key);
+                uint32_t k1 = static_cast<uint32_t>(key >> 32);
+
+                for (size_t r = 0; r < PHILOX_ROUNDS; ++r, k0 += PHILOX_W0, k1 += PHILOX_W1)
+                {
+                    const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c[0];
+                    const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c[2];
+                    const uint32_t next[4] = {
+                        static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k0, static_cast<uint32_t>(p1),
+                        static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k1, static_cast<uint32_t>(p0)
+                    };
+                    std::copy(next, next + 4, c);
+                }
+
+                for (size_t w = 0; w < 4; ++w) {
+                    out[w * LANES + lane] = c[w];
+                }
+            }
+        }
+    }
+
+} // end namespace scalar
+
+
+#ifdef SIMD_X86
+
+/****************************************
+ * SSE2 kernels
+ ****************************************/
+namespace sse2
+{
+    template<typename T> struct Ops;
+
+    template<> struct Ops<float>
+    {
+        using S = float;
+        using V = __m128;
+        inline constexpr static size_t W = 4;
+
+        static V    Load(const float* p)   { return _mm_loadu_ps(p); }
+        static void Store(float* p, V v)   { _mm_storeu_ps(p, v); }
+        static V    Zero()                 { return _mm_setzero_ps(); }
+        static V    Set1(float v)          { return _mm_set1_ps(v); }
+        static V    Add(V a, V b)          { return _mm_add_ps(a, b); }
+        static V    Sub(V a, V b)          { return _mm_sub_ps(a, b); }
+        static V    Mul(V a, V b)          { return _mm_mul_ps(a, b); }
+        static V    MulAdd(V a, V b, V c)  { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static float MulAdd(float a, float b, float c) { return a * b + c; }
+        static bool AllClose(V a, V b, V epsilon)
+        {
+            const V signMask = _mm_set1_ps(-0.0f);
+            const V absA = _mm_andnot_ps(signMask, a);
+            const V absB = _mm_andnot_ps(signMask, b);
+            const V absDiff = _mm_andnot_ps(signMask, _mm_sub_ps(a, b));
+            const V scale = _mm_max_ps(_mm_set1_ps(1.0f), _mm_max_ps(absA, absB));
+            return _mm_movemask_ps(_mm_cmplt_ps(absDiff, _mm_mul_ps(epsilon, scale))) == 0xF;
+        }
+    };
+
+    template<> struct Ops<double>
+    {
+        using S = double;
+        using V = __m128d;
+        inline constexpr static size_t W = 2;
+
+        static V    Load(const double* p)  { return _mm_loadu_pd(p); }
+        static void Store(double* p, V v)  { _mm_storeu_pd(p, v); }
+        static V    Zero()                 { return _mm_setzero_pd(); }
+        static V    Set1(double v)         { return _mm_set1_pd(v); }
+        static V    Add(V a, V b)          { return _mm_add_pd(a, b); }
+        static V    Sub(V a, V b)          { return _mm_sub_pd(a, b); }
+        static V    Mul(V a, V b)          { return _mm_mul_pd(a, b); }
+        static V    MulAdd(V a, V b, V c)  { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+        static double MulAdd(double a, double b, double c) { return a * b + c; }
+        static bool AllClose(V a, V b, V epsilon)
+        {
+            const V signMask = _mm_set1_pd(-0.0);
+            const V absA = _mm_andnot_pd(signMask, a);
+            const V absB = _mm_andnot_pd(signMask, b);
+            const V absDiff = _mm_andnot_pd(signMask, _mm_sub_pd(a, b));
+            const V scale = _mm_max_pd(_mm_set1_pd(1.0), _mm_max_pd(absA, absB));
+            return _mm_movemask_pd(_mm_cmplt_pd(absDiff, _mm_mul_pd(epsilon, scale))) == 0x3;
+        }
+    };
+
+    // The 16 bit types are float vectors in registers, they are only converted by the loads and
+    // stores. BFloat16 widens by shifting the bits to the upper half, and narrows by rounding to
+    // nearest even on the integer bits. NaNs are kept quiet instead of rounded, like in BFloat16.
+    // SSE2 has no conversions for Float16, it uses the scalar kernels.
+    template<> struct Ops<BFloat16> : Ops<float>
+    {
+        using Ops<float>::Load;
+        using Ops<float>::Store;
+
+        static V Load(const BFloat16* p)
+        {
+            const __m128i bits = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+            return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), bits));
+        }
+        static void Store(BFloat16* p, V v)
+        {
+            const __m128i bits    = _mm_castps_si128(v);
+            const __m128i lsb     = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+            const __m128i rounded = _mm_srli_epi32(_mm_add_epi32(bits, _mm_add_epi32(lsb, _mm_set1_epi32(0x7FFF))), 16);
+            const __m128i quiet   = _mm_or_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x40));
+            const __m128i nan     = _mm_castps_si128(_mm_cmpunord_ps(v, v));
+            const __m128i halves  = _mm_or_si128(_mm_and_si128(nan, quiet), _mm_andnot_si128(nan, rounded));
+            // Sign extended, so that the saturating pack keeps all 16 bits.
+            const __m128i packed  = _mm_srai_epi32(_mm_slli_epi32(halves, 16), 16);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(packed, packed));
+        }
+    };
+
+    #include "SimdKernels.inl"
+
+} // end namespace sse2
+
+
+/****************************************
+ * AVX2 kernels
+ ****************************************/
+#if defined(__clang__)
+    #pragma clang attribute push (__attribute__((target("avx2,fma,f16c"))), apply_to = function)
+#else
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma,f16c")
+#endif
+
+namespace avx2
+{
+    template<typename T> struct Ops;
+
+    template<> struct Ops<float>
+    {
+        using S = float;
+        using V = __m256;
+        inline constexpr static size_t W = 8;
+
+        static V    Load(const float* p)   { return _mm256_loadu_ps(p); }
+        static void Store(float* p, V v)   { _mm256_storeu_ps(p, v); }
+        static V    Zero()                 { return _mm256_setzero_ps(); }
+        static V    Set1(float v)          { return _mm256_set1_ps(v); }
+        static V    Add(V a, V b)          { return _mm256_add_ps(a, b); }
+        static V    Sub(V a, V b)          { return _mm256_sub_ps(a, b); }
+        static V    Mul(V a, V b)          { return _mm256_mul_ps(a, b); }
+        static V    MulAdd(V a, V b, V c)  { return _mm256_fmadd_ps(a, b, c); }
+        static float MulAdd(float a, float b, float c) { return std::fma(a, b, c); }
+        static bool AllClose(V a, V b, V epsilon)
+        {
+            const V signMask = _mm256_set1_ps(-0.0f);
+            const V absA = _mm256_andnot_ps(signMask, a);
+            const V absB = _mm256_andnot_ps(signMask, b);
+            const V absDiff = _mm256_andnot_ps(signMask, _mm256_sub_ps(a, b));
+            const V scale = _mm256_max_ps(_mm256_set1_ps(1.0f), _mm256_max_ps(absA, absB));
+            return _mm256_movemask_ps(_mm256_cmp_ps(absDiff, _mm256_mul_ps(epsilon, scale), _CMP_LT_OQ)) == 0xFF;
+        }
+    };
+
+    template<> struct Ops<double>
+    {
+        using S = double;
+        using V = __m256d;
+        inline constexpr static size_t W = 4;
+
+        static V    Load(const double* p)  { return _mm256_loadu_pd(p); }
+        static void Store(double* p, V v)  { _mm256_storeu_pd(p, v); }
+        static V    Zero()                 { return _mm256_setzero_pd(); }
+        static V    Set1(double v)         { return _mm256_set1_pd(v); }
+        static V    Add(V a, V b)          { return _mm256_add_pd(a, b); }
+        static V    Sub(V a, V b)          { return _mm256_sub_pd(a, b); }
+        static V    Mul(V a, V b)          { return _mm256_mul_pd(a, b); }
+        static V    MulAdd(V a, V b, V c)  { return _mm256_fmadd_pd(a, b, c); }
+        static double MulAdd(double a, double b, double c) { return std::fma(a, b, c); }
+        static bool AllClose(V a, V b, V epsilon)
+        {
+            const V signMask = _mm256_set1_pd(-0.0);
+            const V absA = _mm256_andnot_pd(signMask, a);
+            const V absB = _mm256_andnot_pd(signMask, b);
+            const V absDiff = _mm256_andnot_pd(signMask, _mm256_sub_pd(a, b));
+            const V scale = _mm256_max_pd(_mm256_set1_pd(1.0), _mm256_max_pd(absA, absB));
+            return _mm256_movemask_pd(_mm256_cmp_pd(absDiff, _mm256_mul_pd(epsilon, scale), _CMP_LT_OQ)) == 0xF;
+        }
+    };
+
+    // F16C converts Float16 in both directions, BFloat16 is converted like in SSE2.
+    template<> struct Ops<BFloat16> : Ops<float>
+    {
+        using Ops<float>::Load;
+        using Ops<float>::Store;
+
+        static V Load(const BFloat16* p)
+        {
+            const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(bits), 16));
+        }
+        static void Store(BFloat16* p, V v)
+        {
+            const __m256i bits    = _mm256_castps_si256(v);
+            const __m256i lsb     = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+            const __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF))), 16);
+            const __m256i quiet   = _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x40));
+            const __m256i nan     = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+            const __m256i halves  = _mm256_blendv_epi8(rounded, quiet, nan);
+            const __m128i packed  = _mm_packus_epi32(_mm256_castsi256_si128(halves), _mm256_extracti128_si256(halves, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), packed);
+        }
+    };
+
+    template<> struct Ops<Float16> : Ops<float>
+    {
+        using Ops<float>::Load;
+        using Ops<float>::Store;
+
+        static V Load(const Float16* p)
+        {
+            return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        }
+        static void Store(Float16* p, V v)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+        }
+    };
+
+    #include "SimdKernels.inl"
+
+    /// @brief The quantized micro-kernel with tiles of 6 x 8. A group of 4 bytes of 8 columns of
+    ///        B is sign extended to two vectors of 16 bit, vpmaddwd multiplies them with the
+    ///        group of a row of A and sums adjacent pairs of products into 32 bit. Each row
+    ///        accumulates two partial sums per column, which are added when the tile is stored.
+    ///        vpmaddubsw would multiply the bytes directly, but saturates the sums of pairs
+    ///        of products to 16 bit.
+    void quantizedMicroKernel(size_t groups, const uint8_t* a, const int8_t* b, int32_t* tile)
+    {
+        constexpr size_t MR = 6;
+        constexpr size_t NR = 8;
+        constexpr size_t G = Simd::QUANTIZED_GROUP;
+
+        __m256i low[MR];  // Partial sums of the columns 0 to 3
+        __m256i high[MR]; // Partial sums of the columns 4 to 7
+        for (size_t i = 0; i < MR; ++i) {
+            low[i]  = _mm256_setzero_si256();
+            high[i] = _mm256_setzero_si256();
+        }
+
+        for (size_t g = 0; g < groups; ++g, a += MR * G, b += NR * G)
+        {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+            const __m256i b0 = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(bytes));
+            const __m256i b1 = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(bytes, 1));
+
+            for (size_t i = 0; i < MR; ++i)
+            {
+                int32_t group;
+                std::memcpy(&group, a + i * G, sizeof(group));
+                const __m256i ai = _mm256_cvtepu8_epi16(_mm_set1_epi32(group));
+                low[i]  = _mm256_add_epi32(low[i], _mm256_madd_epi16(ai, b0));
+                high[i] = _mm256_add_epi32(high[i], _mm256_madd_epi16(ai, b1));
+            }
+        }
+
+        for (size_t i = 0; i < MR; ++i)
+        {
+            // The horizontal sums are ordered 0 1 4 5 | 2 3 6 7 by the 128 bit lanes.
+            const __m256i sums = _mm256_hadd_epi32(low[i], high[i]);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(tile + i * NR), _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+    }
+
+    /// @brief The high and low 32 bits of the products of the lanes of x with m: vpmuludq
+    ///        multiplies the even lanes, the odd lanes are shifted into the even ones.
+    inline void
+    mulHiLo(__m256i m, __m256i x, __m256i& hi, __m256i& lo)
+    {
+        const __m256i even = _mm256_mul_epu32(x, m);
+        const __m256i odd  = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), m);
+        lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+        hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    }
+
+    void
+    philox(uint64_t key, uint64_t stream, uint64_t firstGroup, size_t groups, uint32_t* out)
+    {
+        constexpr size_t LANES = Simd::PHILOX_LANES;
+        const __m256i m0 = _mm256_set1_epi32(static_cast<int>(scalar::PHILOX_M0));
+        const __m256i m1 = _mm256_set1_epi32(static_cast<int>(scalar::PHILOX_M1));
+
+        for (size_t g = 0; g < groups; ++g, out += 4 * LANES) {
+            for (size_t half = 0; half < LANES; half += 8)
+            {
+                // The counters of a group share their upper word, the first one is a multiple of 16.
+                const uint64_t counter = (firstGroup + g) * LANES + half;
+                __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(counter)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+                __m256i c1 = _mm256_set1_epi32(static_cast<int>(counter >> 32));
+                __m256i c2 = _mm256_set1_epi32(static_cast<int>(stream));
+                __m256i c3 = _mm256_set1_epi32(static_cast<int>(stream >> 32));
+                uint32_t k0 = static_cast<uint32_t>(key);
+                uint32_t k1 = static_cast<uint32_t>(key >> 32);
+
+                for (size_t r = 0; r < scalar::PHILOX_ROUNDS; ++r, k0 += scalar::PHILOX_W0, k1 += scalar::PHILOX_W1)
+                {
+                    __m256i hi0, lo0, hi1, lo1;
+                    mulHiLo(m0, c0, hi0, lo0);
+                    mulHiLo(m1, c2, hi1, lo1);
+                    c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(k0)));
+                    c1 = lo1;
+                    c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(k1)));
+                    c3 = lo0;
+                }
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + half), c0);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + LANES + half), c1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * LANES + half), c2);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 3 * LANES + half), c3);
+            }
+        }
+    }
+
+} // end namespace avx2
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#else
+    #pragma GCC pop_options
+#endif
+
+
+/****************************************
+ * AVX-512 kernels
+ ****************************************/
+#if defined(__clang__)
+    #pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#else
+    #pragma GCC push_options
+    #pragma GCC target("avx512f")
+#endif
+
+namespace avx512
+{
+    template<typename T> struct Ops;
+
+    template<> struct Ops<float>
+    {
+        using S = float;
+        using V = __m512;
+        inline constexpr static size_t W = 16;
+
+        static V    Load(const float* p)   { return _mm512_loadu_ps(p); }
+        static void Store(float* p, V v)   { _mm512_storeu_ps(p, v); }
+        static V    Zero()                 { return _mm512_setzero_ps(); }
+        static V    Set1(float v)          { return _mm512_set1_ps(v); }
+        static V    Add(V a, V b)          { return _mm512_add_ps(a, b); }
+        static V    Sub(V a, V b)          { return _mm512_sub_ps(a, b); }
+        static V    Mul(V a, V b)          { return _mm512_mul_ps(a, b); }
+        static V    MulAdd(V a, V b, V c)  { return _mm512_fmadd_ps(a, b, c); }
+        static float MulAdd(float a, float b, float c) { return std::fma(a, b, c); }
+        static bool AllClose(V a, V b, V epsilon)
+        {
+            // d < e * max(1, |a|, |b|) holds if d is less than any one of the scaled terms.
+            const V absDiff = _mm512_abs_ps(_mm512_sub_ps(a, b));
+            const auto close =
+                _mm512_cmp_ps_mask(absDiff, epsilon, _CMP_LT_OQ) |
+                _mm512_cmp_ps_mask(absDiff, _mm512_mul_ps(epsilon, _mm512_abs_ps(a)), _CMP_LT_OQ) |
+                _mm512_cmp_ps_mask(absDiff, _mm512_mul_ps(epsilon, _mm512_abs_ps(b)), _CMP_LT_OQ);
+            return close == 0xFFFF;
+        }
+    };
+
+    template<> struct Ops<double>
+    {
+        using S = double;
+        using V = __m512d;
+        inline constexpr static size_t W = 8;
+
+        static V    Load(const double* p)  { return _mm512_loadu_pd(p); }
+        static void Store(double* p, V v)  { _mm512_storeu_pd(p, v); }
+        static V    Zero()                 { return _mm512_setzero_pd(); }
+        static V    Set1(double v)         { return _mm512_set1_pd(v); }
+        static V    Add(V a, V b)          { return _mm512_add_pd(a, b); }
+        static V    Sub(V a, V b)          { return _mm512_sub_pd(a, b); }
+        static V    Mul(V a, V b)          { return _mm512_mul_pd(a, b); }
+        static V    MulAdd(V a, V b, V c)  { return _mm512_fmadd_pd(a, b, c); }
+        static double MulAdd(double a, double b, double c) { return std::fma(a, b, c); }
+        static bool AllClose(V a, V b, V epsilon)
+        {
+            // d < e * max(1, |a|, |b|) holds if d is less than any one of the scaled terms.
+            const V absDiff = _mm512_abs_pd(_mm512_sub_pd(a, b));
+            const auto close =
+                _mm512_cmp_pd_mask(absDiff, epsilon, _CMP_LT_OQ) |
+                _mm512_cmp_pd_mask(absDiff, _mm512_mul_pd(epsilon, _mm512_abs_pd(a)), _CMP_LT_OQ) |
+                _mm512_cmp_pd_mask(absDiff, _mm512_mul_pd(epsilon, _mm512_abs_pd(b)), _CMP_LT_OQ);
+            return close == 0xFF;
+        }
+    };
+
+    template<> struct Ops<BFloat16> : Ops<float>
+    {
+        using Ops<float>::Load;
+        using Ops<float>::Store;
+
+        static V Load(const BFloat16* p)
+        {
+            const __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(bits), 16));
+        }
+        static void Store(BFloat16* p, V v)
+        {
+            const __m512i bits    = _mm512_castps_si512(v);
+            const __m512i lsb     = _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+            const __m512i rounded = _mm512_srli_epi32(_mm512_add_epi32(bits, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF))), 16);
+            const __m512i quiet   = _mm512_or_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(0x40));
+            const __m512i halves  = _mm512_mask_blend_epi32(_mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q), rounded, quiet);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtepi32_epi16(halves));
+        }
+    };
+
+    template<> struct Ops<Float16> : Ops<float>
+    {
+        using Ops<float>::Load;
+        using Ops<float>::Store;
+
+        static V Load(const Float16* p)
+        {
+            return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+        }
+        static void Store(Float16* p, V v)
+        {
+            // The masked form, GCC defines the unmasked one as a macro with a mask of -1 that fails -Wsign-conversion.
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_maskz_cvtps_ph(0xFFFF, v, _MM_FROUND_TO_NEAREST_INT));
+        }
+    };
+
+    #include "SimdKernels.inl"
+
+    /// @brief The high and low 32 bits of the products of the lanes of x with m, see avx2::mulHiLo.
+    inline void
+    mulHiLo(__m512i m, __m512i x, __m512i& hi, __m512i& lo)
+    {
+        const __m512i even = _mm512_mul_epu32(x, m);
+        const __m512i odd  = _mm512_mul_epu32(_mm512_srli_epi64(x, 32), m);
+        lo = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+        hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+    }
+
+    void
+    philox(uint64_t key, uint64_t stream, uint64_t firstGroup, size_t groups, uint32_t* out)
+    {
+        constexpr size_t LANES = Simd::PHILOX_LANES;
+        const __m512i m0 = _mm512_set1_epi32(static_cast<int>(scalar::PHILOX_M0));
+        const __m512i m1 = _mm512_set1_epi32(static_cast<int>(scalar::PHILOX_M1));
+        const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+        for (size_t g = 0; g < groups; ++g, out += 4 * LANES)
+        {
+            // The counters of a group share their upper word, the first one is a multiple of 16.
+            const uint64_t counter = (firstGroup + g) * LANES;
+            __m512i c0 = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(counter)), lanes);
+            __m512i c1 = _mm512_set1_epi32(static_cast<int>(counter >> 32));
+            __m512i c2 = _mm512_set1_epi32(static_cast<int>(stream));
+            __m512i c3 = _mm512_set1_epi32(static_cast<int>(stream >> 32));
+            uint32_t k0 = static_cast<uint32_t>(key);
+            uint32_t k1 = static_cast<uint32_t>(key >> 32);
+
+            for (size_t r = 0; r < scalar::PHILOX_ROUNDS; ++r, k0 += scalar::PHILOX_W0, k1 += scalar::PHILOX_W1)
+            {
+                __m512i hi0, lo0, hi1, lo1;
+                mulHiLo(m0, c0, hi0, lo0);
+                mulHiLo(m1, c2, hi1, lo1);
+                c0 = _mm512_xor_si512(_mm512_xor_si512(hi1, c1), _mm512_set1_epi32(static_cast<int>(k0)));
+                c1 = lo1;
+                c2 = _mm512_xor_si512(_mm512_xor_si512(hi0, c3), _mm512_set1_epi32(static_cast<int>(k1)));
+                c3 = lo0;
+            }
+
+            _mm512_storeu_si512(out, c0);
+            _mm512_storeu_si512(out + LANES, c1);
+            _mm512_storeu_si512(out + 2 * LANES, c2);
+            _mm512_storeu_si512(out + 3 * LANES, c3);
+        }
+    }
+
+} // end namespace avx512
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#else
+    #pragma GCC pop_options
+#endif
+
+
+/****************************************
+ * AVX-512 VNNI kernels
+ ****************************************/
+#if defined(__clang__)
+    #pragma clang attribute push (__attribute__((target("avx512f,avx512bw,avx512vnni"))), apply_to = function)
+#else
+    #pragma GCC push_options
+    #pragma GCC target("avx512f,avx512bw,avx512vnni")
+#endif
+
+namespace avx512vnni
+{
+    /// @brief The quantized micro-kernel with tiles of 8 x 32. vpdpbusd multiplies the unsigned
+    ///        group of a row of A with the signed groups of 16 columns of B and adds the sums of
+    ///        the four products to the 32 bit accumulators.
+    void quantizedMicroKernel(size_t groups, const uint8_t* a, const int8_t* b, int32_t* tile)
+    {
+        constexpr size_t MR = 8;
+        constexpr size_t NR = 32;
+        constexpr size_t G = Simd::QUANTIZED_GROUP;
+
+        __m512i acc[MR][2];
+        for (size_t i = 0; i < MR; ++i) {
+            acc[i][0] = _mm512_setzero_si512();
+            acc[i][1] = _mm512_setzero_si512();
+        }
+
+        for (size_t g = 0; g < groups; ++g, a += MR * G, b += NR * G)
+        {
+            const __m512i b0 = _mm512_loadu_si512(b);
+            const __m512i b1 = _mm512_loadu_si512(b + 16 * G);
+
+            for (size_t i = 0; i < MR; ++i)
+            {
+                int32_t group;
+                std::memcpy(&group, a + i * G, sizeof(group));
+                const __m512i ai = _mm512_set1_epi32(group);
+                acc[i][0] = _mm512_dpbusd_epi32(acc[i][0], ai, b0);
+                acc[i][1] = _mm512_dpbusd_epi32(acc[i][1], ai, b1);
+            }
+        }
+
+        for (size_t i = 0; i < MR; ++i) {
+            _mm512_storeu_si512(tile + i * NR, acc[i][0]);
+            _mm512_storeu_si512(tile + i * NR + 16, acc[i][1]);
+        }
+    }
+
+} // end namespace avx512vnni
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#else
+    #pragma GCC pop_options
+#endif
+
+#endif // SIMD_X86
+
+
+/****************************************
+ * Kernel tables and CPU detection
+ ****************************************/
+namespace
+{
+#ifdef SIMD_X86
+    /// @brief Returns the register state enabled by the operating system (XCR0).
+    uint64_t readXcr0()
+    {
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+    }
+
+    Simd::Isa queryCpu()
+    {
+        unsigned int eax, ebx, ecx, edx;
+
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return Simd::Isa::SSE2;
+        }
+
+        const bool osxsave = ecx & bit_OSXSAVE;
+        const bool fma     = ecx & bit_FMA;
+        const bool avx     = ecx & bit_AVX;
+        const bool f16c    = ecx & bit_F16C;
+
+        // The OS must save the ymm (and zmm) registers on context switches.
+        const uint64_t xcr0 = osxsave ? readXcr0() : 0;
+        const bool osYmm = (xcr0 & 0x06) == 0x06;
+        const bool osZmm = (xcr0 & 0xE6) == 0xE6;
+
+        if (!avx || !osYmm || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+            return Simd::Isa::SSE2;
+        }
+
+        if ((ebx & bit_AVX512F) && osZmm && fma && f16c) {
+            return Simd::Isa::AVX512;
+        }
+        if ((ebx & bit_AVX2) && fma && f16c) {
+            return Simd::Isa::AVX2;
+        }
+
+        return Simd::Isa::SSE2;
+    }
+
+    /// @brief Returns true if the CPU has the AVX-512 extensions of the quantized kernel. Only
+    ///        queried for CPUs with AVX-512F, whose register state is enabled by the OS.
+    bool queryVnni()
+    {
+        unsigned int eax, ebx, ecx, edx;
+        return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_AVX512BW) && (ecx & bit_AVX512VNNI);
+    }
+#endif
+
+    template<typename T> Simd::Kernels<T>
+    makeKernels(Simd::Isa isa)
+    {
+        if constexpr (std::is_same<T, float>() || std::is_same<T, double>())
+        {
+#ifdef SIMD_X86
+            // Register tiles of 4 (SSE2) or 6 rows and 2 vectors, which leaves registers
+            // for the loaded rhs vectors and the broadcasted lhs element.
+            switch (isa)
+            {
+                case Simd::Isa::Scalar:
+                    break;
+                case Simd::Isa::SSE2:
+                    return {
+                        isa, 4, 2 * sse2::Ops<T>::W,
+                        &sse2::add<T>, &sse2::subtract<T>, &sse2::scale<T>, &sse2::axpy<T>,
+                        &sse2::dotRows<T>, &sse2::axpyColumns<T>, &sse2::dotBatch<T>, &sse2::areEqual<T>, &sse2::widen<T>,
+                        &sse2::microKernel<T, 4, 2>
+                    };
+                case Simd::Isa::AVX2:
+                    return {
+                        isa, 6, 2 * avx2::Ops<T>::W,
+                        &avx2::add<T>, &avx2::subtract<T>, &avx2::scale<T>, &avx2::axpy<T>,
+                        &avx2::dotRows<T>, &avx2::axpyColumns<T>, &avx2::dotBatch<T>, &avx2::areEqual<T>, &avx2::widen<T>,
+                        &avx2::microKernel<T, 6, 2>
+                    };
+                case Simd::Isa::AVX512:
+                    return {
+                        isa, 6, 2 * avx512::Ops<T>::W,
+                        &avx512::add<T>, &avx512::subtract<T>, &avx512::scale<T>, &avx512::axpy<T>,
+                        &avx512::dotRows<T>, &avx512::axpyColumns<T>, &avx512::dotBatch<T>, &avx512::areEqual<T>, &avx512::widen<T>,
+                        &avx512::microKernel<T, 6, 2>
+                    };
+            }
+#endif
+        }
+        else if constexpr (IsFloat16<T>)
+        {
+            // The products are packed into float panels, so the register tiles are those of float.
+            const Simd::Kernels<float> packed = makeKernels<float>(isa);
+
+#ifdef SIMD_X86
+            switch (isa)
+            {
+                case Simd::Isa::Scalar:
+                    break;
+                case Simd::Isa::SSE2:
+                    if constexpr (std::is_same<T, BFloat16>()) {
+                        return {
+                            isa, packed.MR, packed.NR,
+                            &sse2::add<T>, &sse2::subtract<T>, &sse2::scale<T>, &sse2::axpy<T>,
+                            &sse2::dotRows<T>, &sse2::axpyColumns<T>, &sse2::dotBatch<T>, &sse2::areEqual<T>, &sse2::widen<T>,
+                            packed.MicroKernel
+                        };
+                    }
+                    break;
+                case Simd::Isa::AVX2:
+                    return {
+                        isa, packed.MR, packed.NR,
+                        &avx2::add<T>, &avx2::subtract<T>, &avx2::scale<T>, &avx2::axpy<T>,
+                        &avx2::dotRows<T>, &avx2::axpyColumns<T>, &avx2::dotBatch<T>, &avx2::areEqual<T>, &avx2::widen<T>,
+                        packed.MicroKernel
+                    };
+                case Simd::Isa::AVX512:
+                    return {
+                        isa, packed.MR, packed.NR,
+                        &avx512::add<T>, &avx512::subtract<T>, &avx512::scale<T>, &avx512::axpy<T>,
+                        &avx512::dotRows<T>, &avx512::axpyColumns<T>, &avx512::dotBatch<T>, &avx512::areEqual<T>, &avx512::widen<T>,
+                        packed.MicroKernel
+                    };
+            }
+#endif
+
+            return {
+                packed.InstructionSet, packed.MR, packed.NR,
+                &scalar::add<T>, &scalar::subtract<T>, &scalar::scale<T>, &scalar::axpy<T>,
+                &scalar::dotRows<T>, &scalar::axpyColumns<T>, &scalar::dotBatch<T>, &scalar::areEqual<T>, &scalar::widen<T>,
+                packed.MicroKernel
+            };
+        }
+
+        return {
+            Simd::Isa::Scalar, 4, 8,
+            &scalar::add<T>, &scalar::subtract<T>, &scalar::scale<T>, &scalar::axpy<T>,
+            &scalar::dotRows<T>, &scalar::axpyColumns<T>, &scalar::dotBatch<T>, &scalar::areEqual<T>, &scalar::widen<T>,
+            &scalar::microKernel<AccumulatorType<T>, 4, 8>
+        };
+    }
+
+    Simd::QuantizedKernels
+    makeQuantizedKernels(Simd::Isa isa)
+    {
+#ifdef SIMD_X86
+        switch (isa)
+        {
+            case Simd::Isa::Scalar:
+            case Simd::Isa::SSE2:
+                break;
+            case Simd::Isa::AVX512:
+                if (queryVnni()) {
+                    return { isa, 8, 32, &avx512vnni::quantizedMicroKernel };
+                }
+                [[fallthrough]];
+            case Simd::Isa::AVX2:
+                return { Simd::Isa::AVX2, 6, 8, &avx2::quantizedMicroKernel };
+        }
+#endif
+
+        return { Simd::Isa::Scalar, 4, 8, &scalar::quantizedMicroKernel<4, 8> };
+    }
+
+    Simd::RandomKernels
+    makeRandomKernels(Simd::Isa isa)
+    {
+#ifdef SIMD_X86
+        switch (isa)
+        {
+            case Simd::Isa::Scalar:
+            case Simd::Isa::SSE2:
+                break;
+            case Simd::Isa::AVX2:
+                return { isa, &avx2::philox };
+            case Simd::Isa::AVX512:
+                return { isa, &avx512::philox };
+        }
+#endif
+
+        return { Simd::Isa::Scalar, &scalar::philox };
+    }
+
+} // end anonymous namespace
+
+
+Simd::Isa
+Simd::DetectIsa()
+{
+#ifdef SIMD_X86
+    static const Isa detected = queryCpu();
+    return detected;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+bool
+Simd::IsSupported(Isa isa)
+{
+    return static_cast<int>(isa) <= static_cast<int>(DetectIsa());
+}
+
+const char*
+Simd::IsaName(Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::Scalar: return "Scalar";
+        case Isa::SSE2:   return "SSE2";
+        case Isa::AVX2:   return "AVX2";
+        case Isa::AVX512: return "AVX-512";
+    }
+
+    return "Unknown";
+}
+
+template<typename T> const Simd::Kernels<T>&
+Simd::GetKernels()
+{
+    static const Kernels<T> kernels = makeKernels<T>(DetectIsa());
+    return kernels;
+}
+
+template<typename T> const Simd::Kernels<T>&
+Simd::GetKernels(Isa isa)
+{
+    if (!IsSupported(isa)) {
+        throw std::invalid_argument(std::string("Instruction set not supported by the CPU: ") + IsaName(isa));
+    }
+
+    static const Kernels<T> kernels[] = {
+        makeKernels<T>(Isa::Scalar),
+        makeKernels<T>(IsSupported(Isa::SSE2)   ? Isa::SSE2   : Isa::Scalar),
+        makeKernels<T>(IsSupported(Isa::AVX2)   ? Isa::AVX2   : Isa::Scalar),
+        makeKernels<T>(IsSupported(Isa::AVX512) ? Isa::AVX512 : Isa::Scalar),
+    };
+
+    return kernels[static_cast<size_t>(isa)];
+}
+
+const Simd::QuantizedKernels&
+Simd::GetQuantizedKernels()
+{
+    static const QuantizedKernels kernels = makeQuantizedKernels(DetectIsa());
+    return kernels;
+}
+
+const Simd::QuantizedKernels&
+Simd::GetQuantizedKernels(Isa isa)
+{
+    if (!IsSupported(isa)) {
+        throw std::invalid_argument(std::string("Instruction set not supported by the CPU: ") + IsaName(isa));
+    }
+
+    static const QuantizedKernels kernels[] = {
+        makeQuantizedKernels(Isa::Scalar),
+        makeQuantizedKernels(IsSupported(Isa::SSE2)   ? Isa::SSE2   : Isa::Scalar),
+        makeQuantizedKernels(IsSupported(Isa::AVX2)   ? Isa::AVX2   : Isa::Scalar),
+        makeQuantizedKernels(IsSupported(Isa::AVX512) ? Isa::AVX512 : Isa::Scalar),
+    };
+
+    return kernels[static_cast<size_t>(isa)];
+}
+
+const Simd::RandomKernels&
+Simd::GetRandomKernels()
+{
+    static const RandomKernels kernels = makeRandomKernels(DetectIsa());
+    return kernels;
+}
+
+const Simd::RandomKernels&
+Simd::GetRandomKernels(Isa isa)
+{
+    if (!IsSupported(isa)) {
+        throw std::invalid_argument(std::string("Instruction set not supported by the CPU: ") + IsaName(isa));
+    }
+
+    static const RandomKernels kernels[] = {
+        makeRandomKernels(Isa::Scalar),
+        makeRandomKernels(IsSupported(Isa::SSE2)   ? Isa::SSE2   : Isa::Scalar),
+        makeRandomKernels(IsSupported(Isa::AVX2)   ? Isa::AVX2   : Isa::Scalar),
+        makeRandomKernels(IsSupported(Isa::AVX512) ? Isa::AVX512 : Isa::Scalar),
+    };
+
+    return kernels[static_cast<size_t>(isa)];
+}
+
+
+template const Simd::Kernels<int>&      Simd::GetKernels<int>();
+template const Simd::Kernels<size_t>&   Simd::GetKernels<size_t>();
+template const Simd::Kernels<float>&    Simd::GetKernels<float>();
+template const Simd::Kernels<double>&   Simd::GetKernels<double>();
+template const Simd::Kernels<BFloat16>& Simd::GetKernels<BFloat16>();
+template const Simd::Kernels<Float16>&  Simd::GetKernels<Float16>();
+
+template const Simd::Kernels<int>&      Simd::GetKernels<int>(Isa);
+template const Simd::Kernels<size_t>&   Simd::GetKernels<size_t>(Isa);
+template const Simd::Kernels<float>&    Simd::GetKernels<float>(Isa);
+template const Simd::Kernels<double>&   Simd::GetKernels<double>(Isa);
+template const Simd::Kernels<BFloat16>& Simd::GetKernels<BFloat16>(Isa);
+template const Simd::Kernels<Float16>&  Simd::GetKernels<Float16>(Isa);
@@ -0,0 +1,328 @@
+// Generic vector kernels, included by Simd.cpp once for every supported instruction set.
+// The including namespace must define the template Ops<T> for float and double, and for the
+// 16 bit types it has conversions for, with:
+//   S                  - the scalar type of the vector lanes, float for the 16 bit types
+//   V                  - the vector type
+//   W                  - the amount of elements in one vector
+//   Load, Store        - unaligned load and store, of T and of S elements
+//   Zero, Set1         - vector with all elements set to zero or to the given value
+//   Add, Sub, Mul      - a + b, a - b, a * b
+//   MulAdd             - a * b + c, fused where the instruction set supports it, also for scalars
+//   AllClose(a, b, e)  - true if |a - b| < e * max(1, |a|, |b|) for all elements
+// The code is compiled with the target options in effect at the point of inclusion.
+
+
+template<typename T> void
+add(const T* a, const T* b, T* out, size_t n)
+{
+    using O = Ops<T>;
+
+    size_t i = 0;
+    for (; i + 2 * O::W <= n; i += 2 * O::W) {
+        O::Store(out + i,        O::Add(O::Load(a + i),        O::Load(b + i)));
+        O::Store(out + i + O::W, O::Add(O::Load(a + i + O::W), O::Load(b + i + O::W)));
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+template<typename T> void
+subtract(const T* a, const T* b, T* out, size_t n)
+{
+    using O = Ops<T>;
+
+    size_t i = 0;
+    for (; i + 2 * O::W <= n; i += 2 * O::W) {
+        O::Store(out + i,        O::Sub(O::Load(a + i),        O::Load(b + i)));
+        O::Store(out + i + O::W, O::Sub(O::Load(a + i + O::W), O::Load(b + i + O::W)));
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+template<typename T> void
+scale(typename Ops<T>::S alpha, const T* a, T* out, size_t n)
+{
+    using O = Ops<T>;
+    const typename O::V alphaV = O::Set1(alpha);
+
+    size_t i = 0;
+    for (; i + 2 * O::W <= n; i += 2 * O::W) {
+        O::Store(out + i,        O::Mul(alphaV, O::Load(a + i)));
+        O::Store(out + i + O::W, O::Mul(alphaV, O::Load(a + i + O::W)));
+    }
+    for (; i < n; ++i) {
+        out[i] = alpha * a[i];
+    }
+}
+
+// Not fused, so that the results match the scalar kernel. The loop is bound by memory anyway.
+template<typename T> void
+axpy(typename Ops<T>::S alpha, const T* a, T* out, size_t n)
+{
+    using O = Ops<T>;
+    const typename O::V alphaV = O::Set1(alpha);
+
+    size_t i = 0;
+    for (; i + 2 * O::W <= n; i += 2 * O::W) {
+        O::Store(out + i,        O::Add(O::Load(out + i),        O::Mul(alphaV, O::Load(a + i))));
+        O::Store(out + i + O::W, O::Add(O::Load(out + i + O::W), O::Mul(alphaV, O::Load(a + i + O::W))));
+    }
+    for (; i < n; ++i) {
+        out[i] += alpha * a[i];
+    }
+}
+
+template<typename T> void
+dotRows(size_t rows, size_t n, const T* a, size_t rowStride, const T* x, T* out)
+{
+    using O = Ops<T>;
+    using S = typename O::S;
+    constexpr size_t ROWS = 4;
+
+    // Sums the accumulators of one row, the vector lanes are reduced through memory.
+    const auto reduce = [](typename O::V lo, typename O::V hi) {
+        alignas(64) S lanes[O::W];
+        O::Store(lanes, O::Add(lo, hi));
+        S sum = static_cast<S>(0);
+        for (size_t l = 0; l < O::W; ++l) {
+            sum += lanes[l];
+        }
+        return sum;
+    };
+
+    // Four rows share every loaded vector of x, two accumulators per row hide the latency of the FMAs.
+    size_t r = 0;
+    for (; r + ROWS <= rows; r += ROWS)
+    {
+        const T* a0 = a + r * rowStride;
+        const T* a1 = a0 + rowStride;
+        const T* a2 = a1 + rowStride;
+        const T* a3 = a2 + rowStride;
+
+        typename O::V acc[ROWS][2] = { { O::Zero(), O::Zero() }, { O::Zero(), O::Zero() }, { O::Zero(), O::Zero() }, { O::Zero(), O::Zero() } };
+
+        size_t j = 0;
+        for (; j + 2 * O::W <= n; j += 2 * O::W)
+        {
+            const typename O::V x0 = O::Load(x + j);
+            const typename O::V x1 = O::Load(x + j + O::W);
+            acc[0][0] = O::MulAdd(O::Load(a0 + j), x0, acc[0][0]); acc[0][1] = O::MulAdd(O::Load(a0 + j + O::W), x1, acc[0][1]);
+            acc[1][0] = O::MulAdd(O::Load(a1 + j), x0, acc[1][0]); acc[1][1] = O::MulAdd(O::Load(a1 + j + O::W), x1, acc[1][1]);
+            acc[2][0] = O::MulAdd(O::Load(a2 + j), x0, acc[2][0]); acc[2][1] = O::MulAdd(O::Load(a2 + j + O::W), x1, acc[2][1]);
+            acc[3][0] = O::MulAdd(O::Load(a3 + j), x0, acc[3][0]); acc[3][1] = O::MulAdd(O::Load(a3 + j + O::W), x1, acc[3][1]);
+        }
+
+        S sums[ROWS] = { reduce(acc[0][0], acc[0][1]), reduce(acc[1][0], acc[1][1]), reduce(acc[2][0], acc[2][1]), reduce(acc[3][0], acc[3][1]) };
+        for (; j < n; ++j) {
+            sums[0] = O::MulAdd(a0[j], x[j], sums[0]);
+            sums[1] = O::MulAdd(a1[j], x[j], sums[1]);
+            sums[2] = O::MulAdd(a2[j], x[j], sums[2]);
+            sums[3] = O::MulAdd(a3[j], x[j], sums[3]);
+        }
+
+        for (size_t i = 0; i < ROWS; ++i) {
+            out[r + i] = sums[i];
+        }
+    }
+
+    for (; r < rows; ++r)
+    {
+        const T* ar = a + r * rowStride;
+        typename O::V acc0 = O::Zero();
+        typename O::V acc1 = O::Zero();
+
+        size_t j = 0;
+        for (; j + 2 * O::W <= n; j += 2 * O::W) {
+            acc0 = O::MulAdd(O::Load(ar + j),        O::Load(x + j),        acc0);
+            acc1 = O::MulAdd(O::Load(ar + j + O::W), O::Load(x + j + O::W), acc1);
+        }
+
+        S sum = reduce(acc0, acc1);
+        for (; j < n; ++j) {
+            sum = O::MulAdd(ar[j], x[j], sum);
+        }
+        out[r] = sum;
+    }
+}
+
+template<typename T> void
+axpyColumns(size_t columns, size_t n, typename Ops<T>::S alpha, const T* a, size_t columnStride, const T* x, T* out)
+{
+    using O = Ops<T>;
+    using S = typename O::S;
+    constexpr size_t COLUMNS = 4;
+
+    // Four columns per pass over out, which quarters the loads and stores of out.
+    size_t c = 0;
+    for (; c + COLUMNS <= columns; c += COLUMNS)
+    {
+        const T* a0 = a + c * columnStride;
+        const T* a1 = a0 + columnStride;
+        const T* a2 = a1 + columnStride;
+        const T* a3 = a2 + columnStride;
+        const S s0 = alpha * x[c], s1 = alpha * x[c + 1], s2 = alpha * x[c + 2], s3 = alpha * x[c + 3];
+        const typename O::V x0 = O::Set1(s0), x1 = O::Set1(s1), x2 = O::Set1(s2), x3 = O::Set1(s3);
+
+        size_t i = 0;
+        for (; i + O::W <= n; i += O::W)
+        {
+            typename O::V acc = O::Load(out + i);
+            acc = O::MulAdd(O::Load(a0 + i), x0, acc);
+            acc = O::MulAdd(O::Load(a1 + i), x1, acc);
+            acc = O::MulAdd(O::Load(a2 + i), x2, acc);
+            acc = O::MulAdd(O::Load(a3 + i), x3, acc);
+            O::Store(out + i, acc);
+        }
+        for (; i < n; ++i)
+        { // Same operations as the vectors, so the results do not depend on where the tail starts.
+            S acc = out[i];
+            acc = O::MulAdd(a0[i], s0, acc);
+            acc = O::MulAdd(a1[i], s1, acc);
+            acc = O::MulAdd(a2[i], s2, acc);
+            acc = O::MulAdd(a3[i], s3, acc);
+            out[i] = acc;
+        }
+    }
+
+    for (; c < columns; ++c)
+    {
+        const T* ac = a + c * columnStride;
+        const S s = alpha * x[c];
+        const typename O::V xs = O::Set1(s);
+
+        size_t i = 0;
+        for (; i + O::W <= n; i += O::W) {
+            O::Store(out + i, O::MulAdd(O::Load(ac + i), xs, O::Load(out + i)));
+        }
+        for (; i < n; ++i) {
+            out[i] = O::MulAdd(ac[i], s, out[i]);
+        }
+    }
+}
+
+template<typename T> void
+dotBatch(size_t k, size_t n, const T* a, size_t aStride, const T* b, size_t bStride, T* out)
+{
+    using O = Ops<T>;
+    using S = typename O::S;
+    constexpr size_t VECTORS = 4;
+
+    // Four vectors of lanes per pass keep four independent chains of FMAs in flight.
+    size_t l = 0;
+    for (; l + VECTORS * O::W <= n; l += VECTORS * O::W)
+    {
+        typename O::V acc[VECTORS] = { O::Zero(), O::Zero(), O::Zero(), O::Zero() };
+        for (size_t p = 0; p < k; ++p)
+        {
+            const T* ap = a + p * aStride + l;
+            const T* bp = b + p * bStride + l;
+            for (size_t v = 0; v < VECTORS; ++v) {
+                acc[v] = O::MulAdd(O::Load(ap + v * O::W), O::Load(bp + v * O::W), acc[v]);
+            }
+        }
+        for (size_t v = 0; v < VECTORS; ++v) {
+            O::Store(out + l + v * O::W, acc[v]);
+        }
+    }
+
+    for (; l + O::W <= n; l += O::W)
+    {
+        typename O::V acc = O::Zero();
+        for (size_t p = 0; p < k; ++p) {
+            acc = O::MulAdd(O::Load(a + p * aStride + l), O::Load(b + p * bStride + l), acc);
+        }
+        O::Store(out + l, acc);
+    }
+
+    for (; l < n; ++l)
+    { // Same operations as the vectors, so the results do not depend on the position of the lane.
+        S sum = static_cast<S>(0);
+        for (size_t p = 0; p < k; ++p) {
+            sum = O::MulAdd(a[p * aStride + l], b[p * bStride + l], sum);
+        }
+        out[l] = sum;
+    }
+}
+
+template<typename T> bool
+areEqual(const T* a, const T* b, size_t n, typename Ops<T>::S realTypeToleranceFactor)
+{
+    using O = Ops<T>;
+    using S = typename O::S;
+
+    const S epsilon = realTypeToleranceFactor * static_cast<S>(std::numeric_limits<T>::epsilon());
+    const typename O::V epsilonV = O::Set1(epsilon);
+
+    size_t i = 0;
+    for (; i + O::W <= n; i += O::W) {
+        if (!O::AllClose(O::Load(a + i), O::Load(b + i), epsilonV)) {
+            return false;
+        }
+    }
+    for (; i < n; ++i)
+    {
+        const S ai = a[i];
+        const S bi = b[i];
+        if (!(std::fabs(ai - bi) < epsilon * std::max({ static_cast<S>(1), std::fabs(ai), std::fabs(bi) }))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename T> void
+widen(const T* a, typename Ops<T>::S* out, size_t n)
+{
+    using O = Ops<T>;
+
+    size_t i = 0;
+    for (; i + O::W <= n; i += O::W) {
+        O::Store(out + i, O::Load(a + i));
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i];
+    }
+}
+
+template<typename T, size_t MR, size_t NV> void
+microKernel(size_t kc, const T* a, Gemm::Strides as, const T* b, size_t bRowStride, T* tile)
+{
+    using O = Ops<T>;
+    constexpr size_t NR = NV * O::W;
+
+    typename O::V acc[MR][NV];
+    for (size_t i = 0; i < MR; ++i) {
+        for (size_t j = 0; j < NV; ++j) {
+            acc[i][j] = O::Zero();
+        }
+    }
+
+    for (size_t p = 0; p < kc; ++p)
+    {
+        const T* ap = a + p * as.Col;
+        const T* bp = b + p * bRowStride;
+
+        typename O::V bv[NV];
+        for (size_t j = 0; j < NV; ++j) {
+            bv[j] = O::Load(bp + j * O::W);
+        }
+
+        for (size_t i = 0; i < MR; ++i)
+        {
+            const typename O::V ai = O::Set1(ap[i * as.Row]);
+            for (size_t j = 0; j < NV; ++j) {
+                acc[i][j] = O::MulAdd(ai, bv[j], acc[i][j]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        for (size_t j = 0; j < NV; ++j) {
+            O::Store(tile + i * NR + j * O::W, acc[i][j]);
+        }
+    }
+}
@@ -0,0 +1,635 @@
+#include "SparseMatrix.hpp"
+#include "Math.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+namespace
+{
+    /// @brief Returns true if the value is stored in a sparse matrix built with the tolerance.
+    ///        NaN values are stored.
+    template<typename T> bool
+    isStored(T value, T tolerance)
+    {
+        if constexpr (std::is_unsigned<T>()) {
+            return value > tolerance;
+        } else {
+            return !(value <= tolerance && value >= -tolerance);
+        }
+    }
+
+    /// @brief Marks columns that are not yet part of a row of a product.
+    constexpr size_t NOT_MARKED = static_cast<size_t>(-1);
+
+} // end anonymous namespace
+
+
+/****************************************
+ * Constructors
+ ****************************************/
+template<class T>
+SparseMatrix<T>::SparseMatrix(size_t rows, size_t columns, Format format)
+    : _rows(rows)
+    , _columns(columns)
+    , _format(format)
+    , _offsets(lines() + 1, 0)
+{
+    //
+}
+
+template<class T>
+SparseMatrix<T>::SparseMatrix(
+    size_t rows,
+    size_t columns,
+    std::vector<size_t> offsets,
+    std::vector<size_t> indices,
+    std::vector<T> values,
+    Format format)
+    : _rows(rows)
+    , _columns(columns)
+    , _format(format)
+    , _offsets(std::move(offsets))
+    , _indices(std::move(indices))
+    , _values(std::move(values))
+{
+    validate();
+}
+
+template<class T>
+SparseMatrix<T>::SparseMatrix(const Matrix<T>& dense, Format format, T tolerance)
+    : SparseMatrix(dense.GetHeight(), dense.GetWidth(), format)
+{
+    const T* data = dense._data.get();
+    const Gemm::Strides strides = dense.getStrides();
+    const size_t lineStride    = _format == Format::CSR ? strides.Row : strides.Col;
+    const size_t elementStride = _format == Format::CSR ? strides.Col : strides.Row;
+    const size_t length = lineLength();
+    const size_t minLines = std::max<size_t>(Matrix<T>::MIN_OPERATIONS_PER_THREAD / std::max<size_t>(length, 1), 1);
+
+    // Count the stored elements of every line first, then fill the lines in parallel.
+    ThreadPool::ParallelFor(lines(), minLines, [&](size_t line, size_t endLine) {
+        for (; line < endLine; ++line)
+        {
+            size_t count = 0;
+            for (size_t i = 0; i < length; ++i) {
+                count += isStored(data[line * lineStride + i * elementStride], tolerance) ? size_t(1) : size_t(0);
+            }
+            _offsets[line + 1] = count;
+        }
+    });
+
+    for (size_t line = 0; line < lines(); ++line) {
+        _offsets[line + 1] += _offsets[line];
+    }
+
+    _indices.resize(_offsets.back());
+    _values.resize(_offsets.back());
+
+    ThreadPool::ParallelFor(lines(), minLines, [&](size_t line, size_t endLine) {
+        for (; line < endLine; ++line)
+        {
+            size_t pos = _offsets[line];
+            for (size_t i = 0; i < length; ++i)
+            {
+                const T value = data[line * lineStride + i * elementStride];
+                if (isStored(value, tolerance)) {
+                    _indices[pos] = i;
+                    _values[pos] = value;
+                    ++pos;
+                }
+            }
+        }
+    });
+}
+
+template<class T> SparseMatrix<T>
+SparseMatrix<T>::FromTriplets(size_t rows, size_t columns, std::vector<Triplet> triplets, Format format)
+{ // static function
+    for (const Triplet& t : triplets)
+    {
+        if (t.Row >= rows || t.Column >= columns) {
+            throw std::out_of_range("Element (" + std::to_string(t.Row) + ", " + std::to_string(t.Column) +
+                                    ") is outside of the " + std::to_string(rows) + "X" + std::to_string(columns) + " matrix.");
+        }
+    }
+
+    const auto lineOf  = [format](const Triplet& t) { return format == Format::CSR ? t.Row : t.Column; };
+    const auto indexOf = [format](const Triplet& t) { return format == Format::CSR ? t.Column : t.Row; };
+
+    std::sort(triplets.begin(), triplets.end(), [&lineOf, &indexOf](const Triplet& lhs, const Triplet& rhs) {
+        return std::make_pair(lineOf(lhs), indexOf(lhs)) < std::make_pair(lineOf(rhs), indexOf(rhs));
+    });
+
+    SparseMatrix result(rows, columns, format);
+    result._indices.reserve(triplets.size());
+    result._values.reserve(triplets.size());
+
+    for (size_t i = 0; i < triplets.size(); ++i)
+    {
+        const Triplet& t = triplets[i];
+        if (i > 0 && lineOf(t) == lineOf(triplets[i - 1]) && indexOf(t) == indexOf(triplets[i - 1])) {
+            result._values.back() += t.Value;
+            continue;
+        }
+
+        result._indices.push_back(indexOf(t));
+        result._values.push_back(t.Value);
+        ++result._offsets[lineOf(t) + 1];
+    }
+
+    for (size_t line = 0; line < result.lines(); ++line) {
+        result._offsets[line + 1] += result._offsets[line];
+    }
+
+    return result;
+}
+
+
+/****************************************
+ * Getters
+ ****************************************/
+template<class T> size_t
+SparseMatrix<T>::GetWidth() const
+{
+    return _columns;
+}
+
+template<class T> size_t
+SparseMatrix<T>::GetHeight() const
+{
+    return _rows;
+}
+
+template<class T> size_t
+SparseMatrix<T>::GetNonZeros() const
+{
+    return _values.size();
+}
+
+template<class T> typename SparseMatrix<T>::Format
+SparseMatrix<T>::GetFormat() const
+{
+    return _format;
+}
+
+template<class T> const std::vector<size_t>&
+SparseMatrix<T>::GetOffsets() const
+{
+    return _offsets;
+}
+
+template<class T> const std::vector<size_t>&
+SparseMatrix<T>::GetIndices() const
+{
+    return _indices;
+}
+
+template<class T> const std::vector<T>&
+SparseMatrix<T>::GetValues() const
+{
+    return _values;
+}
+
+template<class T> T
+SparseMatrix<T>::At(size_t row, size_t col) const
+{
+    if (row >= _rows || col >= _columns) {
+        throw std::out_of_range("Element (" + std::to_string(row) + ", " + std::to_string(col) +
+                                ") is outside of the " + std::to_string(_rows) + "X" + std::to_string(_columns) + " matrix.");
+    }
+
+    const size_t line  = _format == Format::CSR ? row : col;
+    const size_t index = _format == Format::CSR ? col : row;
+
+    const auto begin = _indices.begin() + static_cast<std::ptrdiff_t>(_offsets[line]);
+    const auto end   = _indices.begin() + static_cast<std::ptrdiff_t>(_offsets[line + 1]);
+    const auto it = std::lower_bound(begin, end, index);
+
+    return it != end && *it == index ? _values[static_cast<size_t>(it - _indices.begin())] : static_cast<T>(0);
+}
+
+
+/****************************************
+ * Conversions
+ ****************************************/
+template<class T> Matrix<T>
+SparseMatrix<T>::ToDense(typename Matrix<T>::Ordering ordering) const
+{
+    Matrix<T> result(_rows, _columns, ordering);
+
+    T* data = result._data.get();
+    const Gemm::Strides strides = result.getStrides();
+    const size_t lineStride    = _format == Format::CSR ? strides.Row : strides.Col;
+    const size_t elementStride = _format == Format::CSR ? strides.Col : strides.Row;
+
+    // Every line writes to its own row or column of the result.
+    forLines(1, [&](size_t line, size_t endLine) {
+        for (; line < endLine; ++line) {
+            for (size_t p = _offsets[line]; p < _offsets[line + 1]; ++p) {
+                data[line * lineStride + _indices[p] * elementStride] = _values[p];
+            }
+        }
+    });
+
+    return result;
+}
+
+template<class T> SparseMatrix<T>
+SparseMatrix<T>::ToFormat(Format format) const
+{
+    if (format == _format) {
+        return *this;
+    }
+
+    // The lines of the result are the indices of this matrix: counting sort of the nonzeros by index.
+    SparseMatrix result(_rows, _columns, format);
+    for (size_t index : _indices) {
+        ++result._offsets[index + 1];
+    }
+    for (size_t line = 0; line < result.lines(); ++line) {
+        result._offsets[line + 1] += result._offsets[line];
+    }
+
+    result._indices.resize(GetNonZeros());
+    result._values.resize(GetNonZeros());
+
+    std::vector<size_t> next(result._offsets.begin(), result._offsets.end() - 1);
+    for (size_t line = 0; line < lines(); ++line)
+    {
+        for (size_t p = _offsets[line]; p < _offsets[line + 1]; ++p)
+        {
+            const size_t pos = next[_indices[p]]++;
+            result._indices[pos] = line;
+            result._values[pos] = _values[p];
+        }
+    }
+
+    return result;
+}
+
+template<class T> SparseMatrix<T>
+SparseMatrix<T>::Transpose() const
+{
+    SparseMatrix result(_columns, _rows, _format == Format::CSR ? Format::CSC : Format::CSR);
+    result._offsets = _offsets;
+    result._indices = _indices;
+    result._values  = _values;
+    return result;
+}
+
+
+/****************************************
+ * Arithmetic
+ ****************************************/
+template<class T> Matrix<T>
+SparseMatrix<T>::Multiply(const Matrix<T>& rhs) const
+{
+    if (GetWidth() != rhs.GetHeight()) {
+        throw std::invalid_argument("Mismatching matrix dimensions for multiplication.");
+    }
+
+    if (_format == Format::CSC) {
+        return ToFormat(Format::CSR).Multiply(rhs);
+    }
+
+    // Shorter rows of rhs are cheaper to add up element by element than with the vector kernels.
+    constexpr size_t MIN_AXPY_LENGTH = 16;
+
+    const size_t width = rhs.GetWidth();
+    Matrix<T> result(_rows, width, Matrix<T>::uninitialized(_rows * width), rhs.GetOrdering());
+
+    const T* b = rhs._data.get();
+    const Gemm::Strides bs = rhs.getStrides();
+    T* c = result._data.get();
+    const Gemm::Strides cs = result.getStrides();
+
+    forLines(width, [&](size_t row, size_t endRow)
+    {
+        if (bs.Col == 1 && width >= MIN_AXPY_LENGTH)
+        { // The rows of the result are sums of scaled rows of rhs.
+            const Simd::Kernels<T>& kernels = Simd::GetKernels<T>();
+            for (; row < endRow; ++row)
+            {
+                T* out = c + row * cs.Row;
+                std::fill(out, out + width, static_cast<T>(0));
+                for (size_t p = _offsets[row]; p < _offsets[row + 1]; ++p) {
+                    kernels.Axpy(_values[p], b + _indices[p] * bs.Row, out, width);
+                }
+            }
+        }
+        else
+        { // Sparse dot products of the rows with every column of rhs, one column at a time.
+            for (size_t j = 0; j < width; ++j) {
+                for (size_t r = row; r < endRow; ++r)
+                {
+                    T sum = static_cast<T>(0);
+                    for (size_t p = _offsets[r]; p < _offsets[r + 1]; ++p) {
+                        sum += _values[p] * b[_indices[p] * bs.Row + j * bs.Col];
+                    }
+                    c[r * cs.Row + j * cs.Col] = sum;
+                }
+            }
+        }
+    });
+
+    return result;
+}
+
+template<class T> SparseMatrix<T>
+SparseMatrix<T>::Multiply(const SparseMatrix& rhs) const
+{
+    if (GetWidth() != rhs.GetHeight()) {
+        throw std::invalid_argument("Mismatching matrix dimensions for multiplication.");
+    }
+
+    std::optional<SparseMatrix> lhsConverted;
+    std::optional<SparseMatrix> rhsConverted;
+    const SparseMatrix& a = _format == Format::CSR ? *this : lhsConverted.emplace(ToFormat(Format::CSR));
+    const SparseMatrix& b = rhs._format == Format::CSR ? rhs : rhsConverted.emplace(rhs.ToFormat(Format::CSR));
+
+    const size_t width = b._columns;
+    const size_t operationsPerNonZero = b.GetNonZeros() / std::max<size_t>(b._rows, 1) + 1;
+
+    SparseMatrix result(a._rows, width, Format::CSR);
+
+    // Symbolic pass: the amount of distinct columns reached from every row of a.
+    a.forLines(operationsPerNonZero, [&a, &b, &result, width](size_t row, size_t endRow)
+    {
+        std::vector<size_t> marks(width, NOT_MARKED);
+        for (; row < endRow; ++row)
+        {
+            size_t count = 0;
+            for (size_t p = a._offsets[row]; p < a._offsets[row + 1]; ++p)
+            {
+                const size_t k = a._indices[p];
+                for (size_t q = b._offsets[k]; q < b._offsets[k + 1]; ++q)
+                {
+                    if (marks[b._indices[q]] != row) {
+                        marks[b._indices[q]] = row;
+                        ++count;
+                    }
+                }
+            }
+            result._offsets[row + 1] = count;
+        }
+    });
+
+    for (size_t row = 0; row < result._rows; ++row) {
+        result._offsets[row + 1] += result._offsets[row];
+    }
+
+    result._indices.resize(result._offsets.back());
+    result._values.resize(result._offsets.back());
+
+    // Numeric pass: accumulate every row in a dense row, then gather it in increasing column order.
+    a.forLines(operationsPerNonZero, [&a, &b, &result, width](size_t row, size_t endRow)
+    {
+        std::vector<size_t> marks(width, NOT_MARKED);
+        std::vector<T> accumulator(width);
+
+        for (; row < endRow; ++row)
+        {
+            const size_t begin = result._offsets[row];
+            size_t end = begin;
+
+            for (size_t p = a._offsets[row]; p < a._offsets[row + 1]; ++p)
+            {
+                const size_t k = a._indices[p];
+                const T value = a._values[p];
+                for (size_t q = b._offsets[k]; q < b._offsets[k + 1]; ++q)
+                {
+                    const size_t col = b._indices[q];
+                    if (marks[col] != row) {
+                        marks[col] = row;
+                        accumulator[col] = value * b._values[q];
+                        result._indices[end++] = col;
+                    } else {
+                        accumulator[col] += value * b._values[q];
+                    }
+                }
+            }
+
+            const auto first = result._indices.begin() + static_cast<std::ptrdiff_t>(begin);
+            std::sort(first, first + static_cast<std::ptrdiff_t>(end - begin));
+            for (size_t pos = begin; pos < end; ++pos) {
+                result._values[pos] = accumulator[result._indices[pos]];
+            }
+        }
+    });
+
+    return _format == Format::CSR ? result : result.ToFormat(_format);
+}
+
+template<class T> Matrix<T>
+SparseMatrix<T>::MultiplyLeft(const Matrix<T>& lhs) const
+{
+    if (lhs.GetWidth() != GetHeight()) {
+        throw std::invalid_argument("Mismatching matrix dimensions for multiplication.");
+    }
+
+    const size_t height = lhs.GetHeight();
+    const size_t width  = _columns;
+
+    Matrix<T> result(height, width);
+
+    const T* a = lhs._data.get();
+    const Gemm::Strides as = lhs.getStrides();
+    T* c = result._data.get();
+
+    if (_format == Format::CSR)
+    { // Row i of the result is the sum of the rows of this matrix, scaled by the elements of row i of lhs.
+        const size_t minRows = std::max<size_t>(Matrix<T>::MIN_OPERATIONS_PER_THREAD / std::max<size_t>(GetNonZeros(), 1), 1);
+        ThreadPool::ParallelFor(height, minRows, [&](size_t row, size_t endRow) {
+            for (; row < endRow; ++row)
+            {
+                T* out = c + row * width;
+                for (size_t k = 0; k < _rows; ++k)
+                {
+                    const T factor = a[row * as.Row + k * as.Col];
+                    if (factor == static_cast<T>(0)) {
+                        continue;
+                    }
+                    for (size_t p = _offsets[k]; p < _offsets[k + 1]; ++p) {
+                        out[_indices[p]] += factor * _values[p];
+                    }
+                }
+            }
+        });
+    }
+    else
+    { // Element (i, j) of the result is the sparse dot product of row i of lhs and column j of this matrix.
+        forLines(height, [&](size_t col, size_t endCol) {
+            for (size_t row = 0; row < height; ++row) {
+                for (size_t j = col; j < endCol; ++j)
+                {
+                    T sum = static_cast<T>(0);
+                    for (size_t p = _offsets[j]; p < _offsets[j + 1]; ++p) {
+                        sum += a[row * as.Row + _indices[p] * as.Col] * _values[p];
+                    }
+                    c[row * width + j] = sum;
+                }
+            }
+        });
+    }
+
+    return result;
+}
+
+template<class T> bool
+SparseMatrix<T>::Equals(const SparseMatrix& rhs) const
+{
+    if (_rows != rhs._rows || _columns != rhs._columns) {
+        return false;
+    }
+
+    if (_format != rhs._format) {
+        return Equals(rhs.ToFormat(_format));
+    }
+
+    // Same tolerance as for dense matrices, see Matrix::Equals.
+    constexpr T realTEpsilonFactor = static_cast<T>(3);
+
+    // Merge the indices of every line, elements missing on one side are zero.
+    for (size_t line = 0; line < lines(); ++line)
+    {
+        size_t p = _offsets[line];
+        size_t q = rhs._offsets[line];
+        while (p < _offsets[line + 1] || q < rhs._offsets[line + 1])
+        {
+            const size_t i = p < _offsets[line + 1]     ? _indices[p]     : NOT_MARKED;
+            const size_t j = q < rhs._offsets[line + 1] ? rhs._indices[q] : NOT_MARKED;
+
+            const T lhsValue = i <= j ? _values[p++]     : static_cast<T>(0);
+            const T rhsValue = j <= i ? rhs._values[q++] : static_cast<T>(0);
+
+            if (!Math::AreEqual(lhsValue, rhsValue, realTEpsilonFactor)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+/****************************************
+ * Private functions
+ ****************************************/
+template<class T> size_t
+SparseMatrix<T>::lines() const
+{
+    return _format == Format::CSR ? _rows : _columns;
+}
+
+template<class T> size_t
+SparseMatrix<T>::lineLength() const
+{
+    return _format == Format::CSR ? _columns : _rows;
+}
+
+template<class T>
+template<typename F> void
+SparseMatrix<T>::forLines(size_t operationsPerNonZero, const F& func) const
+{
+    // Every line and every nonzero is one unit of work, line l starts at unit _offsets[l] + l.
+    const size_t count = lines();
+    const size_t total = _offsets.back() + count;
+    const size_t minSliceLength = std::max<size_t>(Matrix<T>::MIN_OPERATIONS_PER_THREAD / std::max<size_t>(operationsPerNonZero, 1), 1);
+
+    // Returns the first line that starts at or after the unit.
+    const auto lineAt = [this, count, total](size_t unit)
+    {
+        if (unit >= total) {
+            return count;
+        }
+
+        size_t lo = 0;
+        size_t hi = count;
+        while (lo < hi)
+        {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (_offsets[mid] + mid < unit) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    };
+
+    ThreadPool::ParallelFor(total, minSliceLength, [&func, &lineAt](size_t begin, size_t end)
+    {
+        const size_t line    = lineAt(begin);
+        const size_t endLine = lineAt(end);
+        if (line < endLine) {
+            func(line, endLine);
+        }
+    });
+}
+
+template<class T> void
+SparseMatrix<T>::validate() const
+{
+    if (_offsets.size() != lines() + 1 || _offsets.front() != 0) {
+        throw std::invalid_argument("The offsets of a sparse matrix must start with zero and hold one element more than the matrix has lines.");
+    }
+    if (_offsets.back() != _indices.size() || _indices.size() != _values.size()) {
+        throw std::invalid_argument("The last offset of a sparse matrix must equal the amount of indices and values.");
+    }
+
+    for (size_t line = 0; line < lines(); ++line)
+    {
+        if (_offsets[line] > _offsets[line + 1]) {
+            throw std::invalid_argument("The offsets of a sparse matrix must be nondecreasing.");
+        }
+
+        for (size_t p = _offsets[line]; p < _offsets[line + 1]; ++p)
+        {
+            if (_indices[p] >= lineLength() || (p > _offsets[line] && _indices[p] <= _indices[p - 1])) {
+                throw std::invalid_argument("The indices of every line of a sparse matrix must be strictly increasing and within the matrix, line: " + std::to_string(line));
+            }
+        }
+    }
+}
+
+
+/****************************************
+ * Friend functions
+ ****************************************/
+template<typename T>
+std::ostream& operator<<(std::ostream& out, const SparseMatrix<T>& mat)
+{
+    const bool csr = mat.GetFormat() == SparseMatrix<T>::Format::CSR;
+
+    out << "| " << (csr ? "CSR" : "CSC") << " SparseMatrix of height X width: " << mat.GetHeight() << 'X' << mat.GetWidth()
+        << " with " << mat.GetNonZeros() << " nonzeros |\n";
+
+    for (size_t line = 0; line < mat.lines(); ++line)
+    {
+        for (size_t p = mat._offsets[line]; p < mat._offsets[line + 1]; ++p)
+        {
+            const size_t row = csr ? line : mat._indices[p];
+            const size_t col = csr ? mat._indices[p] : line;
+            out << "| (" << row << ", " << col << ") " << mat._values[p] << '\n';
+        }
+    }
+
+    return out;
+}
+
+template class SparseMatrix<int>;
+template class SparseMatrix<size_t>;
+template class SparseMatrix<float>;
+template class SparseMatrix<double>;
+
+template typename std::ostream& operator<<(std::ostream& out, const SparseMatrix<int>& mat);
+template typename std::ostream& operator<<(std::ostream& out, const SparseMatrix<size_t>& mat);
+template typename std::ostream& operator<<(std::ostream& out, const SparseMatrix<float>& mat);
+template typename std::ostream& operator<<(std::ostream& out, const SparseMatrix<double>& mat);
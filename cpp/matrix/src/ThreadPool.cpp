@@ -94,6 +94,12 @@ ThreadPool::GetThreadsCount()
     return s_threadsCount;
 }
 
+bool
+ThreadPool::IsWorkerThread()
+{ // static function
+    return s_isWorkerThread;
+}
+
 
 /****************************************
  * ThreadPool Private methods
@@ -101,6 +107,8 @@ ThreadPool::GetThreadsCount()
 void
 ThreadPool::threadLoop()
 { // static function
+    s_isWorkerThread = true;
+
     while (true)
     {
         std::function<void()> task;
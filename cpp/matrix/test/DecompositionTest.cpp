@@ -0,0 +1,306 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "Decomposition.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace
+{
+    template<typename T>
+    T MaxAbsDifference(const Matrix<T>& lhs, const Matrix<T>& rhs)
+    {
+        T difference = 0;
+        for (size_t i = 0; i < lhs.GetHeight(); ++i) {
+            for (size_t j = 0; j < lhs.GetWidth(); ++j) {
+                difference = std::max(difference, std::abs(lhs[i][j] - rhs[i][j]));
+            }
+        }
+        return difference;
+    }
+
+    /// @brief Returns the rows of the matrix exchanged like in the factorization, P * A.
+    template<typename T>
+    Matrix<T> Permute(Matrix<T> matrix, const std::vector<size_t>& pivots)
+    {
+        for (size_t i = 0; i < pivots.size(); ++i) {
+            for (size_t j = 0; j < matrix.GetWidth(); ++j) {
+                std::swap(matrix[i][j], matrix[pivots[i]][j]);
+            }
+        }
+        return matrix;
+    }
+
+    /// @brief A tolerance for errors of order n * u in results of magnitude one.
+    template<typename T>
+    T Tolerance(size_t n)
+    {
+        return static_cast<T>(n) * std::numeric_limits<T>::epsilon() * static_cast<T>(16);
+    }
+
+} // end anonymous namespace
+
+
+template<typename T>
+class DecompositionTest : public ::testing::Test
+{
+};
+
+using FloatingTypes = ::testing::Types<float, double>;
+TYPED_TEST_SUITE(DecompositionTest, FloatingTypes);
+
+
+TYPED_TEST(DecompositionTest, FactorsReproduceThePermutedMatrix)
+{
+    using T = TypeParam;
+
+    // Spans several panels and leaves of the recursion, with a partial last panel.
+    for (size_t n : { size_t(1), size_t(17), size_t(300) })
+    {
+        const Matrix<T> A = Matrix<T>::Random(n, n, static_cast<T>(-1), static_cast<T>(1), n, Matrix<T>::Ordering::ColumnMajor);
+        const LuDecomposition<T> lu(A);
+        ASSERT_EQ(lu.GetSize(), n);
+        EXPECT_FALSE(lu.IsSingular());
+
+        const Matrix<T> L = lu.GetLower();
+        const Matrix<T> U = lu.GetUpper();
+        for (size_t i = 0; i < n; ++i)
+        {
+            EXPECT_GE(lu.GetPivots()[i], i);
+            EXPECT_EQ(L[i][i], static_cast<T>(1));
+            for (size_t j = 0; j < i; ++j) {
+                // Partial pivoting bounds the multipliers by one.
+                EXPECT_LE(std::abs(L[i][j]), static_cast<T>(1));
+                EXPECT_EQ(U[i][j], static_cast<T>(0));
+            }
+        }
+
+        EXPECT_LE(MaxAbsDifference(Matrix<T>(L * U), Permute(A, lu.GetPivots())), Tolerance<T>(n) * static_cast<T>(n)) << n;
+    }
+}
+
+TYPED_TEST(DecompositionTest, SolvesManyRightHandSides)
+{
+    using T = TypeParam;
+    constexpr size_t N = 257;
+
+    const Matrix<T> A = Matrix<T>::Random(N, N, static_cast<T>(-1), static_cast<T>(1), 11);
+    const Matrix<T> B = Matrix<T>::Random(N, 40, static_cast<T>(-1), static_cast<T>(1), 12, Matrix<T>::Ordering::ColumnMajor);
+    const Matrix<T> b = Matrix<T>::Random(N, 1, static_cast<T>(-1), static_cast<T>(1), 13);
+
+    const LuDecomposition<T> lu(A);
+    const Matrix<T> X = lu.Solve(B);
+    const Matrix<T> x = lu.Solve(b);
+    ASSERT_EQ(X.GetHeight(), N);
+    ASSERT_EQ(X.GetWidth(), 40u);
+    EXPECT_EQ(X.GetOrdering(), Matrix<T>::Ordering::RowMajor);
+
+    // Backward stable: the residuals are small relative to |A| |X|.
+    T scale = 0;
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = 0; j < X.GetWidth(); ++j) {
+            scale = std::max(scale, std::abs(X[i][j]));
+        }
+    }
+    EXPECT_LE(MaxAbsDifference(Matrix<T>(A * X), B), Tolerance<T>(N) * scale * static_cast<T>(N));
+    EXPECT_LE(MaxAbsDifference(Matrix<T>(A * x), b), Tolerance<T>(N) * scale * static_cast<T>(N));
+
+    // Every column is solved like on its own.
+    const Matrix<T> column = Solve(A, Matrix<T>(X.Column(7)));
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_NEAR(static_cast<double>(Matrix<T>(A * column)[i][0]), static_cast<double>(X[i][7]), static_cast<double>(Tolerance<T>(N) * scale * static_cast<T>(N)));
+    }
+}
+
+TYPED_TEST(DecompositionTest, InverseInParallel)
+{
+    using T = TypeParam;
+    constexpr size_t N = 300;
+
+    // Diagonally dominant, so that the inverse is well conditioned.
+    Matrix<T> A = Matrix<T>::Random(N, N, static_cast<T>(-1), static_cast<T>(1), 21);
+    for (size_t i = 0; i < N; ++i) {
+        A[i][i] += static_cast<T>(N);
+    }
+
+    const Matrix<T> serial = A.Inverse();
+
+    ThreadPool::Start(3);
+    const Matrix<T> parallel = A.Inverse();
+    const T determinant = A.Determinant();
+    ThreadPool::Stop();
+
+    const Matrix<T> I = Matrix<T>::ID(N);
+    EXPECT_LE(MaxAbsDifference(Matrix<T>(A * serial), I), Tolerance<T>(N));
+    EXPECT_LE(MaxAbsDifference(Matrix<T>(A * parallel), I), Tolerance<T>(N));
+    EXPECT_LE(MaxAbsDifference(parallel, serial), Tolerance<T>(N) / static_cast<T>(N));
+    EXPECT_GT(determinant, static_cast<T>(0));
+}
+
+TYPED_TEST(DecompositionTest, Determinant)
+{
+    using T = TypeParam;
+
+    EXPECT_EQ(Matrix<T>({ { 3 } }).Determinant(), static_cast<T>(3));
+    EXPECT_NEAR(static_cast<double>(Matrix<T>({ { 1, 2 }, { 3, 4 } }).Determinant()), -2.0, 1e-5);
+    EXPECT_EQ(Matrix<T>({ { 0, 1 }, { 1, 0 } }).Determinant(), static_cast<T>(-1));
+    EXPECT_EQ(Matrix<T>::ID(200).Determinant(), static_cast<T>(1));
+    EXPECT_EQ(Matrix<T>(0, 0).Determinant(), static_cast<T>(1));
+
+    const Matrix<T> A({ { 2, -1, 0 }, { -1, 2, -1 }, { 0, -1, 2 } }, Matrix<T>::Ordering::ColumnMajor);
+    EXPECT_NEAR(static_cast<double>(A.Determinant()), 4.0, 1e-5);
+
+    // det(A * B) = det(A) * det(B), small enough for the determinants to stay in the range of float.
+    const Matrix<T> B = Matrix<T>::Random(40, 40, static_cast<T>(-1), static_cast<T>(1), 31);
+    const Matrix<T> C = Matrix<T>::Random(40, 40, static_cast<T>(-1), static_cast<T>(1), 32);
+    const double product = static_cast<double>(Matrix<T>(B * C).Determinant());
+    EXPECT_NEAR(product / (static_cast<double>(B.Determinant()) * static_cast<double>(C.Determinant())), 1.0,
+                static_cast<double>(Tolerance<T>(40)) * 40.0);
+}
+
+TYPED_TEST(DecompositionTest, SingularMatrices)
+{
+    using T = TypeParam;
+
+    // The third row is the sum of the first two.
+    const Matrix<T> A({ { 1, 2, 3 }, { 4, 5, 6 }, { 5, 7, 9 } });
+    Matrix<T> zeroColumn = Matrix<T>::Random(200, 200, static_cast<T>(-1), static_cast<T>(1), 41);
+    for (size_t i = 0; i < 200; ++i) {
+        zeroColumn[i][150] = 0;
+    }
+
+    for (const Matrix<T>* matrix : { &A, static_cast<const Matrix<T>*>(&zeroColumn) })
+    {
+        const LuDecomposition<T> lu(*matrix);
+        if (matrix == &zeroColumn) {
+            EXPECT_TRUE(lu.IsSingular());
+        }
+        if (lu.IsSingular())
+        {
+            EXPECT_EQ(lu.Determinant(), static_cast<T>(0));
+            EXPECT_THROW(lu.Solve(Matrix<T>(matrix->GetHeight(), 1)), std::runtime_error);
+            EXPECT_THROW(matrix->Inverse(), std::runtime_error);
+        }
+        else {
+            // Rounding may leave a tiny pivot instead of zero.
+            EXPECT_NEAR(static_cast<double>(lu.Determinant()), 0.0, 1e-5);
+        }
+
+        const Matrix<T> L = lu.GetLower();
+        const Matrix<T> U = lu.GetUpper();
+        EXPECT_LE(MaxAbsDifference(Matrix<T>(L * U), Permute(*matrix, lu.GetPivots())), Tolerance<T>(200) * static_cast<T>(200));
+    }
+}
+
+TYPED_TEST(DecompositionTest, InvalidDimensions)
+{
+    using T = TypeParam;
+
+    EXPECT_THROW(LuDecomposition<T>(Matrix<T>(3, 4)), std::invalid_argument);
+    EXPECT_THROW(Matrix<T>(4, 3).Inverse(), std::invalid_argument);
+    EXPECT_THROW(Matrix<T>(4, 3).Determinant(), std::invalid_argument);
+    EXPECT_THROW(Solve(Matrix<T>::ID(3), Matrix<T>(4, 1)), std::invalid_argument);
+
+    EXPECT_EQ(Solve(Matrix<T>::ID(3), Matrix<T>(3, 0)).GetWidth(), 0u);
+    EXPECT_EQ(Matrix<T>(0, 0).Inverse().GetHeight(), 0u);
+}
+
+TYPED_TEST(DecompositionTest, QrFactorsReproduceTheMatrix)
+{
+    using T = TypeParam;
+
+    // Tall, square and wide, spanning several panels and leaves of the recursion.
+    for (const auto& [m, n] : { std::pair<size_t, size_t>(300, 150), { 70, 70 }, { 50, 120 }, { 1, 1 } })
+    {
+        const Matrix<T> A = Matrix<T>::Random(m, n, static_cast<T>(-1), static_cast<T>(1), m + n, Matrix<T>::Ordering::ColumnMajor);
+        const QrDecomposition<T> qr(A);
+        const size_t p = std::min(m, n);
+        EXPECT_FALSE(qr.IsRankDeficient());
+
+        const Matrix<T> Q = qr.GetQ();
+        const Matrix<T> R = qr.GetR();
+        ASSERT_EQ(Q.GetHeight(), m);
+        ASSERT_EQ(Q.GetWidth(), p);
+        ASSERT_EQ(R.GetHeight(), p);
+        ASSERT_EQ(R.GetWidth(), n);
+
+        for (size_t i = 0; i < p; ++i)
+        {
+            EXPECT_GE(R[i][i], static_cast<T>(0));
+            for (size_t j = 0; j < i; ++j) {
+                EXPECT_EQ(R[i][j], static_cast<T>(0));
+            }
+        }
+
+        EXPECT_LE(MaxAbsDifference(Matrix<T>(Q * R), A), Tolerance<T>(m) * static_cast<T>(4)) << m << 'X' << n;
+        EXPECT_LE(MaxAbsDifference(Matrix<T>(Q.Transpose() * Q), Matrix<T>::ID(p)), Tolerance<T>(m)) << m << 'X' << n;
+
+        // Q and Q^T are inverse of each other.
+        const Matrix<T> B = Matrix<T>::Random(m, 3, static_cast<T>(-1), static_cast<T>(1), 5);
+        EXPECT_LE(MaxAbsDifference(qr.MultiplyQ(qr.MultiplyQTranspose(B)), B), Tolerance<T>(m)) << m << 'X' << n;
+    }
+}
+
+TYPED_TEST(DecompositionTest, LeastSquares)
+{
+    using T = TypeParam;
+    constexpr size_t M = 9000;
+    constexpr size_t N = 20;
+
+    // Several blocks of rows, factored by three threads.
+    const Matrix<T> A = Matrix<T>::Random(M, N, static_cast<T>(-1), static_cast<T>(1), 51);
+    const Matrix<T> B = Matrix<T>::Random(M, 2, static_cast<T>(-1), static_cast<T>(1), 52, Matrix<T>::Ordering::ColumnMajor);
+    ASSERT_GE(M / std::max(QrDecomposition<T>::TALL_SKINNY_ROWS * (N + 2), QrDecomposition<T>::MIN_TALL_SKINNY_ROWS), 2u);
+
+    const QrDecomposition<T> qr(A);
+    const Matrix<T> X = qr.Solve(B);
+
+    ThreadPool::Start(3);
+    const Matrix<T> tallSkinny = LeastSquares(A, B);
+    const Matrix<T> R = QrDecomposition<T>::TallSkinnyR(A);
+    ThreadPool::Stop();
+
+    ASSERT_EQ(X.GetHeight(), N);
+    ASSERT_EQ(X.GetWidth(), 2u);
+
+    // The residual is orthogonal to the columns of A.
+    const Matrix<T> residual = A * X - B;
+    EXPECT_LE(MaxAbsDifference(Matrix<T>(A.Transpose() * residual), Matrix<T>(N, 2)), Tolerance<T>(M) * static_cast<T>(4));
+
+    // R is unique with a non-negative diagonal, so the tall-skinny factorization agrees.
+    EXPECT_LE(MaxAbsDifference(tallSkinny, X), Tolerance<T>(M) / static_cast<T>(16));
+    EXPECT_LE(MaxAbsDifference(R, qr.GetR()), Tolerance<T>(M) * static_cast<T>(4));
+}
+
+TYPED_TEST(DecompositionTest, QrOfRankDeficientMatrices)
+{
+    using T = TypeParam;
+
+    Matrix<T> A = Matrix<T>::Random(100, 10, static_cast<T>(-1), static_cast<T>(1), 61);
+    for (size_t i = 0; i < A.GetHeight(); ++i) {
+        A[i][4] = 0;
+    }
+
+    const QrDecomposition<T> qr(A);
+    EXPECT_TRUE(qr.IsRankDeficient());
+    EXPECT_LE(MaxAbsDifference(Matrix<T>(qr.GetQ() * qr.GetR()), A), Tolerance<T>(100));
+    EXPECT_THROW(qr.Solve(Matrix<T>(100, 1)), std::runtime_error);
+    EXPECT_THROW(LeastSquares(A, Matrix<T>(100, 1)), std::runtime_error);
+
+    EXPECT_THROW(qr.Solve(Matrix<T>(99, 1)), std::invalid_argument);
+    EXPECT_THROW(qr.MultiplyQ(Matrix<T>(99, 1)), std::invalid_argument);
+    EXPECT_THROW(QrDecomposition<T>(Matrix<T>(3, 5)).Solve(Matrix<T>(3, 1)), std::invalid_argument);
+    EXPECT_THROW(LeastSquares(Matrix<T>(3, 5), Matrix<T>(3, 1)), std::invalid_argument);
+
+    // Reduced columns with negative diagonals are reflected as well.
+    const QrDecomposition<T> diagonal(Matrix<T>({ { -2, 0 }, { 0, 3 }, { 0, 0 } }));
+    EXPECT_EQ(diagonal.GetR()[0][0], static_cast<T>(2));
+    EXPECT_EQ(diagonal.GetR()[1][1], static_cast<T>(3));
+    EXPECT_EQ(QrDecomposition<T>::TallSkinnyR(Matrix<T>(0, 4)).GetHeight(), 0u);
+}
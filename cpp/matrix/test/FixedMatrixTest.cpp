@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+#include "FixedMatrix.hpp"
+#include "Math.hpp"
+#include "Matrix.hpp"
+
+
+namespace
+{
+    // Evaluated at compile time: a 2D rotation by 90 degrees with a translation, in homogeneous coordinates.
+    constexpr FixedMatrix<int, 3, 3> ROTATE { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } };
+    constexpr FixedMatrix<int, 3, 3> TRANSLATE { { 1, 0, 5 }, { 0, 1, 7 }, { 0, 0, 1 } };
+    constexpr FixedMatrix<int, 3, 1> POINT { { 2 }, { 3 }, { 1 } };
+    constexpr FixedMatrix<int, 3, 1> MOVED = TRANSLATE * ROTATE * POINT;
+
+    static_assert(MOVED(0, 0) == 2 && MOVED(1, 0) == 9 && MOVED(2, 0) == 1);
+    static_assert((ROTATE * ROTATE.Transpose())(0, 0) == 1 && (ROTATE * ROTATE.Transpose())(1, 0) == 0);
+    static_assert((2 * FixedMatrix<int, 2, 2>::ID() - FixedMatrix<int, 2, 2>::ID())(1, 1) == 1);
+    static_assert(sizeof(FixedMatrix<double, 4, 4>) == 16 * sizeof(double));
+
+} // end anonymous namespace
+
+
+TEST(FixedMatrixTest, ArithmeticMatchesMatrix)
+{
+    const auto generator = std::bind(&Random::Fast<int>, -10, 10);
+
+    const Matrix<int> A = Matrix<int>::Random(3, 4, generator);
+    const Matrix<int> B = Matrix<int>::Random(4, 2, generator, Matrix<int>::Ordering::ColumnMajor);
+    const Matrix<int> C = Matrix<int>::Random(3, 4, generator);
+
+    const FixedMatrix<int, 3, 4> FIXED_A(A);
+    const FixedMatrix<int, 4, 2> FIXED_B(B);
+    const FixedMatrix<int, 3, 4> FIXED_C(C);
+
+    EXPECT_TRUE((FIXED_A * FIXED_B).ToMatrix() == A * B);
+    EXPECT_TRUE((FIXED_A + FIXED_C).ToMatrix() == A + C);
+    EXPECT_TRUE((FIXED_A - 3 * FIXED_C).ToMatrix(Matrix<int>::Ordering::ColumnMajor) == A - 3 * C);
+    EXPECT_TRUE(FIXED_A.Transpose().ToMatrix() == A.Transpose());
+
+    FixedMatrix<int, 3, 4> D = FIXED_A;
+    D += FIXED_C;
+    D *= 2;
+    D *= FixedMatrix<int, 4, 4>::ID();
+    EXPECT_TRUE(static_cast<Matrix<int>>(D) == 2 * (A + C));
+    EXPECT_TRUE((FixedMatrix<int, 2, 2>(A.Block(1, 1, 2, 2)) == FixedMatrix<int, 2, 2>({ { A[1][1], A[1][2] }, { A[2][1], A[2][2] } })));
+
+    EXPECT_THROW((FixedMatrix<int, 3, 3>(A)), std::invalid_argument);
+    EXPECT_THROW((FixedMatrix<int, 2, 2>({ { 1, 2 }, { 3 } })), std::invalid_argument);
+    EXPECT_THROW((FixedMatrix<int, 2, 2>({ { 1, 2 } })), std::invalid_argument);
+}
+
+TEST(FixedMatrixTest, FloatingPointProducts)
+{
+    const Matrix<double> A = Matrix<double>::Random(4, 4, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> B = Matrix<double>::Random(4, 4, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+
+    const FixedMatrix<double, 4, 4> PRODUCT = FixedMatrix<double, 4, 4>(A) * FixedMatrix<double, 4, 4>(B);
+    EXPECT_TRUE(PRODUCT.ToMatrix() == A * B);
+
+    std::stringstream FIXED_OUTPUT;
+    std::stringstream MATRIX_OUTPUT;
+    FIXED_OUTPUT << FixedMatrix<double, 4, 4>(A);
+    MATRIX_OUTPUT << A;
+    EXPECT_EQ(FIXED_OUTPUT.str(), MATRIX_OUTPUT.str());
+}
@@ -0,0 +1,240 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "Float16.hpp"
+#include "Math.hpp"
+#include "Matrix.hpp"
+#include "Simd.hpp"
+
+
+namespace
+{
+    float FromBits(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    template<typename T>
+    Matrix<float> Widen(const Matrix<T>& matrix)
+    {
+        Matrix<float> wide(matrix.GetHeight(), matrix.GetWidth());
+        for (size_t r = 0; r < matrix.GetHeight(); ++r) {
+            for (size_t c = 0; c < matrix.GetWidth(); ++c) {
+                wide[r][c] = matrix[r][c];
+            }
+        }
+        return wide;
+    }
+
+} // end anonymous namespace
+
+
+TEST(Float16Test, ConvertsWithRoundToNearestEven)
+{
+    EXPECT_EQ(sizeof(BFloat16), 2u);
+    EXPECT_EQ(sizeof(Float16), 2u);
+
+    EXPECT_EQ(Float16(1.0f).Bits(), 0x3C00);
+    EXPECT_EQ(Float16(-2).Bits(), 0xC000);
+    EXPECT_EQ(Float16(65504.0f).Bits(), 0x7BFF);
+    EXPECT_EQ(Float16(65519.0f).Bits(), 0x7BFF);
+    EXPECT_EQ(Float16(65520.0f).Bits(), 0x7C00);            // Ties to the even infinity
+    EXPECT_EQ(Float16(1.0f + 0x1p-11f).Bits(), 0x3C00);     // Ties to even
+    EXPECT_EQ(Float16(1.0f + 0x3p-11f).Bits(), 0x3C02);
+    EXPECT_EQ(Float16(0x1p-24f).Bits(), 0x0001);            // Smallest subnormal
+    EXPECT_EQ(Float16(0x1p-25f).Bits(), 0x0000);
+    EXPECT_EQ(Float16(0x3p-26f).Bits(), 0x0001);
+    EXPECT_EQ(Float16(0x3p-25f).Bits(), 0x0002);
+    EXPECT_EQ(Float16(-0.0f).Bits(), 0x8000);
+    EXPECT_TRUE(std::isnan(static_cast<float>(Float16(std::numeric_limits<float>::quiet_NaN()))));
+
+    EXPECT_EQ(BFloat16(1.0f).Bits(), 0x3F80);
+    EXPECT_EQ(BFloat16(1.0f + 0x1p-8f).Bits(), 0x3F80);     // Ties to even
+    EXPECT_EQ(BFloat16(1.0f + 0x3p-8f).Bits(), 0x3F82);
+    EXPECT_EQ(BFloat16(std::numeric_limits<float>::max()).Bits(), 0x7F80);
+    EXPECT_TRUE(std::isnan(static_cast<float>(BFloat16(FromBits(0x7F800001)))));
+
+    EXPECT_EQ(static_cast<float>(std::numeric_limits<Float16>::max()), 65504.0f);
+    EXPECT_EQ(static_cast<float>(std::numeric_limits<Float16>::epsilon()), 0x1p-10f);
+    EXPECT_EQ(static_cast<float>(std::numeric_limits<BFloat16>::epsilon()), 0x1p-7f);
+
+    // Every value survives the round trip through float.
+    for (uint32_t bits = 0; bits <= 0xFFFF; ++bits)
+    {
+        const Float16 half = Float16::FromBits(static_cast<uint16_t>(bits));
+        const BFloat16 brain = BFloat16::FromBits(static_cast<uint16_t>(bits));
+        if (!std::isnan(static_cast<float>(half))) {
+            EXPECT_EQ(Float16(static_cast<float>(half)).Bits(), bits);
+        }
+        if (!std::isnan(static_cast<float>(brain))) {
+            EXPECT_EQ(BFloat16(static_cast<float>(brain)).Bits(), bits);
+        }
+    }
+}
+
+template<typename T>
+class Float16KernelsTest : public ::testing::Test {};
+
+using HalfTypes = ::testing::Types<BFloat16, Float16>;
+TYPED_TEST_SUITE(Float16KernelsTest, HalfTypes);
+
+TYPED_TEST(Float16KernelsTest, VectorKernelsMatchScalar)
+{
+    using T = TypeParam;
+    constexpr size_t LENGTH = 1037;
+
+    std::vector<T> a(LENGTH);
+    std::vector<T> b(LENGTH);
+    for (size_t i = 0; i < LENGTH; ++i) {
+        a[i] = Random::Fast<float>(-10.0f, 10.0f);
+        b[i] = Random::Fast<float>(-10.0f, 10.0f);
+    }
+
+    const Simd::Kernels<T>& scalar = Simd::GetKernels<T>(Simd::Isa::Scalar);
+    std::vector<T> sum(LENGTH), difference(LENGTH), scaled(LENGTH), axpy(b);
+    scalar.Add(a.data(), b.data(), sum.data(), LENGTH);
+    scalar.Subtract(a.data(), b.data(), difference.data(), LENGTH);
+    scalar.Scale(0.3f, a.data(), scaled.data(), LENGTH);
+    scalar.Axpy(0.3f, a.data(), axpy.data(), LENGTH);
+
+    // The sums are rounded once from float, the vector kernels must round the same way.
+    for (size_t i = 0; i < LENGTH; ++i) {
+        ASSERT_EQ(sum[i].Bits(), T(static_cast<float>(a[i]) + static_cast<float>(b[i])).Bits());
+    }
+
+    // Every 16 bit pattern, with NaNs, infinities and subnormals, scaled so that many products are ties.
+    std::vector<T> patterns(0x10000);
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        patterns[i] = T::FromBits(static_cast<uint16_t>(i));
+    }
+    std::vector<T> scaledPatterns(patterns.size());
+    scalar.Scale(1.5f, patterns.data(), scaledPatterns.data(), patterns.size());
+
+    for (Simd::Isa isa : { Simd::Isa::SSE2, Simd::Isa::AVX2, Simd::Isa::AVX512 })
+    {
+        if (!Simd::IsSupported(isa)) {
+            continue;
+        }
+
+        const Simd::Kernels<T>& kernels = Simd::GetKernels<T>(isa);
+        std::vector<T> result(LENGTH);
+
+        const auto bitsEqual = [](const std::vector<T>& lhs, const std::vector<T>& rhs) {
+            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](T l, T r) { return l.Bits() == r.Bits(); });
+        };
+
+        kernels.Add(a.data(), b.data(), result.data(), LENGTH);
+        EXPECT_TRUE(bitsEqual(result, sum)) << Simd::IsaName(isa);
+        kernels.Subtract(a.data(), b.data(), result.data(), LENGTH);
+        EXPECT_TRUE(bitsEqual(result, difference)) << Simd::IsaName(isa);
+        kernels.Scale(0.3f, a.data(), result.data(), LENGTH);
+        EXPECT_TRUE(bitsEqual(result, scaled)) << Simd::IsaName(isa);
+        std::vector<T> resultPatterns(patterns.size());
+        kernels.Scale(1.5f, patterns.data(), resultPatterns.data(), patterns.size());
+        EXPECT_TRUE(bitsEqual(resultPatterns, scaledPatterns)) << Simd::IsaName(isa);
+        result = b;
+        kernels.Axpy(0.3f, a.data(), result.data(), LENGTH);
+        EXPECT_TRUE(bitsEqual(result, axpy)) << Simd::IsaName(isa);
+
+        EXPECT_TRUE(kernels.AreEqual(a.data(), a.data(), LENGTH, 1.0f)) << Simd::IsaName(isa);
+        EXPECT_FALSE(kernels.AreEqual(a.data(), b.data(), LENGTH, 1.0f)) << Simd::IsaName(isa);
+
+        // Dot products of length LENGTH, summed in float.
+        T dots[2];
+        float expected[2] = { 0.0f, 0.0f };
+        for (size_t j = 0; j < LENGTH; ++j) {
+            expected[0] += static_cast<float>(a[j]) * static_cast<float>(b[j]);
+            expected[1] += static_cast<float>(b[j]) * static_cast<float>(b[j]);
+        }
+        kernels.DotRows(1, LENGTH, a.data(), LENGTH, b.data(), dots);
+        kernels.DotRows(1, LENGTH, b.data(), LENGTH, b.data(), dots + 1);
+        for (size_t i = 0; i < 2; ++i) {
+            EXPECT_NEAR(static_cast<float>(dots[i]), expected[i], 2.0f * static_cast<float>(std::numeric_limits<T>::epsilon()) * std::fabs(expected[i]) + 1e-2f)
+                << Simd::IsaName(isa);
+        }
+    }
+}
+
+TYPED_TEST(Float16KernelsTest, ProductsAccumulateInFloat)
+{
+    using T = TypeParam;
+
+    // 1000 is exact in both types, but a sum of ones stops growing at 256 in BFloat16 and
+    // at 2048 in Float16 if it is accumulated in the 16 bit type.
+    const Matrix<T> ONES(9, 1000, std::vector<T>(9 * 1000, T(1)));
+    const Matrix<T> COUNT = ONES * ONES.Transpose();
+    for (size_t r = 0; r < COUNT.GetHeight(); ++r) {
+        for (size_t c = 0; c < COUNT.GetWidth(); ++c) {
+            EXPECT_EQ(static_cast<float>(COUNT[r][c]), 1000.0f);
+        }
+    }
+    const Matrix<T> LONG_ONES(5, 3000, std::vector<T>(5 * 3000, T(1)));
+    const Matrix<T> LONG = LONG_ONES * LONG_ONES.Transpose();
+    EXPECT_EQ(static_cast<float>(LONG[4][2]), static_cast<float>(T(3000)));
+
+    // Larger than a cache block of every dimension, with both orderings of the operands and the
+    // result rounded once from the float product of the same elements.
+    const Matrix<T> A = Matrix<T>::Random(157, 301, std::bind(&Random::Fast<T>, T(-1), T(1)));
+    const Matrix<T> B = Matrix<T>::Random(301, 133, std::bind(&Random::Fast<T>, T(-1), T(1)), Matrix<T>::Ordering::ColumnMajor);
+    const Matrix<float> EXPECTED = Widen(A) * Widen(B);
+
+    const float EPSILON = static_cast<float>(std::numeric_limits<T>::epsilon());
+    Matrix<T> C = A * B;
+    for (size_t r = 0; r < C.GetHeight(); ++r) {
+        for (size_t c = 0; c < C.GetWidth(); ++c) {
+            ASSERT_NEAR(static_cast<float>(C[r][c]), EXPECTED[r][c], EPSILON * std::fabs(EXPECTED[r][c]) + 1e-4f) << r << ' ' << c;
+        }
+    }
+
+    // C = 2 * A * B + C reads C as float too.
+    C += static_cast<T>(2) * A * B;
+    for (size_t r = 0; r < C.GetHeight(); ++r) {
+        for (size_t c = 0; c < C.GetWidth(); ++c) {
+            ASSERT_NEAR(static_cast<float>(C[r][c]), 3.0f * EXPECTED[r][c], 3.0f * EPSILON * std::fabs(EXPECTED[r][c]) + 1e-3f) << r << ' ' << c;
+        }
+    }
+
+    // Matrix times vector.
+    const Matrix<T> X = Matrix<T>::Random(301, 1, std::bind(&Random::Fast<T>, T(-1), T(1)));
+    const Matrix<float> EXPECTED_Y = Widen(A) * Widen(X);
+    const Matrix<T> Y = A * X;
+    for (size_t r = 0; r < Y.GetHeight(); ++r) {
+        EXPECT_NEAR(static_cast<float>(Y[r][0]), EXPECTED_Y[r][0], EPSILON * std::fabs(EXPECTED_Y[r][0]) + 1e-4f) << r;
+    }
+}
+
+TYPED_TEST(Float16KernelsTest, ElementwiseOperationsRoundOnce)
+{
+    using T = TypeParam;
+
+    const Matrix<T> A = Matrix<T>::Random(61, 47, std::bind(&Random::UniformlyDistributed<T>, T(-4), T(4)));
+    const Matrix<T> B = Matrix<T>::Random(61, 47, std::bind(&Random::UniformlyDistributed<T>, T(-4), T(4)), Matrix<T>::Ordering::ColumnMajor);
+
+    const Matrix<T> SUM = A + B;
+    const Matrix<T> LINEAR = A * static_cast<T>(0.5f) - B;
+    for (size_t r = 0; r < A.GetHeight(); ++r) {
+        for (size_t c = 0; c < A.GetWidth(); ++c)
+        {
+            const float a = A[r][c];
+            const float b = B[r][c];
+            ASSERT_GE(a, -4.0f);
+            ASSERT_LE(a, 4.0f);
+            EXPECT_EQ(SUM[r][c].Bits(), T(a + b).Bits());
+            EXPECT_EQ(static_cast<float>(LINEAR[r][c]), static_cast<float>(T(T(0.5f * a) - b)));
+        }
+    }
+
+    EXPECT_TRUE(SUM - B == A);
+    EXPECT_FALSE(SUM == A);
+    EXPECT_TRUE(Math::AreEqual(T(1), T(1.001f), T(2)));
+    EXPECT_FALSE(Math::AreEqual(T(1), T(1.1f), T(2)));
+}
@@ -0,0 +1,198 @@
+#include "gtest/gtest.h"
+
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "Io.hpp"
+#include "Math.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace
+{
+    /// @brief Path of a file in the temporary directory that is removed at the end of the scope.
+    class TemporaryFile
+    {
+    public:
+        explicit TemporaryFile(const std::string& name)
+            : Path((std::filesystem::temp_directory_path() / ("matrixer-test-" + name)).string())
+        {}
+
+        ~TemporaryFile()
+        {
+            std::error_code error;
+            std::filesystem::remove(Path, error);
+        }
+
+        const std::string Path;
+    };
+
+    void WriteBytes(const std::string& fpath, const std::string& bytes)
+    {
+        std::ofstream out(fpath, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+} // end anonymous namespace
+
+
+TEST(IoTest, MatrixFilesKeepElementsAndOrdering)
+{
+    const TemporaryFile BINARY("matrix.bin");
+    const TemporaryFile NPY("matrix.npy");
+
+    const Matrix<double> A = Matrix<double>::Random(37, 23, std::bind(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<int> B = Matrix<int>::Random(19, 41, std::bind(&Random::Fast<int>, -100, 100), Matrix<int>::Ordering::ColumnMajor);
+
+    for (const std::string& fpath : { BINARY.Path, NPY.Path })
+    {
+        const bool npy = fpath == NPY.Path;
+
+        npy ? IO::WriteNpyFile(fpath, A) : IO::WriteMatrixFile(fpath, A);
+        {
+            const IO::MappedMatrix<double> MAPPED(fpath);
+            EXPECT_EQ(MAPPED.GetHeight(), 37);
+            EXPECT_EQ(MAPPED.GetWidth(), 23);
+            EXPECT_EQ(MAPPED.View().GetOrdering(), Matrix<double>::Ordering::RowMajor);
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(MAPPED.View().Data()) % 64, 0);
+            EXPECT_TRUE(Matrix<double>(MAPPED.View()) == A);
+            EXPECT_TRUE(Matrix<double>(MAPPED.View() * A.Transpose()) == A * A.Transpose());
+        }
+
+        // Strided views are saved without the gaps between their lines.
+        npy ? IO::WriteNpyFile(fpath, B.Block(3, 5, 11, 7)) : IO::WriteMatrixFile(fpath, B.Block(3, 5, 11, 7));
+        const Matrix<int> BLOCK = IO::ReadMatrixFile<int>(fpath);
+        EXPECT_EQ(BLOCK.GetOrdering(), Matrix<int>::Ordering::ColumnMajor);
+        EXPECT_TRUE(BLOCK == Matrix<int>(B.Block(3, 5, 11, 7)));
+
+        IO::MappedMatrix<int> moved(fpath);
+        IO::MappedMatrix<int> target(std::move(moved));
+        EXPECT_EQ(moved.GetHeight(), 0);
+        EXPECT_TRUE(Matrix<int>(target.View()) == BLOCK);
+
+        EXPECT_THROW(IO::MappedMatrix<float>{ fpath }, std::runtime_error);
+    }
+
+    const TemporaryFile GARBAGE("garbage");
+    WriteBytes(GARBAGE.Path, "1.0 2.0 3.0\n");
+    EXPECT_THROW(IO::MappedMatrix<double>{ GARBAGE.Path }, std::runtime_error);
+    EXPECT_THROW(IO::ReadMatrixFile<double>(GARBAGE.Path + "-missing"), std::system_error);
+
+    // Truncated files are detected from the dimensions in the header.
+    IO::WriteMatrixFile(BINARY.Path, A);
+    std::filesystem::resize_file(BINARY.Path, IO::MATRIX_FILE_ALIGNMENT + 100);
+    EXPECT_THROW(IO::MappedMatrix<double>{ BINARY.Path }, std::runtime_error);
+}
+
+TEST(IoTest, ReadsNpyFilesWrittenByNumpy)
+{
+    const TemporaryFile NPY("numpy.npy");
+
+    // np.save of np.arange(1, 7, dtype=np.float32).reshape(2, 3, order='F') and of np.arange(3, dtype=np.uint64)
+    const std::string MATRIX_HEADER = "{'descr': '<f4', 'fortran_order': True, 'shape': (2, 3), }";
+    const std::string VECTOR_HEADER = "{'descr': '<u8', 'fortran_order': False, 'shape': (3,), }";
+
+    const auto npyFile = [](const std::string& header, const std::string& data) {
+        std::string padded = header + std::string(64 - (10 + header.size() + 1) % 64, ' ') + '\n';
+        return std::string("\x93NUMPY\x01\x00", 8) + static_cast<char>(padded.size()) + '\0' + padded + data;
+    };
+
+    const float MATRIX_DATA[] = { 1, 2, 3, 4, 5, 6 };
+    WriteBytes(NPY.Path, npyFile(MATRIX_HEADER, std::string(reinterpret_cast<const char*>(MATRIX_DATA), sizeof(MATRIX_DATA))));
+    EXPECT_TRUE(IO::ReadMatrixFile<float>(NPY.Path) == Matrix<float>({ { 1, 3, 5 }, { 2, 4, 6 } }));
+
+    const uint64_t VECTOR_DATA[] = { 0, 1, 2 };
+    WriteBytes(NPY.Path, npyFile(VECTOR_HEADER, std::string(reinterpret_cast<const char*>(VECTOR_DATA), sizeof(VECTOR_DATA))));
+    EXPECT_TRUE(IO::ReadMatrixFile<size_t>(NPY.Path) == Matrix<size_t>({ { 0 }, { 1 }, { 2 } }));
+
+    WriteBytes(NPY.Path, npyFile("{'descr': '<f4', 'fortran_order': False, 'shape': (2, 2, 2), }", std::string(32, '\0')));
+    EXPECT_THROW(IO::MappedMatrix<float>{ NPY.Path }, std::runtime_error);
+}
+
+TEST(IoTest, ParsesTextMatrices)
+{
+    const Matrix<double> PARSED = IO::ParseTextMatrix<double>("# 3x2\n1.5 -2e-3\n\n  \t3.25e+02\t4 # comment\r\n5 6");
+    EXPECT_TRUE(PARSED == Matrix<double>({ { 1.5, -2e-3 }, { 3.25e+02, 4 }, { 5, 6 } }));
+    EXPECT_EQ(IO::ParseTextMatrix<int>("# empty\n\n").GetHeight(), 0);
+
+    EXPECT_THROW(IO::ParseTextMatrix<double>("1 2\n3\n"), std::runtime_error);
+    EXPECT_THROW(IO::ParseTextMatrix<double>("1 2\n3 4 5\n"), std::runtime_error);
+    EXPECT_THROW(IO::ParseTextMatrix<double>("1 2\n3 x\n"), std::runtime_error);
+    EXPECT_THROW(IO::ParseTextMatrix<int>("1 2\n3 4.5\n"), std::runtime_error);
+
+    // Larger than one chunk, so the chunks are parsed in parallel and their rows must line up.
+    const Matrix<float> A = Matrix<float>::Random(4000, 97, std::bind(&Random::Fast<float>, -1.0f, 1.0f));
+    std::string text = "# 4000x97\n";
+    for (size_t r = 0; r < A.GetHeight(); ++r) {
+        for (size_t c = 0; c < A.GetWidth(); ++c) {
+            char element[32];
+            const std::to_chars_result result = std::to_chars(element, element + sizeof(element), A[r][c]);
+            text.append(element, result.ptr).push_back(c + 1 < A.GetWidth() ? ' ' : '\n');
+        }
+    }
+    ASSERT_GT(text.size(), 2u << 20);
+
+    ThreadPool::Start(4);
+    const Matrix<float> PARALLEL = IO::ParseTextMatrix<float>(text);
+    ThreadPool::Stop();
+
+    EXPECT_TRUE(PARALLEL == A);
+    EXPECT_TRUE(IO::ParseTextMatrix<float>(text) == A);
+}
+
+TEST(IoTest, MultipliesMatrixFilesInBlocks)
+{
+    const TemporaryFile A_FILE("a.bin");
+    const TemporaryFile B_FILE("b.npy");
+    const TemporaryFile C_FILE("c.bin");
+
+    const Matrix<int> A = Matrix<int>::Random(67, 45, std::bind(&Random::Fast<int>, -10, 10));
+    const Matrix<int> B = Matrix<int>::Random(45, 53, std::bind(&Random::Fast<int>, -10, 10), Matrix<int>::Ordering::ColumnMajor);
+    IO::WriteMatrixFile(A_FILE.Path, A);
+    IO::WriteNpyFile(B_FILE.Path, B);
+
+    // Budgets for everything at once, for square tiles with several blocks of the inner dimension,
+    // and for single rows and columns.
+    for (size_t budget : { IO::STREAMING_MEMORY_BUDGET, 1500 * sizeof(int), 300 * sizeof(int), 20 * sizeof(int) })
+    {
+        IO::MultiplyMatrixFiles<int>(A_FILE.Path, B_FILE.Path, C_FILE.Path, budget);
+        EXPECT_TRUE(IO::ReadMatrixFile<int>(C_FILE.Path) == A * B) << budget;
+    }
+
+    // Reading overlaps the multiplication when the pool is started.
+    IO::WriteMatrixFile(B_FILE.Path, B.ToOrdering(Matrix<int>::Ordering::RowMajor));
+    ThreadPool::Start(3);
+    IO::MultiplyMatrixFiles<int>(A_FILE.Path, B_FILE.Path, C_FILE.Path, 400 * sizeof(int));
+    ThreadPool::Stop();
+    EXPECT_TRUE(IO::ReadMatrixFile<int>(C_FILE.Path) == A * B);
+
+    EXPECT_THROW(IO::MultiplyMatrixFiles<int>(A_FILE.Path, A_FILE.Path, C_FILE.Path), std::invalid_argument);
+    EXPECT_THROW(IO::MultiplyMatrixFiles<int>(A_FILE.Path, B_FILE.Path, C_FILE.Path, 3 * sizeof(int)), std::invalid_argument);
+    EXPECT_THROW(IO::MultiplyMatrixFiles<float>(A_FILE.Path, B_FILE.Path, C_FILE.Path), std::runtime_error);
+}
+
+TEST(IoTest, KeepsSixteenBitElements)
+{
+    const TemporaryFile BINARY("half.bin");
+    const TemporaryFile NPY("half.npy");
+
+    const Matrix<BFloat16> A = Matrix<BFloat16>::Random(29, 31, std::bind(&Random::Fast<BFloat16>, BFloat16(-1), BFloat16(1)));
+    const Matrix<Float16> B = Matrix<Float16>::Random(31, 17, std::bind(&Random::Fast<Float16>, Float16(-1), Float16(1)), Matrix<Float16>::Ordering::ColumnMajor);
+
+    IO::WriteMatrixFile(BINARY.Path, A);
+    EXPECT_EQ(std::filesystem::file_size(BINARY.Path), IO::MATRIX_FILE_ALIGNMENT + 29 * 31 * 2);
+    EXPECT_TRUE(Matrix<BFloat16>(IO::MappedMatrix<BFloat16>(BINARY.Path).View()) == A);
+    EXPECT_THROW(IO::MappedMatrix<Float16>{ BINARY.Path }, std::runtime_error);
+
+    IO::WriteNpyFile(NPY.Path, B);
+    const Matrix<Float16> READ = IO::ReadMatrixFile<Float16>(NPY.Path);
+    EXPECT_EQ(READ.GetOrdering(), Matrix<Float16>::Ordering::ColumnMajor);
+    EXPECT_TRUE(READ == B);
+}
@@ -0,0 +1,175 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "Math.hpp"
+#include "Matrix.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace
+{
+    constexpr size_t LANES = Simd::PHILOX_LANES;
+
+    /// @brief Returns the four words of the Philox block of the counter, from the given kernels.
+    std::vector<uint32_t> Block(const Simd::RandomKernels& kernels, uint64_t key, uint64_t stream, uint64_t counter)
+    {
+        std::vector<uint32_t> group(4 * LANES);
+        kernels.Philox(key, stream, counter / LANES, 1, group.data());
+
+        std::vector<uint32_t> block(4);
+        for (size_t w = 0; w < 4; ++w) {
+            block[w] = group[w * LANES + counter % LANES];
+        }
+        return block;
+    }
+
+} // end anonymous namespace
+
+
+TEST(MathTest, PhiloxMatchesKnownAnswers)
+{
+    // The known answer tests of Philox4x32-10 from the Random123 library, the counters as
+    // (counter, stream) and the keys as seeds with the first word in the lower half.
+    for (Simd::Isa isa : { Simd::Isa::Scalar, Simd::Isa::SSE2, Simd::Isa::AVX2, Simd::Isa::AVX512 })
+    {
+        if (!Simd::IsSupported(isa)) {
+            continue;
+        }
+
+        const Simd::RandomKernels& kernels = Simd::GetRandomKernels(isa);
+        EXPECT_EQ(Block(kernels, 0, 0, 0), (std::vector<uint32_t>{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }))
+            << Simd::IsaName(isa);
+        EXPECT_EQ(Block(kernels, ~uint64_t(0), ~uint64_t(0), ~uint64_t(0)), (std::vector<uint32_t>{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }))
+            << Simd::IsaName(isa);
+        EXPECT_EQ(Block(kernels, 0x299f31d0a4093822, 0x0370734413198a2e, 0x85a308d3243f6a88), (std::vector<uint32_t>{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }))
+            << Simd::IsaName(isa);
+    }
+}
+
+TEST(MathTest, PhiloxKernelsAgree)
+{
+    constexpr size_t GROUPS = 37;
+    std::vector<uint32_t> expected(GROUPS * 4 * LANES);
+    Simd::GetRandomKernels(Simd::Isa::Scalar).Philox(42, 7, 1000, GROUPS, expected.data());
+
+    for (Simd::Isa isa : { Simd::Isa::SSE2, Simd::Isa::AVX2, Simd::Isa::AVX512 })
+    {
+        if (Simd::IsSupported(isa))
+        {
+            std::vector<uint32_t> words(expected.size());
+            Simd::GetRandomKernels(isa).Philox(42, 7, 1000, GROUPS, words.data());
+            EXPECT_EQ(words, expected) << Simd::IsaName(isa);
+        }
+    }
+}
+
+template<typename T>
+class PhiloxFillTest : public ::testing::Test
+{
+};
+
+using FillTypes = ::testing::Types<float, double, int, size_t, BFloat16, Float16>;
+TYPED_TEST_SUITE(PhiloxFillTest, FillTypes);
+
+
+TYPED_TEST(PhiloxFillTest, SlicesMatchTheSequence)
+{
+    using T = TypeParam;
+    constexpr size_t LENGTH = 5000;
+    const T lowest = static_cast<T>(2);
+    const T highest = static_cast<T>(9);
+    const Random::Philox generator(1234, 5);
+
+    std::vector<T> sequence(LENGTH);
+    generator.Fill(sequence.data(), LENGTH, 0, lowest, highest);
+
+    // Slices starting and ending inside of the groups of counters.
+    std::vector<T> sliced(LENGTH);
+    for (size_t first = 0, length = 1; first < LENGTH; first += length, length = length * 3 + 7) {
+        const size_t n = std::min(length, LENGTH - first);
+        generator.Fill(sliced.data() + first, n, first, lowest, highest);
+    }
+
+    std::set<T> distinct;
+    for (size_t i = 0; i < LENGTH; ++i)
+    {
+        ASSERT_EQ(static_cast<double>(sliced[i]), static_cast<double>(sequence[i])) << i;
+        ASSERT_GE(sequence[i], lowest);
+        ASSERT_LE(sequence[i], highest);
+        distinct.insert(sequence[i]);
+    }
+    EXPECT_GE(distinct.size(), 8u);
+
+    // Another seed or stream gives another sequence.
+    std::vector<T> other(LENGTH);
+    Random::Philox(1234, 6).Fill(other.data(), LENGTH, 0, lowest, highest);
+    EXPECT_FALSE(std::equal(other.begin(), other.end(), sequence.begin()));
+}
+
+TEST(MathTest, PhiloxFillIsUniform)
+{
+    constexpr size_t LENGTH = 1 << 20;
+    const Random::Philox generator(99);
+
+    std::vector<double> reals(LENGTH);
+    generator.Fill(reals.data(), LENGTH, 0, -1.0, 3.0);
+    double sum = 0.0;
+    for (double v : reals) {
+        sum += v;
+    }
+    EXPECT_NEAR(sum / LENGTH, 1.0, 0.01);
+
+    std::vector<int> ints(LENGTH);
+    generator.Fill(ints.data(), LENGTH, 0, -3, 3);
+    std::vector<size_t> histogram(7, 0);
+    for (int v : ints) {
+        ++histogram[static_cast<size_t>(v + 3)];
+    }
+    for (size_t count : histogram) {
+        EXPECT_NEAR(static_cast<double>(count), LENGTH / 7.0, LENGTH / 7.0 * 0.02);
+    }
+
+    // The full ranges of the integer types.
+    generator.Fill(ints.data(), 1000, 0, std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+    EXPECT_LT(*std::min_element(ints.begin(), ints.begin() + 1000), -1000000);
+    EXPECT_GT(*std::max_element(ints.begin(), ints.begin() + 1000), 1000000);
+
+    std::vector<size_t> sizes(1000);
+    generator.Fill(sizes.data(), sizes.size(), 0, size_t(0), std::numeric_limits<size_t>::max());
+    EXPECT_GT(*std::max_element(sizes.begin(), sizes.end()), size_t(1) << 62);
+
+    EXPECT_THROW(generator.Fill(ints.data(), 1, 0, 1, 0), std::invalid_argument);
+}
+
+TEST(MathTest, SeededRandomMatrixIsIndependentOfThreads)
+{
+    // Large enough to be split between the threads.
+    const Matrix<float> serial = Matrix<float>::Random(1500, 1500, -1.0f, 1.0f, 2024);
+
+    ThreadPool::Start(3);
+    const Matrix<float> parallel = Matrix<float>::Random(1500, 1500, -1.0f, 1.0f, 2024);
+    const Matrix<float> reseeded = Matrix<float>::Random(1500, 1500, -1.0f, 1.0f, 2025);
+    ThreadPool::Stop();
+
+    EXPECT_TRUE(serial == parallel);
+    EXPECT_FALSE(serial == reseeded);
+
+    // Element i of the data array is element i of the sequence.
+    std::vector<float> expected(10);
+    Random::Philox(2024).Fill(expected.data(), expected.size(), 1500 * 3, -1.0f, 1.0f);
+    for (size_t j = 0; j < expected.size(); ++j) {
+        EXPECT_EQ(serial[3][j], expected[j]);
+    }
+
+    const Matrix<int> columnMajor = Matrix<int>::Random(4, 3, 0, 9, 1, Matrix<int>::Ordering::ColumnMajor);
+    std::vector<int> values(12);
+    Random::Philox(1).Fill(values.data(), values.size(), 0, 0, 9);
+    EXPECT_EQ(columnMajor[1][2], values[2 * 4 + 1]);
+}
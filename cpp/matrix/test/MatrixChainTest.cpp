@@ -0,0 +1,132 @@
+#include "gtest/gtest.h"
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "Math.hpp"
+#include "Matrix.hpp"
+#include "MatrixChain.hpp"
+#include "ThreadPool.hpp"
+
+
+TEST(MatrixChainTest, PlansTheFewestOperations)
+{
+    // The example of Cormen et al., Introduction to Algorithms, 15.2.
+    const MatrixChain::Plan plan = MatrixChain::MakePlan({ 30, 35, 15, 5, 10, 20, 25 }, 1);
+
+    EXPECT_EQ(plan.ToString(), "((A0 (A1 A2)) ((A3 A4) A5))");
+    EXPECT_EQ(plan.Operations, 15125.0);
+    EXPECT_EQ(plan.Time, 15125.0);
+    ASSERT_EQ(plan.Products.size(), 5u);
+
+    const MatrixChain::Product& last = plan.Products.back();
+    EXPECT_EQ(last.Height, 30u);
+    EXPECT_EQ(last.Width, 25u);
+    EXPECT_EQ(last.Depth, 5u);
+    EXPECT_FALSE(last.Concurrent);
+
+    // A matrix times a vector is computed before the matrix of the same size in front of it.
+    const MatrixChain::Plan vector = MatrixChain::MakePlan({ 1'000'000, 1000, 1'000'000, 1 }, 4);
+    EXPECT_EQ(vector.ToString(), "(A0 (A1 A2))");
+    EXPECT_EQ(vector.Operations, 2e9);
+    EXPECT_EQ(vector.PeakElements, 1'000'000u + 1000u);
+
+    const MatrixChain::Plan single = MatrixChain::MakePlan({ 3, 4 }, 1);
+    EXPECT_EQ(single.ToString(), "A0");
+    EXPECT_TRUE(single.Products.empty());
+}
+
+TEST(MatrixChainTest, PlansConcurrentProducts)
+{
+    // The products are too small to be split between threads, so two of them are computed at
+    // the same time instead.
+    const std::vector<size_t> dimensions = { 10, 10, 10, 10, 10 };
+
+    const MatrixChain::Plan parallel = MatrixChain::MakePlan(dimensions, 2);
+    EXPECT_EQ(parallel.ToString(), "((A0 A1)|(A2 A3))");
+    EXPECT_EQ(parallel.Operations, 3000.0);
+    EXPECT_EQ(parallel.Time, 2000.0);
+    EXPECT_TRUE(parallel.Products.back().Concurrent);
+
+    const MatrixChain::Plan serial = MatrixChain::MakePlan(dimensions, 1);
+    EXPECT_EQ(serial.ToString().find('|'), std::string::npos);
+    EXPECT_EQ(serial.Time, 3000.0);
+
+    // Products large enough for all threads are computed one after the other.
+    const size_t n = 1000;
+    const MatrixChain::Plan large = MatrixChain::MakePlan({ n, n, n, n, n }, 4);
+    EXPECT_EQ(large.ToString().find('|'), std::string::npos);
+    EXPECT_EQ(large.Time, large.Operations / 4);
+}
+
+TEST(MatrixChainTest, PlansWithinTheMemoryLimit)
+{
+    const std::vector<size_t> dimensions = { 1, 8, 32, 2 };
+
+    const MatrixChain::Plan fastest = MatrixChain::MakePlan(dimensions, 1);
+    EXPECT_EQ(fastest.ToString(), "((A0 A1) A2)");
+    EXPECT_EQ(fastest.Operations, 320.0);
+    EXPECT_EQ(fastest.PeakElements, 34u);
+
+    const MatrixChain::Plan limited = MatrixChain::MakePlan(dimensions, 1, 20);
+    EXPECT_EQ(limited.ToString(), "(A0 (A1 A2))");
+    EXPECT_EQ(limited.Operations, 528.0);
+    EXPECT_EQ(limited.PeakElements, 18u);
+
+    // Nothing fits, the smallest plan is taken.
+    EXPECT_EQ(MatrixChain::MakePlan(dimensions, 1, 10).ToString(), "(A0 (A1 A2))");
+}
+
+TEST(MatrixChainTest, MultipliesLikeTheLeftToRightProduct)
+{
+    const auto generator = std::bind(&Random::Fast<int>, -5, 5);
+    const Matrix<int> A = Matrix<int>::Random(40, 3, generator);
+    const Matrix<int> B = Matrix<int>::Random(3, 70, generator, Matrix<int>::Ordering::ColumnMajor);
+    const Matrix<int> C = Matrix<int>::Random(70, 60, generator);
+    const Matrix<int> D = Matrix<int>::Random(60, 5, generator, Matrix<int>::Ordering::ColumnMajor);
+    const Matrix<int> E = Matrix<int>::Random(5, 80, generator);
+
+    const Matrix<int> expected = (((A * B) * C) * D) * E;
+
+    const Matrix<int> product = MatrixChain::Multiply(A, B, C, D, E);
+    EXPECT_EQ(product.GetOrdering(), Matrix<int>::Ordering::RowMajor);
+    EXPECT_EQ(product, expected);
+
+    EXPECT_EQ(MatrixChain::Multiply<int>({ &A, &B, &C, &D, &E }, 64 * sizeof(int)), expected);
+    EXPECT_EQ(MatrixChain::Multiply(B), B);
+
+    // Empty inner dimensions give products of zeros.
+    const Matrix<int> NO_COLUMNS(4, 0);
+    const Matrix<int> NO_ROWS(0, 6);
+    EXPECT_EQ(MatrixChain::Multiply(NO_COLUMNS, NO_ROWS, Matrix<int>::Random(6, 2, generator)), Matrix<int>(4, 2));
+
+    // Independent products that are computed at the same time, and products large enough to
+    // be split between the threads.
+    const Matrix<int> F = Matrix<int>::Random(30, 30, generator);
+    const Matrix<int> G = Matrix<int>::Random(30, 30, generator);
+    const Matrix<int> H = Matrix<int>::Random(100, 200, generator);
+    const Matrix<int> I = Matrix<int>::Random(200, 200, generator);
+    const Matrix<int> J = Matrix<int>::Random(200, 200, generator);
+
+    ThreadPool::Start(3);
+    const Matrix<int> parallel = MatrixChain::Multiply(F, G, F, G);
+    const Matrix<int> large = MatrixChain::Multiply(H, I, J, I, J);
+    ThreadPool::Stop();
+
+    EXPECT_EQ(parallel, ((F * G) * F) * G);
+    EXPECT_EQ(large, (((H * I) * J) * I) * J);
+}
+
+TEST(MatrixChainTest, InvalidChainsThrow)
+{
+    const Matrix<double> A(3, 4);
+    const Matrix<double> B(5, 2);
+
+    EXPECT_THROW(MatrixChain::Multiply(A, B), std::invalid_argument);
+    EXPECT_THROW(MatrixChain::Multiply(std::vector<const Matrix<double>*>{}), std::invalid_argument);
+    EXPECT_THROW(MatrixChain::Multiply(std::vector<const Matrix<double>*>{ &A, nullptr }), std::invalid_argument);
+
+    EXPECT_THROW(MatrixChain::MakePlan({ 3 }, 1), std::invalid_argument);
+    EXPECT_THROW(MatrixChain::MakePlan({ 3, 4, 5 }, 0), std::invalid_argument);
+}
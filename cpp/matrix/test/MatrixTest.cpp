@@ -2,16 +2,21 @@
 #include "gmock/gmock.h"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <sstream>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "Gemm.hpp"
 #include "Io.hpp"
 #include "Math.hpp"
 #include <Matrix.hpp>
@@ -19,28 +24,37 @@
 
 
 template<typename T>
-std::vector<T> SplitStrToTypeVals(const std::string& str, char delimiter)
+double MaxAbsElement(const Matrix<T>& mat)
 {
-    std::stringstream strsequence(str);
-    std::string segment;
-    std::vector<T> segments;
+    double maxAbs = 0.0;
+    for (size_t r = 0; r < mat.GetHeight(); ++r) {
+        for (size_t c = 0; c < mat.GetWidth(); ++c) {
+            maxAbs = std::max(maxAbs, std::fabs(static_cast<double>(mat[r][c])));
+        }
+    }
+    return maxAbs;
+}
 
-    while (std::getline(strsequence, segment, delimiter))
-    {
-        if constexpr (std::is_same<T, float>::value) {
-            segments.push_back(std::stof(segment));
-        } else if constexpr (std::is_same<T, double>::value) {
-            segments.push_back(std::stod(segment));
-        } else if constexpr (std::is_same<T, int>::value) {
-            segments.push_back(std::stoi(segment));
-        } else if constexpr (std::is_same<T, size_t>::value) {
-            segments.push_back(std::stoul(segment));
-        } else {
-            throw std::domain_error("SplitStrToTypeVals specified template type not supported");
+template<typename T>
+double MaxAbsDifference(const Matrix<T>& lhs, const Matrix<T>& rhs)
+{
+    double maxAbs = 0.0;
+    for (size_t r = 0; r < lhs.GetHeight(); ++r) {
+        for (size_t c = 0; c < lhs.GetWidth(); ++c) {
+            maxAbs = std::max(maxAbs, std::fabs(static_cast<double>(lhs[r][c]) - static_cast<double>(rhs[r][c])));
         }
     }
+    return maxAbs;
+}
 
-    return segments;
+/// @brief Tolerance for comparing a Strassen product to a reference computed with the classic
+///        algorithm: the documented Strassen bound plus the classic bound for the reference.
+template<typename T>
+double StrassenTolerance(const Matrix<T>& A, const Matrix<T>& B, size_t cutoff)
+{
+    const size_t n = std::max({ A.GetHeight(), A.GetWidth(), B.GetWidth() });
+    const double classicBound = static_cast<double>(n * n) * static_cast<double>(std::numeric_limits<T>::epsilon());
+    return (Gemm::StrassenErrorBound<T>(n, cutoff) + classicBound) * MaxAbsElement(A) * MaxAbsElement(B);
 }
 
 
@@ -94,52 +108,40 @@ protected:
         }
     }
 
+    /// @brief Returns the matrix saved in the text file, or nullopt if it can not be read.
+    static std::optional<Matrix<float>> ReadTextMatrix(const std::string& fpath)
+    {
+        try
+        {
+            return IO::ReadTextMatrix<float>(fpath);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Could not read file: '" << fpath << "': " << e.what() << " Skipping." << std::endl;
+            return std::nullopt;
+        }
+    }
+
     static void LoadSquareMatrices(const std::vector<IO::FilePath>& matrixFiles)
     {
-        //for (std::vector<IO::FilePath>::iterator i = matrixFiles.begin(); i < matrixFiles.begin() + 2; i++)
         for (const IO::FilePath& testCase : matrixFiles)
         {
-            //IO::FilePath& testCase = *i;
-            std::string fpath = testCase.Path + '/' + testCase.Filename;
-            auto fileLinesOptional = IO::ReadLinesTextFile(fpath);
-            if (!fileLinesOptional.has_value() || fileLinesOptional->empty()) {
-                std::cerr << "Could not read file: '" << fpath << "'. Skipping file." << std::endl;
+            const std::string fpath = testCase.Path + '/' + testCase.Filename;
+
+            // The file holds the rows of A, B and C = A * B one after the other.
+            std::optional<Matrix<float>> stacked = ReadTextMatrix(fpath);
+            if (!stacked.has_value()) {
                 continue;
             }
-            std::vector<std::string> fileLines = *fileLinesOptional;
-
-            std::vector<size_t> dimensions = SplitStrToTypeVals<size_t>(fileLines[0].substr(2), 'x');
-
-            Matrix<float> A(dimensions[0], dimensions[1]);
-            Matrix<float> B(dimensions[0], dimensions[1]);
-            Matrix<float> C(dimensions[0], dimensions[1]);
-
-            size_t r = 0;
-            size_t m = 0;
 
-            std::for_each(fileLines.begin() + 1, fileLines.end(), [&dimensions, &r, &m, &A, &B, &C, &fpath](const std::string& line)
-            {
-                std::vector<float> vals = SplitStrToTypeVals<float>(line, ' ');
-
-                for (size_t c = 0; c < vals.size(); ++c)
-                {
-                    switch (m)
-                    {
-                        case 0: A[r][c] = vals[c]; break;
-                        case 1: B[r][c] = vals[c]; break;
-                        case 2: C[r][c] = vals[c]; break;
-                        default: throw std::domain_error("Invalid data for square matrix: '" + fpath + "'.");
-                    }
-                }
-
-                if (++r % dimensions[0] == 0)
-                {
-                    r = 0;
-                    ++m;
-                }
-            });
+            const size_t size = stacked->GetWidth();
+            if (stacked->GetHeight() != 3 * size) {
+                throw std::domain_error("Invalid data for square matrix: '" + fpath + "'.");
+            }
 
-            SquareMatrices.insert({ dimensions[0], { A, B, C } });
+            SquareMatrices.insert({ size, { Matrix<float>(stacked->Block(0, 0, size, size)),
+                                            Matrix<float>(stacked->Block(size, 0, size, size)),
+                                            Matrix<float>(stacked->Block(2 * size, 0, size, size)) } });
         }
     }
 
@@ -163,7 +165,7 @@ protected:
             std::vector<Matrix<float>> testCase;
             size_t matIdx = 0;
 
-            while (parseTestCaseName(it->Filename) == currentTestCase && it < matrixFiles.end()) {
+            while (it < matrixFiles.end() && parseTestCaseName(it->Filename) == currentTestCase) {
                 testCaseFiles[matIdx++] = filePathToStr(*it);
                 it++;
             }
@@ -175,27 +177,16 @@ protected:
 
             for (size_t m = 0; m < 3; ++m)
             {
-                auto fileLinesOptional = IO::ReadLinesTextFile(testCaseFiles[m]);
-                if (!fileLinesOptional.has_value() || fileLinesOptional->empty()) {
-                    std::cerr << "Could not read file: '" << testCaseFiles[m] << "'. Skipping test case." << std::endl;
-                    break; // TODO: Exit outer loop
-                }
-                std::vector<std::string> fileLines = *fileLinesOptional;
-
-                std::vector<size_t> dimensions = SplitStrToTypeVals<size_t>(fileLines[0].substr(2), 'x');
-                std::vector<float> matrixData;
-                matrixData.reserve(dimensions[0] * dimensions[1]);
-
-                for (size_t r = 1; r < fileLines.size(); ++r)
-                {
-                    std::vector<float> vals = SplitStrToTypeVals<float>(fileLines[r], ' ');
-                    for (size_t c = 0; c < vals.size(); ++c) {
-                        matrixData.emplace_back(vals[c]);
-                    }
+                std::optional<Matrix<float>> matrix = ReadTextMatrix(testCaseFiles[m]);
+                if (!matrix.has_value()) {
+                    break;
                 }
-                testCase.emplace_back(dimensions[0], dimensions[1], std::move(matrixData));
+                testCase.push_back(std::move(*matrix));
             }
 
+            if (testCase.size() != testCaseFiles.size()) {
+                continue;
+            }
             RandomMatrices.push_back({ testCase[0], testCase[1], testCase[2] });
         }
     }
@@ -493,6 +484,313 @@ TEST_F(MatrixTestPreComputed, RandomRowMajorMatricesMultiplication)
     }
 }
 
+TEST_F(MatrixTestPreComputed, RandomMixedOrderingMatricesMultiplication)
+{
+    EXPECT_TRUE(MatrixTestPreComputed::RandomMatrices.size() > 0)
+        << "No test data for matrices with random sizes";
+
+    using Ordering = Matrix<float>::Ordering;
+    const auto withOrdering = [](const Matrix<float>& mat, Ordering ordering) {
+        Matrix<float> result(mat.GetHeight(), mat.GetWidth(), ordering);
+        for (size_t r = 0; r < mat.GetHeight(); ++r) {
+            for (size_t c = 0; c < mat.GetWidth(); ++c) {
+                result[r][c] = mat[r][c];
+            }
+        }
+        return result;
+    };
+
+    for (const auto& matrices : MatrixTestPreComputed::RandomMatrices)
+    {
+        for (Ordering lhsOrdering : { Ordering::RowMajor, Ordering::ColumnMajor }) {
+            for (Ordering rhsOrdering : { Ordering::RowMajor, Ordering::ColumnMajor }) {
+                for (Ordering resultOrdering : { Ordering::RowMajor, Ordering::ColumnMajor })
+                {
+                    Matrix<float> A = withOrdering(matrices[0], lhsOrdering);
+                    Matrix<float> B = withOrdering(matrices[1], rhsOrdering);
+                    Matrix<float> RESULT = A.Multiply(B, resultOrdering);
+                    EXPECT_TRUE(RESULT == matrices[2]);
+                    EXPECT_TRUE(RESULT.GetOrdering() == resultOrdering);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(MatrixTestPreComputed, SquareMatricesStrassenMultiplication)
+{
+    EXPECT_TRUE(MatrixTestPreComputed::SquareMatrices.size() > 0)
+        << "No test data for square matrices";
+    for (size_t cutoff : { size_t(2), size_t(5) })
+    {
+        for (auto const& [diagonal, matrices] : MatrixTestPreComputed::SquareMatrices)
+        {
+            const Matrix<float> RESULT = matrices[0].MultiplyStrassen(matrices[1], cutoff);
+            EXPECT_LE(MaxAbsDifference(RESULT, matrices[2]), StrassenTolerance(matrices[0], matrices[1], cutoff))
+                << "Square matrix with diagonal size: " << diagonal << ", cutoff: " << cutoff;
+        }
+    }
+}
+
+TEST_F(MatrixTestPreComputed, RandomMatricesStrassenMultiplication)
+{
+    EXPECT_TRUE(MatrixTestPreComputed::RandomMatrices.size() > 0)
+        << "No test data for matrices with random sizes";
+    for (size_t cutoff : { size_t(2), size_t(5) })
+    {
+        for (const auto& matrices : MatrixTestPreComputed::RandomMatrices)
+        {
+            const Matrix<float> RESULT = matrices[0].MultiplyStrassen(matrices[1], cutoff);
+            EXPECT_LE(MaxAbsDifference(RESULT, matrices[2]), StrassenTolerance(matrices[0], matrices[1], cutoff))
+                << "Matrices of size: " << matrices[0].GetHeight() << 'X' << matrices[0].GetWidth()
+                << ", cutoff: " << cutoff;
+        }
+    }
+}
+
+TEST(MatrixTest, OddSizedStrassenMultiplication)
+{
+    const Matrix<double> A = Matrix<double>::Random(67, 45, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> B = Matrix<double>::Random(45, 81, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> RESULT = A.MultiplyStrassen(B, 4);
+    EXPECT_LE(MaxAbsDifference(RESULT, Matrix<double>(A * B)), StrassenTolerance(A, B, 4));
+}
+
+TEST(MatrixTest, StrassenIsExactForIntegers)
+{
+    const Matrix<int> A = Matrix<int>::Random(33, 20, std::bind(&Random::Fast<int>, -10, 10));
+    const Matrix<int> B = Matrix<int>::Random(20, 17, std::bind(&Random::Fast<int>, -10, 10));
+    EXPECT_TRUE(A.MultiplyStrassen(B, 2) == A * B);
+}
+
+TEST(MatrixExpressionTest, FusedElementwiseExpression)
+{
+    const Matrix<int> A({ { 1, 2 }, { 3, 4 } });
+    const Matrix<int> B({ { 5, 6 }, { 7, 8 } }, Matrix<int>::Ordering::ColumnMajor);
+    const Matrix<int> C({ { 9, 10 }, { 11, 12 } });
+    const Matrix<int> EXPECTED({ { -1, 2 }, { 5, 8 } });
+
+    const Matrix<int> RESULT = A + B - C + 2 * A - B * 0;
+    EXPECT_TRUE(RESULT == EXPECTED) << RESULT;
+    EXPECT_TRUE(RESULT.GetOrdering() == Matrix<int>::Ordering::RowMajor);
+    EXPECT_TRUE(A * 3 - (A + A) == A);
+}
+
+TEST(MatrixExpressionTest, ProductPlusMatrixAccumulates)
+{
+    const Matrix<double> A = Matrix<double>::Random(37, 29, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> B = Matrix<double>::Random(29, 41, std::bind<double>(&Random::Fast<double>, -1.0, 1.0), Matrix<double>::Ordering::ColumnMajor);
+    const Matrix<double> C = Matrix<double>::Random(37, 41, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> AB = A.Multiply(B, Matrix<double>::Ordering::RowMajor);
+
+    Matrix<double> D(37, 41, Matrix<double>::Ordering::ColumnMajor);
+    D = A * B + C;
+    for (size_t r = 0; r < D.GetHeight(); ++r) {
+        for (size_t c = 0; c < D.GetWidth(); ++c) {
+            EXPECT_TRUE(Math::AreEqual(D[r][c], AB[r][c] + C[r][c], 100.0)) << r << ", " << c;
+        }
+    }
+    EXPECT_TRUE(D.GetOrdering() == Matrix<double>::Ordering::ColumnMajor);
+
+    const Matrix<double> E = C - 0.5 * (A * B);
+    for (size_t r = 0; r < E.GetHeight(); ++r) {
+        for (size_t c = 0; c < E.GetWidth(); ++c) {
+            EXPECT_TRUE(Math::AreEqual(E[r][c], C[r][c] - 0.5 * AB[r][c], 100.0)) << r << ", " << c;
+        }
+    }
+
+    Matrix<double> RESIZED(41, 37);
+    RESIZED = A * B + C;
+    EXPECT_TRUE(RESIZED == D);
+    EXPECT_THROW(A * C, std::invalid_argument);
+    EXPECT_THROW(A + B, std::invalid_argument);
+}
+
+TEST(MatrixExpressionTest, ExpressionOperandsOfProducts)
+{
+    const Matrix<int> A = Matrix<int>::Random(13, 11, std::bind(&Random::Fast<int>, -10, 10));
+    const Matrix<int> B = Matrix<int>::Random(13, 11, std::bind(&Random::Fast<int>, -10, 10), Matrix<int>::Ordering::ColumnMajor);
+    const Matrix<int> C = Matrix<int>::Random(11, 7, std::bind(&Random::Fast<int>, -10, 10));
+    const Matrix<int> SUM = A + B;
+
+    EXPECT_TRUE((A + B) * C == SUM * C);
+    EXPECT_TRUE((2 * A) * (C * 3) == 6 * (A * C));
+    EXPECT_TRUE((A + B) * (C + C) == SUM * (2 * C));
+    EXPECT_TRUE((A - B + B) * (C * Matrix<int>::ID(7)) == A * C);
+}
+
+TEST(MatrixExpressionTest, AssignmentMayReferenceTheResult)
+{
+    const Matrix<int> A = Matrix<int>::Random(9, 9, std::bind(&Random::Fast<int>, -10, 10));
+    const Matrix<int> B = Matrix<int>::Random(9, 9, std::bind(&Random::Fast<int>, -10, 10));
+    const Matrix<int> C = Matrix<int>::Random(9, 9, std::bind(&Random::Fast<int>, -10, 10));
+    const Matrix<int> AB = A.Multiply(B, Matrix<int>::Ordering::RowMajor);
+
+    Matrix<int> D(C);
+    D = A * B + D;
+    EXPECT_TRUE(D == AB + C);
+
+    Matrix<int> E(C);
+    E = A - E + E + E;
+    EXPECT_TRUE(E == A + C);
+
+    Matrix<int> F(A);
+    F = F * B - F;
+    EXPECT_TRUE(F == AB - A);
+}
+
+TEST(MatrixExpressionTest, TemporaryOperandsOutliveTheFullExpression)
+{
+    const Matrix<int> A = Matrix<int>::Random(8, 8, std::bind(&Random::Fast<int>, -10, 10));
+    const Matrix<int> B = Matrix<int>::Random(8, 8, std::bind(&Random::Fast<int>, -10, 10));
+    const auto copyOf = [](const Matrix<int>& matrix) { return Matrix<int>(matrix); };
+
+    const auto SUM      = copyOf(A) + B;
+    const auto PRODUCT  = A * copyOf(B);
+    const auto COMBINED = 2 * copyOf(A) - copyOf(B) * copyOf(A);
+    const auto OF_NODES = SUM * (copyOf(B) - A);
+
+    // Reuse the released buffers of the temporaries, if any were released.
+    const Matrix<int> OVERWRITE = Matrix<int>::Random(8, 8, std::bind(&Random::Fast<int>, 100, 200));
+    const Matrix<int> OVERWRITE_AGAIN(OVERWRITE);
+
+    const Matrix<int> A_PLUS_B  = A + B;
+    const Matrix<int> B_MINUS_A = B - A;
+    EXPECT_TRUE(Matrix<int>(SUM) == A_PLUS_B);
+    EXPECT_TRUE(Matrix<int>(PRODUCT) == A.Multiply(B, Matrix<int>::Ordering::RowMajor));
+    EXPECT_TRUE(Matrix<int>(COMBINED) == 2 * A - B * A);
+    EXPECT_TRUE(Matrix<int>(OF_NODES) == A_PLUS_B.Multiply(B_MINUS_A, Matrix<int>::Ordering::RowMajor));
+}
+
+TEST(MatrixTest, MoveConstructionAndAssignment)
+{
+    Matrix<int> A({ { 1, 2, 3 }, { 4, 5, 6 } }, Matrix<int>::Ordering::ColumnMajor);
+    const Matrix<int> EXPECTED(A);
+
+    Matrix<int> B(std::move(A));
+    EXPECT_TRUE(B == EXPECTED);
+    EXPECT_TRUE(B.GetOrdering() == Matrix<int>::Ordering::ColumnMajor);
+    EXPECT_EQ(A.GetHeight(), 0u);
+    EXPECT_EQ(A.GetWidth(), 0u);
+
+    A = std::move(B);
+    EXPECT_TRUE(A == EXPECTED);
+
+    Matrix<int> C = Matrix<int>::ID(4);
+    C = A;
+    EXPECT_TRUE(C == EXPECTED);
+    EXPECT_TRUE(C.GetOrdering() == Matrix<int>::Ordering::ColumnMajor);
+
+    std::vector<Matrix<int>> matrices;
+    for (size_t i = 1; i <= 8; ++i) {
+        matrices.push_back(Matrix<int>::ID(i));
+    }
+    EXPECT_TRUE(matrices[6] == Matrix<int>::ID(7));
+}
+
+TEST(MatrixTest, InPlaceCompoundOperators)
+{
+    const Matrix<int> A({ { 1, 2 }, { 3, 4 } });
+    const Matrix<int> B({ { 5, 6 }, { 7, 8 } }, Matrix<int>::Ordering::ColumnMajor);
+
+    Matrix<int> C(A);
+    C += B;
+    EXPECT_TRUE(C == Matrix<int>({ { 6, 8 }, { 10, 12 } }));
+    C -= A * B;
+    EXPECT_TRUE(C == Matrix<int>({ { -13, -14 }, { -33, -38 } }));
+    C *= -2;
+    EXPECT_TRUE(C == Matrix<int>({ { 26, 28 }, { 66, 76 } }));
+    C -= C;
+    EXPECT_TRUE(C == Matrix<int>(2, 2));
+    EXPECT_THROW(C += Matrix<int>::ID(3), std::invalid_argument);
+
+    Matrix<int> D(A);
+    D *= D;
+    EXPECT_TRUE(D == Matrix<int>({ { 7, 10 }, { 15, 22 } }));
+
+    Matrix<int> E({ { 1, 2, 3 }, { 4, 5, 6 } });
+    E *= Matrix<int>({ { 1 }, { 1 }, { 1 } });
+    EXPECT_TRUE(E == Matrix<int>({ { 6 }, { 15 } }));
+    EXPECT_THROW(E *= A, std::invalid_argument);
+}
+
+TEST(MatrixTest, InPlaceMultiplicationMatchesProduct)
+{
+    // More rows than one scratch block, in both orderings.
+    for (auto ordering : { Matrix<double>::Ordering::RowMajor, Matrix<double>::Ordering::ColumnMajor })
+    {
+        const Matrix<double> A = Matrix<double>::Random(301, 47, std::bind<double>(&Random::Fast<double>, -1.0, 1.0), ordering);
+        const Matrix<double> B = Matrix<double>::Random(47, 47, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+        const Matrix<double> EXPECTED = A * B;
+
+        Matrix<double> RESULT(A);
+        RESULT *= B;
+        EXPECT_TRUE(RESULT == EXPECTED);
+        EXPECT_TRUE(RESULT.GetOrdering() == ordering);
+    }
+}
+
+TEST(MatrixTest, Swap)
+{
+    Matrix<int> A({ { 1, 2, 3 } });
+    Matrix<int> B({ { 4 }, { 5 } }, Matrix<int>::Ordering::ColumnMajor);
+
+    A.Swap(B);
+    EXPECT_TRUE(A == Matrix<int>({ { 4 }, { 5 } }));
+    EXPECT_TRUE(A.GetOrdering() == Matrix<int>::Ordering::ColumnMajor);
+    EXPECT_TRUE(B == Matrix<int>({ { 1, 2, 3 } }));
+
+    swap(A, B);
+    EXPECT_TRUE(A == Matrix<int>({ { 1, 2, 3 } }));
+}
+
+TEST(MatrixTest, TransposeAndOrderingConversion)
+{
+    const Matrix<int> A({ { 1, 2, 3 }, { 4, 5, 6 } });
+    const Matrix<int> A_T({ { 1, 4 }, { 2, 5 }, { 3, 6 } });
+
+    for (auto ordering : { Matrix<int>::Ordering::RowMajor, Matrix<int>::Ordering::ColumnMajor })
+    {
+        const Matrix<int> B = A.ToOrdering(ordering);
+        EXPECT_TRUE(B == A);
+        EXPECT_TRUE(B.GetOrdering() == ordering);
+
+        const Matrix<int> B_T = B.Transpose();
+        EXPECT_TRUE(B_T == A_T);
+        EXPECT_TRUE(B_T.GetOrdering() == ordering);
+
+        Matrix<int> C(B);
+        C.TransposeInPlace();
+        EXPECT_TRUE(C == A_T);
+        EXPECT_TRUE(C.GetOrdering() == ordering);
+    }
+}
+
+TEST(MatrixTest, TransposeOfLargerMatrices)
+{
+    // Sizes around the leaf size of the recursion and tall and wide shapes.
+    for (auto [rows, columns] : { std::pair<size_t, size_t>{ 31, 33 }, { 97, 5 }, { 3, 250 }, { 64, 64 }, { 65, 65 } })
+    {
+        const Matrix<double> A = Matrix<double>::Random(rows, columns, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+        const Matrix<double> A_T = A.Transpose();
+        const Matrix<double> A_COLUMN_MAJOR = A.ToOrdering(Matrix<double>::Ordering::ColumnMajor);
+
+        ASSERT_EQ(A_T.GetHeight(), columns);
+        ASSERT_EQ(A_T.GetWidth(), rows);
+        Matrix<double> A_T_IN_PLACE(A);
+        A_T_IN_PLACE.TransposeInPlace();
+
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < columns; ++c) {
+                ASSERT_EQ(A_T[c][r], A[r][c]);
+                ASSERT_EQ(A_T_IN_PLACE[c][r], A[r][c]);
+                ASSERT_EQ(A_COLUMN_MAJOR[r][c], A[r][c]);
+            }
+        }
+        EXPECT_TRUE(A_T.Transpose() == A);
+    }
+}
+
 TEST(MatrixThreadsTest, RandomMatrixMultiplication)
 {
     constexpr size_t minElementsPerThread = Matrix<float>::MIN_OPERATIONS_PER_THREAD;
@@ -513,5 +811,498 @@ TEST(MatrixThreadsTest, RandomMatrixMultiplication)
     ThreadPool::Start(threadCount);
     Matrix<float> RESULT = A * B;
     ThreadPool::Stop();
+
+    // The inner dimension dominates and is split, which only changes the order of the summation.
+    const double tolerance = dimA * static_cast<double>(std::numeric_limits<float>::epsilon()) * 10.0 * 10.0;
+    EXPECT_LE(MaxAbsDifference(RESULT, EXPECTED), tolerance);
+}
+
+TEST(GemmTest, BatchedProductsOfAllLayouts)
+{
+    const auto generator = std::bind(&Random::Fast<int>, -10, 10);
+    constexpr size_t count = 150; // Two full groups of matrices and a partial one
+
+    // Tiny, rectangular, vectors and large enough for the blocked kernel.
+    const std::vector<std::array<size_t, 3>> shapes = { { 3, 3, 3 }, { 4, 2, 5 }, { 1, 7, 1 }, { 20, 17, 16 } };
+
+    for (const auto& [m, n, k] : shapes)
+    {
+        std::vector<Matrix<int>> A, B, C;
+        for (size_t i = 0; i < count; ++i) {
+            A.push_back(Matrix<int>::Random(m, k, generator));
+            B.push_back(Matrix<int>::Random(k, n, generator));
+            C.push_back(Matrix<int>::Random(m, n, generator));
+        }
+
+        // RowMajor A with gaps between the matrices, ColumnMajor B, and all operands interleaved.
+        const Gemm::BatchStrides aStrided = Gemm::BatchStrides::Strided(m * k + 3, { k, 1 });
+        const Gemm::BatchStrides bStrided = Gemm::BatchStrides::Strided(k * n, { 1, k });
+        const Gemm::BatchStrides cStrided = Gemm::BatchStrides::Strided(m * n, { n, 1 });
+        const Gemm::BatchStrides aInterleaved = Gemm::BatchStrides::Interleaved(count, { k, 1 });
+        const Gemm::BatchStrides bInterleaved = Gemm::BatchStrides::Interleaved(count, { n, 1 });
+        const Gemm::BatchStrides cInterleaved = Gemm::BatchStrides::Interleaved(count, { n, 1 });
+
+        const auto fill = [](const std::vector<Matrix<int>>& matrices, Gemm::BatchStrides strides, size_t length) {
+            std::vector<int> data(length);
+            for (size_t i = 0; i < matrices.size(); ++i) {
+                for (size_t r = 0; r < matrices[i].GetHeight(); ++r) {
+                    for (size_t c = 0; c < matrices[i].GetWidth(); ++c) {
+                        data[i * strides.Batch + r * strides.Row + c * strides.Col] = matrices[i][r][c];
+                    }
+                }
+            }
+            return data;
+        };
+
+        for (bool interleavedOperands : { false, true }) {
+            for (bool interleavedResult : { false, true })
+            {
+                const Gemm::BatchStrides as = interleavedOperands ? aInterleaved : aStrided;
+                const Gemm::BatchStrides bs = interleavedOperands ? bInterleaved : bStrided;
+                const Gemm::BatchStrides cs = interleavedResult ? cInterleaved : cStrided;
+
+                const std::vector<int> a = fill(A, as, count * (m * k + 3));
+                const std::vector<int> b = fill(B, bs, count * k * n);
+                std::vector<int> product(count * m * n);
+                std::vector<int> accumulated = fill(C, cs, count * m * n);
+
+                Gemm::MultiplyBatched<int>(count, m, n, k, 1, a.data(), as, b.data(), bs, 0, product.data(), cs, 1);
+                Gemm::MultiplyBatched<int>(count, m, n, k, 2, a.data(), as, b.data(), bs, 1, accumulated.data(), cs, 1);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const Matrix<int> EXPECTED = A[i] * B[i];
+                    const Matrix<int> EXPECTED_ACCUMULATED = C[i] + 2 * EXPECTED;
+                    for (size_t r = 0; r < m; ++r) {
+                        for (size_t c = 0; c < n; ++c)
+                        {
+                            const size_t idx = i * cs.Batch + r * cs.Row + c * cs.Col;
+                            ASSERT_EQ(product[idx], EXPECTED[r][c]) << m << "x" << n << "x" << k << ", matrix " << i;
+                            ASSERT_EQ(accumulated[idx], EXPECTED_ACCUMULATED[r][c]) << m << "x" << n << "x" << k << ", matrix " << i;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(MatrixThreadsTest, ParallelBatchedProducts)
+{
+    constexpr size_t count = 20'000;
+    constexpr size_t size = 4;
+    const auto generator = std::bind<double>(&Random::Fast<double>, -1.0, 1.0);
+
+    const Matrix<double> A = Matrix<double>::Random(count, size * size, generator);
+    const Matrix<double> B = Matrix<double>::Random(count, size * size, generator, Matrix<double>::Ordering::ColumnMajor);
+    const Gemm::BatchStrides as = Gemm::BatchStrides::Strided(size * size, { size, 1 });
+    const Gemm::BatchStrides bs = Gemm::BatchStrides::Interleaved(count, { size, 1 });
+
+    const auto multiply = [&]() {
+        Matrix<double> C(count, size * size);
+        Gemm::MultiplyBatched<double>(count, size, size, size, 1.0, A.View().Data(), as, B.View().Data(), bs, 0.0,
+                                      C.View().Data(), as, 100'000);
+        return C;
+    };
+
+    const Matrix<double> EXPECTED = multiply();
+    ThreadPool::Start(3);
+    const Matrix<double> RESULT = multiply();
+    ThreadPool::Stop();
+
+    EXPECT_TRUE(RESULT == EXPECTED);
+
+    // Matrix 17 of the batch: a row of A, and the same elements of all matrices are a row of B.
+    Matrix<double> B17(size, size);
+    for (size_t e = 0; e < size * size; ++e) {
+        B17[e / size][e % size] = B[17][e];
+    }
+    const Matrix<double> C17 = MatrixView<const double>(A.Row(17).Data(), size, size, size) * B17;
+    EXPECT_TRUE(MatrixView<const double>(RESULT.Row(17).Data(), size, size, size) == C17);
+}
+
+TEST(MatrixThreadsTest, PartitionFollowsTheShapeOfTheProduct)
+{
+    constexpr size_t minOperations = 1000;
+
+    // Square products are split along both dimensions of the result.
+    const Gemm::Partition square = Gemm::PlanPartition(1000, 1000, 1000, 4, minOperations);
+    EXPECT_EQ(square.Rows, 2u);
+    EXPECT_EQ(square.Columns, 2u);
+    EXPECT_EQ(square.Depth, 1u);
+
+    // Tall-skinny and short-wide products are split along their long side only.
+    const Gemm::Partition tall = Gemm::PlanPartition(1'000'000, 10, 10, 6, minOperations);
+    EXPECT_EQ(tall.Rows, 6u);
+    EXPECT_EQ(tall.Tiles(), 6u);
+    const Gemm::Partition wide = Gemm::PlanPartition(10, 1'000'000, 10, 5, minOperations);
+    EXPECT_EQ(wide.Columns, 5u);
+    EXPECT_EQ(wide.Tiles(), 5u);
+
+    // The inner dimension is split once the tiles of the result become too thin.
+    const Gemm::Partition inner = Gemm::PlanPartition(200, 1, 1'000'000, 8, minOperations);
+    EXPECT_EQ(inner.Rows, 2u);
+    EXPECT_EQ(inner.Depth, 4u);
+
+    // Never more tiles than there are operations for.
+    EXPECT_EQ(Gemm::PlanPartition(10, 10, 10, 8, minOperations).Tiles(), 1u);
+    EXPECT_EQ(Gemm::PlanPartition(100, 10, 10, 8, minOperations).Tiles(), 8u);
+
+    for (size_t parts : { size_t(1), size_t(3), size_t(7) })
+    {
+        size_t previous = 0;
+        for (size_t i = 0; i <= parts; ++i)
+        {
+            const size_t bound = Gemm::Partition::Bound(1000, parts, i, 8);
+            EXPECT_GE(bound, previous);
+            EXPECT_EQ(bound % 8 == 0 || i == parts, true);
+            previous = bound;
+        }
+        EXPECT_EQ(previous, 1000u);
+    }
+}
+
+TEST(MatrixThreadsTest, ParallelMultiplicationOfAllShapes)
+{
+    constexpr size_t minOperations = Matrix<int>::MIN_OPERATIONS_PER_THREAD;
+    const auto generator = std::bind(&Random::Fast<int>, -10, 10);
+
+    // Tall-skinny, short-wide, dominating inner dimension and square, with odd extents.
+    const std::vector<std::array<size_t, 3>> shapes = {
+        { 3 * minOperations / 100 + 7, 9, 11 },
+        { 9, 3 * minOperations / 100 + 7, 11 },
+        { 13, 3, 3 * minOperations / 39 + 257 },
+        { 211, 203, 197 }
+    };
+
+    for (const auto& [m, n, k] : shapes)
+    {
+        for (auto ordering : { Matrix<int>::Ordering::RowMajor, Matrix<int>::Ordering::ColumnMajor })
+        {
+            const Matrix<int> A = Matrix<int>::Random(m, k, generator, ordering);
+            const Matrix<int> B = Matrix<int>::Random(k, n, generator);
+            const Matrix<int> C = Matrix<int>::Random(m, n, generator, ordering);
+            const Matrix<int> PRODUCT_EXPECTED = A.Multiply(B, ordering);
+            const Matrix<int> ACCUMULATED_EXPECTED = A * B + C;
+
+            ThreadPool::Start(3);
+            const Matrix<int> PRODUCT = A.Multiply(B, ordering);
+            Matrix<int> ACCUMULATED(C);
+            ACCUMULATED += A * B;
+            ThreadPool::Stop();
+
+            EXPECT_TRUE(PRODUCT == PRODUCT_EXPECTED) << m << "x" << n << "x" << k;
+            EXPECT_TRUE(ACCUMULATED == ACCUMULATED_EXPECTED) << m << "x" << n << "x" << k;
+        }
+    }
+}
+
+TEST(MatrixTest, ProductsWithVectors)
+{
+    const auto generator = std::bind(&Random::Fast<int>, -10, 10);
+
+    const auto naiveProduct = [](const Matrix<int>& A, const Matrix<int>& B) {
+        Matrix<int> C(A.GetHeight(), B.GetWidth());
+        for (size_t i = 0; i < A.GetHeight(); ++i) {
+            for (size_t j = 0; j < B.GetWidth(); ++j) {
+                for (size_t p = 0; p < A.GetWidth(); ++p) {
+                    C[i][j] += A[i][p] * B[p][j];
+                }
+            }
+        }
+        return C;
+    };
+
+    // Matrix-vector, vector-matrix, outer product and dot product.
+    const std::vector<std::array<size_t, 3>> shapes = { { 133, 1, 71 }, { 1, 133, 71 }, { 133, 71, 1 }, { 1, 1, 133 } };
+
+    for (const auto& [m, n, k] : shapes)
+    {
+        for (auto lhsOrdering : { Matrix<int>::Ordering::RowMajor, Matrix<int>::Ordering::ColumnMajor }) {
+            for (auto rhsOrdering : { Matrix<int>::Ordering::RowMajor, Matrix<int>::Ordering::ColumnMajor })
+            {
+                const Matrix<int> A = Matrix<int>::Random(m, k, generator, lhsOrdering);
+                const Matrix<int> B = Matrix<int>::Random(k, n, generator, rhsOrdering);
+                const Matrix<int> C = Matrix<int>::Random(m, n, generator, lhsOrdering);
+                const Matrix<int> EXPECTED = naiveProduct(A, B);
+
+                EXPECT_TRUE(A * B == EXPECTED) << m << "x" << n << "x" << k;
+                EXPECT_TRUE(A.Multiply(B, Matrix<int>::Ordering::ColumnMajor) == EXPECTED) << m << "x" << n << "x" << k;
+
+                // Scaled and accumulated: the rank-1 update C += 2 * a * b for the outer product.
+                Matrix<int> ACCUMULATED(C);
+                ACCUMULATED += 2 * (A * B);
+                EXPECT_TRUE(ACCUMULATED == C + 2 * EXPECTED) << m << "x" << n << "x" << k;
+            }
+        }
+    }
+}
+
+TEST(MatrixViewTest, SlicesShareTheElementsOfTheMatrix)
+{
+    for (auto ordering : { Matrix<int>::Ordering::RowMajor, Matrix<int>::Ordering::ColumnMajor })
+    {
+        Matrix<int> M({ {  1,  2,  3,  4,  5 },
+                        {  6,  7,  8,  9, 10 },
+                        { 11, 12, 13, 14, 15 },
+                        { 16, 17, 18, 19, 20 } }, ordering);
+
+        const MatrixView<int> BLOCK = M.Block(1, 1, 2, 3);
+        EXPECT_TRUE(BLOCK == Matrix<int>({ { 7, 8, 9 }, { 12, 13, 14 } }));
+        EXPECT_TRUE(M.Row(2) == Matrix<int>({ { 11, 12, 13, 14, 15 } }));
+        EXPECT_TRUE(M.Column(3) == Matrix<int>({ { 4 }, { 9 }, { 14 }, { 19 } }));
+        EXPECT_TRUE(BLOCK.Column(2).Row(1) == Matrix<int>({ { 14 } }));
+        EXPECT_TRUE(M.View().Block(0, 0, 4, 5) == M);
+        EXPECT_EQ(M.View().IsContiguous(), true);
+        EXPECT_EQ(BLOCK.IsContiguous(), false);
+
+        BLOCK(1, 2) = 100;
+        EXPECT_EQ(M[2][3], 100);
+
+        EXPECT_THROW(M.Block(2, 2, 3, 1), std::out_of_range);
+        EXPECT_THROW(M.Row(4), std::out_of_range);
+        EXPECT_THROW(BLOCK(2, 0), std::out_of_range);
+    }
+
+    std::vector<double> data(12, 1.0);
+    EXPECT_THROW(MatrixView<double>(data.data(), 3, 4, 3), std::invalid_argument);
+    EXPECT_TRUE(MatrixView<const double>(data.data(), 3, 2, 4) == Matrix<double>({ { 1.0, 1.0 }, { 1.0, 1.0 }, { 1.0, 1.0 } }));
+}
+
+TEST(MatrixViewTest, ViewsInExpressions)
+{
+    const auto generator = std::bind(&Random::Fast<int>, -10, 10);
+
+    for (auto lhsOrdering : { Matrix<int>::Ordering::RowMajor, Matrix<int>::Ordering::ColumnMajor }) {
+        for (auto rhsOrdering : { Matrix<int>::Ordering::RowMajor, Matrix<int>::Ordering::ColumnMajor })
+        {
+            const Matrix<int> A = Matrix<int>::Random(23, 19, generator, lhsOrdering);
+            const Matrix<int> B = Matrix<int>::Random(19, 29, generator, rhsOrdering);
+
+            // Copies of the blocks as reference.
+            const Matrix<int> A_BLOCK = A.Block(3, 2, 11, 13);
+            const Matrix<int> B_BLOCK = B.Block(1, 5, 13, 7);
+            const Matrix<int> B_SQUARE = B.Block(2, 3, 11, 13);
+            EXPECT_EQ(A_BLOCK.GetOrdering(), lhsOrdering);
+
+            EXPECT_TRUE(A.Block(3, 2, 11, 13) + 2 * B.Block(2, 3, 11, 13) == A_BLOCK + 2 * B_SQUARE);
+            EXPECT_TRUE(A.Block(3, 2, 11, 13) * B.Block(1, 5, 13, 7) == A_BLOCK * B_BLOCK);
+            EXPECT_TRUE(A.Row(4) * B.Block(0, 0, 19, 29).Column(3) == Matrix<int>(A.Row(4)) * Matrix<int>(B.Block(0, 3, 19, 1)));
+            EXPECT_TRUE(B.Block(0, 0, 19, 29).Column(3) * A.Row(4) == Matrix<int>(B.Block(0, 3, 19, 1)) * Matrix<int>(A.Row(4)));
+
+            // Assigning into a block only writes the block.
+            Matrix<int> C = Matrix<int>::Random(20, 20, generator, rhsOrdering);
+            const Matrix<int> C_BEFORE = C;
+            C.Block(4, 6, 11, 7) = A.Block(3, 2, 11, 13) * B.Block(1, 5, 13, 7) - C.Block(4, 6, 11, 7);
+            C.Row(0) += C.Row(19);
+            C.Column(0) *= 3;
+
+            Matrix<int> C_EXPECTED = C_BEFORE;
+            const Matrix<int> PRODUCT = A_BLOCK * B_BLOCK;
+            for (size_t r = 0; r < 20; ++r) {
+                for (size_t c = 0; c < 20; ++c)
+                {
+                    if (r >= 4 && r < 15 && c >= 6 && c < 13) {
+                        C_EXPECTED[r][c] = PRODUCT[r - 4][c - 6] - C_BEFORE[r][c];
+                    }
+                    if (r == 0) {
+                        C_EXPECTED[r][c] += C_BEFORE[19][c];
+                    }
+                    if (c == 0) {
+                        C_EXPECTED[r][c] *= 3;
+                    }
+                }
+            }
+            EXPECT_TRUE(C == C_EXPECTED);
+
+            EXPECT_THROW(C.Block(0, 0, 2, 2).CopyFrom(A.Block(0, 0, 2, 3)), std::invalid_argument);
+        }
+    }
+}
+
+TEST(MatrixViewTest, AssignmentOfOverlappingViews)
+{
+    Matrix<int> M({ { 1, 2, 3, 4 }, { 5, 6, 7, 8 }, { 9, 10, 11, 12 } });
+
+    // Shifting a block by one element reads elements that the assignment overwrites.
+    M.Block(0, 0, 2, 3).CopyFrom(M.Block(1, 1, 2, 3));
+    EXPECT_TRUE(M == Matrix<int>({ { 6, 7, 8, 4 }, { 10, 11, 12, 8 }, { 9, 10, 11, 12 } }));
+
+    // A product with an operand that is part of the result.
+    Matrix<int> N({ { 1, 2 }, { 3, 4 }, { 0, 0 } });
+    N.Block(1, 0, 2, 2) = N.Block(0, 0, 2, 2) * N.Block(0, 0, 2, 2);
+    EXPECT_TRUE(N == Matrix<int>({ { 1, 2 }, { 7, 10 }, { 15, 22 } }));
+
+    // Strided rows of a ColumnMajor matrix.
+    Matrix<int> S({ { 1, 2, 3 }, { 4, 5, 6 } }, Matrix<int>::Ordering::ColumnMajor);
+    S.Row(0) = S.Row(0) + S.Row(1);
+    EXPECT_TRUE(S == Matrix<int>({ { 5, 7, 9 }, { 4, 5, 6 } }));
+
+    std::stringstream VIEW_OUTPUT;
+    std::stringstream MATRIX_OUTPUT;
+    VIEW_OUTPUT << M.Block(0, 1, 2, 2);
+    MATRIX_OUTPUT << Matrix<int>(M.Block(0, 1, 2, 2));
+    EXPECT_EQ(VIEW_OUTPUT.str(), MATRIX_OUTPUT.str());
+}
+
+TEST(MatrixViewTest, AssignmentRebindsTheView)
+{
+    static_assert(std::is_assignable_v<MatrixView<int>&, const MatrixView<int>&>);
+    static_assert(!std::is_assignable_v<MatrixView<int>, const MatrixView<int>&>);
+    static_assert(!std::is_assignable_v<MatrixView<int>&, const MatrixView<const int>&>);
+
+    Matrix<int> M({ { 1, 2 }, { 3, 4 } });
+    MatrixView<int> view = M.Row(0);
+    const MatrixView<int> SECOND_ROW = M.Row(1);
+
+    view = SECOND_ROW;
+    view(0, 0) = 5;
+    EXPECT_TRUE(M == Matrix<int>({ { 1, 2 }, { 5, 4 } }));
+
+    MatrixView<const int> readOnly = M.Column(1);
+    readOnly = view;
+    EXPECT_TRUE(readOnly == Matrix<int>({ { 5, 4 } }));
+
+    view = M.Row(0);
+    view.CopyFrom(readOnly);
+    EXPECT_TRUE(M == Matrix<int>({ { 5, 4 }, { 5, 4 } }));
+}
+
+TEST(MatrixThreadsTest, ParallelProductsWithVectors)
+{
+    constexpr size_t length = 3 * Matrix<double>::MIN_OPERATIONS_PER_THREAD / 1000 + 7;
+    const auto generator = std::bind<double>(&Random::Fast<double>, -1.0, 1.0);
+
+    for (auto ordering : { Matrix<double>::Ordering::RowMajor, Matrix<double>::Ordering::ColumnMajor })
+    {
+        const Matrix<double> A = Matrix<double>::Random(length, 1000, generator, ordering);
+        const Matrix<double> x = Matrix<double>::Random(1000, 1, generator);
+        const Matrix<double> y = Matrix<double>::Random(1, length, generator);
+        const Matrix<double> u = Matrix<double>::Random(length, 1, generator);
+        const Matrix<double> v = Matrix<double>::Random(1, 1000, generator);
+        const Matrix<double> AX_EXPECTED = A * x;
+        const Matrix<double> YA_EXPECTED = y * A;
+        Matrix<double> UPDATED_EXPECTED(A);
+        UPDATED_EXPECTED += u * v;
+
+        ThreadPool::Start(3);
+        const Matrix<double> AX = A * x;
+        const Matrix<double> YA = y * A;
+        Matrix<double> UPDATED(A);
+        UPDATED += u * v;
+        ThreadPool::Stop();
+
+        EXPECT_TRUE(AX == AX_EXPECTED);
+        EXPECT_TRUE(YA == YA_EXPECTED);
+        EXPECT_TRUE(UPDATED == UPDATED_EXPECTED);
+    }
+}
+
+TEST(MatrixThreadsTest, ParallelStrassenMatchesSerial)
+{
+    const Matrix<double> A = Matrix<double>::Random(130, 121, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> B = Matrix<double>::Random(121, 115, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> EXPECTED = A.MultiplyStrassen(B, 16);
+
+    ThreadPool::Start(3);
+    const Matrix<double> RESULT = A.MultiplyStrassen(B, 16);
+    ThreadPool::Stop();
+
+    EXPECT_TRUE(RESULT == EXPECTED);
+}
+
+TEST(MatrixThreadsTest, ParallelAssignmentToViews)
+{
+    // Blocks with gaps between their lines, large enough to be split into several slices.
+    constexpr size_t rows = 1000;
+    constexpr size_t columns = 3 * Matrix<int>::MIN_OPERATIONS_PER_THREAD / rows + 7;
+
+    const Matrix<int> A = Matrix<int>::Random(rows + 5, columns + 3, std::bind(&Random::Fast<int>, -100, 100));
+    const Matrix<int> B = Matrix<int>::Random(rows + 2, columns + 9, std::bind(&Random::Fast<int>, -100, 100), Matrix<int>::Ordering::ColumnMajor);
+    Matrix<int> EXPECTED = Matrix<int>::Random(rows + 1, columns + 1, std::bind(&Random::Fast<int>, -100, 100));
+    Matrix<int> RESULT(EXPECTED);
+
+    EXPECTED.Block(1, 0, rows, columns) = A.Block(5, 3, rows, columns) - 2 * B.Block(1, 7, rows, columns) + EXPECTED.Block(1, 0, rows, columns);
+
+    ThreadPool::Start(3);
+    RESULT.Block(1, 0, rows, columns) = A.Block(5, 3, rows, columns) - 2 * B.Block(1, 7, rows, columns) + RESULT.Block(1, 0, rows, columns);
+    ThreadPool::Stop();
+
     EXPECT_TRUE(RESULT == EXPECTED);
 }
+
+TEST(MatrixThreadsTest, ParallelElementwiseOperationsAndCopies)
+{
+    // Large enough to be split into several slices.
+    constexpr size_t rows = 1000;
+    constexpr size_t columns = 3 * Matrix<int>::MIN_OPERATIONS_PER_THREAD / rows + 7;
+
+    const Matrix<int> A = Matrix<int>::Random(rows, columns, std::bind(&Random::Fast<int>, -100, 100));
+    const Matrix<int> B = Matrix<int>::Random(rows, columns, std::bind(&Random::Fast<int>, -100, 100), Matrix<int>::Ordering::ColumnMajor);
+    const Matrix<int> SUM_EXPECTED = A + B;
+    const Matrix<int> DIFF_EXPECTED = A - 2 * A;
+
+    ThreadPool::Start(3);
+    const Matrix<int> SUM = A + B;
+    const Matrix<int> DIFF = A - 2 * A;
+    Matrix<int> COPY(A);
+    COPY *= 3;
+    const Matrix<int> ID = Matrix<int>::ID(rows);
+    const Matrix<int> ZEROS(rows, columns);
+    ThreadPool::Stop();
+
+    EXPECT_TRUE(SUM == SUM_EXPECTED);
+    EXPECT_TRUE(DIFF == DIFF_EXPECTED);
+    EXPECT_TRUE(COPY == 3 * A);
+    EXPECT_TRUE(ID == Matrix<int>::ID(rows));
+    EXPECT_TRUE(ZEROS == A - A);
+}
+
+TEST(MatrixThreadsTest, ParallelComparisonFindsEveryMismatch)
+{
+    constexpr size_t rows = 1000;
+    constexpr size_t columns = 3 * Matrix<double>::MIN_OPERATIONS_PER_THREAD / rows + 7;
+
+    const Matrix<double> A = Matrix<double>::Random(rows, columns, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    Matrix<double> A_COLUMN_MAJOR(rows, columns, Matrix<double>::Ordering::ColumnMajor);
+    A_COLUMN_MAJOR = 1.0 * A; // Assigning an expression keeps the ordering
+
+    ThreadPool::Start(3);
+    EXPECT_TRUE(A == Matrix<double>(A));
+    EXPECT_TRUE(A == A_COLUMN_MAJOR);
+
+    // Mismatches in the first and in the last slice, in both orderings.
+    for (size_t row : { size_t(0), rows / 2, rows - 1 })
+    {
+        Matrix<double> B(A);
+        B[row][columns - 1] += 1.0;
+        EXPECT_FALSE(A == B) << "row: " << row;
+        EXPECT_FALSE(A_COLUMN_MAJOR == B) << "row: " << row;
+    }
+    ThreadPool::Stop();
+}
+
+TEST(MatrixThreadsTest, ParallelTranspose)
+{
+    constexpr size_t rows = 1000;
+    constexpr size_t columns = 3 * Matrix<int>::MIN_OPERATIONS_PER_THREAD / rows + 7;
+
+    const Matrix<int> A = Matrix<int>::Random(rows, columns, std::bind(&Random::Fast<int>, -100, 100));
+    const Matrix<int> SQUARE = Matrix<int>::Random(2 * rows + 3, 2 * rows + 3, std::bind(&Random::Fast<int>, -100, 100));
+    const Matrix<int> A_T_EXPECTED = A.Transpose();
+    const Matrix<int> A_COLUMN_MAJOR_EXPECTED = A.ToOrdering(Matrix<int>::Ordering::ColumnMajor);
+    Matrix<int> SQUARE_T_EXPECTED(SQUARE);
+    SQUARE_T_EXPECTED.TransposeInPlace();
+
+    ThreadPool::Start(3);
+    const Matrix<int> A_T = A.Transpose();
+    const Matrix<int> A_COLUMN_MAJOR = A.ToOrdering(Matrix<int>::Ordering::ColumnMajor);
+    Matrix<int> SQUARE_T(SQUARE);
+    SQUARE_T.TransposeInPlace();
+    ThreadPool::Stop();
+
+    EXPECT_TRUE(A_T == A_T_EXPECTED);
+    EXPECT_TRUE(A_COLUMN_MAJOR == A_COLUMN_MAJOR_EXPECTED);
+    EXPECT_TRUE(SQUARE_T == SQUARE_T_EXPECTED);
+    EXPECT_TRUE(SQUARE_T.Transpose() == SQUARE);
+}
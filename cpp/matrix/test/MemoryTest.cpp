@@ -0,0 +1,258 @@
+#include "gtest/gtest.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Math.hpp"
+#include "Matrix.hpp"
+#include "Memory.hpp"
+
+
+namespace
+{
+    /// @brief Forwards to the default allocator and counts the live buffers.
+    class CountingAllocator final : public Memory::Allocator
+    {
+    public:
+        void* Allocate(size_t bytes) override
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++Allocations;
+            LiveBytes += bytes;
+            return Memory::DefaultAllocator().Allocate(bytes);
+        }
+
+        void Deallocate(void* ptr, size_t bytes) noexcept override
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++Deallocations;
+            LiveBytes -= bytes;
+            Memory::DefaultAllocator().Deallocate(ptr, bytes);
+        }
+
+        size_t Allocations   = 0;
+        size_t Deallocations = 0;
+        size_t LiveBytes     = 0;
+
+    private:
+        std::mutex _mutex;
+    };
+
+    bool IsAligned(const void* ptr, size_t alignment)
+    {
+        return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+    }
+
+} // end anonymous namespace
+
+
+TEST(MemoryTest, BuffersAreAligned)
+{
+    for (size_t count : { size_t(1), size_t(3), size_t(1000), size_t(12345) })
+    {
+        const Memory::Buffer<double> buffer = Memory::Allocate<double>(count);
+        EXPECT_TRUE(IsAligned(buffer.get(), Memory::ALIGNMENT)) << count;
+    }
+
+    EXPECT_EQ(Memory::Allocate<float>(0).get(), nullptr);
+}
+
+TEST(MemoryTest, LargeBuffersAreAlignedToHugePages)
+{
+    Memory::AlignedAllocator allocator(Memory::HUGE_PAGE_SIZE);
+
+    const size_t bytes = Memory::HUGE_PAGE_SIZE + 8;
+    void* ptr = allocator.Allocate(bytes);
+    EXPECT_TRUE(IsAligned(ptr, Memory::HUGE_PAGE_SIZE));
+    allocator.Deallocate(ptr, bytes);
+}
+
+TEST(MemoryTest, MatricesUseTheCurrentAllocator)
+{
+    CountingAllocator counting;
+    Memory::Allocator* previous = Memory::SetAllocator(&counting);
+    EXPECT_EQ(previous, &Memory::DefaultAllocator());
+
+    {
+        const Matrix<float> A = Matrix<float>::Random(20, 30, std::bind<float>(&Random::Fast<float>, -1.0f, 1.0f));
+        const Matrix<float> B(30, 10);
+        EXPECT_EQ(counting.Allocations, 2u);
+        EXPECT_EQ(counting.LiveBytes, (20 * 30 + 30 * 10) * sizeof(float));
+
+        // Buffers are returned to the allocator they were drawn from, even after it is replaced.
+        Memory::SetAllocator(nullptr);
+        const Matrix<float> C = A * B;
+        EXPECT_GE(counting.Allocations, 2u);
+    }
+
+    EXPECT_EQ(counting.Allocations, counting.Deallocations);
+    EXPECT_EQ(counting.LiveBytes, 0u);
+    EXPECT_EQ(&Memory::GetAllocator(), &Memory::DefaultAllocator());
+}
+
+TEST(MemoryTest, MatricesAdoptArraysAllocatedWithNew)
+{
+    std::unique_ptr<int[]> data(new int[4] { 1, 2, 3, 4 });
+    const Matrix<int> A(2, 2, std::move(data));
+    EXPECT_TRUE(A == Matrix<int>({ { 1, 2 }, { 3, 4 } }));
+}
+
+TEST(MemoryTest, PoolReusesReleasedBlocks)
+{
+    CountingAllocator upstream;
+    Memory::PoolAllocator pool(static_cast<size_t>(1) << 30, &upstream);
+
+    {
+        Memory::AllocatorScope scope(pool);
+        for (size_t i = 0; i < 100; ++i)
+        {
+            const Matrix<double> A = Matrix<double>::Random(30, 40, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+            const Matrix<double> B(40, 20);
+            const Matrix<double> C = A * B + Matrix<double>(30, 20);
+        }
+    }
+    EXPECT_EQ(&Memory::GetAllocator(), &Memory::DefaultAllocator());
+
+    // Only the first iteration (and the kernel scratch buffers of its first product) misses.
+    const Memory::PoolAllocator::Stats stats = pool.GetStats();
+    EXPECT_LE(stats.Misses, 8u);
+    EXPECT_EQ(upstream.Allocations, stats.Misses);
+    EXPECT_GT(stats.HitRate(), 0.95);
+    EXPECT_EQ(stats.RetainedBlocks, stats.Misses);
+    EXPECT_EQ(stats.RetainedBytes, upstream.LiveBytes);
+
+    pool.Trim();
+    EXPECT_EQ(pool.GetStats().RetainedBytes, 0u);
+    EXPECT_EQ(upstream.LiveBytes, 0u);
+}
+
+TEST(MemoryTest, PoolCachesOfExitedThreadsAreMovedToTheShards)
+{
+    CountingAllocator upstream;
+    Memory::PoolAllocator pool(static_cast<size_t>(1) << 30, &upstream);
+
+    // More blocks of one size than a thread caches, so some are spilled to the shards while
+    // the threads run, and the rest when they exit.
+    constexpr size_t threadCount = 4;
+    constexpr size_t blocks = 20;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&pool]() {
+            std::vector<void*> allocated;
+            for (size_t round = 0; round < 10; ++round)
+            {
+                for (size_t i = 0; i < blocks; ++i) {
+                    allocated.push_back(pool.Allocate(1000));
+                }
+                for (void* ptr : allocated) {
+                    pool.Deallocate(ptr, 1000);
+                }
+                allocated.clear();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    const Memory::PoolAllocator::Stats stats = pool.GetStats();
+    EXPECT_EQ(stats.RetainedBlocks, upstream.Allocations);
+    EXPECT_EQ(stats.RetainedBytes, upstream.LiveBytes);
+    EXPECT_LE(upstream.Allocations, threadCount * blocks);
+
+    // All blocks are in the shards now, and are handed out to this thread.
+    void* ptr = pool.Allocate(1000);
+    EXPECT_EQ(pool.GetStats().Misses, stats.Misses);
+    pool.Deallocate(ptr, 1000);
+
+    pool.Trim();
+    EXPECT_EQ(pool.GetStats().RetainedBlocks, 0u);
+    EXPECT_EQ(upstream.LiveBytes, 0u);
+}
+
+TEST(MemoryTest, PoolReleasesTheCachesOfRunningThreadsWhenDestroyed)
+{
+    CountingAllocator upstream;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool cached = false;
+    bool destroyed = false;
+
+    std::thread thread;
+    {
+        Memory::PoolAllocator pool(static_cast<size_t>(1) << 30, &upstream);
+        thread = std::thread([&]() {
+            pool.Deallocate(pool.Allocate(100), 100);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            cached = true;
+            condition.notify_all();
+            condition.wait(lock, [&]() { return destroyed; });
+        });
+
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return cached; });
+        EXPECT_EQ(pool.GetStats().RetainedBlocks, 1u);
+    }
+    EXPECT_EQ(upstream.LiveBytes, 0u);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        destroyed = true;
+    }
+    condition.notify_all();
+    thread.join();
+    EXPECT_EQ(upstream.Allocations, upstream.Deallocations);
+}
+
+TEST(MemoryTest, InPlaceProductsDrawTheirScratchFromThePool)
+{
+    CountingAllocator upstream;
+    Memory::PoolAllocator pool(static_cast<size_t>(1) << 30, &upstream);
+    Memory::AllocatorScope scope(pool);
+
+    Matrix<double> A = Matrix<double>::Random(300, 50, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> B = Matrix<double>::ID(50);
+    const Matrix<double> EXPECTED(A);
+
+    A *= B;
+    const size_t warmMisses = pool.GetStats().Misses;
+    for (size_t i = 0; i < 10; ++i) {
+        A *= B;
+    }
+
+    // The scratch panel is released after every product and handed out again by the pool.
+    EXPECT_EQ(pool.GetStats().Misses, warmMisses);
+    EXPECT_TRUE(A == EXPECTED);
+}
+
+TEST(MemoryTest, PoolRoundsToSizeClassesAndRespectsTheRetentionLimit)
+{
+    CountingAllocator upstream;
+    Memory::PoolAllocator pool(1000, &upstream);
+
+    // 700 and 720 bytes share the class of 768 bytes.
+    void* ptr = pool.Allocate(700);
+    EXPECT_EQ(upstream.LiveBytes, 768u);
+    pool.Deallocate(ptr, 700);
+    EXPECT_EQ(pool.Allocate(720), ptr);
+    EXPECT_EQ(pool.GetStats().Hits, 1u);
+
+    // A second block would exceed the limit of 1000 retained bytes and is released.
+    void* other = pool.Allocate(720);
+    pool.Deallocate(ptr, 720);
+    pool.Deallocate(other, 720);
+    EXPECT_EQ(pool.GetStats().RetainedBlocks, 1u);
+    EXPECT_EQ(upstream.LiveBytes, 768u);
+
+    // Block sizes above half of the address space are not representable.
+    EXPECT_THROW(pool.Allocate(std::numeric_limits<size_t>::max() - 1), std::bad_alloc);
+    EXPECT_EQ(upstream.Allocations, 2u);
+}
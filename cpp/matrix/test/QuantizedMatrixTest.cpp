@@ -0,0 +1,212 @@
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "Gemm.hpp"
+#include "Math.hpp"
+#include "Matrix.hpp"
+#include "QuantizedMatrix.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace
+{
+    template<typename T>
+    std::vector<T> RandomBytes(size_t length)
+    {
+        std::vector<T> values(length);
+        for (T& v : values) {
+            v = static_cast<T>(Random::Fast<int>(std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max()));
+        }
+        return values;
+    }
+
+    using Axis = QuantizedMatrix<int8_t>::Axis;
+    using Parameters = QuantizedMatrix<int8_t>::Parameters;
+
+} // end anonymous namespace
+
+
+template<typename T>
+class QuantizedMatrixTest : public ::testing::Test
+{
+};
+
+using LhsTypes = ::testing::Types<uint8_t, int8_t>;
+TYPED_TEST_SUITE(QuantizedMatrixTest, LhsTypes);
+
+
+TYPED_TEST(QuantizedMatrixTest, MultiplyQuantizedIsExact)
+{
+    using L = TypeParam;
+
+    // Several inner blocks with a partial last group, B in both orderings.
+    constexpr size_t M = 67, N = 45, K = 603;
+    const std::vector<L> a = RandomBytes<L>(M * K);
+    const std::vector<int8_t> b = RandomBytes<int8_t>(K * N);
+
+    for (Gemm::Strides bs : { Gemm::Strides{ N, 1 }, Gemm::Strides{ 1, K } })
+    {
+        std::vector<int32_t> c(M * N);
+        Gemm::MultiplyQuantized<L>(M, N, K, a.data(), { K, 1 }, b.data(), bs, c.data(), { N, 1 });
+
+        for (size_t i = 0; i < M; ++i) {
+            for (size_t j = 0; j < N; ++j)
+            {
+                int64_t expected = 0;
+                for (size_t p = 0; p < K; ++p) {
+                    expected += a[i * K + p] * b[p * bs.Row + j * bs.Col];
+                }
+                ASSERT_EQ(c[i * N + j], expected) << "(" << i << ", " << j << ")";
+            }
+        }
+    }
+
+    // The largest sums of the deepest exact product.
+    constexpr size_t DEPTH = Gemm::MAX_QUANTIZED_DEPTH;
+    const std::vector<L> lowest(DEPTH, std::numeric_limits<L>::is_signed ? L(-128) : L(255));
+    const std::vector<int8_t> column(DEPTH, int8_t(-128));
+    int32_t c = 0;
+    Gemm::MultiplyQuantized<L>(1, 1, DEPTH, lowest.data(), { DEPTH, 1 }, column.data(), { 1, 1 }, &c, { 1, 1 });
+    EXPECT_EQ(c, static_cast<int64_t>(DEPTH) * lowest[0] * -128);
+}
+
+TYPED_TEST(QuantizedMatrixTest, QuantizeRoundTrips)
+{
+    using L = TypeParam;
+
+    const Matrix<float> values = Matrix<float>::Random(37, 29, std::bind(&Random::Fast<float>, -3.0f, 5.0f), Matrix<float>::Ordering::ColumnMajor);
+
+    for (Axis axis : { Axis::Rows, Axis::Columns })
+    {
+        const auto q = QuantizedMatrix<L>::Quantize(values, static_cast<typename QuantizedMatrix<L>::Axis>(axis));
+        const Matrix<float> restored = q.Dequantize();
+
+        for (size_t i = 0; i < values.GetHeight(); ++i) {
+            for (size_t j = 0; j < values.GetWidth(); ++j)
+            {
+                const float scale = q.GetParameters()[axis == Axis::Rows ? i : j].Scale;
+                ASSERT_LE(std::abs(restored[i][j] - values[i][j]), 0.5001f * scale) << "(" << i << ", " << j << ")";
+            }
+        }
+    }
+
+    // Zero is represented exactly, also for lines without negative values.
+    const auto zeros = QuantizedMatrix<L>::Quantize(Matrix<float>({ { 0.0f, 0.0f }, { 0.0f, 2.0f } }), QuantizedMatrix<L>::Axis::Rows);
+    EXPECT_EQ(zeros.Dequantize()[0][0], 0.0f);
+    EXPECT_EQ(zeros.Dequantize()[1][0], 0.0f);
+    EXPECT_FLOAT_EQ(zeros.Dequantize()[1][1], 2.0f);
+}
+
+TYPED_TEST(QuantizedMatrixTest, ProductsCorrectForZeroPoints)
+{
+    using L = TypeParam;
+    using LParameters = typename QuantizedMatrix<L>::Parameters;
+
+    constexpr size_t M = 23, N = 41, K = 301;
+    std::vector<LParameters> rowParameters(M);
+    for (LParameters& p : rowParameters) {
+        p = { Random::Fast<float>(0.01f, 0.1f), Random::Fast<int>(std::numeric_limits<L>::lowest(), std::numeric_limits<L>::max()) };
+    }
+    std::vector<Parameters> columnParameters(N);
+    for (Parameters& p : columnParameters) {
+        p = { Random::Fast<float>(0.01f, 0.1f), Random::Fast<int>(-128, 127) };
+    }
+
+    const QuantizedMatrix<L> A(M, K, RandomBytes<L>(M * K), rowParameters, QuantizedMatrix<L>::Axis::Rows);
+    const QuantizedMatrix<int8_t> B(K, N, RandomBytes<int8_t>(K * N), columnParameters, Axis::Columns);
+
+    const Matrix<int> accumulators = A.MultiplyAccumulate(B);
+    const Matrix<float> product = A * B;
+    const Matrix<float> reference = A.Dequantize() * B.Dequantize();
+
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t j = 0; j < N; ++j)
+        {
+            int64_t expected = 0;
+            for (size_t p = 0; p < K; ++p) {
+                expected += (A.At(i, p) - rowParameters[i].ZeroPoint) * (B.At(p, j) - columnParameters[j].ZeroPoint);
+            }
+            ASSERT_EQ(accumulators[i][j], expected) << "(" << i << ", " << j << ")";
+
+            // The product is exact up to the rounding of the scaling, the reference sums rounded terms.
+            const float tolerance = 1e-5f * rowParameters[i].Scale * columnParameters[j].Scale * static_cast<float>(K * 255 * 255);
+            ASSERT_NEAR(product[i][j], reference[i][j], tolerance) << "(" << i << ", " << j << ")";
+        }
+    }
+}
+
+TYPED_TEST(QuantizedMatrixTest, ApproximatesFloatProduct)
+{
+    using L = TypeParam;
+
+    // Activations after a ReLU for the unsigned lhs, weights of both signs for the rhs.
+    const float lowest = std::numeric_limits<L>::is_signed ? -1.0f : 0.0f;
+    const Matrix<float> a = Matrix<float>::Random(150, 200, std::bind(&Random::Fast<float>, lowest, 1.0f));
+    const Matrix<float> b = Matrix<float>::Random(200, 70, std::bind(&Random::Fast<float>, -1.0f, 1.0f));
+    const Matrix<float> expected = a * b;
+
+    ThreadPool::Start(3);
+    const auto qa = QuantizedMatrix<L>::Quantize(a, QuantizedMatrix<L>::Axis::Rows);
+    const auto qb = QuantizedMatrix<int8_t>::Quantize(b, Axis::Columns);
+    const Matrix<float> product = qa * qb;
+    ThreadPool::Stop();
+
+    // Each element of either operand is off by at most half a step, about 1 / 255.
+    float maxError = 0.0f;
+    for (size_t i = 0; i < expected.GetHeight(); ++i) {
+        for (size_t j = 0; j < expected.GetWidth(); ++j) {
+            maxError = std::max(maxError, std::abs(product[i][j] - expected[i][j]));
+        }
+    }
+    EXPECT_LT(maxError, 200.0f * 2.0f / 255.0f);
+    EXPECT_TRUE(Math::AreEqual(qa.Multiply(qb)[3][5], product[3][5]));
+}
+
+TYPED_TEST(QuantizedMatrixTest, RequantizesWithSaturation)
+{
+    using L = TypeParam;
+    using LParameters = typename QuantizedMatrix<L>::Parameters;
+
+    // | 1 2 |   | 1 -1 |   |  3  1 |
+    // | 3 4 | * | 1  1 | = |  7  1 |
+    const QuantizedMatrix<L> A(2, 2, { 1, 2, 3, 4 }, std::vector<LParameters>(2, { 1.0f, 0 }), QuantizedMatrix<L>::Axis::Rows);
+    const QuantizedMatrix<int8_t> B(2, 2, { 1, -1, 1, 1 }, std::vector<Parameters>(2, { 1.0f, 0 }), Axis::Columns);
+
+    // Steps of 2 round ties to even: 3 / 2 -> 2, 7 / 2 -> 4, 1 / 2 -> 0. The zero point shifts by 126.
+    const QuantizedMatrix<int8_t> C = A.template MultiplyRequantized<int8_t>(B, { 2.0f, 126 });
+    EXPECT_EQ(C.GetValues(), (std::vector<int8_t>{ 127, 126, 127, 126 }));
+    EXPECT_EQ(C.GetParameters()[1].Scale, 2.0f);
+
+    const QuantizedMatrix<uint8_t> D = A.template MultiplyRequantized<uint8_t>(B, { 0.5f, 0 });
+    EXPECT_EQ(D.GetValues(), (std::vector<uint8_t>{ 6, 2, 14, 2 }));
+    EXPECT_TRUE(D == (QuantizedMatrix<uint8_t>(2, 2, { 6, 2, 14, 2 }, std::vector<QuantizedMatrix<uint8_t>::Parameters>(2, { 0.5f, 0 }), QuantizedMatrix<uint8_t>::Axis::Rows)));
+}
+
+TEST(QuantizedMatrixTest, ThrowsOnInvalidArguments)
+{
+    const std::vector<Parameters> two(2, { 1.0f, 0 });
+    EXPECT_THROW(QuantizedMatrix<int8_t>(2, 2, { 1, 2, 3 }, two, Axis::Rows), std::invalid_argument);
+    EXPECT_THROW(QuantizedMatrix<int8_t>(2, 3, std::vector<int8_t>(6), two, Axis::Columns), std::invalid_argument);
+    EXPECT_THROW(QuantizedMatrix<int8_t>(2, 2, std::vector<int8_t>(4), { { 1.0f, 0 }, { 0.0f, 0 } }, Axis::Rows), std::invalid_argument);
+    EXPECT_THROW(QuantizedMatrix<int8_t>(2, 2, std::vector<int8_t>(4), { { 1.0f, 0 }, { 1.0f, 128 } }, Axis::Rows), std::invalid_argument);
+    EXPECT_THROW(QuantizedMatrix<uint8_t>(2, 2, std::vector<uint8_t>(4), { { 1.0f, -1 }, { 1.0f, 0 } }, QuantizedMatrix<uint8_t>::Axis::Rows), std::invalid_argument);
+
+    const QuantizedMatrix<int8_t> A(2, 2, std::vector<int8_t>(4), two, Axis::Rows);
+    const QuantizedMatrix<int8_t> B(2, 2, std::vector<int8_t>(4), two, Axis::Columns);
+    const QuantizedMatrix<int8_t> C(3, 2, std::vector<int8_t>(6), two, Axis::Columns);
+    EXPECT_THROW(A * C, std::invalid_argument);
+    EXPECT_THROW(A * A, std::invalid_argument);
+    EXPECT_THROW(B * B, std::invalid_argument);
+    EXPECT_THROW(A.MultiplyRequantized<int8_t>(B, { std::nanf(""), 0 }), std::invalid_argument);
+    EXPECT_THROW(A.At(2, 0), std::out_of_range);
+
+    constexpr size_t DEEP = QuantizedMatrix<int8_t>::MAX_DEPTH + 1;
+    const QuantizedMatrix<int8_t> wide(1, DEEP, std::vector<int8_t>(DEEP), { { 1.0f, 0 } }, Axis::Rows);
+    const QuantizedMatrix<int8_t> tall(DEEP, 1, std::vector<int8_t>(DEEP), { { 1.0f, 0 } }, Axis::Columns);
+    EXPECT_THROW(wide * tall, std::invalid_argument);
+    EXPECT_EQ(A * B, Matrix<float>(2, 2));
+}
@@ -0,0 +1,292 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "Math.hpp"
+#include "Simd.hpp"
+
+
+template<typename T>
+class SimdKernelsTest : public ::testing::Test
+{
+protected:
+    // Odd lengths so that the scalar tail loops of the kernels get exercised.
+    inline static constexpr size_t LENGTH = 1037;
+    inline static constexpr size_t KC = 67;
+
+    static std::vector<T> RandomVector(size_t length)
+    {
+        std::vector<T> values(length);
+        for (T& v : values) {
+            v = Random::Fast<T>(static_cast<T>(-10), static_cast<T>(10));
+        }
+        return values;
+    }
+
+    /// @brief Returns the kernels of all instruction sets supported by the CPU, excluding the scalar fallback.
+    static std::vector<const Simd::Kernels<T>*> VectorKernels()
+    {
+        std::vector<const Simd::Kernels<T>*> kernels;
+        for (Simd::Isa isa : { Simd::Isa::SSE2, Simd::Isa::AVX2, Simd::Isa::AVX512 }) {
+            if (Simd::IsSupported(isa)) {
+                kernels.push_back(&Simd::GetKernels<T>(isa));
+            }
+        }
+        return kernels;
+    }
+};
+
+using RealTypes = ::testing::Types<float, double>;
+TYPED_TEST_SUITE(SimdKernelsTest, RealTypes);
+
+
+TYPED_TEST(SimdKernelsTest, AddMatchesScalar)
+{
+    using T = TypeParam;
+    const std::vector<T> a = this->RandomVector(this->LENGTH);
+    const std::vector<T> b = this->RandomVector(this->LENGTH);
+    std::vector<T> expected(this->LENGTH);
+    Simd::GetKernels<T>(Simd::Isa::Scalar).Add(a.data(), b.data(), expected.data(), this->LENGTH);
+
+    for (const auto* kernels : this->VectorKernels())
+    {
+        std::vector<T> result(this->LENGTH);
+        kernels->Add(a.data(), b.data(), result.data(), this->LENGTH);
+        EXPECT_EQ(result, expected) << Simd::IsaName(kernels->InstructionSet);
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, SubtractMatchesScalar)
+{
+    using T = TypeParam;
+    const std::vector<T> a = this->RandomVector(this->LENGTH);
+    const std::vector<T> b = this->RandomVector(this->LENGTH);
+    std::vector<T> expected(this->LENGTH);
+    Simd::GetKernels<T>(Simd::Isa::Scalar).Subtract(a.data(), b.data(), expected.data(), this->LENGTH);
+
+    for (const auto* kernels : this->VectorKernels())
+    {
+        std::vector<T> result(this->LENGTH);
+        kernels->Subtract(a.data(), b.data(), result.data(), this->LENGTH);
+        EXPECT_EQ(result, expected) << Simd::IsaName(kernels->InstructionSet);
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, ScaleAndAxpyMatchScalar)
+{
+    using T = TypeParam;
+    const T alpha = static_cast<T>(-1.5);
+    const std::vector<T> a = this->RandomVector(this->LENGTH);
+    const std::vector<T> b = this->RandomVector(this->LENGTH);
+    const auto& reference = Simd::GetKernels<T>(Simd::Isa::Scalar);
+
+    std::vector<T> expectedScale(this->LENGTH);
+    std::vector<T> expectedAxpy = b;
+    reference.Scale(alpha, a.data(), expectedScale.data(), this->LENGTH);
+    reference.Axpy(alpha, a.data(), expectedAxpy.data(), this->LENGTH);
+
+    for (const auto* kernels : this->VectorKernels())
+    {
+        std::vector<T> scaled(this->LENGTH);
+        std::vector<T> accumulated = b;
+        kernels->Scale(alpha, a.data(), scaled.data(), this->LENGTH);
+        kernels->Axpy(alpha, a.data(), accumulated.data(), this->LENGTH);
+        EXPECT_EQ(scaled, expectedScale) << Simd::IsaName(kernels->InstructionSet);
+        EXPECT_EQ(accumulated, expectedAxpy) << Simd::IsaName(kernels->InstructionSet);
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, DotRowsAndAxpyColumnsMatchScalar)
+{
+    using T = TypeParam;
+    const T alpha = static_cast<T>(0.5);
+    const size_t lines = 7; // Four lines at once and a remainder of three
+    const size_t stride = this->LENGTH + 5;
+    const std::vector<T> a = this->RandomVector(lines * stride);
+    const std::vector<T> x = this->RandomVector(this->LENGTH);
+    const std::vector<T> y = this->RandomVector(this->LENGTH);
+    const auto& reference = Simd::GetKernels<T>(Simd::Isa::Scalar);
+
+    std::vector<T> expectedDots(lines);
+    std::vector<T> expectedSum = y;
+    reference.DotRows(lines, this->LENGTH, a.data(), stride, x.data(), expectedDots.data());
+    reference.AxpyColumns(lines, this->LENGTH, alpha, a.data(), stride, x.data(), expectedSum.data());
+
+    for (const auto* kernels : this->VectorKernels())
+    {
+        std::vector<T> dots(lines);
+        std::vector<T> sum = y;
+        kernels->DotRows(lines, this->LENGTH, a.data(), stride, x.data(), dots.data());
+        kernels->AxpyColumns(lines, this->LENGTH, alpha, a.data(), stride, x.data(), sum.data());
+
+        // The sums are added in another order and with fused multiply-adds, so they are rounded
+        // differently, by at most about 2n ulp of the sum of the magnitudes of n terms.
+        for (size_t i = 0; i < lines; ++i)
+        {
+            T magnitude = static_cast<T>(0);
+            for (size_t j = 0; j < this->LENGTH; ++j) {
+                magnitude += std::abs(a[i * stride + j] * x[j]);
+            }
+            EXPECT_NEAR(dots[i], expectedDots[i], static_cast<T>(2 * this->LENGTH) * std::numeric_limits<T>::epsilon() * magnitude)
+                << Simd::IsaName(kernels->InstructionSet) << " dot " << i;
+        }
+        for (size_t j = 0; j < this->LENGTH; ++j)
+        {
+            T magnitude = std::abs(y[j]);
+            for (size_t i = 0; i < lines; ++i) {
+                magnitude += std::abs(alpha * a[i * stride + j] * x[i]);
+            }
+            EXPECT_NEAR(sum[j], expectedSum[j], static_cast<T>(4 * (lines + 1)) * std::numeric_limits<T>::epsilon() * magnitude)
+                << Simd::IsaName(kernels->InstructionSet) << " sum " << j;
+        }
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, DotBatchMatchesScalar)
+{
+    using T = TypeParam;
+    const size_t k = 5;
+    const size_t aStride = this->LENGTH + 3;
+    const size_t bStride = this->LENGTH + 11;
+    const std::vector<T> a = this->RandomVector(k * aStride);
+    const std::vector<T> b = this->RandomVector(k * bStride);
+
+    std::vector<T> expected(this->LENGTH);
+    Simd::GetKernels<T>(Simd::Isa::Scalar).DotBatch(k, this->LENGTH, a.data(), aStride, b.data(), bStride, expected.data());
+
+    for (const auto* kernels : this->VectorKernels())
+    {
+        std::vector<T> dots(this->LENGTH);
+        kernels->DotBatch(k, this->LENGTH, a.data(), aStride, b.data(), bStride, dots.data());
+
+        // The sums are rounded differently with fused multiply-adds, by at most about k ulp of the sum of the magnitudes.
+        for (size_t l = 0; l < this->LENGTH; ++l)
+        {
+            T magnitude = static_cast<T>(0);
+            for (size_t p = 0; p < k; ++p) {
+                magnitude += std::abs(a[p * aStride + l] * b[p * bStride + l]);
+            }
+            EXPECT_NEAR(dots[l], expected[l], static_cast<T>(4 * k) * std::numeric_limits<T>::epsilon() * magnitude)
+                << Simd::IsaName(kernels->InstructionSet) << " lane " << l;
+        }
+
+        // Every lane is computed with the same operations, wherever it is in the vectors.
+        std::vector<T> shifted(this->LENGTH - 1);
+        kernels->DotBatch(k, this->LENGTH - 1, a.data() + 1, aStride, b.data() + 1, bStride, shifted.data());
+        EXPECT_TRUE(std::equal(shifted.begin(), shifted.end(), dots.begin() + 1)) << Simd::IsaName(kernels->InstructionSet);
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, AreEqualMatchesScalar)
+{
+    using T = TypeParam;
+    const std::vector<T> a = this->RandomVector(this->LENGTH);
+    const auto& reference = Simd::GetKernels<T>(Simd::Isa::Scalar);
+
+    // Mismatches at the start, in the middle and in the scalar tail.
+    for (size_t mismatchIdx : { size_t(0), this->LENGTH / 2, this->LENGTH - 1 })
+    {
+        std::vector<T> b = a;
+        b[mismatchIdx] += static_cast<T>(1);
+        ASSERT_TRUE(reference.AreEqual(a.data(), a.data(), this->LENGTH, static_cast<T>(3)));
+        ASSERT_FALSE(reference.AreEqual(a.data(), b.data(), this->LENGTH, static_cast<T>(3)));
+
+        for (const auto* kernels : this->VectorKernels())
+        {
+            EXPECT_TRUE(kernels->AreEqual(a.data(), a.data(), this->LENGTH, static_cast<T>(3)))
+                << Simd::IsaName(kernels->InstructionSet);
+            EXPECT_FALSE(kernels->AreEqual(a.data(), b.data(), this->LENGTH, static_cast<T>(3)))
+                << Simd::IsaName(kernels->InstructionSet) << ", mismatch at: " << mismatchIdx;
+        }
+    }
+}
+
+TYPED_TEST(SimdKernelsTest, MicroKernelMatchesScalar)
+{
+    using T = TypeParam;
+
+    for (const auto* kernels : this->VectorKernels())
+    {
+        const size_t MR = kernels->MR;
+        const size_t NR = kernels->NR;
+        const size_t bRowStride = NR + 3; // B is a sliver of a wider matrix
+
+        const std::vector<T> a = this->RandomVector(MR * this->KC);
+        const std::vector<T> b = this->RandomVector(this->KC * bRowStride);
+
+        // A in row major and in column major order.
+        for (Gemm::Strides as : { Gemm::Strides{ this->KC, 1 }, Gemm::Strides{ 1, MR } })
+        {
+            std::vector<T> tile(MR * NR);
+            kernels->MicroKernel(this->KC, a.data(), as, b.data(), bRowStride, tile.data());
+
+            for (size_t i = 0; i < MR; ++i) {
+                for (size_t j = 0; j < NR; ++j)
+                {
+                    T expected = static_cast<T>(0);
+                    for (size_t p = 0; p < this->KC; ++p) {
+                        expected += a[i * as.Row + p * as.Col] * b[p * bRowStride + j];
+                    }
+                    EXPECT_TRUE(Math::AreEqual(tile[i * NR + j], expected, static_cast<T>(1000)))
+                        << Simd::IsaName(kernels->InstructionSet) << " tile(" << i << ", " << j << "): "
+                        << tile[i * NR + j] << " != " << expected;
+                }
+            }
+        }
+    }
+}
+
+TEST(SimdTest, DetectedIsaIsSupported)
+{
+    EXPECT_TRUE(Simd::IsSupported(Simd::DetectIsa()));
+    EXPECT_TRUE(Simd::IsSupported(Simd::Isa::Scalar));
+    EXPECT_EQ(Simd::GetKernels<float>().InstructionSet, Simd::DetectIsa());
+    EXPECT_EQ(Simd::GetKernels<int>().InstructionSet, Simd::Isa::Scalar);
+}
+
+TEST(SimdTest, QuantizedMicroKernelIsExact)
+{
+    constexpr size_t GROUPS = 67;
+    constexpr size_t G = Simd::QUANTIZED_GROUP;
+
+    for (Simd::Isa isa : { Simd::Isa::Scalar, Simd::Isa::SSE2, Simd::Isa::AVX2, Simd::Isa::AVX512 })
+    {
+        if (!Simd::IsSupported(isa)) {
+            continue;
+        }
+
+        const Simd::QuantizedKernels& kernels = Simd::GetQuantizedKernels(isa);
+        const size_t MR = kernels.MR;
+        const size_t NR = kernels.NR;
+
+        // Random bytes, and the extremes whose pairs of products overflow 16 bit.
+        for (bool extremes : { false, true })
+        {
+            std::vector<uint8_t> a(GROUPS * MR * G);
+            std::vector<int8_t> b(GROUPS * NR * G);
+            for (uint8_t& v : a) {
+                v = extremes ? uint8_t(255) : static_cast<uint8_t>(Random::Fast<int>(0, 255));
+            }
+            for (int8_t& v : b) {
+                v = extremes ? int8_t(-128) : static_cast<int8_t>(Random::Fast<int>(-128, 127));
+            }
+
+            std::vector<int32_t> tile(MR * NR);
+            kernels.MicroKernel(GROUPS, a.data(), b.data(), tile.data());
+
+            for (size_t i = 0; i < MR; ++i) {
+                for (size_t j = 0; j < NR; ++j)
+                {
+                    int32_t expected = 0;
+                    for (size_t p = 0; p < GROUPS * G; ++p) {
+                        expected += a[(p / G * MR + i) * G + p % G] * b[(p / G * NR + j) * G + p % G];
+                    }
+                    ASSERT_EQ(tile[i * NR + j], expected) << Simd::IsaName(kernels.InstructionSet) << " tile(" << i << ", " << j << ")";
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "Math.hpp"
+#include "Matrix.hpp"
+#include "SparseMatrix.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace
+{
+    using Format = SparseMatrix<int>::Format;
+    using Ordering = Matrix<int>::Ordering;
+
+    /// @brief Returns a dense matrix where about one in sparsity elements is nonzero.
+    template<typename T>
+    Matrix<T> RandomSparseDense(size_t rows, size_t columns, int sparsity, typename Matrix<T>::Ordering ordering = Matrix<T>::Ordering::RowMajor)
+    {
+        Matrix<T> dense(rows, columns, ordering);
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < columns; ++c) {
+                if (Random::Fast<int>(0, sparsity - 1) == 0) {
+                    dense[r][c] = static_cast<T>(Random::Fast<int>(1, 9));
+                }
+            }
+        }
+        return dense;
+    }
+
+} // end anonymous namespace
+
+
+TEST(SparseMatrixTest, CompressedArraysOfBothFormats)
+{
+    // | 1 0 2 |
+    // | 0 0 3 |
+    // | 4 5 0 |
+    const Matrix<int> DENSE({ { 1, 0, 2 }, { 0, 0, 3 }, { 4, 5, 0 } });
+
+    const SparseMatrix<int> CSR(DENSE);
+    EXPECT_EQ(CSR.GetNonZeros(), 5u);
+    EXPECT_EQ(CSR.GetOffsets(), (std::vector<size_t>{ 0, 2, 3, 5 }));
+    EXPECT_EQ(CSR.GetIndices(), (std::vector<size_t>{ 0, 2, 2, 0, 1 }));
+    EXPECT_EQ(CSR.GetValues(),  (std::vector<int>{ 1, 2, 3, 4, 5 }));
+
+    const SparseMatrix<int> CSC(DENSE, Format::CSC);
+    EXPECT_EQ(CSC.GetOffsets(), (std::vector<size_t>{ 0, 2, 3, 5 }));
+    EXPECT_EQ(CSC.GetIndices(), (std::vector<size_t>{ 0, 2, 2, 0, 1 }));
+    EXPECT_EQ(CSC.GetValues(),  (std::vector<int>{ 1, 4, 5, 2, 3 }));
+
+    EXPECT_TRUE(CSR.ToFormat(Format::CSC).GetValues() == CSC.GetValues());
+    EXPECT_TRUE(CSC.ToFormat(Format::CSR).GetIndices() == CSR.GetIndices());
+    EXPECT_TRUE(CSR == CSC);
+
+    EXPECT_EQ(CSR.At(2, 1), 5);
+    EXPECT_EQ(CSC.At(1, 0), 0);
+    EXPECT_THROW(CSR.At(3, 0), std::out_of_range);
+
+    EXPECT_TRUE(CSR.ToDense() == DENSE);
+    EXPECT_TRUE(CSC.ToDense(Ordering::ColumnMajor) == DENSE);
+    EXPECT_TRUE(CSR.Transpose().ToDense() == DENSE.Transpose());
+    EXPECT_EQ(CSR.Transpose().GetFormat(), Format::CSC);
+}
+
+TEST(SparseMatrixTest, ConstructionFromTripletsAndArrays)
+{
+    // Unordered, with a duplicate that is summed.
+    const SparseMatrix<double> A = SparseMatrix<double>::FromTriplets(2, 3, {
+        { 1, 2, 3.0 }, { 0, 0, 1.0 }, { 1, 2, 0.5 }, { 0, 1, 2.0 }
+    });
+    EXPECT_TRUE(A.ToDense() == Matrix<double>({ { 1.0, 2.0, 0.0 }, { 0.0, 0.0, 3.5 } }));
+    EXPECT_THROW(SparseMatrix<double>::FromTriplets(2, 3, { { 2, 0, 1.0 } }), std::out_of_range);
+
+    const SparseMatrix<double> B(2, 3, { 0, 2, 3 }, { 0, 1, 2 }, { 1.0, 2.0, 3.5 });
+    EXPECT_TRUE(A == B);
+
+    // An explicitly stored zero equals an element that is not stored.
+    const SparseMatrix<double> C(2, 3, { 0, 3, 4 }, { 0, 1, 2, 2 }, { 1.0, 2.0, 0.0, 3.5 });
+    EXPECT_TRUE(C == A);
+
+    EXPECT_THROW(SparseMatrix<double>(2, 3, { 0, 2 }, { 0, 1 }, { 1.0, 2.0 }), std::invalid_argument);          // Missing offset
+    EXPECT_THROW(SparseMatrix<double>(2, 3, { 0, 2, 2 }, { 1, 0 }, { 1.0, 2.0 }), std::invalid_argument);       // Unsorted indices
+    EXPECT_THROW(SparseMatrix<double>(2, 3, { 0, 1, 2 }, { 0, 3 }, { 1.0, 2.0 }), std::invalid_argument);       // Index out of range
+    EXPECT_THROW(SparseMatrix<double>(2, 3, { 0, 1, 2 }, { 0, 1 }, { 1.0 }), std::invalid_argument);            // Missing value
+
+    // Small values are dropped with a tolerance.
+    const SparseMatrix<double> D(Matrix<double>({ { 1e-9, 1.0 }, { -1e-9, -2.0 } }), SparseMatrix<double>::Format::CSR, 1e-6);
+    EXPECT_EQ(D.GetNonZeros(), 2u);
+}
+
+TEST(SparseMatrixTest, ProductsMatchDenseProducts)
+{
+    for (Format format : { Format::CSR, Format::CSC }) {
+        for (Ordering ordering : { Ordering::RowMajor, Ordering::ColumnMajor })
+        {
+            const Matrix<int> A_DENSE = RandomSparseDense<int>(37, 53, 5, ordering);
+            const Matrix<int> B_DENSE = RandomSparseDense<int>(53, 29, 4, ordering);
+            const SparseMatrix<int> A(A_DENSE, format);
+            const SparseMatrix<int> B(B_DENSE, format);
+
+            const Matrix<int> X = Matrix<int>::Random(53, 41, std::bind(&Random::Fast<int>, -9, 9), ordering);
+            const Matrix<int> x = Matrix<int>::Random(53, 1, std::bind(&Random::Fast<int>, -9, 9));
+            const Matrix<int> Y = Matrix<int>::Random(17, 37, std::bind(&Random::Fast<int>, -9, 9), ordering);
+
+            EXPECT_TRUE(A * X == A_DENSE * X);
+            EXPECT_TRUE(A * x == A_DENSE * x);
+            EXPECT_TRUE(Y * A == Y * A_DENSE);
+
+            const SparseMatrix<int> AB = A * B;
+            EXPECT_EQ(AB.GetFormat(), format);
+            EXPECT_TRUE(AB.ToDense() == A_DENSE * B_DENSE);
+            EXPECT_TRUE(A * B.ToFormat(format == Format::CSR ? Format::CSC : Format::CSR) == AB);
+        }
+    }
+
+    const SparseMatrix<int> A(3, 4);
+    EXPECT_THROW(A * Matrix<int>(3, 2), std::invalid_argument);
+    EXPECT_THROW(Matrix<int>(2, 4) * A, std::invalid_argument);
+    EXPECT_THROW(A * A, std::invalid_argument);
+}
+
+TEST(SparseMatrixThreadsTest, ParallelProductsMatchSerial)
+{
+    // Enough nonzeros times columns to be split into several slices, with a few dense rows.
+    constexpr size_t size = 3000;
+    Matrix<double> A_DENSE = RandomSparseDense<double>(size, size, 100);
+    for (size_t c = 0; c < size; ++c) {
+        A_DENSE[7][c] = 1.0;
+    }
+
+    const SparseMatrix<double> A(A_DENSE);
+    const Matrix<double> X = Matrix<double>::Random(size, 40, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+    const Matrix<double> x = Matrix<double>::Random(size, 1, std::bind<double>(&Random::Fast<double>, -1.0, 1.0));
+
+    const Matrix<double> AX_EXPECTED = A * X;
+    const Matrix<double> Ax_EXPECTED = A * x;
+    const Matrix<double> XA_EXPECTED = X.Transpose() * A;
+    const SparseMatrix<double> AA_EXPECTED = A * A;
+    const Matrix<double> DENSE_EXPECTED = A.ToDense();
+
+    ThreadPool::Start(3);
+    const Matrix<double> AX = A * X;
+    const Matrix<double> Ax = A * x;
+    const Matrix<double> XA = X.Transpose() * A;
+    const SparseMatrix<double> AA = A * A;
+    const SparseMatrix<double> A_PARALLEL(A_DENSE);
+    const Matrix<double> DENSE = A.ToDense();
+    ThreadPool::Stop();
+
+    EXPECT_TRUE(AX == AX_EXPECTED);
+    EXPECT_TRUE(Ax == Ax_EXPECTED);
+    EXPECT_TRUE(XA == XA_EXPECTED);
+    EXPECT_TRUE(AA == AA_EXPECTED);
+    EXPECT_TRUE(A_PARALLEL == A);
+    EXPECT_TRUE(DENSE == DENSE_EXPECTED);
+}